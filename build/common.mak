@@ -203,6 +203,14 @@ endif
 
 LDFLAGS += -export-dynamic
 
+# Set USE_HEAP_PROFILER=1 to have cstdmf's HeapProfiler replace malloc, calloc,
+# realloc and free, so that allocations are sampled when the process is run
+# with the BW_HEAP_PROFILER environment variable set. Leave it off when using
+# tools that replace these functions too, such as AddressSanitizer.
+ifeq ($(USE_HEAP_PROFILER),1)
+CPPFLAGS += -DBW_HEAP_PROFILER
+endif
+
 # The OpenSSL redist is used for all builds as cstdmf/md5.[ch]pp depends
 # on the OpenSSL MD5 implementation.
 OPENSSL_DIR = $(MF_ROOT)/bigworld/src/lib/third_party/openssl
@@ -68,7 +68,7 @@ BaseAppLoginRequest::BaseAppLoginRequest( LoginHandler & parent ) :
 		*pInterface_, parent.baseAppAddr(),
 		Mercury::Channel::EXTERNAL,
 		/* minInactivityResendDelay: */ 1.0,
-		pServConn->pFilter().get() );
+		pServConn->createChannelFilter( parent.channelCipher() ) );
 
 	// The channel is irregular until we get cellPlayerCreate (i.e. entities
 	// enabled).
@@ -91,6 +91,11 @@ void LogOnParams::addToStreamInternal( BinaryOStream & data,
 		data << digest_;
 	}
 
+	if (flags & HAS_CHANNEL_CIPHER)
+	{
+		data << channelCipher_;
+	}
+
 	data << nonce_;
 }
 
@@ -107,6 +112,14 @@ bool LogOnParams::readFromStreamInternal( BinaryIStream & data )
 		data >> digest_;
 	}
 
+	// Older clients do not send a cipher and only support Blowfish.
+	channelCipher_ = CHANNEL_CIPHER_BLOWFISH;
+
+	if (flags_ & HAS_CHANNEL_CIPHER)
+	{
+		data >> channelCipher_;
+	}
+
 	data >> nonce_;
 
 	return !data.error();
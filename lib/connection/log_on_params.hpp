@@ -33,11 +33,20 @@ public:
 	/// An enumeration of flags for fields that are optionally streamed.
 	typedef uint8 Flags;
 	static const Flags HAS_DIGEST = 0x1;
-	static const Flags HAS_ALL = 0x1;
+	static const Flags HAS_CHANNEL_CIPHER = 0x2;
+	static const Flags HAS_ALL = 0x3;
 	static const Flags PASS_THRU = 0xFF;
 
+	/// An enumeration of the ciphers that the client's channel to its BaseApp
+	/// can use. The client requests one and the LoginApp may fall back to
+	/// CHANNEL_CIPHER_BLOWFISH, which all servers support.
+	typedef uint8 ChannelCipher;
+	static const ChannelCipher CHANNEL_CIPHER_BLOWFISH = 0;
+	static const ChannelCipher CHANNEL_CIPHER_AES_GCM = 1;
+
 	LogOnParams() :
-		flags_( HAS_ALL )
+		flags_( HAS_ALL ),
+		channelCipher_( CHANNEL_CIPHER_BLOWFISH )
 	{
 		nonce_ = std::rand();
 		digest_.clear();
@@ -48,7 +57,8 @@ public:
 		flags_( HAS_ALL ),
 		username_( username ),
 		password_( password ),
-		encryptionKey_( encryptionKey )
+		encryptionKey_( encryptionKey ),
+		channelCipher_( CHANNEL_CIPHER_BLOWFISH )
 	{
 		nonce_ = std::rand();
 		digest_.clear();
@@ -71,6 +81,9 @@ public:
 	const std::string & encryptionKey() const { return encryptionKey_; }
 	void encryptionKey( const std::string & s ) { encryptionKey_ = s; }
 
+	ChannelCipher channelCipher() const { return channelCipher_; }
+	void channelCipher( ChannelCipher cipher ) { channelCipher_ = cipher; }
+
 	const MD5::Digest & digest() const { return digest_; }
 	void digest( const MD5::Digest & digest ){ digest_ = digest; }
 
@@ -82,6 +95,7 @@ public:
 		return username_ == other.username_ &&
 			password_ == other.password_ &&
 			encryptionKey_ == other.encryptionKey_ &&
+			channelCipher_ == other.channelCipher_ &&
 			nonce_ == other.nonce_;
 	}
 
@@ -94,6 +108,7 @@ private:
 	std::string username_;
 	std::string password_;
 	std::string encryptionKey_;
+	ChannelCipher channelCipher_;
 	uint32 nonce_;
 	MD5::Digest digest_;
 };
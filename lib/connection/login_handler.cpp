@@ -16,6 +16,8 @@ criminal penalties as provided by law.
 #include "loginapp_login_request.hpp"
 #include "server_connection.hpp"
 
+#include "cstdmf/timestamp.hpp"
+
 #include "network/network_interface.hpp"
 
 namespace // anonymous
@@ -40,8 +42,11 @@ LoginHandler::LoginHandler(
 	pParams_( NULL ),
 	pServerConnection_( pServerConnection ),
 	replyRecord_(),
+	channelCipher_( LogOnParams::CHANNEL_CIPHER_BLOWFISH ),
 	done_( loginNotSent != LogOnStatus::NOT_SET ),
 	status_( loginNotSent ),
+	startTime_( timestamp() ),
+	finishTime_( startTime_ ),
 	errorMsg_(),
 	numBaseAppLoginAttempts_( 0 ),
 	childRequests_()
@@ -93,6 +98,7 @@ void LoginHandler::finish()
 	}
 
 	done_ = true;
+	finishTime_ = timestamp();
 }
 
 
@@ -121,6 +127,14 @@ void LoginHandler::onLoginReply( BinaryIStream & data )
 			MemoryOStream clearText;
 			pServerConnection_->pFilter()->decryptStream( data, clearText );
 			clearText >> replyRecord_;
+
+			// The LoginApp's choice of channel cipher follows the reply
+			// record. Older servers do not send one and only support
+			// Blowfish.
+			if (clearText.remainingLength() > 0)
+			{
+				clearText >> channelCipher_;
+			}
 		}
 		else
 #endif
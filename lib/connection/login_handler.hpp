@@ -61,8 +61,11 @@ public:
 	void onFailure( Mercury::Reason reason );
 
 	const LoginReplyRecord & replyRecord() const { return replyRecord_; }
+	LogOnParams::ChannelCipher channelCipher() const { return channelCipher_; }
 
 	bool done() const						{ return done_; }
+	uint64 startTime() const				{ return startTime_; }
+	uint64 finishTime() const				{ return finishTime_; }
 	int status() const						{ return status_; }
 	LogOnParamsPtr pParams()				{ return pParams_; }
 
@@ -93,9 +96,13 @@ private:
 
 	ServerConnection* 	pServerConnection_;
 	LoginReplyRecord	replyRecord_;
+	LogOnParams::ChannelCipher channelCipher_;
 	bool				done_;
 	uint8				status_;
 
+	uint64				startTime_;
+	uint64				finishTime_;
+
 	std::string			errorMsg_;
 
 	/// Number of BaseAppLoginRequests that have been created
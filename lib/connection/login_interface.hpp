@@ -77,8 +77,10 @@ criminal penalties as provided by law.
 // Version 54: LogOnParams no longer streams nonce twice.
 // Version 55: Optimised slice changes to arrays. Bug: 15846
 // Version 56: createEntity can now be compressed
-const uint32 LOGIN_VERSION = 56;
-const uint32 OLDEST_SUPPORTED_CLIENT_LOGIN_VERSION = 56;
+// Version 57: Added support for selective ACKs.
+// Version 58: LogOnParams may request a channel cipher (HAS_CHANNEL_CIPHER).
+const uint32 LOGIN_VERSION = 58;
+const uint32 OLDEST_SUPPORTED_CLIENT_LOGIN_VERSION = 58;
 
 // Probe reply is a list of pairs of strings
 // Some strings can be interpreted as integers
@@ -29,6 +29,7 @@ criminal penalties as provided by law.
 #include "math/vector3.hpp"
 
 #include "network/portmap.hpp"
+#include "network/aes_gcm_filter.hpp"
 #include "network/encryption_filter.hpp"
 #include "network/compression_stream.hpp"
 #include "network/interface_table.hpp"
@@ -109,6 +110,11 @@ ServerConnection::ServerConnection() :
 	pFilter_( new Mercury::EncryptionFilter() ),
 #else
 	pFilter_( NULL ),
+#endif
+#ifdef HAS_AES_GCM_FILTER
+	channelCipher_( LogOnParams::CHANNEL_CIPHER_AES_GCM ),
+#else
+	channelCipher_( LogOnParams::CHANNEL_CIPHER_BLOWFISH ),
 #endif
 	pLogOnParamsEncoder_( NULL ),
 	timerHandle_(),
@@ -258,6 +264,24 @@ LogOnStatus ServerConnection::logOn( ServerMessageHandler * pHandler,
 }
 
 
+/**
+ *	This method returns the filter to use on a channel to the BaseApp with the
+ *	given cipher. The filter's key is the one sent with the login parameters.
+ */
+Mercury::PacketFilterPtr ServerConnection::createChannelFilter(
+	LogOnParams::ChannelCipher cipher )
+{
+#ifdef HAS_AES_GCM_FILTER
+	if (pFilter_ && (cipher == LogOnParams::CHANNEL_CIPHER_AES_GCM))
+	{
+		return new Mercury::AESGCMFilter( pFilter_->key() );
+	}
+#endif
+
+	return pFilter_.get();
+}
+
+
 /**
  *	This method begins an asynchronous login
  */
@@ -271,6 +295,7 @@ LoginHandlerPtr ServerConnection::logOnBegin(
 	LogOnParamsPtr pParams = new LogOnParams( username, password, key );
 
 	pParams->digest( this->digest() );
+	pParams->channelCipher( channelCipher_ );
 
 	g_isMainThread = true;
 
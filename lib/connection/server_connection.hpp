@@ -96,6 +96,14 @@ public:
 
 	Mercury::EncryptionFilterPtr pFilter() { return pFilter_; }
 
+	LogOnParams::ChannelCipher channelCipher() const
+		{ return channelCipher_; }
+	void channelCipher( LogOnParams::ChannelCipher cipher )
+		{ channelCipher_ = cipher; }
+
+	Mercury::PacketFilterPtr createChannelFilter(
+		LogOnParams::ChannelCipher cipher );
+
 	void addMove( EntityID id, SpaceID spaceID, EntityID vehicleID,
 		const Vector3 & pos, float yaw, float pitch, float roll,
 		bool onGround, const Vector3 & globalPos );
@@ -387,6 +395,9 @@ private:
 
 	Mercury::EncryptionFilterPtr pFilter_;
 
+	// The cipher requested for the channel to the BaseApp.
+	LogOnParams::ChannelCipher channelCipher_;
+
 	StreamEncoder * pLogOnParamsEncoder_;
 
 	TimerHandle timerHandle_;
@@ -13,6 +13,7 @@ criminal penalties as provided by law.
 
 #include "bgtask_manager.hpp"
 #include "diary.hpp"
+#include "memory_stream_arena.hpp"
 #include "profiler.hpp"
 
 DECLARE_DEBUG_COMPONENT2( "CStdMF", 0 )
@@ -97,10 +98,11 @@ volatile int g_threadSync = 0;
  * BackgroundTaskThread
  */
 BackgroundTaskThread::BackgroundTaskThread( BgTaskManager & mgr,
-		BackgroundThreadDataPtr pData ) :
+		BackgroundThreadDataPtr pData, int queueIndex ) :
 	SimpleThread(),
 	mgr_( mgr ),
-	pData_( pData )
+	pData_( pData ),
+	queueIndex_( queueIndex )
 {
 	this->SimpleThread::init( BackgroundTaskThread::s_start, this );
 
@@ -150,7 +152,7 @@ void BackgroundTaskThread::run()
 
 	while (true)
 	{
-		BackgroundTaskPtr pTask = mgr_.pullBackgroundTask();
+		BackgroundTaskPtr pTask = mgr_.pullBackgroundTask( queueIndex_ );
 
 		// A NULL task indicates that the thread should terminate.
 		if (pTask)
@@ -165,6 +167,8 @@ void BackgroundTaskThread::run()
 			#ifdef _WIN32
 			InterlockedDecrement( &mgr_.workingCount_ );
 			#endif
+
+			MemoryStreamArena::resetCurrentThread();
 		}
 		else
 		{
@@ -195,8 +199,8 @@ bool BgTaskManager::isWorking()
 		return true;
 	}
 
-	// If there is anything in the list, we are working
-	if ( !bgTaskList_.isEmpty() )
+	// If there is anything queued, we are working
+	if ( this->numQueuedTasks() > 0 )
 	{
 		return true;
 	}
@@ -221,31 +225,53 @@ void ThreadFinisher::doMainThreadTask( BgTaskManager & mgr )
 
 
 // -----------------------------------------------------------------------------
-// Section: BackgroundTaskList
+// Section: WorkQueue
 // -----------------------------------------------------------------------------
 
 /**
- *	This method adds a task to the list of tasks in a thread-safe way.
- *
- *	@param pTask	The task to add
- *	@param priority	The priority to add this task at. A higher value means that
- *		the task is done earlier.
+ *	Constructor.
+ */
+BgTaskManager::WorkQueue::WorkQueue() :
+	isActive_( false ),
+	isStopping_( false ),
+	isIdle_( false ),
+	hasThread_( false )
+{
+	for (int i = 0; i < NUM_LANES; ++i)
+	{
+		sizes_[ i ] = 0;
+		frontSequences_[ i ] = 0;
+	}
+}
+
+
+/**
+ *	This method adds a task to a lane and wakes the owning thread. The task is
+ *	placed after any tasks with lower numbers, which is normally the back.
  */
-void BgTaskManager::BackgroundTaskList::push( BackgroundTaskPtr pTask,
-												int priority )
+void BgTaskManager::WorkQueue::push( BackgroundTaskPtr pTask, int lane,
+		uint32 sequence )
 {
 	{
 		SimpleMutexHolder holder( mutex_ );
+		Lane & tasks = lanes_[ lane ];
 
-		// Insert with highest priority value tasks first
-		List::reverse_iterator iter = list_.rbegin();
+		// Another thread may have numbered an earlier task but added it after
+		// this one.
+		Lane::iterator iter = tasks.end();
 
-		while ((iter != list_.rend()) && (priority > iter->first))
+		while ((iter != tasks.begin()) &&
+				(int32( sequence - (iter - 1)->sequence ) < 0))
 		{
-			++iter;
+			--iter;
 		}
 
-		list_.insert( iter.base(), std::make_pair( priority, pTask ) );
+		QueuedTask queuedTask;
+		queuedTask.pTask = pTask;
+		queuedTask.sequence = sequence;
+		tasks.insert( iter, queuedTask );
+
+		this->updateLane( lane );
 	}
 
 	semaphore_.push();
@@ -253,42 +279,118 @@ void BgTaskManager::BackgroundTaskList::push( BackgroundTaskPtr pTask,
 
 
 /**
- *	This method pulls a task from the list of tasks in a thread-safe way. It
- *	waits on a semaphore if no tasks exist.
+ *	This method removes the task at the front of a lane if it is the task with
+ *	the given number. It may be called by any thread.
+ *
+ *	@return The task, or NULL if the lane is empty or another task is at the
+ *		front.
  */
-BackgroundTaskPtr BgTaskManager::BackgroundTaskList::pull()
+BackgroundTaskPtr BgTaskManager::WorkQueue::pop( int lane, uint32 sequence )
 {
-	semaphore_.pull();
-	mutex_.grab();
-	BackgroundTaskPtr pTask = list_.front().second;
-	list_.pop_front();
-	mutex_.give();
+	if (this->isEmpty( lane ))
+	{
+		return NULL;
+	}
+
+	SimpleMutexHolder holder( mutex_ );
+	Lane & tasks = lanes_[ lane ];
+
+	if (tasks.empty() || (tasks.front().sequence != sequence))
+	{
+		return NULL;
+	}
+
+	BackgroundTaskPtr pTask = tasks.front().pTask;
+	tasks.pop_front();
+	this->updateLane( lane );
 
 	return pTask;
 }
 
+
 /**
- *	This method tells the caller if the list is empty.
+ *	This method moves all tasks in this queue to another queue, keeping their
+ *	numbers.
  */
-bool BgTaskManager::BackgroundTaskList::isEmpty()
+void BgTaskManager::WorkQueue::moveTo( WorkQueue & other )
+{
+	for (int lane = 0; lane < NUM_LANES; ++lane)
+	{
+		Lane tasks;
+
+		{
+			SimpleMutexHolder holder( mutex_ );
+			tasks.swap( lanes_[ lane ] );
+			this->updateLane( lane );
+		}
+
+		Lane::iterator iter = tasks.begin();
+
+		while (iter != tasks.end())
+		{
+			other.push( iter->pTask, lane, iter->sequence );
+
+			++iter;
+		}
+	}
+}
+
+
+/**
+ *	This method updates the values of a lane that are read without holding the
+ *	mutex. The mutex must be held.
+ */
+void BgTaskManager::WorkQueue::updateLane( int lane )
+{
+	const Lane & tasks = lanes_[ lane ];
+
+	if (!tasks.empty())
+	{
+		frontSequences_[ lane ] = tasks.front().sequence;
+	}
+
+	sizes_[ lane ] = tasks.size();
+}
+
+
+/**
+ *	This method discards all tasks in this queue.
+ */
+void BgTaskManager::WorkQueue::clear()
 {
 	SimpleMutexHolder holder( mutex_ );
-	return list_.empty();
+
+	for (int i = 0; i < NUM_LANES; ++i)
+	{
+		lanes_[ i ].clear();
+		sizes_[ i ] = 0;
+	}
 }
 
+
+/**
+ *	This method blocks the owning thread until a task is added to this queue
+ *	or wake() is called.
+ */
+void BgTaskManager::WorkQueue::wait()
+{
+	semaphore_.pull();
+}
+
+
 /**
- *	This method clears the task list.
+ *	This method returns the number of tasks in this queue.
  */
-void BgTaskManager::BackgroundTaskList::clear()
+int BgTaskManager::WorkQueue::size() const
 {
-	mutex_.grab();
+	int size = 0;
 
-	while (semaphore_.pullTry())
+	for (int i = 0; i < NUM_LANES; ++i)
 	{
-		list_.pop_front();
+		size += sizes_[ i ];
 	}
 
-	mutex_.give();
+	return size;
 }
 
 
@@ -330,10 +432,17 @@ void BgTaskManager::fini()
  *	Constructor.
  */
 BgTaskManager::BgTaskManager() :
+	numQueues_( 0 ),
+	nextQueue_( 0 ),
+	nextSequence_( 0 ),
 	numRunningThreads_( 0 ),
 	numUnstoppedThreads_( 0 ),
 	workingCount_( 0 )
 {
+	for (int i = 0; i < MAX_THREADS; ++i)
+	{
+		queues_[ i ] = NULL;
+	}
 }
 
 
@@ -343,6 +452,24 @@ BgTaskManager::BgTaskManager() :
 BgTaskManager::~BgTaskManager()
 {
 	this->stopAll();
+
+	for (int i = 0; i < numQueues_; ++i)
+	{
+		delete queues_[ i ];
+	}
+}
+
+
+/**
+ *	This method returns the lane used for tasks of the given priority. Lane 0
+ *	holds HIGH priority tasks and above, lane 1 holds MEDIUM, lane 2 holds LOW
+ *	and lane 3 holds everything below LOW.
+ */
+int BgTaskManager::laneFor( int priority )
+{
+	return (priority >= HIGH)   ? 0 :
+		(priority >= MEDIUM) ? 1 :
+		(priority >= LOW)    ? 2 : 3;
 }
 
 
@@ -354,14 +481,43 @@ BgTaskManager::~BgTaskManager()
 void BgTaskManager::startThreads( int numThreads,
 			BackgroundThreadDataPtr pData )
 {
-	numUnstoppedThreads_ += numThreads;
-	numRunningThreads_ += numThreads;
-
 	for (int i = 0; i < numThreads; ++i)
 	{
+		// Reuse the queue of a thread that has finished, if there is one.
+		int queueIndex = 0;
+
+		while ((queueIndex < numQueues_) && queues_[ queueIndex ]->hasThread())
+		{
+			++queueIndex;
+		}
+
+		if (queueIndex == MAX_THREADS)
+		{
+			ERROR_MSG( "BgTaskManager::startThreads: "
+					"Cannot run more than %d threads\n", MAX_THREADS );
+			break;
+		}
+
+		if (queueIndex == numQueues_)
+		{
+			queues_[ queueIndex ] = new WorkQueue();
+
+			// The queue must be constructed before other threads can see it.
+			memory_barrier();
+			numQueues_ = queueIndex + 1;
+		}
+
+		WorkQueue & queue = *queues_[ queueIndex ];
+		queue.hasThread( true );
+		queue.isStopping( false );
+		queue.isActive( true );
+
+		++numUnstoppedThreads_;
+		++numRunningThreads_;
+
 		// This object deletes itself
 		BackgroundTaskThread * pThread =
-			new BackgroundTaskThread( *this, pData );
+			new BackgroundTaskThread( *this, pData, queueIndex );
 
 #ifdef _WIN32
 		Profiler::instance().addThread( pThread->handle(), "Background Task" );
@@ -387,13 +543,25 @@ void BgTaskManager::stopAll( bool discardPendingTasks, bool waitForThreads )
 {
 	if (discardPendingTasks)
 	{
-		bgTaskList_.clear();
+		sharedQueue_.clear();
 	}
 
-	for (int i = 0; i < numUnstoppedThreads_; ++i)
+	for (int i = 0; i < numQueues_; ++i)
 	{
-		// NULL indicates that a thread should shut down.
-		bgTaskList_.push( NULL );
+		WorkQueue & queue = *queues_[ i ];
+
+		if (discardPendingTasks)
+		{
+			queue.clear();
+		}
+
+		// Threads finish once they cannot find any more work.
+		if (queue.isActive())
+		{
+			queue.isActive( false );
+			queue.isStopping( true );
+			queue.wake();
+		}
 	}
 
 	numUnstoppedThreads_ = 0;
@@ -436,19 +604,109 @@ void BgTaskManager::addBackgroundTask( BackgroundTaskPtr pTask, int priority )
 #ifdef FORCE_MAIN_THREAD
 	pTask->doBackgroundTask( *this, NULL );
 #else
-	bgTaskList_.push( pTask, priority );
+	bool isIdle = false;
+	this->chooseQueue( isIdle ).push( pTask, laneFor( priority ),
+		this->nextSequence() );
+
+	// If the task went to a busy thread, make sure that an idle thread knows
+	// that there is something to take. This pairs with the barrier in
+	// pullBackgroundTask so that either the idle thread sees the task or this
+	// thread sees that it is idle.
+	if (!isIdle)
+	{
+		memory_barrier();
+		this->wakeIdleThread();
+	}
 #endif
 }
 
 
 /**
- *	This method adds a task that should be processed by a background thread.
+ *	This method returns the number to give a new task. It may be called from
+ *	any thread.
+ */
+uint32 BgTaskManager::nextSequence()
+{
+	uint32 sequence;
+
+	do
+	{
+		sequence = nextSequence_;
+	}
+	while (!atomic_swap( nextSequence_, sequence, sequence + 1 ));
+
+	return sequence;
+}
+
+
+/**
+ *	This method chooses the queue that a new task should be added to. Idle
+ *	threads are preferred, otherwise the threads are used in turn.
+ *
+ *	@param rIsIdle	Set to whether the owner of the chosen queue is idle.
+ */
+BgTaskManager::WorkQueue & BgTaskManager::chooseQueue( bool & rIsIdle )
+{
+	const int numQueues = numQueues_;
+	const uint32 start = nextQueue_;
+	WorkQueue * pFallback = NULL;
+
+	for (int i = 0; i < numQueues; ++i)
+	{
+		const int index = (start + i) % numQueues;
+		WorkQueue & queue = *queues_[ index ];
+
+		if (queue.isActive())
+		{
+			if (queue.isIdle())
+			{
+				nextQueue_ = index + 1;
+				rIsIdle = true;
+				return queue;
+			}
+
+			if (pFallback == NULL)
+			{
+				nextQueue_ = index + 1;
+				pFallback = &queue;
+			}
+		}
+	}
+
+	rIsIdle = false;
+
+	return pFallback ? *pFallback : sharedQueue_;
+}
+
+
+/**
+ *	This method wakes a thread that is waiting for work, if there is one, so
+ *	that it can take tasks from the other queues.
+ */
+void BgTaskManager::wakeIdleThread()
+{
+	const int numQueues = numQueues_;
+
+	for (int i = 0; i < numQueues; ++i)
+	{
+		WorkQueue & queue = *queues_[ i ];
+
+		if (queue.isActive() && queue.isIdle())
+		{
+			queue.wake();
+			return;
+		}
+	}
+}
+
+
+/**
+ *	This method adds a task that should be processed by the main thread. It may
+ *	be called from any thread.
  */
 void BgTaskManager::addMainThreadTask( BackgroundTaskPtr pTask )
 {
-	fgTaskListMutex_.grab();
-	fgTaskList_.push_back( pTask );
-	fgTaskListMutex_.give();
+	fgTaskQueue_.push( pTask );
 }
 
 
@@ -458,20 +716,47 @@ void BgTaskManager::addMainThreadTask( BackgroundTaskPtr pTask )
  */
 void BgTaskManager::tick()
 {
-	fgTaskListMutex_.grab();
-	fgTaskList_.swap( newTasks_ );
-	fgTaskListMutex_.give();
+	// Take everything that is queued first so that tasks added while these
+	// are being processed wait until the next tick. The vector is swapped out
+	// in case a task calls tick() again.
+	ForegroundTasks tasks;
+	tasks.swap( newTasks_ );
+
+	BackgroundTaskPtr pTask;
+
+	while (fgTaskQueue_.pop( pTask ))
+	{
+		tasks.push_back( pTask );
+	}
 
-	ForegroundTaskList::iterator iter = newTasks_.begin();
+	ForegroundTasks::iterator iter = tasks.begin();
 
-	while (iter != newTasks_.end())
+	while (iter != tasks.end())
 	{
 		(*iter)->doMainThreadTask( *this );
 
 		++iter;
 	}
 
-	newTasks_.clear();
+	tasks.clear();
+	newTasks_.swap( tasks );
+}
+
+
+/**
+ *	This method returns the number of tasks that are waiting to be processed by
+ *	a background thread.
+ */
+int BgTaskManager::numQueuedTasks() const
+{
+	int numTasks = sharedQueue_.size();
+
+	for (int i = 0; i < numQueues_; ++i)
+	{
+		numTasks += queues_[ i ]->size();
+	}
+
+	return numTasks;
 }
 
 
@@ -480,6 +765,17 @@ void BgTaskManager::tick()
  */
 void BgTaskManager::onThreadFinished( BackgroundTaskThread * pThread )
 {
+	WorkQueue & queue = *queues_[ pThread->queueIndex() ];
+	queue.hasThread( false );
+
+	// Anything added after the thread last looked is picked up by the
+	// remaining threads.
+	if (queue.size() > 0)
+	{
+		queue.moveTo( sharedQueue_ );
+		this->wakeIdleThread();
+	}
+
 	--numRunningThreads_;
 	delete pThread;
 	TRACE_MSG( "BgTaskManager::onThreadFinished: "
@@ -488,12 +784,98 @@ void BgTaskManager::onThreadFinished( BackgroundTaskThread * pThread )
 
 
 /**
- *	This method pulls a task from the list of background tasks in a thread-safe
- *	way. It waits on a semaphore if no tasks exist.
+ *	This method pulls a task for a background thread. It waits for a task to be
+ *	added if there are none to pull.
+ *
+ *	@param queueIndex	The index of the calling thread's queue.
+ *
+ *	@return The task to process, or NULL if the thread should finish.
+ */
+BackgroundTaskPtr BgTaskManager::pullBackgroundTask( int queueIndex )
+{
+	WorkQueue & queue = *queues_[ queueIndex ];
+
+	while (true)
+	{
+		BackgroundTaskPtr pTask = this->findTask( queueIndex );
+
+		if (pTask)
+		{
+			return pTask;
+		}
+
+		// Look once more after being marked as idle so that a task added by a
+		// thread that did not see the flag is not missed.
+		queue.isIdle( true );
+		memory_barrier();
+
+		pTask = this->findTask( queueIndex );
+
+		if (pTask || queue.isStopping())
+		{
+			queue.isIdle( false );
+			return pTask;
+		}
+
+		queue.wait();
+		queue.isIdle( false );
+	}
+}
+
+
+/**
+ *	This method finds the next task for a background thread. This is the
+ *	lowest numbered task at the front of the first non-empty lane of any queue,
+ *	so that tasks in the same band are pulled in the order they were added.
  */
-BackgroundTaskPtr BgTaskManager::pullBackgroundTask()
+BackgroundTaskPtr BgTaskManager::findTask( int queueIndex )
 {
-	return bgTaskList_.pull();
+	const int numQueues = numQueues_;
+
+	for (int lane = 0; lane < NUM_LANES; ++lane)
+	{
+		// Another thread may take the chosen task first, so look again while
+		// the lane has tasks.
+		while (true)
+		{
+			WorkQueue * pOldest = NULL;
+			uint32 oldestSequence = 0;
+
+			// Start with the thread's own queue so that it wins ties.
+			for (int i = 0; i <= numQueues; ++i)
+			{
+				WorkQueue * pQueue = (i < numQueues) ?
+					queues_[ (queueIndex + i) % numQueues ] : &sharedQueue_;
+
+				if (pQueue->isEmpty( lane ))
+				{
+					continue;
+				}
+
+				const uint32 sequence = pQueue->frontSequence( lane );
+
+				if (!pOldest || (int32( sequence - oldestSequence ) < 0))
+				{
+					pOldest = pQueue;
+					oldestSequence = sequence;
+				}
+			}
+
+			if (!pOldest)
+			{
+				break;
+			}
+
+			BackgroundTaskPtr pTask = pOldest->pop( lane, oldestSequence );
+
+			if (pTask)
+			{
+				return pTask;
+			}
+		}
+	}
+
+	return NULL;
 }
 
 // bgtask_manager.cpp
@@ -12,10 +12,12 @@ criminal penalties as provided by law.
 #ifndef BGTASK_MANAGER_HPP
 #define BGTASK_MANAGER_HPP
 
-#include <list>
+#include <deque>
+#include <vector>
 
 #include "cstdmf/concurrency.hpp"
 #include "cstdmf/debug.hpp"
+#include "cstdmf/mpsc_queue.hpp"
 #include "cstdmf/smartpointer.hpp"
 
 class BgTaskManager;
@@ -102,17 +104,22 @@ class BackgroundTaskThread : public SimpleThread
 {
 public:
 	BackgroundTaskThread( BgTaskManager & mgr,
-			BackgroundThreadDataPtr pData );
+			BackgroundThreadDataPtr pData, int queueIndex = 0 );
 
 	BackgroundThreadDataPtr pData() const			{ return pData_; }
 	void pData( BackgroundThreadDataPtr pData ) 	{ pData_ = pData; }
 
+	int queueIndex() const							{ return queueIndex_; }
+
 private:
 	static void s_start( void * arg );
 	void run();
 
 	BgTaskManager & mgr_;
 	BackgroundThreadDataPtr pData_;
+
+	// The index of the work queue owned by this thread.
+	int queueIndex_;
 };
 
 
@@ -164,6 +171,17 @@ private:
  *	This class defines a background task manager that manages a pool
  *	of working threads. BackgroundTask objects are added to be processed by a
  *	background thread and then, possibly by the main thread again.
+ *
+ *	Each thread owns a work queue with a lane for each priority band. New tasks
+ *	are given to an idle thread where possible. Tasks in a higher band are
+ *	always pulled before tasks in a lower band. Tasks in the same band are
+ *	pulled in the order they were added, whichever queue they were given to,
+ *	since each task is numbered as it is added and a thread always pulls the
+ *	lowest numbered task at the front of any queue. Exact priority values
+ *	within a band are not ordered.
+ *
+ *	Tasks added with addMainThreadTask are passed back to the main thread on a
+ *	lock-free queue that is emptied by tick().
  */
 class BgTaskManager
 {
@@ -217,9 +235,11 @@ public:
 	static BgTaskManager & instance();
 	static void fini();
 
+	int numQueuedTasks() const;
+
 	// Used by background tasks.
 	void onThreadFinished( BackgroundTaskThread * pThread ); // In main thread
-	BackgroundTaskPtr pullBackgroundTask(); // In background thread
+	BackgroundTaskPtr pullBackgroundTask( int queueIndex ); // In background thread
 
 	#ifdef _WIN32
 	const std::vector<HANDLE> & getThreadHandles() { return threadHandles_; }
@@ -228,27 +248,117 @@ public:
 private:
 	static BgTaskManager		* s_instance_;
 
-	class BackgroundTaskList
+	/// The maximum number of threads that can be running at once.
+	static const int MAX_THREADS = 64;
+
+	/// The number of priority bands. See laneFor().
+	static const int NUM_LANES = 4;
+
+	static int laneFor( int priority );
+
+	/**
+	 *	This class is the queue of tasks owned by a single background thread.
+	 *	Each lane is kept in the order that its tasks were numbered. Any thread
+	 *	may pull from the front of a lane.
+	 */
+	class WorkQueue
 	{
 	public:
-		void push( BackgroundTaskPtr pTask, int priority = DEFAULT );
-		BackgroundTaskPtr pull();
-		bool isEmpty();
+		WorkQueue();
+
+		void push( BackgroundTaskPtr pTask, int lane, uint32 sequence );
+		BackgroundTaskPtr pop( int lane, uint32 sequence );
+		void moveTo( WorkQueue & other );
 		void clear();
 
+		void wait();
+		void wake()						{ semaphore_.push(); }
+
+		bool isEmpty( int lane ) const	{ return sizes_[ lane ] == 0; }
+		uint32 frontSequence( int lane ) const
+										{ return frontSequences_[ lane ]; }
+		int size() const;
+
+		bool isActive() const			{ return isActive_; }
+		void isActive( bool value )		{ isActive_ = value; }
+
+		bool isStopping() const			{ return isStopping_; }
+		void isStopping( bool value )	{ isStopping_ = value; }
+
+		bool isIdle() const				{ return isIdle_; }
+		void isIdle( bool value )		{ isIdle_ = value; }
+
+		bool hasThread() const			{ return hasThread_; }
+		void hasThread( bool value )	{ hasThread_ = value; }
+
 	private:
-		typedef std::list< std::pair< int, BackgroundTaskPtr > > List;
-		List list_;
+		/**
+		 *	This structure is a task in a lane, along with the number it was
+		 *	given when it was added.
+		 */
+		struct QueuedTask
+		{
+			BackgroundTaskPtr pTask;
+			uint32 sequence;
+		};
+
+		typedef std::deque< QueuedTask > Lane;
+		Lane lanes_[ NUM_LANES ];
+
+		void updateLane( int lane );
+
+		// The size of each lane and the number of the task at its front.
+		// These can be read without holding the mutex to choose a lane to
+		// pull from.
+		volatile int sizes_[ NUM_LANES ];
+		volatile uint32 frontSequences_[ NUM_LANES ];
+
 		SimpleMutex mutex_;
+
+		// Pushed once for each task added to this queue. The owning thread
+		// waits on this when it cannot find any work.
 		SimpleSemaphore semaphore_;
+
+		// Whether new tasks may be given to this queue.
+		volatile bool isActive_;
+
+		// Whether the owning thread should stop once there is no work left.
+		volatile bool isStopping_;
+
+		// Whether the owning thread is waiting for work.
+		volatile bool isIdle_;
+
+		// Whether a thread currently owns this queue. Only used by the main
+		// thread.
+		bool hasThread_;
 	};
 
-	BackgroundTaskList	bgTaskList_;
+	WorkQueue & chooseQueue( bool & rIsIdle );
+	void wakeIdleThread();
+	BackgroundTaskPtr findTask( int queueIndex );
+	uint32 nextSequence();
+
+	WorkQueue * queues_[ MAX_THREADS ];
+	volatile int numQueues_;
+
+	// Holds tasks added while there are no running threads and tasks left
+	// behind by threads that have finished. All threads pull from this.
+	WorkQueue sharedQueue_;
+
+	// Where to start looking when choosing a queue for a new task. This is only
+	// a hint so it is not updated atomically.
+	volatile uint32 nextQueue_;
+
+	// The number to give the next task added. Numbers may wrap around, so
+	// they are compared by their difference.
+	volatile uint32 nextSequence_;
+
+	// Tasks waiting to be run in the main thread.
+	UnboundedMPSCQueue< BackgroundTaskPtr > fgTaskQueue_;
 
-	typedef std::list< BackgroundTaskPtr > ForegroundTaskList;
-	ForegroundTaskList fgTaskList_;
-	ForegroundTaskList newTasks_;
-	SimpleMutex fgTaskListMutex_;
+	// The tasks being run by the current tick(). Only used by the main thread.
+	typedef std::vector< BackgroundTaskPtr > ForegroundTasks;
+	ForegroundTasks newTasks_;
 
 	int numRunningThreads_;
 	int numUnstoppedThreads_;
@@ -62,6 +62,15 @@ inline unsigned long OurThreadID()
 	return (unsigned long)(GetCurrentThreadId());
 }
 
+/**
+ *	This function stops the compiler and the processor from reordering memory
+ *	accesses across it.
+ */
+inline void memory_barrier()
+{
+	MemoryBarrier();
+}
+
 inline uint getNumCores()
 {
 	static uint count;
@@ -209,11 +218,19 @@ inline char atomic_swap( void *& dst, void * curVal, void * newVal )
 #else
 inline char atomic_swap( void *& dst, void * curVal, void * newVal )
 {
-	InterlockedExchange( (volatile long *)&dst, (long)newVal );
-	return 1;
+	return InterlockedCompareExchangePointer( &dst, newVal, curVal ) == curVal;
 }
 #endif
 
+/**
+ *	Swaps dst for newVal if it is still curVal. Returns true if swapped.
+ */
+inline char atomic_swap( volatile uint32 & dst, uint32 curVal, uint32 newVal )
+{
+	return InterlockedCompareExchange( (volatile long *)&dst,
+		(long)newVal, (long)curVal ) == (long)curVal;
+}
+
 
 #if BWCLIENT_AS_PYTHON_MODULE
 
@@ -608,6 +625,50 @@ inline bool atomic_swap( void *& dst, void * curVal, void * newVal )
 
 #endif
 
+/**
+ *	Swaps dst for newVal if it is still curVal. Returns true if swapped.
+ */
+
+#if defined( PLAYSTATION3 )
+
+inline bool atomic_swap( volatile uint32 & dst, uint32 curVal, uint32 newVal )
+{
+	return cellAtomicCompareAndSwap32(
+		(uint32_t *)&dst, curVal, newVal ) == curVal;
+}
+
+#else
+
+inline bool atomic_swap( volatile uint32 & dst, uint32 curVal, uint32 newVal )
+{
+	char ret;
+
+	__asm__ volatile (
+			"lock cmpxchgl %3, %1\n\t"	// (atomically) Compare and Exchange
+			"setz %0\n"
+		:	"=q"	(ret),		// %0 is ret on output
+			"+m"	(dst),		// %1 is dst
+			"+a"	(curVal)	// eax is curVal, and is changed on failure
+		:	"r"		(newVal)	// %3 is newVal on input
+		: "memory", "cc" );
+	return ret;
+}
+
+#endif
+
+/**
+ *	This function stops the compiler and the processor from reordering memory
+ *	accesses across it.
+ */
+inline void memory_barrier()
+{
+#if defined( PLAYSTATION3 )
+	__asm__ volatile ( "sync" : : : "memory" );
+#else
+	__asm__ volatile ( "mfence" : : : "memory" );
+#endif
+}
+
 #endif // _WIN32
 
 /**
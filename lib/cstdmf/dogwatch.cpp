@@ -15,6 +15,7 @@ criminal penalties as provided by law.
 #include "dogwatch.hpp"
 
 #include "debug.hpp"
+#include "trace_buffer.hpp"
 
 #include <string.h>
 
@@ -78,6 +79,10 @@ DogWatchManager::DogWatchManager()
 	// clear the cache
 	this->clearCache();
 
+	// mark the frame boundary while no watches are running, so that the
+	//  traced scopes nest inside it
+	TraceBuffer::tick();
+
 	// start the frame timer
 	slice_ = 0;
 	frameStart_ = timestamp();
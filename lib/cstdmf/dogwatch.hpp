@@ -22,6 +22,7 @@ criminal penalties as provided by law.
 #include "cstdmf/stdmf.hpp"
 #include "cstdmf/smartpointer.hpp"
 #include "cstdmf/timestamp.hpp"
+#include "cstdmf/trace_buffer.hpp"
 #include "cstdmf/profiler.hpp"
 #include "cstdmf/debug.hpp"
 #include <string>
@@ -26,6 +26,8 @@ inline void DogWatch::start()
 	if ( id_ < 0 )
 		return;
 
+	TraceBuffer::begin( title_.c_str() );
+
 	pSlice_ = &DogWatchManager::pInstance->grabSlice( id_ );
 	started_ = timestamp();
 #endif
@@ -54,6 +56,8 @@ inline void DogWatch::stop()
 	(*pSlice_) += timestamp() - started_;
 	DogWatchManager::pInstance->giveSlice();
 
+	TraceBuffer::end( title_.c_str() );
+
 #endif
 }
 
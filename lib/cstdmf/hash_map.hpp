@@ -0,0 +1,712 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef HASH_MAP_HPP
+#define HASH_MAP_HPP
+
+#include "stdmf.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <string>
+#include <utility>
+
+// -----------------------------------------------------------------------------
+// Section: Hash functions
+// -----------------------------------------------------------------------------
+
+/*
+ *	HashMap finds the hash of a key by calling hashMapHash( key ). To use a
+ *	class as a key, declare a hashMapHash() for it in the class's namespace.
+ *	The result does not need to be well distributed, since HashMap mixes it
+ *	before use.
+ */
+inline uint32 hashMapHash( int32 value )	{ return uint32( value ); }
+inline uint32 hashMapHash( uint32 value )	{ return value; }
+
+inline uint32 hashMapHash( int64 value )
+{
+	return uint32( value ) ^ uint32( uint64( value ) >> 32 );
+}
+
+inline uint32 hashMapHash( uint64 value )
+{
+	return uint32( value ) ^ uint32( value >> 32 );
+}
+
+inline uint32 hashMapHash( const void * value )
+{
+	return hashMapHash( uint64( size_t( value ) ) );
+}
+
+/**
+ *	This function returns the FNV-1a hash of a string.
+ */
+inline uint32 hashMapHash( const std::string & value )
+{
+	uint32 hash = 2166136261U;
+
+	for (std::string::const_iterator iter = value.begin();
+			iter != value.end(); ++iter)
+	{
+		hash = (hash ^ uint8( *iter )) * 16777619U;
+	}
+
+	return hash;
+}
+
+
+/**
+ *	This is the default hash function object of HashMap.
+ */
+template <class KEY>
+struct HashMapHash
+{
+	uint32 operator()( const KEY & key ) const
+	{
+		return hashMapHash( key );
+	}
+};
+
+
+// -----------------------------------------------------------------------------
+// Section: HashMapIterator
+// -----------------------------------------------------------------------------
+
+template <class KEY, class VALUE, class HASH, class EQUAL> class HashMap;
+
+/**
+ *	This class is the iterator of HashMap. VALUE_TYPE is the value_type of the
+ *	map, made const for a const_iterator.
+ */
+template <class VALUE_TYPE>
+class HashMapIterator
+{
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef VALUE_TYPE value_type;
+	typedef ptrdiff_t difference_type;
+	typedef VALUE_TYPE * pointer;
+	typedef VALUE_TYPE & reference;
+
+	HashMapIterator() : values_( NULL ), distances_( NULL ), index_( 0 ) {}
+
+	HashMapIterator( VALUE_TYPE * values, const int8 * distances,
+			size_t index ) :
+		values_( values ),
+		distances_( distances ),
+		index_( index )
+	{
+	}
+
+	/// This allows an iterator to be converted to a const_iterator.
+	template <class OTHER>
+	HashMapIterator( const HashMapIterator< OTHER > & other ) :
+		values_( other.values() ),
+		distances_( other.distances() ),
+		index_( other.index() )
+	{
+	}
+
+	reference operator*() const			{ return values_[ index_ ]; }
+	pointer operator->() const			{ return values_ + index_; }
+
+	HashMapIterator & operator++()
+	{
+		// The slot after the last one is never empty, so this stops there.
+		do
+		{
+			++index_;
+		}
+		while (distances_[ index_ ] < 0);
+
+		return *this;
+	}
+
+	HashMapIterator operator++( int )
+	{
+		HashMapIterator result = *this;
+		++*this;
+		return result;
+	}
+
+	template <class OTHER>
+	bool operator==( const HashMapIterator< OTHER > & other ) const
+	{
+		return index_ == other.index();
+	}
+
+	template <class OTHER>
+	bool operator!=( const HashMapIterator< OTHER > & other ) const
+	{
+		return index_ != other.index();
+	}
+
+	VALUE_TYPE * values() const			{ return values_; }
+	const int8 * distances() const		{ return distances_; }
+	size_t index() const				{ return index_; }
+
+private:
+	VALUE_TYPE * values_;
+	const int8 * distances_;
+	size_t index_;
+};
+
+
+// -----------------------------------------------------------------------------
+// Section: HashMap
+// -----------------------------------------------------------------------------
+
+/**
+ *	This class is an open-addressing hash map. It supports the commonly used
+ *	subset of the std::map interface and is much faster than std::map for
+ *	lookups by small keys such as EntityID or Mercury::Address.
+ *
+ *	Elements are stored in a single array using Robin Hood linear probing.
+ *	Each slot records how far its element is from the slot it hashed to, and
+ *	an insert takes the slot of any element that is closer to its own slot
+ *	than the new element is. This keeps probe sequences short and lets a
+ *	lookup stop as soon as it passes where its key would have been.
+ *
+ *	Probing does not wrap around. Instead, the array has maxProbe_ extra slots
+ *	after the last bucket, and the map grows if an element would need to be
+ *	further than that from its bucket.
+ *
+ *	Unlike std::map, the elements are not ordered, and insert() and erase()
+ *	invalidate all iterators and references to elements. erase( iterator )
+ *	returns the iterator that follows the erased element so that elements
+ *	can be erased while iterating.
+ */
+template <class KEY, class VALUE, class HASH = HashMapHash< KEY >,
+	class EQUAL = std::equal_to< KEY > >
+class HashMap
+{
+public:
+	typedef KEY key_type;
+	typedef VALUE mapped_type;
+	typedef std::pair< const KEY, VALUE > value_type;
+	typedef size_t size_type;
+	typedef HashMapIterator< value_type > iterator;
+	typedef HashMapIterator< const value_type > const_iterator;
+
+	HashMap();
+	HashMap( const HashMap & other );
+	~HashMap();
+
+	HashMap & operator=( const HashMap & other );
+
+	iterator begin()				{ return this->iteratorFrom( 0 ); }
+	const_iterator begin() const	{ return this->iteratorFrom( 0 ); }
+
+	iterator end()
+	{
+		return iterator( values_, distances_, numSlots_ );
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator( values_, distances_, numSlots_ );
+	}
+
+	bool empty() const				{ return size_ == 0; }
+	size_type size() const			{ return size_; }
+
+	void clear();
+	void reserve( size_type size );
+	void swap( HashMap & other );
+
+	iterator find( const KEY & key )
+	{
+		return iterator( values_, distances_, this->findIndex( key ) );
+	}
+
+	const_iterator find( const KEY & key ) const
+	{
+		return const_iterator( values_, distances_, this->findIndex( key ) );
+	}
+
+	size_type count( const KEY & key ) const
+	{
+		return (this->findIndex( key ) != numSlots_) ? 1 : 0;
+	}
+
+	std::pair< iterator, bool > insert( const value_type & value );
+	VALUE & operator[]( const KEY & key );
+
+	iterator erase( iterator iter );
+	size_type erase( const KEY & key );
+
+private:
+	enum { MIN_BUCKETS = 8 };
+
+	/// The number of elements a map can hold before it grows.
+	static size_t maxSizeFor( size_t numBuckets )
+	{
+		return numBuckets - numBuckets/8;
+	}
+
+	iterator iteratorFrom( size_t index ) const
+	{
+		// The slot after the last one is never empty, so this stops there.
+		while (distances_[ index ] < 0)
+		{
+			++index;
+		}
+
+		return iterator( values_, distances_, index );
+	}
+
+	size_t bucketFor( const KEY & key ) const
+	{
+		// Fibonacci hashing spreads out keys that differ only in their high
+		// or low bits, such as sequential IDs or addresses in the same subnet.
+		return (hash_( key ) * 2654435769U) >> shift_;
+	}
+
+	size_t findIndex( const KEY & key ) const;
+	size_t insertNew( const KEY & key, const VALUE & value );
+	void rehash( size_t numBuckets );
+
+	void construct( size_t index, const KEY & key, const VALUE & value,
+		int distance )
+	{
+		new (values_ + index) value_type( key, value );
+		distances_[ index ] = int8( distance );
+	}
+
+	void destroy( size_t index )
+	{
+		values_[ index ].~value_type();
+		distances_[ index ] = -1;
+	}
+
+	static int8 * emptyDistances()
+	{
+		// A map with no slots still needs the slot after the last one.
+		static int8 s_distances[1] = { 0 };
+		return s_distances;
+	}
+
+	value_type * values_;
+
+	// The distance of each element from its bucket, or -1 if the slot is
+	// empty. There is one extra entry that is always 0 to stop iteration.
+	int8 * distances_;
+
+	size_t numBuckets_;
+	size_t numSlots_;
+	size_t size_;
+	int maxProbe_;
+	int shift_;
+
+	HASH hash_;
+	EQUAL equal_;
+};
+
+
+/**
+ *	Constructor.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+HashMap< KEY, VALUE, HASH, EQUAL >::HashMap() :
+	values_( NULL ),
+	distances_( emptyDistances() ),
+	numBuckets_( 0 ),
+	numSlots_( 0 ),
+	size_( 0 ),
+	maxProbe_( 0 ),
+	shift_( 32 )
+{
+}
+
+
+/**
+ *	Copy constructor.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+HashMap< KEY, VALUE, HASH, EQUAL >::HashMap( const HashMap & other ) :
+	values_( NULL ),
+	distances_( emptyDistances() ),
+	numBuckets_( 0 ),
+	numSlots_( 0 ),
+	size_( 0 ),
+	maxProbe_( 0 ),
+	shift_( 32 ),
+	hash_( other.hash_ ),
+	equal_( other.equal_ )
+{
+	this->reserve( other.size() );
+
+	for (const_iterator iter = other.begin(); iter != other.end(); ++iter)
+	{
+		this->insertNew( iter->first, iter->second );
+	}
+}
+
+
+/**
+ *	Destructor.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+HashMap< KEY, VALUE, HASH, EQUAL >::~HashMap()
+{
+	this->clear();
+
+	if (numSlots_ != 0)
+	{
+		::operator delete( values_ );
+		delete [] distances_;
+	}
+}
+
+
+/**
+ *	Assignment operator.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+HashMap< KEY, VALUE, HASH, EQUAL > &
+	HashMap< KEY, VALUE, HASH, EQUAL >::operator=( const HashMap & other )
+{
+	if (this != &other)
+	{
+		HashMap copy( other );
+		this->swap( copy );
+	}
+
+	return *this;
+}
+
+
+/**
+ *	This method removes all elements. The memory used by the slots is kept.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+void HashMap< KEY, VALUE, HASH, EQUAL >::clear()
+{
+	for (size_t i = 0; (i < numSlots_) && (size_ > 0); ++i)
+	{
+		if (distances_[i] >= 0)
+		{
+			this->destroy( i );
+			--size_;
+		}
+	}
+}
+
+
+/**
+ *	This method makes room for at least the given number of elements, so that
+ *	inserting them does not need to grow the map.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+void HashMap< KEY, VALUE, HASH, EQUAL >::reserve( size_type size )
+{
+	size_t numBuckets = std::max( numBuckets_, size_t( MIN_BUCKETS ) );
+
+	while (maxSizeFor( numBuckets ) < size)
+	{
+		numBuckets *= 2;
+	}
+
+	if (numBuckets != numBuckets_)
+	{
+		this->rehash( numBuckets );
+	}
+}
+
+
+/**
+ *	This method swaps the contents of this map with another.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+void HashMap< KEY, VALUE, HASH, EQUAL >::swap( HashMap & other )
+{
+	std::swap( values_, other.values_ );
+	std::swap( distances_, other.distances_ );
+	std::swap( numBuckets_, other.numBuckets_ );
+	std::swap( numSlots_, other.numSlots_ );
+	std::swap( size_, other.size_ );
+	std::swap( maxProbe_, other.maxProbe_ );
+	std::swap( shift_, other.shift_ );
+	std::swap( hash_, other.hash_ );
+	std::swap( equal_, other.equal_ );
+}
+
+
+/**
+ *	This method inserts a copy of a value if there is no element with its key.
+ *
+ *	@return	The element with the value's key, and whether it was inserted.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+std::pair< typename HashMap< KEY, VALUE, HASH, EQUAL >::iterator, bool >
+	HashMap< KEY, VALUE, HASH, EQUAL >::insert( const value_type & value )
+{
+	const size_t index = this->findIndex( value.first );
+
+	if (index != numSlots_)
+	{
+		return std::make_pair(
+			iterator( values_, distances_, index ), false );
+	}
+
+	const size_t newIndex = this->insertNew( value.first, value.second );
+
+	return std::make_pair( iterator( values_, distances_, newIndex ), true );
+}
+
+
+/**
+ *	This method returns the value with the given key, inserting a default
+ *	constructed value if there is none.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+VALUE & HashMap< KEY, VALUE, HASH, EQUAL >::operator[]( const KEY & key )
+{
+	size_t index = this->findIndex( key );
+
+	if (index == numSlots_)
+	{
+		index = this->insertNew( key, VALUE() );
+	}
+
+	return values_[ index ].second;
+}
+
+
+/**
+ *	This method removes an element.
+ *
+ *	@return An iterator to the element after the one removed.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+typename HashMap< KEY, VALUE, HASH, EQUAL >::iterator
+	HashMap< KEY, VALUE, HASH, EQUAL >::erase( iterator iter )
+{
+	const size_t erasedIndex = iter.index();
+	size_t index = erasedIndex;
+
+	this->destroy( index );
+	--size_;
+
+	// Shift back the following elements that are not in their own bucket, so
+	// that there is no gap in their probe sequences. Moved elements come from
+	// after the erased one, so iteration does not miss or repeat them.
+	size_t next = index + 1;
+
+	while (distances_[ next ] > 0)
+	{
+		this->construct( index, values_[ next ].first,
+			values_[ next ].second, distances_[ next ] - 1 );
+		this->destroy( next );
+
+		index = next;
+		++next;
+	}
+
+	return this->iteratorFrom( erasedIndex );
+}
+
+
+/**
+ *	This method removes the element with the given key, if there is one.
+ *
+ *	@return The number of elements removed.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+typename HashMap< KEY, VALUE, HASH, EQUAL >::size_type
+	HashMap< KEY, VALUE, HASH, EQUAL >::erase( const KEY & key )
+{
+	const size_t index = this->findIndex( key );
+
+	if (index == numSlots_)
+	{
+		return 0;
+	}
+
+	this->erase( iterator( values_, distances_, index ) );
+
+	return 1;
+}
+
+
+/**
+ *	This method returns the slot of the element with the given key, or
+ *	numSlots_ if there is none.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+size_t HashMap< KEY, VALUE, HASH, EQUAL >::findIndex( const KEY & key ) const
+{
+	if (size_ == 0)
+	{
+		return numSlots_;
+	}
+
+	size_t index = this->bucketFor( key );
+
+	// Elements further from their bucket than the current distance would have
+	// been displaced by the key, so the search can stop at the first slot
+	// with a smaller distance. Empty slots and the end have distances less
+	// than any this search can reach.
+	for (int distance = 0; distances_[ index ] >= distance;
+			++distance, ++index)
+	{
+		if (equal_( values_[ index ].first, key ))
+		{
+			return index;
+		}
+	}
+
+	return numSlots_;
+}
+
+
+/**
+ *	This method inserts an element whose key is not in the map.
+ *
+ *	@return The slot of the new element.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+size_t HashMap< KEY, VALUE, HASH, EQUAL >::insertNew( const KEY & key,
+	const VALUE & value )
+{
+	if (size_ >= maxSizeFor( numBuckets_ ))
+	{
+		this->rehash( std::max( numBuckets_ * 2, size_t( MIN_BUCKETS ) ) );
+	}
+
+	size_t index = this->bucketFor( key );
+	int distance = 0;
+
+	while (distances_[ index ] >= distance)
+	{
+		++index;
+		++distance;
+	}
+
+	if (distance > maxProbe_)
+	{
+		this->rehash( numBuckets_ * 2 );
+		return this->insertNew( key, value );
+	}
+
+	if (distances_[ index ] < 0)
+	{
+		this->construct( index, key, value, distance );
+		++size_;
+		return index;
+	}
+
+	// Take the slot from an element that is closer to its bucket, and carry
+	// that element on to the next slot it can take.
+	const size_t result = index;
+
+	std::pair< KEY, VALUE > carried( values_[ index ].first,
+		values_[ index ].second );
+	int carriedDistance = distances_[ index ];
+
+	this->destroy( index );
+	this->construct( index, key, value, distance );
+	++size_;
+
+	for (;;)
+	{
+		++index;
+		++carriedDistance;
+
+		if (carriedDistance > maxProbe_)
+		{
+			this->rehash( numBuckets_ * 2 );
+			this->insertNew( carried.first, carried.second );
+			return this->findIndex( key );
+		}
+
+		if (distances_[ index ] < 0)
+		{
+			this->construct( index, carried.first, carried.second,
+				carriedDistance );
+			return result;
+		}
+
+		if (distances_[ index ] < carriedDistance)
+		{
+			std::pair< KEY, VALUE > next( values_[ index ].first,
+				values_[ index ].second );
+			const int nextDistance = distances_[ index ];
+
+			this->destroy( index );
+			this->construct( index, carried.first, carried.second,
+				carriedDistance );
+
+			carried = next;
+			carriedDistance = nextDistance;
+		}
+	}
+}
+
+
+/**
+ *	This method moves the elements into a new array with the given number of
+ *	buckets.
+ */
+template <class KEY, class VALUE, class HASH, class EQUAL>
+void HashMap< KEY, VALUE, HASH, EQUAL >::rehash( size_t numBuckets )
+{
+	value_type * oldValues = values_;
+	int8 * oldDistances = distances_;
+	const size_t oldNumSlots = numSlots_;
+
+	int log2Buckets = 0;
+
+	while ((size_t( 1 ) << log2Buckets) < numBuckets)
+	{
+		++log2Buckets;
+	}
+
+	// Allowing longer probes in larger maps keeps the load factor high. With
+	// a reasonable hash, probes are rarely longer than log2 of the size.
+	numBuckets_ = size_t( 1 ) << log2Buckets;
+	maxProbe_ = std::max( 4, std::min( 2 * log2Buckets, 127 ) );
+	numSlots_ = numBuckets_ + maxProbe_;
+	shift_ = 32 - log2Buckets;
+
+	values_ = static_cast< value_type * >(
+		::operator new( numSlots_ * sizeof( value_type ) ) );
+	distances_ = new int8[ numSlots_ + 1 ];
+
+	for (size_t i = 0; i < numSlots_; ++i)
+	{
+		distances_[i] = -1;
+	}
+
+	distances_[ numSlots_ ] = 0;
+
+	size_ = 0;
+
+	for (size_t i = 0; i < oldNumSlots; ++i)
+	{
+		if (oldDistances[i] >= 0)
+		{
+			this->insertNew( oldValues[i].first, oldValues[i].second );
+			oldValues[i].~value_type();
+		}
+	}
+
+	if (oldNumSlots != 0)
+	{
+		::operator delete( oldValues );
+		delete [] oldDistances;
+	}
+}
+
+#endif // HASH_MAP_HPP
@@ -0,0 +1,911 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "pch.hpp"
+
+#include "heap_profiler.hpp"
+
+#include "concurrency.hpp"
+#include "debug.hpp"
+#include "watcher.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#ifdef unix
+#include <execinfo.h>
+#include <sched.h>
+#endif
+
+DECLARE_DEBUG_COMPONENT2( "CStdMF", 0 )
+
+// The per-thread state is used from inside malloc, so on Linux it must use
+// the initial-exec model. Other models may call malloc on first access.
+#ifdef unix
+#define HEAP_PROFILER_THREADLOCAL( type )								\
+	__thread type __attribute__(( tls_model( "initial-exec" ) ))
+#else
+#define HEAP_PROFILER_THREADLOCAL( type ) THREADLOCAL( type )
+#endif
+
+// -----------------------------------------------------------------------------
+// Section: Sample tables
+// -----------------------------------------------------------------------------
+
+namespace
+{
+
+const int MAX_DEPTH = 32;
+
+// These must be powers of two. The tables are never more than 3/4 full.
+const uint32 MAX_STACKS = 4096;
+const uint32 MAX_LIVE_SAMPLES = 1 << 16;
+const uint32 FILTER_SIZE = 1 << 16;
+
+
+/**
+ *	This structure holds the samples taken with a single call stack.
+ */
+struct StackEntry
+{
+	int depth;
+	void * frames[ MAX_DEPTH ];
+
+	uint32 liveCount;
+	uint64 liveBytes;
+	uint32 totalCount;
+	uint64 totalBytes;
+};
+
+
+/**
+ *	This structure is a sampled allocation that has not yet been freed.
+ */
+struct LiveSample
+{
+	void * ptr;
+	size_t size;
+	uint32 stackIndex;
+};
+
+
+// An entry is unused if its depth or ptr is zero.
+StackEntry s_stacks[ MAX_STACKS ];
+LiveSample s_liveSamples[ MAX_LIVE_SAMPLES ];
+uint32 s_numStacks = 0;
+uint32 s_numDropped = 0;
+
+// The number of live samples in each bucket of pointer hashes. This lets
+// free() skip the lock for nearly every pointer that was not sampled.
+volatile uint16 s_filter[ FILTER_SIZE ];
+
+uint32 s_randomState = 0x2545f491;
+
+// A spin lock protects the tables. It needs no construction or destruction,
+// so it can be used by allocations made before main() or after exit().
+volatile uint32 s_lock = 0;
+
+// Whether the current thread is inside the profiler. Allocations made while
+// this is set, such as by backtrace(), are not sampled.
+HEAP_PROFILER_THREADLOCAL( bool ) s_isBusy = false;
+
+// The number of bytes this thread can allocate before its next sample.
+HEAP_PROFILER_THREADLOCAL( int64 ) s_bytesUntilSample = 0;
+
+
+/**
+ *	This class holds the table lock while it is in scope. s_isBusy must be set
+ *	while it is held, so that an allocation or free by the same thread does not
+ *	try to take it again.
+ */
+class TableLockHolder
+{
+public:
+	TableLockHolder()
+	{
+		while (!atomic_swap( s_lock, 0, 1 ))
+		{
+#ifdef _WIN32
+			Sleep( 0 );
+#else
+			sched_yield();
+#endif
+		}
+	}
+
+	~TableLockHolder()
+	{
+		memory_barrier();
+		s_lock = 0;
+	}
+};
+
+
+inline uint32 hashPointer( void * ptr )
+{
+	// Allocations are at least 8 byte aligned.
+	return uint32( (uintptr( ptr ) >> 3) * 0x9e3779b1U );
+}
+
+
+inline uint32 filterIndex( void * ptr )
+{
+	return hashPointer( ptr ) >> 16;
+}
+
+
+/**
+ *	This function returns the index of the entry for the given call stack,
+ *	adding it if necessary.
+ *
+ *	@return False if the table is full, otherwise true.
+ */
+bool findStack( void ** frames, int depth, uint32 & rIndex )
+{
+	uint32 hash = 2166136261U;
+
+	for (int i = 0; i < depth; ++i)
+	{
+		hash = (hash ^ hashPointer( frames[i] )) * 16777619U;
+	}
+
+	for (uint32 i = hash & (MAX_STACKS - 1); ; i = (i + 1) & (MAX_STACKS - 1))
+	{
+		StackEntry & entry = s_stacks[i];
+
+		if (entry.depth == 0)
+		{
+			if (s_numStacks >= MAX_STACKS/4 * 3)
+			{
+				return false;
+			}
+
+			entry.depth = depth;
+			memcpy( entry.frames, frames, depth * sizeof( void * ) );
+			++s_numStacks;
+
+			rIndex = i;
+			return true;
+		}
+
+		if ((entry.depth == depth) &&
+			(memcmp( entry.frames, frames, depth * sizeof( void * ) ) == 0))
+		{
+			rIndex = i;
+			return true;
+		}
+	}
+}
+
+
+/**
+ *	This function removes a live sample, shifting back any entries after it
+ *	that would no longer be found.
+ */
+void eraseLiveSample( uint32 index )
+{
+	const uint32 MASK = MAX_LIVE_SAMPLES - 1;
+
+	uint32 hole = index;
+	uint32 next = index;
+
+	while (true)
+	{
+		next = (next + 1) & MASK;
+		void * ptr = s_liveSamples[ next ].ptr;
+
+		if (ptr == NULL)
+		{
+			break;
+		}
+
+		const uint32 home = hashPointer( ptr ) & MASK;
+
+		// Leave the entry if its home is cyclically within (hole, next].
+		const bool isInPlace = (hole <= next) ?
+			((hole < home) && (home <= next)) :
+			((hole < home) || (home <= next));
+
+		if (!isInPlace)
+		{
+			s_liveSamples[ hole ] = s_liveSamples[ next ];
+			hole = next;
+		}
+	}
+
+	s_liveSamples[ hole ].ptr = NULL;
+}
+
+
+/**
+ *	This function adds a live sample and counts it against its call stack. The
+ *	table must not be full.
+ */
+void insertLiveSample( void * ptr, size_t size, uint32 stackIndex )
+{
+	const uint32 MASK = MAX_LIVE_SAMPLES - 1;
+	uint32 index = hashPointer( ptr ) & MASK;
+
+	while (s_liveSamples[ index ].ptr != NULL)
+	{
+		index = (index + 1) & MASK;
+	}
+
+	LiveSample & sample = s_liveSamples[ index ];
+	sample.ptr = ptr;
+	sample.size = size;
+	sample.stackIndex = stackIndex;
+
+	StackEntry & stack = s_stacks[ stackIndex ];
+	++stack.liveCount;
+	stack.liveBytes += size;
+
+	++s_filter[ filterIndex( ptr ) ];
+}
+
+
+/**
+ *	This function returns the number of bytes to allocate before the next
+ *	sample. The intervals are exponentially distributed so that the chance of
+ *	an allocation being sampled depends only on its size.
+ */
+int64 nextSampleInterval( uint32 meanInterval )
+{
+	// xorshift32
+	s_randomState ^= s_randomState << 13;
+	s_randomState ^= s_randomState >> 17;
+	s_randomState ^= s_randomState << 5;
+
+	const double uniform = (double( s_randomState ) + 1.0) / 4294967296.0;
+
+	return int64( -log( uniform ) * meanInterval ) + 1;
+}
+
+
+/**
+ *	This function returns the estimated number of bytes held by all
+ *	allocations of a call stack, given its live samples.
+ */
+double estimateBytes( uint32 count, uint64 bytes, uint32 interval )
+{
+	if (count == 0)
+	{
+		return 0.0;
+	}
+
+	// An allocation of this size had this probability of being sampled.
+	const double averageSize = double( bytes ) / count;
+	const double probability = 1.0 - exp( -averageSize / interval );
+
+	return double( bytes ) / probability;
+}
+
+
+/**
+ *	This function captures the call stack of the caller of its caller. It
+ *	must not be inlined, or it would skip the wrong frames.
+ */
+#ifdef unix
+__attribute__(( noinline ))
+#endif
+int captureStack( void ** frames )
+{
+#ifdef unix
+	const int SKIP = 2;
+	void * buffer[ MAX_DEPTH + SKIP ];
+	const int depth = backtrace( buffer, MAX_DEPTH + SKIP ) - SKIP;
+
+	if (depth <= 0)
+	{
+		return 0;
+	}
+
+	memcpy( frames, buffer + SKIP, depth * sizeof( void * ) );
+	return depth;
+#elif defined( _WIN32 ) && !defined( _XBOX360 )
+	return CaptureStackBackTrace( 2, MAX_DEPTH, frames, NULL );
+#else
+	return 0;
+#endif
+}
+
+
+/**
+ *	This function copies every call stack that has been sampled.
+ */
+void copyStacks( std::vector< StackEntry > & stacks )
+{
+	// The profiler's own memory is not sampled.
+	s_isBusy = true;
+
+	stacks.clear();
+	stacks.reserve( s_numStacks + 64 );
+
+	{
+		TableLockHolder lock;
+
+		for (uint32 i = 0; i < MAX_STACKS; ++i)
+		{
+			if (s_stacks[i].depth != 0)
+			{
+				stacks.push_back( s_stacks[i] );
+			}
+		}
+	}
+
+	s_isBusy = false;
+}
+
+
+/**
+ *	This class orders stacks by their estimated live bytes, largest first.
+ */
+class LiveBytesGreater
+{
+public:
+	LiveBytesGreater( uint32 interval ) : interval_( interval ) {}
+
+	bool operator()( const StackEntry & a, const StackEntry & b ) const
+	{
+		return estimateBytes( a.liveCount, a.liveBytes, interval_ ) >
+			estimateBytes( b.liveCount, b.liveBytes, interval_ );
+	}
+
+private:
+	uint32 interval_;
+};
+
+} // anonymous namespace
+
+
+// -----------------------------------------------------------------------------
+// Section: HeapProfiler
+// -----------------------------------------------------------------------------
+
+volatile bool HeapProfiler::s_isEnabled_ = false;
+volatile uint32 HeapProfiler::s_sampleInterval_ =
+	HeapProfiler::DEFAULT_SAMPLE_INTERVAL;
+volatile uint32 HeapProfiler::s_numLiveSamples_ = 0;
+
+
+/**
+ *	This method is called after memory has been allocated.
+ */
+void HeapProfiler::onAlloc( void * ptr, size_t size )
+{
+	if (!s_isEnabled_ || (ptr == NULL))
+	{
+		return;
+	}
+
+	s_bytesUntilSample -= size;
+
+	if ((s_bytesUntilSample < 0) && !s_isBusy)
+	{
+		HeapProfiler::sample( ptr, size );
+	}
+}
+
+
+/**
+ *	This method is called before memory is freed.
+ */
+void HeapProfiler::onFree( void * ptr )
+{
+	size_t size;
+	uint32 stackIndex;
+
+	HeapProfiler::removeSample( ptr, size, stackIndex );
+}
+
+
+/**
+ *	This method reallocates memory with the given function. If that fails, the
+ *	old block is unchanged and so is its sample.
+ */
+void * HeapProfiler::reallocate( void * ptr, size_t size,
+	ReallocFunction pRealloc )
+{
+	// The sample is removed first since, once the old block is freed, another
+	// thread may be given the same address.
+	size_t oldSize = 0;
+	uint32 stackIndex = 0;
+	const bool wasSampled =
+		HeapProfiler::removeSample( ptr, oldSize, stackIndex );
+
+	void * newPtr = pRealloc( ptr, size );
+
+	if ((newPtr == NULL) && (size != 0))
+	{
+		if (wasSampled)
+		{
+			HeapProfiler::restoreSample( ptr, oldSize, stackIndex );
+		}
+	}
+	else
+	{
+		HeapProfiler::onAlloc( newPtr, size );
+	}
+
+	return newPtr;
+}
+
+
+/**
+ *	This method records an allocation as a live sample.
+ */
+void HeapProfiler::sample( void * ptr, size_t size )
+{
+	s_isBusy = true;
+
+	void * frames[ MAX_DEPTH ];
+	const int depth = captureStack( frames );
+
+	{
+		TableLockHolder lock;
+
+		uint32 stackIndex = 0;
+
+		if ((depth > 0) &&
+			(s_numLiveSamples_ < MAX_LIVE_SAMPLES/4 * 3) &&
+			findStack( frames, depth, stackIndex ))
+		{
+			insertLiveSample( ptr, size, stackIndex );
+
+			StackEntry & stack = s_stacks[ stackIndex ];
+			++stack.totalCount;
+			stack.totalBytes += size;
+
+			++s_numLiveSamples_;
+		}
+		else
+		{
+			++s_numDropped;
+		}
+
+		s_bytesUntilSample = nextSampleInterval( s_sampleInterval_ );
+	}
+
+	s_isBusy = false;
+}
+
+
+/**
+ *	This method removes the live sample for the given pointer, if there is
+ *	one.
+ *
+ *	@param ptr			The freed pointer.
+ *	@param rSize		Set to the size of the sample that was removed.
+ *	@param rStackIndex	Set to the call stack of the sample that was removed.
+ *
+ *	@return True if a sample was removed, otherwise false.
+ */
+bool HeapProfiler::removeSample( void * ptr, size_t & rSize,
+	uint32 & rStackIndex )
+{
+	if ((s_numLiveSamples_ == 0) || (ptr == NULL) ||
+		(s_filter[ filterIndex( ptr ) ] == 0))
+	{
+		return false;
+	}
+
+	// The tables may be locked by this thread.
+	if (s_isBusy)
+	{
+		return false;
+	}
+
+	TableLockHolder lock;
+
+	const uint32 MASK = MAX_LIVE_SAMPLES - 1;
+
+	for (uint32 index = hashPointer( ptr ) & MASK;
+			s_liveSamples[ index ].ptr != NULL;
+			index = (index + 1) & MASK)
+	{
+		LiveSample & sample = s_liveSamples[ index ];
+
+		if (sample.ptr == ptr)
+		{
+			StackEntry & stack = s_stacks[ sample.stackIndex ];
+			--stack.liveCount;
+			stack.liveBytes -= sample.size;
+
+			--s_filter[ filterIndex( ptr ) ];
+			--s_numLiveSamples_;
+
+			rSize = sample.size;
+			rStackIndex = sample.stackIndex;
+
+			eraseLiveSample( index );
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ *	This method puts back a sample that was removed by removeSample.
+ */
+void HeapProfiler::restoreSample( void * ptr, size_t size, uint32 stackIndex )
+{
+	TableLockHolder lock;
+
+	if (s_numLiveSamples_ < MAX_LIVE_SAMPLES/4 * 3)
+	{
+		insertLiveSample( ptr, size, stackIndex );
+		++s_numLiveSamples_;
+	}
+	else
+	{
+		++s_numDropped;
+	}
+}
+
+
+/**
+ *	This method enables or disables sampling. Allocations sampled while
+ *	enabled are still tracked until they are freed.
+ */
+void HeapProfiler::isEnabled( bool value )
+{
+#ifdef unix
+	if (value)
+	{
+		// The first call to backtrace() loads libgcc, which allocates. Do it
+		// now rather than inside malloc.
+		void * buffer[ 1 ];
+		backtrace( buffer, 1 );
+	}
+#endif
+
+	s_isEnabled_ = value;
+}
+
+
+/**
+ *	This method sets the mean number of bytes allocated between samples.
+ */
+void HeapProfiler::sampleInterval( uint32 value )
+{
+	s_sampleInterval_ = std::max( value, uint32( 1 ) );
+}
+
+
+/**
+ *	This method returns the number of samples that were not recorded because
+ *	the tables were full.
+ */
+uint32 HeapProfiler::numDroppedSamples()
+{
+	return s_numDropped;
+}
+
+
+/**
+ *	This method returns the estimated number of bytes held by allocations
+ *	made while sampling was enabled.
+ */
+uint64 HeapProfiler::estimatedLiveBytes()
+{
+	std::vector< StackEntry > stacks;
+	copyStacks( stacks );
+
+	double total = 0.0;
+
+	for (size_t i = 0; i < stacks.size(); ++i)
+	{
+		total += estimateBytes( stacks[i].liveCount, stacks[i].liveBytes,
+			s_sampleInterval_ );
+	}
+
+	return uint64( total );
+}
+
+
+/**
+ *	This method returns a description of the call stacks holding the most
+ *	memory.
+ *
+ *	@param numSites		The number of call stacks to describe.
+ *	@param numFrames	The number of frames of each call stack to show.
+ */
+std::string HeapProfiler::topSites( int numSites, int numFrames )
+{
+	std::vector< StackEntry > stacks;
+	copyStacks( stacks );
+
+	const uint32 interval = s_sampleInterval_;
+	std::sort( stacks.begin(), stacks.end(), LiveBytesGreater( interval ) );
+
+	std::string result;
+	char buf[ 128 ];
+
+	for (int i = 0; i < std::min( numSites, int( stacks.size() ) ); ++i)
+	{
+		const StackEntry & stack = stacks[i];
+
+		if (stack.liveCount == 0)
+		{
+			break;
+		}
+
+		bw_snprintf( buf, sizeof( buf ), "%10.1f KB in %u samples\n",
+			estimateBytes( stack.liveCount, stack.liveBytes, interval ) / 1024.0,
+			stack.liveCount );
+		result += buf;
+
+		const int depth = std::min( numFrames, stack.depth );
+
+#ifdef unix
+		char ** symbols = backtrace_symbols( (void * const *)stack.frames,
+			depth );
+
+		for (int j = 0; symbols && (j < depth); ++j)
+		{
+			result += "\t";
+			result += symbols[j];
+			result += "\n";
+		}
+
+		raw_free( symbols );
+#else
+		for (int j = 0; j < depth; ++j)
+		{
+			bw_snprintf( buf, sizeof( buf ), "\t%p\n", stack.frames[j] );
+			result += buf;
+		}
+#endif
+	}
+
+	return result;
+}
+
+
+/**
+ *	This method writes the live samples to a file.
+ *
+ *	@return True on success, otherwise false.
+ */
+bool HeapProfiler::dump( const std::string & filename )
+{
+	std::ofstream stream( filename.c_str() );
+
+	if (!stream)
+	{
+		ERROR_MSG( "HeapProfiler::dump: Could not open %s\n", filename.c_str() );
+		return false;
+	}
+
+	HeapProfiler::writePprofProfile( stream );
+
+	INFO_MSG( "HeapProfiler::dump: Wrote %u live samples to %s\n",
+		s_numLiveSamples_, filename.c_str() );
+
+	return stream.good();
+}
+
+
+/**
+ *	This method writes the samples in the legacy text heap profile format read
+ *	by pprof. The counts are of samples. pprof scales them using the sample
+ *	interval in the header.
+ */
+void HeapProfiler::writePprofProfile( std::ostream & stream )
+{
+	std::vector< StackEntry > stacks;
+	copyStacks( stacks );
+
+	uint64 liveCount = 0;
+	uint64 liveBytes = 0;
+	uint64 totalCount = 0;
+	uint64 totalBytes = 0;
+
+	for (size_t i = 0; i < stacks.size(); ++i)
+	{
+		liveCount += stacks[i].liveCount;
+		liveBytes += stacks[i].liveBytes;
+		totalCount += stacks[i].totalCount;
+		totalBytes += stacks[i].totalBytes;
+	}
+
+	char buf[ 128 ];
+
+	bw_snprintf( buf, sizeof( buf ),
+		"heap profile: %"PRIu64": %"PRIu64" [%"PRIu64": %"PRIu64"] "
+			"@ heap_v2/%u\n",
+		liveCount, liveBytes, totalCount, totalBytes,
+		uint32( s_sampleInterval_ ) );
+	stream << buf;
+
+	for (size_t i = 0; i < stacks.size(); ++i)
+	{
+		const StackEntry & stack = stacks[i];
+
+		bw_snprintf( buf, sizeof( buf ),
+			"%u: %"PRIu64" [%u: %"PRIu64"] @",
+			stack.liveCount, stack.liveBytes,
+			stack.totalCount, stack.totalBytes );
+		stream << buf;
+
+		for (int j = 0; j < stack.depth; ++j)
+		{
+			bw_snprintf( buf, sizeof( buf ), " 0x%"PRIx64,
+				uint64( uintptr( stack.frames[j] ) ) );
+			stream << buf;
+		}
+
+		stream << "\n";
+	}
+
+#ifdef unix
+	// pprof needs the load addresses of the executable and libraries.
+	std::ifstream maps( "/proc/self/maps" );
+
+	if (maps)
+	{
+		stream << "\nMAPPED_LIBRARIES:\n" << maps.rdbuf();
+	}
+#endif
+}
+
+
+#if ENABLE_WATCHERS
+namespace
+{
+
+bool getIsEnabled()					{ return HeapProfiler::isEnabled(); }
+void setIsEnabled( bool value )		{ HeapProfiler::isEnabled( value ); }
+
+uint32 getSampleInterval()			{ return HeapProfiler::sampleInterval(); }
+void setSampleInterval( uint32 value )	{ HeapProfiler::sampleInterval( value ); }
+
+uint32 getNumLiveSamples()			{ return HeapProfiler::numLiveSamples(); }
+uint32 getNumDroppedSamples()		{ return HeapProfiler::numDroppedSamples(); }
+uint64 getEstimatedLiveBytes()		{ return HeapProfiler::estimatedLiveBytes(); }
+
+std::string getTopSites()			{ return HeapProfiler::topSites( 20, 8 ); }
+
+std::string s_lastDumpFilename;
+
+std::string getDump()				{ return s_lastDumpFilename; }
+
+void setDump( std::string filename )
+{
+	if (HeapProfiler::dump( filename ))
+	{
+		s_lastDumpFilename = filename;
+	}
+}
+
+} // anonymous namespace
+
+
+/**
+ *	This method adds the watchers that control and report on the profiler.
+ */
+void HeapProfiler::addWatchers()
+{
+	MF_WATCH( "debug/heapProfiler/enabled", &getIsEnabled, &setIsEnabled,
+		"Whether allocations are being sampled" );
+	MF_WATCH( "debug/heapProfiler/sampleInterval", &getSampleInterval,
+		&setSampleInterval,
+		"The average number of bytes allocated between samples" );
+	MF_WATCH( "debug/heapProfiler/numLiveSamples", &getNumLiveSamples );
+	MF_WATCH( "debug/heapProfiler/numDroppedSamples", &getNumDroppedSamples );
+	MF_WATCH( "debug/heapProfiler/estimatedLiveBytes", &getEstimatedLiveBytes );
+	MF_WATCH( "debug/heapProfiler/topSites", &getTopSites );
+	MF_WATCH( "debug/heapProfiler/dump", &getDump, &setDump,
+		"Set to a filename to write the samples in pprof's heap format" );
+}
+#endif // ENABLE_WATCHERS
+
+
+namespace
+{
+
+/**
+ *	This class enables the profiler at startup if the BW_HEAP_PROFILER
+ *	environment variable is set. A positive value sets the sample interval.
+ *	On Linux, this only has an effect if the allocation functions have been
+ *	replaced, so a warning is given if they have not.
+ */
+class HeapProfilerInitialiser
+{
+public:
+	HeapProfilerInitialiser()
+	{
+		const char * value = getenv( "BW_HEAP_PROFILER" );
+
+		if (value != NULL)
+		{
+			const int interval = atoi( value );
+
+			if (interval > 0)
+			{
+				HeapProfiler::sampleInterval( interval );
+			}
+
+			HeapProfiler::isEnabled( true );
+
+#if defined( unix ) && !HEAP_PROFILER_REPLACES_MALLOC
+			WARNING_MSG( "HeapProfilerInitialiser: BW_HEAP_PROFILER is set "
+				"but this process was not built with USE_HEAP_PROFILER=1. "
+				"Only allocations reported to HeapProfiler are sampled.\n" );
+#endif
+		}
+	}
+};
+
+HeapProfilerInitialiser s_heapProfilerInitialiser;
+
+} // anonymous namespace
+
+
+// -----------------------------------------------------------------------------
+// Section: Allocation functions
+// -----------------------------------------------------------------------------
+
+#if HEAP_PROFILER_REPLACES_MALLOC
+
+#undef malloc
+#undef realloc
+#undef free
+
+/*
+ *	These replace the C library's allocation functions for the whole process.
+ *	Memory from the other allocation functions, such as posix_memalign, is
+ *	not sampled but may still be freed through free().
+ */
+extern "C"
+{
+
+void * __libc_malloc( size_t size );
+void * __libc_calloc( size_t count, size_t size );
+void * __libc_realloc( void * ptr, size_t size );
+void __libc_free( void * ptr );
+
+void * malloc( size_t size ) __THROW
+{
+	void * ptr = __libc_malloc( size );
+	HeapProfiler::onAlloc( ptr, size );
+	return ptr;
+}
+
+void * calloc( size_t count, size_t size ) __THROW
+{
+	void * ptr = __libc_calloc( count, size );
+	HeapProfiler::onAlloc( ptr, count * size );
+	return ptr;
+}
+
+void * realloc( void * ptr, size_t size ) __THROW
+{
+	return HeapProfiler::reallocate( ptr, size, __libc_realloc );
+}
+
+void free( void * ptr ) __THROW
+{
+	HeapProfiler::onFree( ptr );
+	__libc_free( ptr );
+}
+
+} // extern "C"
+
+#endif // HEAP_PROFILER_REPLACES_MALLOC
+
+// heap_profiler.cpp
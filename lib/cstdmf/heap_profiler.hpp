@@ -0,0 +1,96 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef HEAP_PROFILER_HPP
+#define HEAP_PROFILER_HPP
+
+#include "cstdmf/config.hpp"
+#include "cstdmf/stdmf.hpp"
+
+#include <iosfwd>
+#include <string>
+
+/**
+ *	Define BW_HEAP_PROFILER when building cstdmf to have HeapProfiler replace
+ *	the C library's allocation functions on Linux. Building with
+ *	USE_HEAP_PROFILER=1 does this.
+ */
+#if defined( unix ) && defined( BW_HEAP_PROFILER )
+#define HEAP_PROFILER_REPLACES_MALLOC 1
+#else
+#define HEAP_PROFILER_REPLACES_MALLOC 0
+#endif
+
+/**
+ *	This class samples heap allocations to find the call sites responsible
+ *	for heap growth. It is cheap enough to leave enabled in production.
+ *
+ *	About once every sampleInterval() bytes allocated, the call stack of the
+ *	allocation is captured and the allocation is remembered until it is freed.
+ *	The distance between samples is randomised so that allocations of every
+ *	size have a chance of being sampled in proportion to their size. The live
+ *	samples of each call stack are then scaled up to estimate the memory that
+ *	call stack is holding.
+ *
+ *	On Linux, if cstdmf is built with USE_HEAP_PROFILER=1, malloc, calloc,
+ *	realloc and free are interposed by this file's implementation.
+ *	This is off by default since it conflicts with tools that replace them
+ *	too, such as AddressSanitizer and ThreadSanitizer. On Windows, allocations
+ *	are seen through MemTracker. Otherwise, only allocations that are passed
+ *	to onAlloc and onFree are sampled.
+ *
+ *	All tables are a fixed size and allocated statically, so that sampling
+ *	never allocates memory. Samples that do not fit are counted as dropped.
+ */
+class HeapProfiler
+{
+public:
+	/// The default mean number of bytes allocated between samples.
+	static const uint32 DEFAULT_SAMPLE_INTERVAL = 512 * 1024;
+
+	static void onAlloc( void * ptr, size_t size );
+	static void onFree( void * ptr );
+
+	typedef void * (*ReallocFunction)( void * ptr, size_t size );
+	static void * reallocate( void * ptr, size_t size,
+		ReallocFunction pRealloc );
+
+	static bool isEnabled()					{ return s_isEnabled_; }
+	static void isEnabled( bool value );
+
+	static uint32 sampleInterval()			{ return s_sampleInterval_; }
+	static void sampleInterval( uint32 value );
+
+	static uint32 numLiveSamples()			{ return s_numLiveSamples_; }
+	static uint32 numDroppedSamples();
+	static uint64 estimatedLiveBytes();
+
+	static std::string topSites( int numSites, int numFrames );
+
+	static bool dump( const std::string & filename );
+	static void writePprofProfile( std::ostream & stream );
+
+#if ENABLE_WATCHERS
+	static void addWatchers();
+#endif
+
+private:
+	static void sample( void * ptr, size_t size );
+	static bool removeSample( void * ptr, size_t & rSize,
+		uint32 & rStackIndex );
+	static void restoreSample( void * ptr, size_t size, uint32 stackIndex );
+
+	static volatile bool s_isEnabled_;
+	static volatile uint32 s_sampleInterval_;
+	static volatile uint32 s_numLiveSamples_;
+};
+
+#endif // HEAP_PROFILER_HPP
@@ -22,6 +22,7 @@ criminal penalties as provided by law.
 
 #include "cstdmf/binary_stream.hpp"
 #include "cstdmf/debug.hpp"
+#include "cstdmf/memory_stream_arena.hpp"
 
 
 
@@ -31,12 +32,17 @@ criminal penalties as provided by law.
  *	interfaces, so it is possible to read and write data to and from
  *	this stream.
  *
+ *	A short-lived stream can take its buffer from a MemoryStreamArena instead
+ *	of the heap. Such a stream must be destroyed on the thread that created it,
+ *	and before the end of the tick or task.
+ *
  *	@ingroup network
  */
 class MemoryOStream : public BinaryOStream, public BinaryIStream
 {
 public: // constructors and destructor
 	inline MemoryOStream( int size = 64 );
+	inline MemoryOStream( int size, MemoryStreamArena & arena );
 
 	virtual ~MemoryOStream();
 
@@ -60,6 +66,7 @@ public: // own methods
 	void reset();
 	void rewind();
 
+	bool usesArena() const;
 
 protected:
 	char * pBegin_;
@@ -67,6 +74,11 @@ protected:
 	char * pEnd_;
 	char * pRead_;
 	bool shouldDelete_;
+
+private:
+	void freeBuffer();
+
+	MemoryStreamArena * pArena_;
 };
 
 /**
@@ -23,6 +23,32 @@ inline MemoryOStream::MemoryOStream( int size )
 	pEnd_ = pBegin_ + size;
 	shouldDelete_ = true;
 	pRead_ = pBegin_;
+	pArena_ = NULL;
+}
+
+/**
+ * 	This constructor creates a stream whose buffer is allocated from an
+ * 	arena. If the arena is full, the buffer is allocated from the heap.
+ *
+ *	@param size		The initial size of the buffer.
+ *	@param arena	The arena. This is normally MemoryStreamArena::instance().
+ */
+inline MemoryOStream::MemoryOStream( int size, MemoryStreamArena & arena )
+{
+	pBegin_ = arena.allocate( size );
+	pArena_ = &arena;
+
+	if (pBegin_ == NULL)
+	{
+		arena.onOverflow();
+		pBegin_ = new char[ size ];
+		pArena_ = NULL;
+	}
+
+	pCurr_ = pBegin_;
+	pEnd_ = pBegin_ + size;
+	shouldDelete_ = true;
+	pRead_ = pBegin_;
 }
 
 /**
@@ -34,7 +60,22 @@ inline MemoryOStream::MemoryOStream( int size )
 inline MemoryOStream::~MemoryOStream()
 {
 	if (shouldDelete_)
+		this->freeBuffer();
+}
+
+/**
+ *	This method returns the data buffer to the arena or the heap.
+ */
+inline void MemoryOStream::freeBuffer()
+{
+	if (pArena_)
+	{
+		pArena_->release( pBegin_, (int)(pEnd_ - pBegin_) );
+	}
+	else
+	{
 		delete [] pBegin_;
+	}
 }
 
 /**
@@ -69,9 +110,22 @@ inline void MemoryOStream::shouldDelete( bool value )
 {
 	// Make sure we don't try to set this to false twice.
 	MF_ASSERT( shouldDelete_ || value );
+
+	// An arena buffer cannot outlive the stream.
+	MF_ASSERT( value || !pArena_ );
+
 	shouldDelete_ = value;
 }
 
+/**
+ *	This method returns whether the data buffer is allocated from an arena.
+ *	This is false for a stream constructed with an arena if the arena was full.
+ */
+inline bool MemoryOStream::usesArena() const
+{
+	return pArena_ != NULL;
+}
+
 /**
  * 	This method returns a pointer to the data associated with
  * 	this stream.
@@ -100,13 +154,33 @@ inline void * MemoryOStream::reserve( int nBytes )
 	{
 		int multiplier = (int)((pCurr_ - pBegin_)/(pEnd_ - pBegin_) + 1);
 		int newSize = multiplier * (int)(pEnd_ - pBegin_);
-		char * pNewData = new char[ newSize ];
-		memcpy( pNewData, pBegin_, pOldCurr - pBegin_ );
+		int usedSize = (int)(pOldCurr - pBegin_);
+		MF_ASSERT( shouldDelete_ );
+
+		char * pNewData = NULL;
+
+		if (pArena_)
+		{
+			pNewData = pArena_->grow( pBegin_, (int)(pEnd_ - pBegin_),
+				usedSize, newSize );
+
+			if (pNewData == NULL)
+			{
+				pArena_->onOverflow();
+			}
+		}
+
+		if (pNewData == NULL)
+		{
+			pNewData = new char[ newSize ];
+			memcpy( pNewData, pBegin_, usedSize );
+			this->freeBuffer();
+			pArena_ = NULL;
+		}
+
 		pCurr_ = pCurr_ - pBegin_ + pNewData;
 		pOldCurr = pOldCurr - pBegin_ + pNewData;
 		pRead_ = pRead_ - pBegin_ + pNewData;
-		MF_ASSERT( shouldDelete_ );
-		delete [] pBegin_;
 		pBegin_ = pNewData;
 		pEnd_ = pBegin_ + newSize;
 	}
@@ -0,0 +1,288 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "pch.hpp"
+
+#include "memory_stream_arena.hpp"
+
+#include "concurrency.hpp"
+#include "debug.hpp"
+#include "watcher.hpp"
+
+#include <algorithm>
+#include <vector>
+
+DECLARE_DEBUG_COMPONENT2( "CStdMF", 0 )
+
+namespace
+{
+
+/// The arena of the current thread, or NULL if it has not used one.
+THREADLOCAL( MemoryStreamArena * ) s_pArena = NULL;
+
+/// All arenas that have been created. This is protected by s_arenasLock.
+std::vector< MemoryStreamArena * > s_arenas;
+SimpleMutex s_arenasLock;
+
+} // anonymous namespace
+
+
+int MemoryStreamArena::s_defaultSize_ = MemoryStreamArena::DEFAULT_SIZE;
+
+
+/**
+ *	Constructor.
+ *
+ *	@param size	The number of bytes in the arena.
+ */
+MemoryStreamArena::MemoryStreamArena( int size ) :
+	pBegin_( new char[ size ] ),
+	pCurr_( pBegin_ ),
+	pEnd_( pBegin_ + size ),
+	numBuffers_( 0 ),
+	peakBytesInUse_( 0 ),
+	numAllocations_( 0 ),
+	numOverflows_( 0 ),
+	numBlockedResets_( 0 )
+{
+}
+
+
+/**
+ *	Destructor.
+ */
+MemoryStreamArena::~MemoryStreamArena()
+{
+	MF_ASSERT_DEV( numBuffers_ == 0 );
+	delete [] pBegin_;
+}
+
+
+/**
+ *	This method returns the arena of the current thread, creating it the first
+ *	time it is used.
+ */
+MemoryStreamArena & MemoryStreamArena::instance()
+{
+	MemoryStreamArena * pArena = s_pArena;
+
+	if (pArena == NULL)
+	{
+		pArena = new MemoryStreamArena( s_defaultSize_ );
+		s_pArena = pArena;
+
+		SimpleMutexHolder smh( s_arenasLock );
+		s_arenas.push_back( pArena );
+	}
+
+	return *pArena;
+}
+
+
+/**
+ *	This method resets the arena of the current thread, if it has one. It
+ *	should be called at the end of each tick or task.
+ */
+void MemoryStreamArena::resetCurrentThread()
+{
+	MemoryStreamArena * pArena = s_pArena;
+
+	if (pArena != NULL)
+	{
+		pArena->reset();
+	}
+}
+
+
+/**
+ *	This method allocates a buffer from the end of the arena.
+ *
+ *	@return The buffer, or NULL if there is not enough room. The caller should
+ *			then use the heap and call onOverflow().
+ */
+char * MemoryStreamArena::allocate( int size )
+{
+	const int allocSize = alignedSize( size );
+
+	if (allocSize > pEnd_ - pCurr_)
+	{
+		return NULL;
+	}
+
+	char * pBuffer = pCurr_;
+	pCurr_ += allocSize;
+
+	++numBuffers_;
+	++numAllocations_;
+	peakBytesInUse_ = std::max( peakBytesInUse_, this->bytesInUse() );
+
+	return pBuffer;
+}
+
+
+/**
+ *	This method grows a buffer allocated from this arena. A buffer at the end
+ *	of the arena is extended in place. Otherwise, a new buffer is allocated
+ *	and the used part of the old one is copied to it.
+ *
+ *	@return	The grown buffer, or NULL if there is not enough room. In that case,
+ *			the old buffer is still allocated.
+ */
+char * MemoryStreamArena::grow( char * pBuffer, int oldSize, int usedSize,
+		int newSize )
+{
+	if (pBuffer + alignedSize( oldSize ) == pCurr_)
+	{
+		const int allocSize = alignedSize( newSize );
+
+		if (allocSize > pEnd_ - pBuffer)
+		{
+			return NULL;
+		}
+
+		pCurr_ = pBuffer + allocSize;
+		peakBytesInUse_ = std::max( peakBytesInUse_, this->bytesInUse() );
+
+		return pBuffer;
+	}
+
+	char * pNewBuffer = this->allocate( newSize );
+
+	if (pNewBuffer != NULL)
+	{
+		memcpy( pNewBuffer, pBuffer, usedSize );
+		this->release( pBuffer, oldSize );
+	}
+
+	return pNewBuffer;
+}
+
+
+/**
+ *	This method releases a buffer allocated from this arena. The space is only
+ *	reused once the buffers after it have been released.
+ */
+void MemoryStreamArena::release( char * pBuffer, int size )
+{
+	MF_ASSERT( (pBegin_ <= pBuffer) && (pBuffer < pEnd_) );
+	MF_ASSERT( numBuffers_ > 0 );
+
+	--numBuffers_;
+
+	if (numBuffers_ == 0)
+	{
+		pCurr_ = pBegin_;
+	}
+	else if (pBuffer + alignedSize( size ) == pCurr_)
+	{
+		pCurr_ = pBuffer;
+	}
+}
+
+
+/**
+ *	This method empties the arena. Buffers that are still allocated keep it
+ *	from being reset, and this is counted in numBlockedResets().
+ */
+void MemoryStreamArena::reset()
+{
+	if (numBuffers_ == 0)
+	{
+		pCurr_ = pBegin_;
+	}
+	else
+	{
+		++numBlockedResets_;
+	}
+}
+
+
+#if ENABLE_WATCHERS
+namespace
+{
+
+/**
+ *	This function returns the sum of a statistic over all arenas.
+ */
+template <class T>
+T sumArenas( T (MemoryStreamArena::*pGetter)() const )
+{
+	SimpleMutexHolder smh( s_arenasLock );
+
+	T sum = 0;
+
+	for (size_t i = 0; i < s_arenas.size(); ++i)
+	{
+		sum += (s_arenas[i]->*pGetter)();
+	}
+
+	return sum;
+}
+
+int getDefaultSize()			{ return MemoryStreamArena::defaultSize(); }
+void setDefaultSize( int value )	{ MemoryStreamArena::defaultSize( value ); }
+
+int getNumArenas()
+{
+	SimpleMutexHolder smh( s_arenasLock );
+	return int( s_arenas.size() );
+}
+
+int getBytesInUse()
+{
+	return sumArenas( &MemoryStreamArena::bytesInUse );
+}
+
+int getPeakBytesInUse()
+{
+	return sumArenas( &MemoryStreamArena::peakBytesInUse );
+}
+
+uint64 getNumAllocations()
+{
+	return sumArenas( &MemoryStreamArena::numAllocations );
+}
+
+uint64 getNumOverflows()
+{
+	return sumArenas( &MemoryStreamArena::numOverflows );
+}
+
+uint64 getNumBlockedResets()
+{
+	return sumArenas( &MemoryStreamArena::numBlockedResets );
+}
+
+} // anonymous namespace
+
+
+/**
+ *	This method adds the watchers that report the use of the arenas of all
+ *	threads.
+ */
+void MemoryStreamArena::addWatchers()
+{
+	MF_WATCH( "debug/memoryStreamArena/defaultSize", &getDefaultSize,
+		&setDefaultSize,
+		"The size in bytes of arenas created from now on" );
+	MF_WATCH( "debug/memoryStreamArena/numArenas", &getNumArenas );
+	MF_WATCH( "debug/memoryStreamArena/bytesInUse", &getBytesInUse );
+	MF_WATCH( "debug/memoryStreamArena/peakBytesInUse",
+		&getPeakBytesInUse );
+	MF_WATCH( "debug/memoryStreamArena/numAllocations",
+		&getNumAllocations );
+	MF_WATCH( "debug/memoryStreamArena/numOverflows", &getNumOverflows );
+	MF_WATCH( "debug/memoryStreamArena/numBlockedResets",
+		&getNumBlockedResets );
+}
+#endif // ENABLE_WATCHERS
+
+// memory_stream_arena.cpp
@@ -0,0 +1,89 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef MEMORY_STREAM_ARENA_HPP
+#define MEMORY_STREAM_ARENA_HPP
+
+#include "cstdmf/config.hpp"
+#include "cstdmf/stdmf.hpp"
+
+/**
+ *	This class is a bump allocator for the buffers of short-lived
+ *	MemoryOStreams. Each thread has its own arena, returned by instance().
+ *
+ *	A stream constructed with an arena takes its buffer from the end of the
+ *	arena. A buffer at the end of the arena grows in place, and releasing it
+ *	moves the end back. Once all buffers have been released, the arena is
+ *	empty again. If a buffer does not fit, the stream falls back to the heap
+ *	and the overflow is counted.
+ *
+ *	reset() should be called at the end of each tick or task. It is normally
+ *	a no-op. If buffers are still allocated, they have outlived the tick they
+ *	were created in, which defeats the arena, so this is counted.
+ *
+ *	Arenas are never deleted, since streams may still refer to them. A stream
+ *	using an arena must be destroyed on the thread that created it.
+ */
+class MemoryStreamArena
+{
+public:
+	/// The default size of an arena in bytes.
+	static const int DEFAULT_SIZE = 1024 * 1024;
+
+	MemoryStreamArena( int size );
+	~MemoryStreamArena();
+
+	static MemoryStreamArena & instance();
+	static void resetCurrentThread();
+
+	char * allocate( int size );
+	char * grow( char * pBuffer, int oldSize, int usedSize, int newSize );
+	void release( char * pBuffer, int size );
+	void reset();
+
+	void onOverflow()					{ ++numOverflows_; }
+
+	int size() const					{ return int( pEnd_ - pBegin_ ); }
+	int bytesInUse() const				{ return int( pCurr_ - pBegin_ ); }
+	int peakBytesInUse() const			{ return peakBytesInUse_; }
+	int numBuffers() const				{ return numBuffers_; }
+	uint64 numAllocations() const		{ return numAllocations_; }
+	uint64 numOverflows() const			{ return numOverflows_; }
+	uint64 numBlockedResets() const		{ return numBlockedResets_; }
+
+	static int defaultSize()			{ return s_defaultSize_; }
+	static void defaultSize( int value )	{ s_defaultSize_ = value; }
+
+#if ENABLE_WATCHERS
+	static void addWatchers();
+#endif
+
+private:
+	MemoryStreamArena( const MemoryStreamArena & );
+	MemoryStreamArena & operator=( const MemoryStreamArena & );
+
+	static int alignedSize( int size )	{ return (size + 7) & ~7; }
+
+	char * pBegin_;
+	char * pCurr_;
+	char * pEnd_;
+
+	int numBuffers_;
+	int peakBytesInUse_;
+
+	uint64 numAllocations_;
+	uint64 numOverflows_;
+	uint64 numBlockedResets_;
+
+	static int s_defaultSize_;
+};
+
+#endif // MEMORY_STREAM_ARENA_HPP
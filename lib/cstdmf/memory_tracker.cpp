@@ -14,6 +14,7 @@ criminal penalties as provided by law.
 
 #include "bw_util.hpp"
 #include "fini_job.hpp"
+#include "heap_profiler.hpp"
 #include "watcher.hpp"
 
 //-----------------------------------------------------------------------------
@@ -39,9 +40,30 @@ criminal penalties as provided by law.
 #define NO_NED_NAMESPACE
 #define NO_MALLINFO 1
 #include "third_party/nedalloc/nedmalloc.h"
-#define MALLOC ::nedmalloc
-#define REALLOC ::nedrealloc
-#define FREE ::nedfree
+
+// HeapProfiler is told about allocations here. On Linux, it can replace the
+// C library's malloc instead.
+static void* profiledMalloc( size_t size )
+{
+	void* mem = ::nedmalloc( size );
+	HeapProfiler::onAlloc( mem, size );
+	return mem;
+}
+
+static void* profiledRealloc( void* mem, size_t size )
+{
+	return HeapProfiler::reallocate( mem, size, ::nedrealloc );
+}
+
+static void profiledFree( void* mem )
+{
+	HeapProfiler::onFree( mem );
+	::nedfree( mem );
+}
+
+#define MALLOC profiledMalloc
+#define REALLOC profiledRealloc
+#define FREE profiledFree
 #else
 #define MALLOC ::malloc
 #define REALLOC ::realloc
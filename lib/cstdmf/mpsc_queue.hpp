@@ -0,0 +1,555 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include "concurrency.hpp"
+#include "stdmf.hpp"
+
+#include <vector>
+
+/**
+ *	This class is a bounded queue that passes values from any number of
+ *	producer threads to a single consumer thread without locking.
+ *
+ *	Each slot has a sequence number that says whether it is ready to be written
+ *	or read for the current lap of the ring. Producers claim a slot by
+ *	advancing tail_ with atomic_swap and then publish it by updating the slot's
+ *	sequence. Only the consumer may call pop().
+ */
+template <class T>
+class MPSCQueue
+{
+public:
+	MPSCQueue( uint32 capacity );
+	~MPSCQueue();
+
+	bool push( const T & value );
+	bool pop( T & value );
+
+	/// These are only a snapshot when producers are active.
+	bool empty() const			{ return head_ == tail_; }
+	uint32 size() const			{ return tail_ - head_; }
+	uint32 capacity() const		{ return mask_ + 1; }
+
+private:
+	MPSCQueue( const MPSCQueue & );
+	MPSCQueue & operator=( const MPSCQueue & );
+
+	/**
+	 *	This structure is an entry in the ring.
+	 */
+	struct Slot
+	{
+		volatile uint32 sequence;
+		T value;
+	};
+
+	static const int CACHE_LINE_SIZE = 64;
+
+	Slot * slots_;
+	uint32 mask_;
+
+	char padding1_[ CACHE_LINE_SIZE ];
+
+	// The index of the next value to pop. Only written by the consumer.
+	volatile uint32 head_;
+
+	char padding2_[ CACHE_LINE_SIZE ];
+
+	// The index of the next slot to claim. Written by all producers.
+	volatile uint32 tail_;
+
+	char padding3_[ CACHE_LINE_SIZE ];
+};
+
+
+/**
+ *	Constructor.
+ *
+ *	@param capacity	The maximum number of values in the queue. This is rounded
+ *					up to a power of two.
+ */
+template <class T>
+MPSCQueue< T >::MPSCQueue( uint32 capacity ) :
+	slots_( NULL ),
+	mask_( 0 ),
+	head_( 0 ),
+	tail_( 0 )
+{
+	uint32 size = 1;
+
+	while (size < capacity)
+	{
+		size <<= 1;
+	}
+
+	slots_ = new Slot[ size ];
+	mask_ = size - 1;
+
+	for (uint32 i = 0; i < size; ++i)
+	{
+		slots_[ i ].sequence = i;
+	}
+}
+
+
+/**
+ *	Destructor.
+ */
+template <class T>
+MPSCQueue< T >::~MPSCQueue()
+{
+	delete [] slots_;
+}
+
+
+/**
+ *	This method adds a value to the back of the queue. It may be called by any
+ *	thread.
+ *
+ *	@return False if the queue is full, otherwise true.
+ */
+template <class T>
+bool MPSCQueue< T >::push( const T & value )
+{
+	uint32 tail = tail_;
+	Slot * pSlot;
+
+	while (true)
+	{
+		pSlot = &slots_[ tail & mask_ ];
+		const int32 diff = int32( pSlot->sequence - tail );
+
+		if (diff == 0)
+		{
+			// The slot is free for this lap. Try to claim it.
+			if (atomic_swap( tail_, tail, tail + 1 ))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// The consumer has not yet emptied this slot from the last lap.
+			return false;
+		}
+
+		tail = tail_;
+	}
+
+	pSlot->value = value;
+
+	// The value must be visible before the consumer can see the sequence.
+	memory_barrier();
+
+	pSlot->sequence = tail + 1;
+
+	return true;
+}
+
+
+/**
+ *	This method removes the value at the front of the queue. It must only be
+ *	called by the consumer thread.
+ *
+ *	@return False if the queue is empty or the next value has been claimed but
+ *		not yet written, otherwise true.
+ */
+template <class T>
+bool MPSCQueue< T >::pop( T & value )
+{
+	const uint32 head = head_;
+	Slot & slot = slots_[ head & mask_ ];
+
+	if (slot.sequence != head + 1)
+	{
+		return false;
+	}
+
+	// Do not read the value until its sequence has been read.
+	memory_barrier();
+
+	value = slot.value;
+	slot.value = T();
+
+	// The slot must be finished with before a producer can claim it.
+	memory_barrier();
+
+	slot.sequence = head + mask_ + 1;
+	head_ = head + 1;
+
+	return true;
+}
+
+
+/**
+ *	This class is an unbounded queue that passes values from any number of
+ *	producer threads to a single consumer thread without locking.
+ *
+ *	Values are stored in a chain of fixed size segments that are each used
+ *	once. When a segment is full, the first producer to notice links on a new
+ *	one. Once the consumer has emptied a segment and the tail has moved past
+ *	it, the segment is deleted after every producer that was part way through
+ *	a push has finished, since those producers may still be looking at it.
+ *	Producers are counted by epoch so that this does not need a moment when no
+ *	producer is pushing at all.
+ */
+template <class T>
+class UnboundedMPSCQueue
+{
+public:
+	UnboundedMPSCQueue( uint32 segmentSize = 256 );
+	~UnboundedMPSCQueue();
+
+	void push( const T & value );
+	bool pop( T & value );
+
+private:
+	UnboundedMPSCQueue( const UnboundedMPSCQueue & );
+	UnboundedMPSCQueue & operator=( const UnboundedMPSCQueue & );
+
+	/**
+	 *	This structure is a link in the chain of segments.
+	 */
+	struct Segment
+	{
+		Segment( uint32 size );
+		~Segment()	{ delete [] values; delete [] isReady; }
+
+		bool push( const T & value );
+
+		T * values;
+		volatile bool * isReady;
+		uint32 size;
+
+		// The number of slots that have been claimed by producers.
+		volatile uint32 numClaimed;
+
+		// The number of values popped. Only used by the consumer.
+		uint32 numPopped;
+
+		// The next segment. This is linked with atomic_swap.
+		void * pNext;
+	};
+
+	static void adjustCount( volatile uint32 & count, int delta );
+
+	uint32 enterPush();
+	void deleteRetired();
+
+	static const int CACHE_LINE_SIZE = 64;
+
+	uint32 segmentSize_;
+
+	char padding1_[ CACHE_LINE_SIZE ];
+
+	// The segment being popped from. Only used by the consumer.
+	Segment * pHead_;
+
+	// Segments that have been emptied, in order. The tail may still be one
+	// of these.
+	std::vector< Segment * > retired_;
+
+	// Segments that the tail has moved past. These are deleted once the
+	// producers counted in the epoch before pendingEpoch_ have finished.
+	std::vector< Segment * > pending_;
+	uint32 pendingEpoch_;
+
+	char padding2_[ CACHE_LINE_SIZE ];
+
+	// The segment being pushed to. This may lag behind the real last segment.
+	void * pTail_;
+
+	// The current epoch and the number of producers inside push() that
+	// started in an odd or even epoch.
+	volatile uint32 epoch_;
+	volatile uint32 numPushing_[ 2 ];
+
+	char padding3_[ CACHE_LINE_SIZE ];
+};
+
+
+/**
+ *	Constructor.
+ */
+template <class T>
+UnboundedMPSCQueue< T >::Segment::Segment( uint32 size ) :
+	values( new T[ size ] ),
+	isReady( new volatile bool[ size ] ),
+	size( size ),
+	numClaimed( 0 ),
+	numPopped( 0 ),
+	pNext( NULL )
+{
+	for (uint32 i = 0; i < size; ++i)
+	{
+		isReady[ i ] = false;
+	}
+}
+
+
+/**
+ *	This method adds a value to this segment.
+ *
+ *	@return False if every slot in this segment has been claimed.
+ */
+template <class T>
+bool UnboundedMPSCQueue< T >::Segment::push( const T & value )
+{
+	uint32 index;
+
+	do
+	{
+		index = numClaimed;
+
+		if (index >= size)
+		{
+			return false;
+		}
+	}
+	while (!atomic_swap( numClaimed, index, index + 1 ));
+
+	values[ index ] = value;
+
+	// The value must be visible before the consumer can see it is ready.
+	memory_barrier();
+
+	isReady[ index ] = true;
+
+	return true;
+}
+
+
+/**
+ *	Constructor.
+ *
+ *	@param segmentSize	The number of values in each segment.
+ */
+template <class T>
+UnboundedMPSCQueue< T >::UnboundedMPSCQueue( uint32 segmentSize ) :
+	segmentSize_( segmentSize ),
+	pHead_( new Segment( segmentSize ) ),
+	pendingEpoch_( 0 ),
+	pTail_( pHead_ ),
+	epoch_( 0 )
+{
+	numPushing_[ 0 ] = 0;
+	numPushing_[ 1 ] = 0;
+}
+
+
+/**
+ *	Destructor.
+ */
+template <class T>
+UnboundedMPSCQueue< T >::~UnboundedMPSCQueue()
+{
+	while (pHead_)
+	{
+		Segment * pNext = static_cast< Segment * >( pHead_->pNext );
+		delete pHead_;
+		pHead_ = pNext;
+	}
+
+	for (size_t i = 0; i < retired_.size(); ++i)
+	{
+		delete retired_[ i ];
+	}
+
+	for (size_t i = 0; i < pending_.size(); ++i)
+	{
+		delete pending_[ i ];
+	}
+}
+
+
+/**
+ *	This method atomically adds delta to a count.
+ */
+template <class T>
+void UnboundedMPSCQueue< T >::adjustCount( volatile uint32 & count, int delta )
+{
+	uint32 value;
+
+	do
+	{
+		value = count;
+	}
+	while (!atomic_swap( count, value, value + delta ));
+}
+
+
+/**
+ *	This method counts a producer as pushing in the current epoch.
+ *
+ *	@return The epoch that the producer was counted in.
+ */
+template <class T>
+uint32 UnboundedMPSCQueue< T >::enterPush()
+{
+	while (true)
+	{
+		const uint32 epoch = epoch_;
+		adjustCount( numPushing_[ epoch & 1 ], 1 );
+
+		// If the consumer has started a new epoch, it may already have
+		// checked this count, so count again in the new epoch.
+		memory_barrier();
+
+		if (epoch_ == epoch)
+		{
+			return epoch;
+		}
+
+		adjustCount( numPushing_[ epoch & 1 ], -1 );
+	}
+}
+
+
+/**
+ *	This method adds a value to the back of the queue. It may be called by any
+ *	thread.
+ */
+template <class T>
+void UnboundedMPSCQueue< T >::push( const T & value )
+{
+	const uint32 epoch = this->enterPush();
+
+	Segment * pSegment = static_cast< Segment * >( pTail_ );
+
+	while (!pSegment->push( value ))
+	{
+		if (pSegment->pNext == NULL)
+		{
+			Segment * pNew = new Segment( segmentSize_ );
+
+			if (!atomic_swap( pSegment->pNext, NULL, pNew ))
+			{
+				// Another producer linked one first.
+				delete pNew;
+			}
+		}
+
+		Segment * pNext = static_cast< Segment * >( pSegment->pNext );
+
+		// Failing just means that another producer has moved it on.
+		atomic_swap( pTail_, pSegment, pNext );
+
+		pSegment = pNext;
+	}
+
+	adjustCount( numPushing_[ epoch & 1 ], -1 );
+}
+
+
+/**
+ *	This method removes the value at the front of the queue. It must only be
+ *	called by the consumer thread.
+ *
+ *	@return False if the queue is empty or the next value has been claimed but
+ *		not yet written, otherwise true.
+ */
+template <class T>
+bool UnboundedMPSCQueue< T >::pop( T & value )
+{
+	while (pHead_->numPopped == pHead_->size)
+	{
+		// Every slot was claimed, so a producer has linked the next segment
+		// or is about to.
+		Segment * pNext = static_cast< Segment * >( pHead_->pNext );
+
+		if (pNext == NULL)
+		{
+			return false;
+		}
+
+		retired_.push_back( pHead_ );
+		pHead_ = pNext;
+	}
+
+	if (!retired_.empty() || !pending_.empty())
+	{
+		this->deleteRetired();
+	}
+
+	const uint32 index = pHead_->numPopped;
+
+	if (!pHead_->isReady[ index ])
+	{
+		return false;
+	}
+
+	// Do not read the value until it is known to be ready.
+	memory_barrier();
+
+	value = pHead_->values[ index ];
+	pHead_->values[ index ] = T();
+	pHead_->numPopped = index + 1;
+
+	return true;
+}
+
+
+/**
+ *	This method deletes the segments that no producer can be looking at.
+ *
+ *	Segments that the tail has moved past cannot be found by producers that
+ *	start pushing later. They are set aside and a new epoch is started, and
+ *	they are deleted once the producers counted in the old epoch have finished.
+ */
+template <class T>
+void UnboundedMPSCQueue< T >::deleteRetired()
+{
+	memory_barrier();
+
+	if (!pending_.empty())
+	{
+		if (numPushing_[ (pendingEpoch_ - 1) & 1 ] != 0)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < pending_.size(); ++i)
+		{
+			delete pending_[ i ];
+		}
+
+		pending_.clear();
+	}
+
+	// The tail only moves forwards, so the retired segments before it are
+	// behind it for good.
+	const void * pTail = pTail_;
+	size_t numPassed = 0;
+
+	while ((numPassed < retired_.size()) && (retired_[ numPassed ] != pTail))
+	{
+		++numPassed;
+	}
+
+	if (numPassed == 0)
+	{
+		return;
+	}
+
+	pending_.assign( retired_.begin(), retired_.begin() + numPassed );
+	retired_.erase( retired_.begin(), retired_.begin() + numPassed );
+
+	pendingEpoch_ = epoch_ + 1;
+	epoch_ = pendingEpoch_;
+
+	memory_barrier();
+}
+
+#endif // MPSC_QUEUE_HPP
@@ -33,6 +33,24 @@ class PoolAllocator
 		FreeList * next;
 	};
 public:
+	/**
+	 *	This structure holds free instances for the exclusive use of a single
+	 *	thread, so that the thread only needs to grab the pool's mutex once per
+	 *	batch of allocations or deallocations. It is a plain structure so that
+	 *	it can be declared THREADLOCAL. Instances held in a cache are counted as
+	 *	being used by the pool.
+	 */
+	struct ThreadCache
+	{
+		FreeList * pHead_;
+		uint size_;
+		bool isEnabled_;
+	};
+
+	/// The number of instances moved between a ThreadCache and the pool at a
+	/// time.
+	static const uint THREAD_CACHE_BATCH_SIZE = 32;
+
 	/**
 	 *  Initialise a new empty Pool.
 	 */
@@ -41,6 +59,8 @@ public:
 		numInPoolUsed_( 0 ),
 		numInPoolTotal_( 0 ),
 		numAllocatesEver_( 0 ),
+		numPoolHits_( 0 ),
+		maxInPoolUsed_( 0 ),
 		size_( size )
 	{
 		MF_ASSERT( size >= sizeof (FreeList) );
@@ -81,24 +101,46 @@ public:
 
 		mutex_.grab();
 		{
-			// Grab an instance from the pool if there's one available.
-			if (pHead_)
-			{
-				ret = (void*)pHead_;
-				pHead_ = pHead_->next;
-			}
+			ret = this->pop();
+		}
+		mutex_.give();
 
-			// Otherwise just allocate new memory and return that instead.
-			else
+		return ret;
+	}
+
+	/**
+	 *	This method returns a pointer to an available instance, taking it from
+	 *	the given thread cache if it is enabled. An empty cache is refilled from
+	 *	the pool in a batch.
+	 */
+	void * allocate( size_t size, ThreadCache & cache )
+	{
+		if (!cache.isEnabled_)
+		{
+			return this->allocate( size );
+		}
+
+		MF_ASSERT( size == size_ );
+
+		if (cache.pHead_ == NULL)
+		{
+			mutex_.grab();
 			{
-				ret = (void*)new char[ size ];
-				++numInPoolTotal_;
+				for (uint i = 0; i < THREAD_CACHE_BATCH_SIZE; ++i)
+				{
+					FreeList * pInstance = (FreeList *)this->pop();
+					pInstance->next = cache.pHead_;
+					cache.pHead_ = pInstance;
+				}
 			}
+			mutex_.give();
 
-			++numInPoolUsed_;
-			++numAllocatesEver_;
+			cache.size_ = THREAD_CACHE_BATCH_SIZE;
 		}
-		mutex_.give();
+
+		void * ret = (void*)cache.pHead_;
+		cache.pHead_ = cache.pHead_->next;
+		--cache.size_;
 
 		return ret;
 	}
@@ -118,6 +160,49 @@ public:
 		mutex_.give();
 	}
 
+	/**
+	 *	This method returns a deleted instance to the given thread cache if it
+	 *	is enabled. When the cache gets too large, a batch of its instances is
+	 *	returned to the pool.
+	 */
+	void deallocate( void * pInstance, ThreadCache & cache )
+	{
+		if (!cache.isEnabled_)
+		{
+			this->deallocate( pInstance );
+			return;
+		}
+
+		FreeList * pNewHead = (FreeList *)pInstance;
+		pNewHead->next = cache.pHead_;
+		cache.pHead_ = pNewHead;
+		++cache.size_;
+
+		if (cache.size_ >= 2 * THREAD_CACHE_BATCH_SIZE)
+		{
+			this->release( cache, THREAD_CACHE_BATCH_SIZE );
+		}
+	}
+
+	/**
+	 *	This method starts using the given thread cache.
+	 */
+	void enableCache( ThreadCache & cache )
+	{
+		cache.isEnabled_ = true;
+	}
+
+	/**
+	 *	This method returns all instances held by the given thread cache to the
+	 *	pool and stops using it. It should be called before the owning thread
+	 *	exits.
+	 */
+	void disableCache( ThreadCache & cache )
+	{
+		this->release( cache, cache.size_ );
+		cache.isEnabled_ = false;
+	}
+
 	/**
 	 *	This method returns the total number of instances in the pool being used
 	 *	currently.
@@ -141,6 +226,28 @@ public:
 	 */
 	uint	numAllocatesEver() const { return numAllocatesEver_; }
 
+	/**
+	 *	This method returns the number of calls to allocate that reused an
+	 *	instance already in the pool.
+	 */
+	uint	numPoolHits() const { return numPoolHits_; }
+
+	/**
+	 *	This method returns the proportion of calls to allocate that reused an
+	 *	instance already in the pool.
+	 */
+	double	hitRate() const
+	{
+		return numAllocatesEver_ ?
+			double( numPoolHits_ ) / numAllocatesEver_ : 0.0;
+	}
+
+	/**
+	 *	This method returns the largest number of instances that have been in
+	 *	use at the same time.
+	 */
+	uint	maxInPoolUsed() const { return maxInPoolUsed_; }
+
 	/**
 	 *	This method returns the expected allocation size.
 	 */
@@ -162,6 +269,12 @@ public:
 				makeWatcher( pNull->numInPoolTotal_ ) );
 		pWatcher->addChild( "numAllocatesEver",
 				makeWatcher( pNull->numAllocatesEver_ ) );
+		pWatcher->addChild( "numPoolHits",
+				makeWatcher( pNull->numPoolHits_ ) );
+		pWatcher->addChild( "hitRate",
+				makeWatcher( *pNull, &PoolAllocator< MUTEX >::hitRate ) );
+		pWatcher->addChild( "maxInPoolUsed",
+				makeWatcher( pNull->maxInPoolUsed_ ) );
 
 		pWatcher->addChild( "size", makeWatcher( pNull->size_ ) );
 
@@ -170,6 +283,68 @@ public:
 #endif
 
 private:
+	/**
+	 *	This method takes an instance from the free list, or allocates a new
+	 *	one. The mutex must be held.
+	 */
+	void * pop()
+	{
+		void * ret;
+
+		// Grab an instance from the pool if there's one available.
+		if (pHead_)
+		{
+			ret = (void*)pHead_;
+			pHead_ = pHead_->next;
+			++numPoolHits_;
+		}
+
+		// Otherwise just allocate new memory and return that instead.
+		else
+		{
+			ret = (void*)new char[ size_ ];
+			++numInPoolTotal_;
+		}
+
+		++numInPoolUsed_;
+		++numAllocatesEver_;
+
+		if (numInPoolUsed_ > maxInPoolUsed_)
+		{
+			maxInPoolUsed_ = numInPoolUsed_;
+		}
+
+		return ret;
+	}
+
+	/**
+	 *	This method returns up to the given number of instances from a thread
+	 *	cache to the pool.
+	 */
+	void release( ThreadCache & cache, uint count )
+	{
+		if ((count == 0) || (cache.pHead_ == NULL))
+		{
+			return;
+		}
+
+		mutex_.grab();
+		{
+			while ((count > 0) && cache.pHead_)
+			{
+				FreeList * pInstance = cache.pHead_;
+				cache.pHead_ = pInstance->next;
+				--cache.size_;
+				--count;
+
+				pInstance->next = pHead_;
+				pHead_ = pInstance;
+				--numInPoolUsed_;
+			}
+		}
+		mutex_.give();
+	}
+
 	/// The linked-list of memory chunks in the pool.
 	FreeList * pHead_;
 
@@ -182,6 +357,12 @@ private:
 	/// The total number of calls to allocate ever.
 	uint	numAllocatesEver_;
 
+	/// The number of calls to allocate that reused an instance in the pool.
+	uint	numPoolHits_;
+
+	/// The largest number of instances that have been used at the same time.
+	uint	maxInPoolUsed_;
+
 	/// The expected allocation size.
 	size_t	size_;
 
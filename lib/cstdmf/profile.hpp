@@ -29,6 +29,7 @@ criminal penalties as provided by law.
 
 #include "cstdmf/watcher.hpp"
 #include "cstdmf/timestamp.hpp"
+#include "cstdmf/trace_buffer.hpp"
 
 class ProfileVal;
 class ProfileGroup;
@@ -95,6 +96,8 @@ public:
 	 */
 	void start()
 	{
+		TraceBuffer::begin( name_.c_str() );
+
 		TimeStamp now = ::timestamp();
 
 		if (inProgress_ == 0)
@@ -152,6 +155,8 @@ public:
 		{
 			stack.back()->lastIntTime_ = now;
 		}
+
+		TraceBuffer::end( name_.c_str() );
 	}
 
 	/**
@@ -0,0 +1,299 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include "concurrency.hpp"
+#include "stdmf.hpp"
+
+/**
+ *	This class is a bounded queue that passes values from a single producer
+ *	thread to a single consumer thread without locking.
+ *
+ *	Only the producer may call push() and only the consumer may call pop().
+ *	The producer owns tail_ and the consumer owns head_. Each reads the other's
+ *	index to see how much of the buffer it may use.
+ */
+template <class T>
+class SPSCQueue
+{
+public:
+	SPSCQueue( uint32 capacity );
+	~SPSCQueue();
+
+	bool push( const T & value );
+	bool pop( T & value );
+
+	bool empty() const			{ return head_ == tail_; }
+	uint32 size() const			{ return tail_ - head_; }
+	uint32 capacity() const		{ return mask_ + 1; }
+
+private:
+	SPSCQueue( const SPSCQueue & );
+	SPSCQueue & operator=( const SPSCQueue & );
+
+	// The indexes are kept on separate cache lines so that the producer and
+	// consumer do not invalidate each other's cache on every operation.
+	static const int CACHE_LINE_SIZE = 64;
+
+	T * values_;
+	uint32 mask_;
+
+	char padding1_[ CACHE_LINE_SIZE ];
+
+	// The index of the next value to pop. Only written by the consumer.
+	volatile uint32 head_;
+
+	char padding2_[ CACHE_LINE_SIZE ];
+
+	// The index of the next value to push. Only written by the producer.
+	volatile uint32 tail_;
+
+	char padding3_[ CACHE_LINE_SIZE ];
+};
+
+
+/**
+ *	Constructor.
+ *
+ *	@param capacity	The maximum number of values in the queue. This is rounded
+ *					up to a power of two.
+ */
+template <class T>
+SPSCQueue< T >::SPSCQueue( uint32 capacity ) :
+	values_( NULL ),
+	mask_( 0 ),
+	head_( 0 ),
+	tail_( 0 )
+{
+	uint32 size = 1;
+
+	while (size < capacity)
+	{
+		size <<= 1;
+	}
+
+	values_ = new T[ size ];
+	mask_ = size - 1;
+}
+
+
+/**
+ *	Destructor.
+ */
+template <class T>
+SPSCQueue< T >::~SPSCQueue()
+{
+	delete [] values_;
+}
+
+
+/**
+ *	This method adds a value to the back of the queue. It must only be called
+ *	by the producer thread.
+ *
+ *	@return False if the queue is full, otherwise true.
+ */
+template <class T>
+bool SPSCQueue< T >::push( const T & value )
+{
+	const uint32 tail = tail_;
+
+	if (tail - head_ > mask_)
+	{
+		return false;
+	}
+
+	values_[ tail & mask_ ] = value;
+
+	// The value must be visible before the consumer can see the new tail.
+	memory_barrier();
+
+	tail_ = tail + 1;
+
+	return true;
+}
+
+
+/**
+ *	This method removes the value at the front of the queue. It must only be
+ *	called by the consumer thread.
+ *
+ *	@return False if the queue is empty, otherwise true.
+ */
+template <class T>
+bool SPSCQueue< T >::pop( T & value )
+{
+	const uint32 head = head_;
+
+	if (head == tail_)
+	{
+		return false;
+	}
+
+	// Do not read the value until the tail that includes it has been read.
+	memory_barrier();
+
+	T & slot = values_[ head & mask_ ];
+	value = slot;
+	slot = T();
+
+	// The slot must be finished with before the producer can reuse it.
+	memory_barrier();
+
+	head_ = head + 1;
+
+	return true;
+}
+
+
+
+/**
+ *	This class is an unbounded queue that passes values from a single producer
+ *	thread to a single consumer thread without locking.
+ *
+ *	Values are stored in a chain of SPSCQueue segments. When the producer fills
+ *	the last segment it links on a new one and never touches the old one again,
+ *	so the consumer can delete each segment once it has emptied it.
+ */
+template <class T>
+class UnboundedSPSCQueue
+{
+public:
+	UnboundedSPSCQueue( uint32 segmentSize = 256 );
+	~UnboundedSPSCQueue();
+
+	void push( const T & value );
+	bool pop( T & value );
+
+private:
+	UnboundedSPSCQueue( const UnboundedSPSCQueue & );
+	UnboundedSPSCQueue & operator=( const UnboundedSPSCQueue & );
+
+	/**
+	 *	This structure is a link in the chain of segments.
+	 */
+	struct Segment
+	{
+		Segment( uint32 size ) : queue( size ), pNext( NULL ) {}
+
+		SPSCQueue< T > queue;
+
+		// Set by the producer once it has moved on to the next segment.
+		Segment * volatile pNext;
+	};
+
+	static const int CACHE_LINE_SIZE = 64;
+
+	uint32 segmentSize_;
+
+	char padding1_[ CACHE_LINE_SIZE ];
+
+	// The segment being popped from. Only used by the consumer.
+	Segment * pHead_;
+
+	char padding2_[ CACHE_LINE_SIZE ];
+
+	// The segment being pushed to. Only used by the producer.
+	Segment * pTail_;
+
+	char padding3_[ CACHE_LINE_SIZE ];
+};
+
+
+/**
+ *	Constructor.
+ *
+ *	@param segmentSize	The number of values in each segment. This is rounded
+ *						up to a power of two.
+ */
+template <class T>
+UnboundedSPSCQueue< T >::UnboundedSPSCQueue( uint32 segmentSize ) :
+	segmentSize_( segmentSize ),
+	pHead_( new Segment( segmentSize ) ),
+	pTail_( pHead_ )
+{
+}
+
+
+/**
+ *	Destructor.
+ */
+template <class T>
+UnboundedSPSCQueue< T >::~UnboundedSPSCQueue()
+{
+	while (pHead_)
+	{
+		Segment * pNext = pHead_->pNext;
+		delete pHead_;
+		pHead_ = pNext;
+	}
+}
+
+
+/**
+ *	This method adds a value to the back of the queue. It must only be called
+ *	by the producer thread.
+ */
+template <class T>
+void UnboundedSPSCQueue< T >::push( const T & value )
+{
+	if (!pTail_->queue.push( value ))
+	{
+		Segment * pSegment = new Segment( segmentSize_ );
+		pSegment->queue.push( value );
+
+		// The new segment must be complete before the consumer can see it.
+		memory_barrier();
+
+		pTail_->pNext = pSegment;
+		pTail_ = pSegment;
+	}
+}
+
+
+/**
+ *	This method removes the value at the front of the queue. It must only be
+ *	called by the consumer thread.
+ *
+ *	@return False if the queue is empty, otherwise true.
+ */
+template <class T>
+bool UnboundedSPSCQueue< T >::pop( T & value )
+{
+	while (!pHead_->queue.pop( value ))
+	{
+		Segment * pNext = pHead_->pNext;
+
+		if (pNext == NULL)
+		{
+			return false;
+		}
+
+		// The producer pushed its last value to this segment before linking
+		// the next one, so look again before deleting it.
+		memory_barrier();
+
+		if (pHead_->queue.pop( value ))
+		{
+			return true;
+		}
+
+		delete pHead_;
+		pHead_ = pNext;
+	}
+
+	return true;
+}
+
+#endif // SPSC_QUEUE_HPP
@@ -68,7 +68,17 @@ protected:
 class TimeQueueBase
 {
 public:
-	virtual void onCancel() = 0;
+	/// This enumeration describes how a time queue orders its timers.
+	enum Implementation
+	{
+		/// A binary heap. Adding and cancelling timers is O(log n).
+		BINARY_HEAP,
+
+		/// A hierarchical timing wheel. Adding and cancelling timers is O(1).
+		TIMING_WHEEL
+	};
+
+	virtual void onCancel( TimeQueueNode * pNode ) = 0;
 };
 
 
@@ -81,7 +91,7 @@ template< class TIME_STAMP >
 class TimeQueueT : public TimeQueueBase
 {
 public:
-	TimeQueueT();
+	TimeQueueT( Implementation implementation = BINARY_HEAP );
 	~TimeQueueT();
 
 	void clear( bool shouldCallCancel = true );
@@ -104,10 +114,22 @@ public:
 	TIME_STAMP nextExp( TimeStamp now ) const;
 
 	/// Returns the number of timers in the queue
-	inline uint32 size() const	{ return timeQueue_.size(); }
+	inline uint32 size() const
+	{
+		return pTimingWheel_ ? pTimingWheel_->size() : timeQueue_.size();
+	}
 
 	/// Returns whether the time queue is empty.
-	inline bool empty() const	{ return timeQueue_.empty(); }
+	inline bool empty() const
+	{
+		return pTimingWheel_ ? pTimingWheel_->empty() : timeQueue_.empty();
+	}
+
+	/// Returns how this time queue orders its timers.
+	Implementation implementation() const
+	{
+		return pTimingWheel_ ? TIMING_WHEEL : BINARY_HEAP;
+	}
 
 	bool		getTimerInfo( TimerHandle handle,
 					TimeStamp &			time,
@@ -120,7 +142,16 @@ public:
 
 private:
 	void purgeCancelledNodes();
-	void onCancel();
+	void onCancel( TimeQueueNode * pNode );
+
+	class Node;
+
+	/// This structure is a list of the timers in one slot of a TimingWheel.
+	struct WheelSlot
+	{
+		Node * pHead_;
+		Node ** ppTail_;
+	};
 
 	/// This structure represents one event in the time queue.
 	class Node : public TimeQueueNode
@@ -137,6 +168,11 @@ private:
 
 		void triggerTimer();
 
+		/// The TimingWheel slot that this node is in, if any.
+		WheelSlot *			pWheelSlot_;
+		Node *				pWheelNext_;
+		Node **				ppWheelPrev_;
+
 	private:
 		TimeStamp			time_;
 		TimeStamp			interval_;
@@ -216,7 +252,62 @@ private:
 		Container container_;
 	};
 
+	/**
+	 *	This class implements a hierarchical timing wheel. Each level has 256
+	 *	slots, each covering 256 times the range of a slot on the level below,
+	 *	so that a timer is placed by the highest byte of its time that differs
+	 *	from the wheel's current time. Timers are cascaded to lower levels as
+	 *	time advances. Adding and removing timers is O(1).
+	 */
+	class TimingWheel
+	{
+	public:
+		TimingWheel();
+
+		bool empty() const				{ return size_ == 0; }
+		uint32 size() const				{ return size_; }
+
+		void push( Node * pNode );
+		void remove( Node * pNode );
+
+		Node * popExpired( TimeStamp now );
+		Node * popAny();
+
+		TimeStamp nextTime() const;
+
+		bool contains( const Node * pNode ) const;
+
+	private:
+		enum
+		{
+			BITS_PER_LEVEL = 8,
+			SLOTS_PER_LEVEL = 1 << BITS_PER_LEVEL,
+			NUM_LEVELS = (sizeof( TIME_STAMP ) * 8) / BITS_PER_LEVEL,
+			WORDS_PER_LEVEL = SLOTS_PER_LEVEL / 32
+		};
+
+		void append( WheelSlot & slot, Node * pNode );
+		bool findFirst( int & level, int & index ) const;
+		TimeStamp slotTime( int level, int index ) const;
+
+		void setOccupied( int level, int index );
+		void clearOccupied( int level, int index );
+
+		WheelSlot	slots_[ NUM_LEVELS ][ SLOTS_PER_LEVEL ];
+		uint32		occupied_[ NUM_LEVELS ][ WORDS_PER_LEVEL ];
+
+		/// Timers that are due as of currentTime_.
+		WheelSlot	expired_;
+
+		TimeStamp	currentTime_;
+		uint32		size_;
+
+		TimingWheel( const TimingWheel & );
+		TimingWheel & operator=( const TimingWheel & );
+	};
+
 	PriorityQueue	timeQueue_;
+	TimingWheel *	pTimingWheel_;
 	Node * 			pProcessingNode_;
 	TimeStamp 		lastProcessTime_;
 	int				numCancelled_;
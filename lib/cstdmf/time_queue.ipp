@@ -17,8 +17,10 @@ criminal penalties as provided by law.
  *	This is the constructor.
  */
 template< class TIME_STAMP >
-TimeQueueT< TIME_STAMP >::TimeQueueT() :
+TimeQueueT< TIME_STAMP >::TimeQueueT( Implementation implementation ) :
 	timeQueue_(),
+	pTimingWheel_( (implementation == TIMING_WHEEL) ?
+		new TimingWheel() : NULL ),
 	pProcessingNode_( NULL ),
 	lastProcessTime_( 0 ),
 	numCancelled_( 0 )
@@ -33,6 +35,8 @@ template <class TIME_STAMP>
 TimeQueueT< TIME_STAMP >::~TimeQueueT()
 {
 	this->clear();
+
+	delete pTimingWheel_;
 }
 
 
@@ -43,7 +47,31 @@ template <class TIME_STAMP>
 void TimeQueueT< TIME_STAMP >::clear( bool shouldCallCancel )
 {
 	// Make sure we don't loop forever
-	int maxLoopCount = timeQueue_.size();
+	int maxLoopCount = this->size();
+
+	if (pTimingWheel_)
+	{
+		// Nodes in the wheel are never cancelled. Once popped, cancelling a
+		// node does not affect the wheel.
+		Node * pNode;
+
+		while ((pNode = pTimingWheel_->popAny()) != NULL)
+		{
+			if (shouldCallCancel)
+			{
+				pNode->cancel();
+
+				if (--maxLoopCount == 0)
+				{
+					shouldCallCancel = false;
+				}
+			}
+
+			delete pNode;
+		}
+
+		return;
+	}
 
 	while (!timeQueue_.empty())
 	{
@@ -90,7 +118,15 @@ TimerHandle TimeQueueT< TIME_STAMP >::add( TimeStamp startTime,
 		TimeStamp interval, TimerHandler * pHandler, void * pUser )
 {
 	Node * pNode = new Node( *this, startTime, interval, pHandler, pUser );
-	timeQueue_.push( pNode );
+
+	if (pTimingWheel_)
+	{
+		pTimingWheel_->push( pNode );
+	}
+	else
+	{
+		timeQueue_.push( pNode );
+	}
 
 	return TimerHandle( pNode );
 }
@@ -100,8 +136,23 @@ TimerHandle TimeQueueT< TIME_STAMP >::add( TimeStamp startTime,
  *	This method is called when a timer has been cancelled.
  */
 template <class TIME_STAMP>
-void TimeQueueT< TIME_STAMP >::onCancel()
+void TimeQueueT< TIME_STAMP >::onCancel( TimeQueueNode * pTimeQueueNode )
 {
+	if (pTimingWheel_)
+	{
+		// Cancelled nodes are removed from the wheel immediately, unless they
+		// are not in it because they are being processed or cleared.
+		Node * pNode = static_cast< Node * >( pTimeQueueNode );
+
+		if (pNode->pWheelSlot_ != NULL)
+		{
+			pTimingWheel_->remove( pNode );
+			delete pNode;
+		}
+
+		return;
+	}
+
 	++numCancelled_;
 
 	// If there are too many cancelled timers in the queue (more than half),
@@ -175,6 +226,33 @@ int TimeQueueT< TIME_STAMP >::process( TimeStamp now )
 {
 	int numFired = 0;
 
+	if (pTimingWheel_)
+	{
+		Node * pNode;
+
+		while ((pNode = pTimingWheel_->popExpired( now )) != NULL)
+		{
+			pProcessingNode_ = pNode;
+
+			++numFired;
+			pNode->triggerTimer();
+
+			if (!pNode->isCancelled())
+			{
+				pTimingWheel_->push( pNode );
+			}
+			else
+			{
+				delete pNode;
+			}
+		}
+
+		pProcessingNode_ = NULL;
+		lastProcessTime_ = now;
+
+		return numFired;
+	}
+
 	while ((!timeQueue_.empty()) && (
 		timeQueue_.top()->time() <= now ||
 		timeQueue_.top()->isCancelled()))
@@ -228,6 +306,11 @@ bool TimeQueueT< TIME_STAMP >::legal( TimerHandle handle ) const
 		return true;
 	}
 
+	if (pTimingWheel_)
+	{
+		return pTimingWheel_->contains( pNode );
+	}
+
 	NodeIter begin = &timeQueue_.top();
 	NodeIter end = begin + timeQueue_.size();
 
@@ -248,6 +331,18 @@ bool TimeQueueT< TIME_STAMP >::legal( TimerHandle handle ) const
 template <class TIME_STAMP>
 TIME_STAMP TimeQueueT< TIME_STAMP >::nextExp( TimeStamp now ) const
 {
+	if (pTimingWheel_)
+	{
+		if (pTimingWheel_->empty())
+		{
+			return 0;
+		}
+
+		TimeStamp nextTime = pTimingWheel_->nextTime();
+
+		return (now > nextTime) ? 0 : nextTime - now;
+	}
+
 	if (timeQueue_.empty() ||
 		now > timeQueue_.top()->time())
 	{
@@ -360,7 +455,7 @@ void TimeQueueNode::cancel()
 		pHandler_ = NULL;
 	}
 
-	owner_.onCancel();
+	owner_.onCancel( this );
 }
 
 
@@ -376,6 +471,9 @@ TimeQueueT< TIME_STAMP >::Node::Node( TimeQueueBase & owner,
 		TimeStamp startTime, TimeStamp interval,
 		TimerHandler * _pHandler, void * _pUser ) :
 	TimeQueueNode( owner, _pHandler, _pUser ),
+	pWheelSlot_( NULL ),
+	pWheelNext_( NULL ),
+	ppWheelPrev_( NULL ),
 	time_( startTime ),
 	interval_( interval )
 {
@@ -422,4 +520,331 @@ void TimeQueueT< TIME_STAMP >::Node::triggerTimer()
 
 
 
+// -----------------------------------------------------------------------------
+// Section: TimeQueueT::TimingWheel
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+template <class TIME_STAMP>
+TimeQueueT< TIME_STAMP >::TimingWheel::TimingWheel() :
+	currentTime_( 0 ),
+	size_( 0 )
+{
+	for (int level = 0; level < NUM_LEVELS; ++level)
+	{
+		for (int index = 0; index < SLOTS_PER_LEVEL; ++index)
+		{
+			WheelSlot & slot = slots_[ level ][ index ];
+			slot.pHead_ = NULL;
+			slot.ppTail_ = &slot.pHead_;
+		}
+
+		for (int word = 0; word < WORDS_PER_LEVEL; ++word)
+		{
+			occupied_[ level ][ word ] = 0;
+		}
+	}
+
+	expired_.pHead_ = NULL;
+	expired_.ppTail_ = &expired_.pHead_;
+}
+
+
+/**
+ *	This method adds a node to the wheel. Nodes that are due as of the wheel's
+ *	current time are delivered by the next call to popExpired().
+ */
+template <class TIME_STAMP>
+void TimeQueueT< TIME_STAMP >::TimingWheel::push( Node * pNode )
+{
+	const TimeStamp time = pNode->time();
+
+	if (time <= currentTime_)
+	{
+		this->append( expired_, pNode );
+		return;
+	}
+
+	// The level is that of the highest byte that differs from the current
+	// time. All lower levels cover times that share this byte.
+	const TimeStamp diff = time ^ currentTime_;
+	int level = NUM_LEVELS - 1;
+
+	while ((diff >> (level * BITS_PER_LEVEL)) == 0)
+	{
+		--level;
+	}
+
+	const int index =
+		int( (time >> (level * BITS_PER_LEVEL)) & (SLOTS_PER_LEVEL - 1) );
+
+	this->append( slots_[ level ][ index ], pNode );
+	this->setOccupied( level, index );
+}
+
+
+/**
+ *	This method removes a node from the wheel.
+ */
+template <class TIME_STAMP>
+void TimeQueueT< TIME_STAMP >::TimingWheel::remove( Node * pNode )
+{
+	WheelSlot & slot = *pNode->pWheelSlot_;
+
+	*pNode->ppWheelPrev_ = pNode->pWheelNext_;
+
+	if (pNode->pWheelNext_)
+	{
+		pNode->pWheelNext_->ppWheelPrev_ = pNode->ppWheelPrev_;
+	}
+	else
+	{
+		slot.ppTail_ = pNode->ppWheelPrev_;
+	}
+
+	pNode->pWheelSlot_ = NULL;
+	pNode->pWheelNext_ = NULL;
+	pNode->ppWheelPrev_ = NULL;
+	--size_;
+
+	if ((slot.pHead_ == NULL) && (&slot != &expired_))
+	{
+		const int slotNumber = int( &slot - &slots_[ 0 ][ 0 ] );
+
+		this->clearOccupied( slotNumber / SLOTS_PER_LEVEL,
+				slotNumber % SLOTS_PER_LEVEL );
+	}
+}
+
+
+/**
+ *	This method removes and returns the next node that is due at the given
+ *	time, or NULL if there are none. Nodes due at the same time are returned
+ *	in the order they were added.
+ */
+template <class TIME_STAMP>
+typename TimeQueueT< TIME_STAMP >::Node *
+	TimeQueueT< TIME_STAMP >::TimingWheel::popExpired( TimeStamp now )
+{
+	while (expired_.pHead_ == NULL)
+	{
+		int level;
+		int index;
+
+		if (!this->findFirst( level, index ) ||
+				(this->slotTime( level, index ) > now))
+		{
+			// Nothing is due. Nodes that are left in the wheel are still
+			// correctly placed relative to now.
+			if (now > currentTime_)
+			{
+				currentTime_ = now;
+			}
+
+			return NULL;
+		}
+
+		// Advance to the start of the earliest slot and cascade its nodes
+		// into the lower levels, or into expired_.
+		currentTime_ = this->slotTime( level, index );
+
+		WheelSlot & slot = slots_[ level ][ index ];
+		Node * pNode = slot.pHead_;
+
+		slot.pHead_ = NULL;
+		slot.ppTail_ = &slot.pHead_;
+		this->clearOccupied( level, index );
+
+		while (pNode != NULL)
+		{
+			Node * pNext = pNode->pWheelNext_;
+			--size_;
+			this->push( pNode );
+			pNode = pNext;
+		}
+	}
+
+	Node * pNode = expired_.pHead_;
+	this->remove( pNode );
+
+	return pNode;
+}
+
+
+/**
+ *	This method removes and returns any node in the wheel, or NULL if the wheel
+ *	is empty.
+ */
+template <class TIME_STAMP>
+typename TimeQueueT< TIME_STAMP >::Node *
+	TimeQueueT< TIME_STAMP >::TimingWheel::popAny()
+{
+	Node * pNode = expired_.pHead_;
+
+	int level;
+	int index;
+
+	if ((pNode == NULL) && this->findFirst( level, index ))
+	{
+		pNode = slots_[ level ][ index ].pHead_;
+	}
+
+	if (pNode != NULL)
+	{
+		this->remove( pNode );
+	}
+
+	return pNode;
+}
+
+
+/**
+ *	This method returns the time of the earliest node in the wheel. If that
+ *	node has not yet been cascaded to the lowest level, the start of its slot
+ *	is returned instead, which may be earlier. The wheel must not be empty.
+ */
+template <class TIME_STAMP>
+TIME_STAMP TimeQueueT< TIME_STAMP >::TimingWheel::nextTime() const
+{
+	int level;
+	int index;
+
+	if ((expired_.pHead_ != NULL) || !this->findFirst( level, index ))
+	{
+		return currentTime_;
+	}
+
+	return this->slotTime( level, index );
+}
+
+
+/**
+ *	This method returns whether the given node is in the wheel. It is slow.
+ */
+template <class TIME_STAMP>
+bool TimeQueueT< TIME_STAMP >::TimingWheel::contains(
+		const Node * pNode ) const
+{
+	for (const Node * pCurr = expired_.pHead_;
+			pCurr != NULL; pCurr = pCurr->pWheelNext_)
+	{
+		if (pCurr == pNode)
+		{
+			return true;
+		}
+	}
+
+	for (int level = 0; level < NUM_LEVELS; ++level)
+	{
+		for (int index = 0; index < SLOTS_PER_LEVEL; ++index)
+		{
+			for (const Node * pCurr = slots_[ level ][ index ].pHead_;
+					pCurr != NULL; pCurr = pCurr->pWheelNext_)
+			{
+				if (pCurr == pNode)
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ *	This method adds a node to the end of a slot.
+ */
+template <class TIME_STAMP>
+void TimeQueueT< TIME_STAMP >::TimingWheel::append( WheelSlot & slot,
+		Node * pNode )
+{
+	pNode->pWheelSlot_ = &slot;
+	pNode->pWheelNext_ = NULL;
+	pNode->ppWheelPrev_ = slot.ppTail_;
+
+	*slot.ppTail_ = pNode;
+	slot.ppTail_ = &pNode->pWheelNext_;
+
+	++size_;
+}
+
+
+/**
+ *	This method finds the earliest occupied slot. Since a node is placed at
+ *	the level of the highest byte that differs from the current time, nodes on
+ *	a lower level are always earlier than those on a higher level.
+ *
+ *	@return	True if a slot was found, false if the wheel has no occupied slots.
+ */
+template <class TIME_STAMP>
+bool TimeQueueT< TIME_STAMP >::TimingWheel::findFirst(
+		int & level, int & index ) const
+{
+	for (level = 0; level < NUM_LEVELS; ++level)
+	{
+		for (int word = 0; word < WORDS_PER_LEVEL; ++word)
+		{
+			uint32 bits = occupied_[ level ][ word ];
+
+			if (bits != 0)
+			{
+				index = word * 32;
+
+				while ((bits & 1) == 0)
+				{
+					bits >>= 1;
+					++index;
+				}
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ *	This method returns the earliest time covered by the given slot.
+ */
+template <class TIME_STAMP>
+TIME_STAMP TimeQueueT< TIME_STAMP >::TimingWheel::slotTime(
+		int level, int index ) const
+{
+	const int shift = (level + 1) * BITS_PER_LEVEL;
+
+	// Levels above this one share the current time's bytes.
+	const TimeStamp upper = (level + 1 < NUM_LEVELS) ?
+		(currentTime_ >> shift) << shift : 0;
+
+	return upper | (TimeStamp( index ) << (level * BITS_PER_LEVEL));
+}
+
+
+/**
+ *	This method marks the given slot as containing nodes.
+ */
+template <class TIME_STAMP>
+void TimeQueueT< TIME_STAMP >::TimingWheel::setOccupied( int level, int index )
+{
+	occupied_[ level ][ index / 32 ] |= (1U << (index % 32));
+}
+
+
+/**
+ *	This method marks the given slot as empty.
+ */
+template <class TIME_STAMP>
+void TimeQueueT< TIME_STAMP >::TimingWheel::clearOccupied(
+		int level, int index )
+{
+	occupied_[ level ][ index / 32 ] &= ~(1U << (index % 32));
+}
+
+
 // time_queue.ipp
@@ -69,7 +69,7 @@ static uint64 calcStampsPerSecond_rdtsc()
 	/* If we do these in the same order, then as long as the offset of
 	the time returned by gettimeofday is consistent, we should be ok. */
 	gettimeofday( &tvBefore, NULL );
-	stampBefore = timestamp();
+	stampBefore = timestamp_rdtsc();
 
 	select( 0, NULL, NULL, NULL, &tvSleep );
 
@@ -78,7 +78,7 @@ static uint64 calcStampsPerSecond_rdtsc()
 	gettimeofday( &tvAfter, NULL );
 
 	gettimeofday( &tvAfter, NULL );
-	stampAfter = timestamp();
+	stampAfter = timestamp_rdtsc();
 
 	uint64 microDelta =
 		(tvAfter.tv_usec + 1000000 - tvBefore.tv_usec) % 1000000;
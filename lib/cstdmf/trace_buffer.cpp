@@ -0,0 +1,411 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "pch.hpp"
+
+#include "trace_buffer.hpp"
+
+#include "concurrency.hpp"
+#include "debug.hpp"
+#include "watcher.hpp"
+
+#include <fstream>
+#include <stdio.h>
+#include <vector>
+
+DECLARE_DEBUG_COMPONENT2( "CStdMF", 0 )
+
+// -----------------------------------------------------------------------------
+// Section: TraceRing
+// -----------------------------------------------------------------------------
+
+namespace
+{
+
+/**
+ *	This structure is a single entry in a ring.
+ */
+struct TraceEvent
+{
+	uint64 time;
+	const char * name;
+};
+
+
+/**
+ *	This class is the ring of events for a single thread. Only the owning
+ *	thread writes to it. Rings are never deleted, so that the events of
+ *	threads that have finished can still be dumped.
+ */
+class TraceRing
+{
+public:
+	TraceRing( int id, bool isMainThread ) :
+		numRecorded_( 0 ),
+		id_( id ),
+		isMainThread_( isMainThread )
+	{
+	}
+
+	void record( const char * name, uint64 time )
+	{
+		TraceEvent & event =
+			events_[ numRecorded_ & (TraceBuffer::NUM_EVENTS - 1) ];
+		event.time = time;
+		event.name = name;
+
+		++numRecorded_;
+	}
+
+	void copyEvents( std::vector< TraceEvent > & events ) const;
+
+	int id() const					{ return id_; }
+	bool isMainThread() const		{ return isMainThread_; }
+
+private:
+	TraceEvent events_[ TraceBuffer::NUM_EVENTS ];
+	volatile uint32 numRecorded_;
+
+	int id_;
+	bool isMainThread_;
+};
+
+
+/**
+ *	This method copies the events in this ring, oldest first. It may be called
+ *	from any thread.
+ *
+ *	If the owning thread is still recording, this is best-effort. The oldest
+ *	part of the ring is skipped, since it is the part that the owner may
+ *	overwrite while the copy is being made.
+ */
+void TraceRing::copyEvents( std::vector< TraceEvent > & events ) const
+{
+	const uint32 MAX_EVENTS =
+		TraceBuffer::NUM_EVENTS - TraceBuffer::NUM_EVENTS/16;
+
+	const uint32 end = numRecorded_;
+	memory_barrier();
+
+	const uint32 begin = (end > MAX_EVENTS) ? end - MAX_EVENTS : 0;
+
+	events.clear();
+	events.reserve( end - begin );
+
+	for (uint32 i = begin; i != end; ++i)
+	{
+		events.push_back( events_[ i & (TraceBuffer::NUM_EVENTS - 1) ] );
+	}
+}
+
+
+/// The ring of the current thread, or NULL if it has not recorded anything.
+THREADLOCAL( TraceRing * ) s_pRing = NULL;
+
+/// All rings that have been created. This is protected by s_ringsLock.
+std::vector< TraceRing * > s_rings;
+SimpleMutex s_ringsLock;
+
+std::string s_lastDumpFilename;
+
+
+/**
+ *	This function writes a string as a JSON string literal.
+ */
+void writeJSONString( std::ostream & stream, const char * str )
+{
+	stream << '"';
+
+	for (const char * pChar = str; *pChar; ++pChar)
+	{
+		const char c = *pChar;
+
+		if (c == '"' || c == '\\')
+		{
+			stream << '\\' << c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			char buf[8];
+			bw_snprintf( buf, sizeof( buf ), "\\u%04x", c );
+			stream << buf;
+		}
+		else
+		{
+			stream << c;
+		}
+	}
+
+	stream << '"';
+}
+
+} // anonymous namespace
+
+
+// -----------------------------------------------------------------------------
+// Section: TraceBuffer
+// -----------------------------------------------------------------------------
+
+bool TraceBuffer::s_isEnabled_ = false;
+double TraceBuffer::s_tickThreshold_ = 0.2;
+double TraceBuffer::s_dumpPeriod_ = 5.0;
+
+
+/**
+ *	This method sets whether scopes are recorded. The cycle counter is
+ *	calibrated when tracing is first enabled, since that takes a while and
+ *	should not happen in the middle of a slow tick.
+ */
+void TraceBuffer::isEnabled( bool value )
+{
+	if (value && !s_isEnabled_)
+	{
+		TraceBuffer::traceStampsPerSecond();
+	}
+
+	s_isEnabled_ = value;
+}
+
+
+/**
+ *	This method returns the number of traceTimestamp() units per second.
+ */
+double TraceBuffer::traceStampsPerSecond()
+{
+#ifdef unix
+	return stampsPerSecondD_rdtsc();
+#else
+	return stampsPerSecondD();
+#endif
+}
+
+
+/**
+ *	This method adds an event to the ring of the current thread, creating the
+ *	ring if this is the first event from this thread.
+ */
+void TraceBuffer::record( const char * name, uint64 time )
+{
+	TraceRing * pRing = s_pRing;
+
+	if (pRing == NULL)
+	{
+		SimpleMutexHolder smh( s_ringsLock );
+
+		pRing = new TraceRing( int( s_rings.size() ),
+			MainThreadTracker::isCurrentThreadMain() );
+		s_rings.push_back( pRing );
+		s_pRing = pRing;
+	}
+
+	pRing->record( name, time );
+}
+
+
+/**
+ *	This method should be called once per tick by the main thread. It records
+ *	the tick boundary and, if the last tick took longer than tickThreshold(),
+ *	dumps the last dumpPeriod() seconds to a file named
+ *	trace_<pid>_<n>.json in the current directory.
+ *
+ *	At most one dump is written per dumpPeriod() so that a run of slow ticks
+ *	does not write the same events many times.
+ */
+void TraceBuffer::tick()
+{
+	static const char * TICK_NAME = "Tick";
+
+	static uint64 s_lastTickTime = 0;
+	static uint64 s_lastDumpTime = 0;
+	static int s_numDumps = 0;
+
+	if (!s_isEnabled_)
+	{
+		s_lastTickTime = 0;
+		return;
+	}
+
+	const uint64 now = traceTimestamp();
+
+	TraceBuffer::record( TICK_NAME, now | END_FLAG );
+	TraceBuffer::record( TICK_NAME, now );
+
+	const double tickDuration =
+		double( now - s_lastTickTime ) / traceStampsPerSecond();
+
+	if ((s_lastTickTime != 0) &&
+		(s_tickThreshold_ > 0.0) &&
+		(tickDuration > s_tickThreshold_) &&
+		((s_lastDumpTime == 0) ||
+		 (double( now - s_lastDumpTime ) / traceStampsPerSecond() >
+		 	s_dumpPeriod_)))
+	{
+		char filename[ 64 ];
+		bw_snprintf( filename, sizeof( filename ), "trace_%d_%d.json",
+			mf_getpid(), ++s_numDumps );
+
+		WARNING_MSG( "TraceBuffer::tick: Tick took %.3f seconds. "
+				"Writing the last %.1f seconds of events to %s\n",
+			tickDuration, s_dumpPeriod_, filename );
+
+		TraceBuffer::dump( filename, s_dumpPeriod_ );
+		s_lastDumpTime = now;
+	}
+
+	s_lastTickTime = now;
+}
+
+
+/**
+ *	This method writes the events of the last period seconds to a file.
+ *
+ *	@return True on success, otherwise false.
+ */
+bool TraceBuffer::dump( const std::string & filename, double period )
+{
+	std::ofstream stream( filename.c_str() );
+
+	if (!stream)
+	{
+		ERROR_MSG( "TraceBuffer::dump: Could not open %s\n", filename.c_str() );
+		return false;
+	}
+
+	TraceBuffer::writeChromeTrace( stream, period );
+	s_lastDumpFilename = filename;
+
+	return stream.good();
+}
+
+
+/**
+ *	This method writes the events of the last period seconds of every thread
+ *	in the Chrome trace event JSON format. Timestamps are in microseconds
+ *	from the start of the period.
+ */
+void TraceBuffer::writeChromeTrace( std::ostream & stream, double period )
+{
+	std::vector< TraceRing * > rings;
+
+	{
+		SimpleMutexHolder smh( s_ringsLock );
+		rings = s_rings;
+	}
+
+	const double stampsPerMicrosecond = traceStampsPerSecond() / 1000000.0;
+	const uint64 now = traceTimestamp();
+	const uint64 periodInStamps = uint64( period * traceStampsPerSecond() );
+	const uint64 startTime =
+		(now > periodInStamps) ? now - periodInStamps : 0;
+
+	const int pid = mf_getpid();
+	const char * separator = "\n";
+	char buf[ 128 ];
+
+	stream << "{\"traceEvents\":[";
+
+	std::vector< TraceEvent > events;
+
+	for (size_t i = 0; i < rings.size(); ++i)
+	{
+		const TraceRing & ring = *rings[i];
+
+		bw_snprintf( buf, sizeof( buf ), "%s{\"name\":\"thread_name\","
+				"\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+				"\"args\":{\"name\":\"%s %d\"}}",
+			separator, pid, ring.id(),
+			ring.isMainThread() ? "Main" : "Thread", ring.id() );
+		stream << buf;
+		separator = ",\n";
+
+		ring.copyEvents( events );
+
+		for (size_t j = 0; j < events.size(); ++j)
+		{
+			const TraceEvent & event = events[j];
+			const bool isEnd = (event.time & END_FLAG) != 0;
+			const uint64 time = event.time & ~END_FLAG;
+
+			if (time < startTime)
+			{
+				continue;
+			}
+
+			stream << separator << "{\"name\":";
+			writeJSONString( stream, event.name );
+
+			bw_snprintf( buf, sizeof( buf ),
+				",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+				isEnd ? 'E' : 'B',
+				double( time - startTime ) / stampsPerMicrosecond,
+				pid, ring.id() );
+			stream << buf;
+		}
+	}
+
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+
+/**
+ *	This method returns the name of the last file written by dump().
+ */
+const std::string & TraceBuffer::lastDumpFilename()
+{
+	return s_lastDumpFilename;
+}
+
+
+#if ENABLE_WATCHERS
+namespace
+{
+
+bool getIsEnabled()						{ return TraceBuffer::isEnabled(); }
+void setIsEnabled( bool value )			{ TraceBuffer::isEnabled( value ); }
+
+double getTickThreshold()				{ return TraceBuffer::tickThreshold(); }
+void setTickThreshold( double value )	{ TraceBuffer::tickThreshold( value ); }
+
+double getDumpPeriod()					{ return TraceBuffer::dumpPeriod(); }
+void setDumpPeriod( double value )		{ TraceBuffer::dumpPeriod( value ); }
+
+std::string getLastDump()				{ return TraceBuffer::lastDumpFilename(); }
+
+void setDump( std::string filename )
+{
+	TraceBuffer::dump( filename, TraceBuffer::dumpPeriod() );
+}
+
+} // anonymous namespace
+
+
+/**
+ *	This method adds the watchers that control tracing.
+ */
+void TraceBuffer::addWatchers()
+{
+	MF_WATCH( "debug/trace/enabled", &getIsEnabled, &setIsEnabled,
+		"Whether the start and end of each profile and DogWatch scope is "
+		"recorded" );
+	MF_WATCH( "debug/trace/tickThreshold", &getTickThreshold,
+		&setTickThreshold,
+		"The tick duration in seconds above which recent events are dumped "
+		"to a file. Zero disables automatic dumps" );
+	MF_WATCH( "debug/trace/dumpPeriod", &getDumpPeriod, &setDumpPeriod,
+		"The number of seconds of events to dump" );
+	MF_WATCH( "debug/trace/dump", &getLastDump, &setDump,
+		"Set to a filename to dump recent events to that file in the Chrome "
+		"trace event format" );
+}
+
+#endif // ENABLE_WATCHERS
+
+// trace_buffer.cpp
@@ -0,0 +1,106 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef TRACE_BUFFER_HPP
+#define TRACE_BUFFER_HPP
+
+#include "cstdmf/config.hpp"
+#include "cstdmf/stdmf.hpp"
+#include "cstdmf/timestamp.hpp"
+
+#include <iosfwd>
+#include <string>
+
+/**
+ *	This class records the beginning and end of profiled scopes into a fixed
+ *	size ring for each thread, so that the last few seconds before a slow tick
+ *	can be examined in detail rather than only through running averages.
+ *
+ *	ProfileVal and DogWatch scopes are recorded automatically while tracing is
+ *	enabled. When disabled, a scope costs a single load and branch. Each
+ *	thread's ring is allocated the first time that thread records an event.
+ *
+ *	The names passed to begin() and end() are stored by pointer, so they must
+ *	outlive the ring. Profile and DogWatch names always do.
+ *
+ *	The rings can be written out in the Chrome trace event format (see
+ *	chrome://tracing) either on demand or automatically by tick() when a tick
+ *	takes longer than tickThreshold().
+ */
+class TraceBuffer
+{
+public:
+	/// The number of events kept for each thread. This must be a power of two.
+	static const uint32 NUM_EVENTS = 1 << 14;
+
+	static void begin( const char * name )
+	{
+		if (s_isEnabled_)
+		{
+			TraceBuffer::record( name, traceTimestamp() );
+		}
+	}
+
+	static void end( const char * name )
+	{
+		if (s_isEnabled_)
+		{
+			TraceBuffer::record( name, traceTimestamp() | END_FLAG );
+		}
+	}
+
+	static bool isEnabled()					{ return s_isEnabled_; }
+	static void isEnabled( bool value );
+
+	static double tickThreshold()			{ return s_tickThreshold_; }
+	static void tickThreshold( double value ) { s_tickThreshold_ = value; }
+
+	static double dumpPeriod()				{ return s_dumpPeriod_; }
+	static void dumpPeriod( double value )	{ s_dumpPeriod_ = value; }
+
+	static void tick();
+
+	static bool dump( const std::string & filename, double period );
+	static void writeChromeTrace( std::ostream & stream, double period );
+
+	static const std::string & lastDumpFilename();
+
+#if ENABLE_WATCHERS
+	static void addWatchers();
+#endif
+
+private:
+	/// The bit of an event's time that marks the end of a scope.
+	static const uint64 END_FLAG = uint64( 1 ) << 63;
+
+	/**
+	 *	This method returns the time of an event. This is always the cycle
+	 *	counter, since on Linux timestamp() may be a system call.
+	 */
+	static uint64 traceTimestamp()
+	{
+#ifdef unix
+		return timestamp_rdtsc();
+#else
+		return timestamp();
+#endif
+	}
+
+	static double traceStampsPerSecond();
+
+	static void record( const char * name, uint64 time );
+
+	static bool s_isEnabled_;
+	static double s_tickThreshold_;
+	static double s_dumpPeriod_;
+};
+
+#endif // TRACE_BUFFER_HPP
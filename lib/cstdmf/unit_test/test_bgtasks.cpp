@@ -13,9 +13,17 @@ criminal penalties as provided by law.
 
 #include "cstdmf/debug.hpp"
 #include "cstdmf/bgtask_manager.hpp"
+#include "cstdmf/timestamp.hpp"
+
+#include <algorithm>
+#include <vector>
 
 #include <stdio.h>
 
+#ifndef _WIN32
+#include <sched.h>
+#endif
+
 class MyTask : public BackgroundTask
 {
 public:
@@ -80,4 +88,281 @@ TEST( BgTaskMgr )
 	CHECK_EQUAL( COUNT, delCount );
 }
 
+
+namespace
+{
+
+/**
+ *	This function gives up the rest of the current thread's time slice.
+ */
+void yieldThread()
+{
+#ifdef _WIN32
+	Sleep( 0 );
+#else
+	sched_yield();
+#endif
+}
+
+
+/**
+ *	This class is a task that waits until it is released. It is used to keep
+ *	the only background thread busy while other tasks are queued.
+ */
+class BlockingTask : public BackgroundTask
+{
+public:
+	BlockingTask( volatile bool & isReleased ) : isReleased_( isReleased ) {}
+
+	virtual void doBackgroundTask( BgTaskManager & mgr )
+	{
+		while (!isReleased_)
+		{
+			yieldThread();
+		}
+	}
+
+private:
+	volatile bool & isReleased_;
+};
+
+
+/**
+ *	This class is a task that counts that it has started and then waits until
+ *	it is released. It is used to keep a known background thread busy.
+ */
+class GateTask : public BackgroundTask
+{
+public:
+	GateTask( volatile int & numStarted, volatile bool & isReleased ) :
+		numStarted_( numStarted ),
+		isReleased_( isReleased )
+	{}
+
+	virtual void doBackgroundTask( BgTaskManager & mgr )
+	{
+		{
+			SimpleMutexHolder lock( s_mutex_ );
+			++numStarted_;
+		}
+
+		while (!isReleased_)
+		{
+			yieldThread();
+		}
+	}
+
+private:
+	volatile int & numStarted_;
+	volatile bool & isReleased_;
+
+	static SimpleMutex s_mutex_;
+};
+
+SimpleMutex GateTask::s_mutex_;
+
+
+/**
+ *	This class is a task that records the order in which it was run.
+ */
+class OrderedTask : public BackgroundTask
+{
+public:
+	OrderedTask( std::vector< int > & order, int id ) :
+		order_( order ),
+		id_( id )
+	{}
+
+	virtual void doBackgroundTask( BgTaskManager & mgr )
+	{
+		order_.push_back( id_ );
+	}
+
+private:
+	std::vector< int > & order_;
+	int id_;
+};
+
+
+/**
+ *	This class is a task that measures how long it waited to be run.
+ */
+class TimedTask : public BackgroundTask
+{
+public:
+	TimedTask( uint64 & latency, int & numCompleted ) :
+		latency_( latency ),
+		numCompleted_( numCompleted ),
+		addedTime_( timestamp() )
+	{}
+
+	virtual void doBackgroundTask( BgTaskManager & mgr )
+	{
+		latency_ = timestamp() - addedTime_;
+
+		// A small amount of work.
+		volatile uint32 value = 0;
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			value = value * 31 + i;
+		}
+
+		mgr.addMainThreadTask( this );
+	}
+
+	virtual void doMainThreadTask( BgTaskManager & mgr )
+	{
+		++numCompleted_;
+	}
+
+private:
+	uint64 & latency_;
+	int & numCompleted_;
+	uint64 addedTime_;
+};
+
+} // anonymous namespace
+
+
+TEST( BgTaskMgr_priority )
+{
+	BgTaskManager mgr;
+	mgr.startThreads( 1 );
+
+	volatile bool isReleased = false;
+	mgr.addBackgroundTask( new BlockingTask( isReleased ) );
+
+	std::vector< int > order;
+	const int NUM_EACH = 10;
+
+	for (int i = 0; i < NUM_EACH; ++i)
+	{
+		mgr.addBackgroundTask( new OrderedTask( order, i ), BgTaskManager::LOW );
+	}
+
+	for (int i = 0; i < NUM_EACH; ++i)
+	{
+		mgr.addBackgroundTask( new OrderedTask( order, NUM_EACH + i ),
+			BgTaskManager::HIGH );
+	}
+
+	isReleased = true;
+
+	mgr.stopAll( /* discardPendingTasks: */false, /* waitForThreads: */true );
+
+	// Higher priority tasks first, then in the order that they were added.
+	CHECK_EQUAL( 2 * NUM_EACH, int( order.size() ) );
+
+	for (int i = 0; i < int( order.size() ); ++i)
+	{
+		CHECK_EQUAL( (i + NUM_EACH) % (2 * NUM_EACH), order[ i ] );
+	}
+}
+
+
+TEST( BgTaskMgr_orderAcrossThreads )
+{
+	const int NUM_THREADS = 4;
+
+	BgTaskManager mgr;
+	mgr.startThreads( NUM_THREADS );
+
+	volatile int numStarted = 0;
+	volatile bool isReleased[ NUM_THREADS ] = {};
+
+	for (int i = 0; i < NUM_THREADS; ++i)
+	{
+		mgr.addBackgroundTask( new GateTask( numStarted, isReleased[i] ) );
+	}
+
+	while (numStarted < NUM_THREADS)
+	{
+		yieldThread();
+	}
+
+	// With every thread busy, these are spread over all of the threads'
+	// queues.
+	std::vector< int > order;
+	const int NUM_TASKS = 40;
+
+	for (int i = 0; i < NUM_TASKS; ++i)
+	{
+		mgr.addBackgroundTask( new OrderedTask( order, i ) );
+	}
+
+	// Only one thread is free, so it must take the tasks from every queue in
+	// the order that they were added.
+	isReleased[0] = true;
+
+	while (mgr.numQueuedTasks() > 0)
+	{
+		yieldThread();
+	}
+
+	for (int i = 1; i < NUM_THREADS; ++i)
+	{
+		isReleased[i] = true;
+	}
+
+	mgr.stopAll( /* discardPendingTasks: */false, /* waitForThreads: */true );
+
+	CHECK_EQUAL( NUM_TASKS, int( order.size() ) );
+
+	for (int i = 0; i < int( order.size() ); ++i)
+	{
+		CHECK_EQUAL( i, order[ i ] );
+	}
+}
+
+
+TEST( BgTaskMgr_benchmark )
+{
+	const int NUM_TASKS = 20000;
+	const int NUM_THREAD_COUNTS = 6;
+	const int threadCounts[ NUM_THREAD_COUNTS ] = { 1, 2, 4, 8, 16, 32 };
+
+	printf( "BgTaskMgr_benchmark: threads, tasks/s, "
+			"latency p50 / p99 / max (us)\n" );
+
+	for (int i = 0; i < NUM_THREAD_COUNTS; ++i)
+	{
+		BgTaskManager mgr;
+		mgr.startThreads( threadCounts[i] );
+
+		std::vector< uint64 > latencies( NUM_TASKS );
+		int numCompleted = 0;
+
+		const uint64 startTime = timestamp();
+
+		for (int j = 0; j < NUM_TASKS; ++j)
+		{
+			mgr.addBackgroundTask( new TimedTask( latencies[j], numCompleted ) );
+		}
+
+		while (numCompleted < NUM_TASKS)
+		{
+			mgr.tick();
+			yieldThread();
+		}
+
+		const double duration =
+			double( timestamp() - startTime ) / stampsPerSecondD();
+
+		mgr.stopAll();
+
+		std::sort( latencies.begin(), latencies.end() );
+
+		const double usPerStamp = 1000000.0 / stampsPerSecondD();
+
+		printf( "\t%2d: %8.0f  %8.0f %8.0f %8.0f\n",
+			threadCounts[i], NUM_TASKS / duration,
+			latencies[ NUM_TASKS / 2 ] * usPerStamp,
+			latencies[ NUM_TASKS * 99 / 100 ] * usPerStamp,
+			latencies[ NUM_TASKS - 1 ] * usPerStamp );
+
+		CHECK_EQUAL( NUM_TASKS, numCompleted );
+	}
+}
+
 // test_bgtasks.cpp
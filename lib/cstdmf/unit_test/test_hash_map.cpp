@@ -0,0 +1,342 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "cstdmf/hash_map.hpp"
+#include "cstdmf/stringmap.hpp"
+#include "cstdmf/timestamp.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+
+typedef HashMap< int, int > IntHashMap;
+
+
+/**
+ *	This function returns a pseudo-random number. The sequence is the same on
+ *	every run.
+ */
+uint32 nextRandom()
+{
+	static uint32 s_state = 2463534242U;
+
+	s_state ^= s_state << 13;
+	s_state ^= s_state >> 17;
+	s_state ^= s_state << 5;
+
+	return s_state;
+}
+
+
+/**
+ *	This function fills a vector with distinct random keys.
+ */
+void makeKeys( std::vector< int > & keys, int numKeys )
+{
+	std::set< int > used;
+
+	keys.clear();
+	keys.reserve( numKeys );
+
+	while (int( keys.size() ) < numKeys)
+	{
+		const int key = int( nextRandom() & 0x7fffffff );
+
+		if (used.insert( key ).second)
+		{
+			keys.push_back( key );
+		}
+	}
+}
+
+
+void makeKeys( std::vector< std::string > & keys, int numKeys )
+{
+	std::vector< int > intKeys;
+	makeKeys( intKeys, numKeys );
+
+	keys.clear();
+	keys.reserve( numKeys );
+
+	for (int i = 0; i < numKeys; ++i)
+	{
+		char buf[ 32 ];
+		bw_snprintf( buf, sizeof( buf ), "entity_%d", intKeys[i] );
+		keys.push_back( buf );
+	}
+}
+
+
+/**
+ *	This function returns the nanoseconds per operation since a start time.
+ */
+double nanosecondsSince( uint64 startTime, size_t numOperations )
+{
+	return double( timestamp() - startTime ) * 1000000000.0 /
+		stampsPerSecondD() / numOperations;
+}
+
+
+/**
+ *	This structure holds the results of benchmarkMap().
+ */
+struct MapTimes
+{
+	double insert;
+	double lookup;
+	double iterate;
+	double erase;
+};
+
+
+/**
+ *	This function times inserting, looking up, iterating over and erasing the
+ *	given keys in a map, and prints the results.
+ */
+template <class MAP>
+MapTimes benchmarkMap( const char * name,
+	const std::vector< typename MAP::key_type > & keys )
+{
+	std::vector< typename MAP::key_type > shuffledKeys( keys );
+	std::random_shuffle( shuffledKeys.begin(), shuffledKeys.end() );
+
+	MapTimes times;
+	MAP map;
+
+	uint64 startTime = timestamp();
+
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		map[ keys[i] ] = int( i );
+	}
+
+	times.insert = nanosecondsSince( startTime, keys.size() );
+
+	int sum = 0;
+	startTime = timestamp();
+
+	for (size_t i = 0; i < shuffledKeys.size(); ++i)
+	{
+		sum += map.find( shuffledKeys[i] )->second;
+	}
+
+	times.lookup = nanosecondsSince( startTime, keys.size() );
+
+	int iterationSum = 0;
+	startTime = timestamp();
+
+	for (typename MAP::const_iterator iter = map.begin();
+			iter != map.end(); ++iter)
+	{
+		iterationSum += iter->second;
+	}
+
+	times.iterate = nanosecondsSince( startTime, keys.size() );
+
+	startTime = timestamp();
+
+	for (size_t i = 0; i < shuffledKeys.size(); ++i)
+	{
+		map.erase( shuffledKeys[i] );
+	}
+
+	times.erase = nanosecondsSince( startTime, keys.size() );
+
+	printf( "HashMap_benchmark: %-22s %7d keys: insert %6.1fns, "
+			"lookup %6.1fns, iterate %5.1fns, erase %6.1fns%s\n",
+		name, int( keys.size() ),
+		times.insert, times.lookup, times.iterate, times.erase,
+		(sum == iterationSum && map.empty()) ? "" : " (incorrect)" );
+
+	return times;
+}
+
+} // anonymous namespace
+
+
+TEST( HashMap_basics )
+{
+	IntHashMap map;
+
+	CHECK( map.empty() );
+	CHECK( map.begin() == map.end() );
+	CHECK( map.find( 1 ) == map.end() );
+	CHECK_EQUAL( 0U, map.erase( 1 ) );
+
+	CHECK( map.insert( std::make_pair( 1, 10 ) ).second );
+	CHECK( !map.insert( std::make_pair( 1, 11 ) ).second );
+	CHECK_EQUAL( 10, map.find( 1 )->second );
+
+	map[ 2 ] = 20;
+	map[ 2 ] += 1;
+
+	CHECK_EQUAL( 2U, map.size() );
+	CHECK_EQUAL( 21, map[ 2 ] );
+	CHECK_EQUAL( 1U, map.count( 2 ) );
+	CHECK_EQUAL( 0U, map.count( 3 ) );
+
+	// A copy is independent of the original.
+	IntHashMap copy( map );
+	copy.erase( 1 );
+
+	CHECK_EQUAL( 1U, map.count( 1 ) );
+	CHECK_EQUAL( 0U, copy.count( 1 ) );
+
+	copy.swap( map );
+	CHECK_EQUAL( 1U, map.size() );
+	CHECK_EQUAL( 2U, copy.size() );
+
+	map = copy;
+	CHECK_EQUAL( 2U, map.size() );
+
+	CHECK_EQUAL( 1U, map.erase( 1 ) );
+	CHECK_EQUAL( 0U, map.erase( 1 ) );
+
+	map.clear();
+	CHECK( map.empty() );
+	CHECK( map.begin() == map.end() );
+}
+
+
+/**
+ *	This test checks a HashMap against a std::map through a long sequence of
+ *	random inserts and erases.
+ */
+TEST( HashMap_matchesMap )
+{
+	IntHashMap hashMap;
+	std::map< int, int > map;
+
+	// A small key range causes plenty of collisions, erases and re-inserts.
+	for (int i = 0; i < 200000; ++i)
+	{
+		const int key = int( nextRandom() % 5000 );
+
+		if (nextRandom() % 3 == 0)
+		{
+			CHECK_EQUAL( map.erase( key ), hashMap.erase( key ) );
+		}
+		else
+		{
+			CHECK_EQUAL( map.insert( std::make_pair( key, i ) ).second,
+				hashMap.insert( std::make_pair( key, i ) ).second );
+		}
+	}
+
+	CHECK_EQUAL( map.size(), hashMap.size() );
+
+	size_t numIterated = 0;
+
+	for (IntHashMap::const_iterator iter = hashMap.begin();
+			iter != hashMap.end(); ++iter)
+	{
+		std::map< int, int >::const_iterator found = map.find( iter->first );
+
+		CHECK( found != map.end() && found->second == iter->second );
+		++numIterated;
+	}
+
+	CHECK_EQUAL( map.size(), numIterated );
+}
+
+
+/**
+ *	This test checks that each element is visited exactly once when erasing
+ *	while iterating.
+ */
+TEST( HashMap_eraseWhileIterating )
+{
+	IntHashMap map;
+
+	for (int i = 0; i < 10000; ++i)
+	{
+		map[ i * 7 ] = i;
+	}
+
+	std::set< int > visited;
+	IntHashMap::iterator iter = map.begin();
+
+	while (iter != map.end())
+	{
+		CHECK( visited.insert( iter->first ).second );
+
+		if (iter->second % 2 == 0)
+		{
+			iter = map.erase( iter );
+		}
+		else
+		{
+			++iter;
+		}
+	}
+
+	CHECK_EQUAL( 10000U, visited.size() );
+	CHECK_EQUAL( 5000U, map.size() );
+
+	for (iter = map.begin(); iter != map.end(); ++iter)
+	{
+		CHECK( iter->second % 2 == 1 );
+	}
+}
+
+
+TEST( HashMap_stringKeys )
+{
+	HashMap< std::string, int > map;
+
+	map[ "alpha" ] = 1;
+	map[ "beta" ] = 2;
+
+	CHECK_EQUAL( 2, map[ "beta" ] );
+	CHECK( map.find( "gamma" ) == map.end() );
+}
+
+
+/**
+ *	This test reports the cost of each operation of HashMap, std::map and the
+ *	hash_map used by StringHashMap.
+ */
+TEST( HashMap_benchmark )
+{
+	const int sizes[] = { 100000, 1000000 };
+
+	for (size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); ++i)
+	{
+		std::vector< int > keys;
+		makeKeys( keys, sizes[i] );
+
+		const MapTimes mapTimes =
+			benchmarkMap< std::map< int, int > >( "std::map<int>", keys );
+		benchmarkMap< HASH_MAP_NAMESPACE::hash_map< int, int > >(
+			"hash_map<int>", keys );
+		const MapTimes hashMapTimes =
+			benchmarkMap< IntHashMap >( "HashMap<int>", keys );
+
+		CHECK( hashMapTimes.lookup < mapTimes.lookup );
+	}
+
+	std::vector< std::string > keys;
+	makeKeys( keys, 100000 );
+
+	benchmarkMap< std::map< std::string, int > >( "std::map<string>", keys );
+	benchmarkMap< StringHashMap< int > >( "StringHashMap", keys );
+	benchmarkMap< HashMap< std::string, int > >( "HashMap<string>", keys );
+}
+
+// test_hash_map.cpp
@@ -0,0 +1,185 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "cstdmf/heap_profiler.hpp"
+#include "cstdmf/timestamp.hpp"
+
+#include <sstream>
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+
+const int NUM_BLOCKS = 2000;
+const int BLOCK_SIZE = 1000;
+const uint32 SAMPLE_INTERVAL = 4096;
+
+
+/**
+ *	This function allocates a block and tells the profiler about it if the
+ *	profiler is not already seeing every allocation.
+ */
+char * newBlock( size_t size )
+{
+	char * pBlock = new char[ size ];
+#if !HEAP_PROFILER_REPLACES_MALLOC
+	HeapProfiler::onAlloc( pBlock, size );
+#endif
+	return pBlock;
+}
+
+
+/**
+ *	This function frees a block allocated by newBlock.
+ */
+void deleteBlock( char * pBlock )
+{
+#if !HEAP_PROFILER_REPLACES_MALLOC
+	HeapProfiler::onFree( pBlock );
+#endif
+	delete [] pBlock;
+}
+
+
+/**
+ *	This function is a reallocation function that always fails.
+ */
+void * failingRealloc( void * ptr, size_t size )
+{
+	return NULL;
+}
+
+
+/**
+ *	This function returns the average time in nanoseconds of a small
+ *	allocation and free.
+ */
+double timeAllocations( int numAllocations )
+{
+	const uint64 startTime = timestamp();
+
+	for (int i = 0; i < numAllocations; ++i)
+	{
+		char * pBlock = newBlock( 64 );
+		pBlock[0] = char( i );
+		deleteBlock( pBlock );
+	}
+
+	return double( timestamp() - startTime ) * 1000000000.0 /
+		stampsPerSecondD() / numAllocations;
+}
+
+} // anonymous namespace
+
+
+TEST( HeapProfiler_sampling )
+{
+	std::vector< char * > blocks;
+	blocks.reserve( NUM_BLOCKS );
+
+	HeapProfiler::sampleInterval( SAMPLE_INTERVAL );
+	HeapProfiler::isEnabled( true );
+
+	// When malloc is replaced, other allocations may have been sampled too.
+	const uint32 initialSamples = HeapProfiler::numLiveSamples();
+	const double initialEstimate = double( HeapProfiler::estimatedLiveBytes() );
+
+	for (int i = 0; i < NUM_BLOCKS; ++i)
+	{
+		blocks.push_back( newBlock( BLOCK_SIZE ) );
+	}
+
+	HeapProfiler::isEnabled( false );
+
+	// About one sample every SAMPLE_INTERVAL bytes.
+	const uint32 numSamples = HeapProfiler::numLiveSamples() - initialSamples;
+	const uint32 expectedSamples = NUM_BLOCKS * BLOCK_SIZE / SAMPLE_INTERVAL;
+
+	CHECK( numSamples > expectedSamples / 2 );
+	CHECK( numSamples < expectedSamples * 2 );
+
+	// The estimate scales the samples back up to the real allocations.
+	const double estimate =
+		double( HeapProfiler::estimatedLiveBytes() ) - initialEstimate;
+	const double actual = NUM_BLOCKS * BLOCK_SIZE;
+
+	CHECK( estimate > actual * 0.7 );
+	CHECK( estimate < actual * 1.3 );
+
+	CHECK( HeapProfiler::topSites( 5, 4 ).find( "KB in" ) != std::string::npos );
+
+	std::ostringstream stream;
+	HeapProfiler::writePprofProfile( stream );
+	const std::string profile = stream.str();
+
+	CHECK_EQUAL( 0U, profile.find( "heap profile: " ) );
+	CHECK( profile.find( "@ heap_v2/4096\n" ) != std::string::npos );
+
+	// Freeing the blocks removes their samples, even though sampling is now
+	// disabled.
+	for (int i = 0; i < NUM_BLOCKS; ++i)
+	{
+		deleteBlock( blocks[i] );
+	}
+
+	CHECK( HeapProfiler::numLiveSamples() <= initialSamples + 5 );
+
+	HeapProfiler::sampleInterval( HeapProfiler::DEFAULT_SAMPLE_INTERVAL );
+}
+
+
+TEST( HeapProfiler_failedRealloc )
+{
+	static char block[ 64 ];
+
+	// The size is large enough that this is always sampled.
+	HeapProfiler::isEnabled( true );
+	const uint32 initialSamples = HeapProfiler::numLiveSamples();
+	HeapProfiler::onAlloc( block, 1 << 30 );
+	HeapProfiler::isEnabled( false );
+
+	CHECK_EQUAL( initialSamples + 1, HeapProfiler::numLiveSamples() );
+
+	// The block is unchanged, so it keeps its sample.
+	CHECK( HeapProfiler::reallocate( block, 128, failingRealloc ) == NULL );
+	CHECK_EQUAL( initialSamples + 1, HeapProfiler::numLiveSamples() );
+
+	HeapProfiler::onFree( block );
+	CHECK_EQUAL( initialSamples, HeapProfiler::numLiveSamples() );
+}
+
+
+/**
+ *	This test reports the cost of an allocation with the profiler disabled and
+ *	enabled at the default sample interval.
+ */
+TEST( HeapProfiler_overhead )
+{
+	const int NUM_ALLOCATIONS = 1000000;
+
+	const double disabledTime = timeAllocations( NUM_ALLOCATIONS );
+
+	HeapProfiler::isEnabled( true );
+	const double enabledTime = timeAllocations( NUM_ALLOCATIONS );
+	HeapProfiler::isEnabled( false );
+
+	printf( "HeapProfiler_overhead: %.1fns per allocation disabled, "
+			"%.1fns enabled\n",
+		disabledTime, enabledTime );
+
+	CHECK( enabledTime < disabledTime * 2.0 );
+}
+
+// test_heap_profiler.cpp
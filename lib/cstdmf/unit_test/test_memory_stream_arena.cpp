@@ -0,0 +1,268 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "cstdmf/memory_stream.hpp"
+#include "cstdmf/memory_stream_arena.hpp"
+#include "cstdmf/timestamp.hpp"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef ENABLE_MEMTRACKER
+namespace
+{
+/// The number of calls to operator new, used to count heap allocations.
+int s_numNews = 0;
+}
+
+void * operator new( size_t size ) throw( std::bad_alloc )
+{
+	++s_numNews;
+	void * ptr = malloc( size );
+
+	if (ptr == NULL)
+	{
+		throw std::bad_alloc();
+	}
+
+	return ptr;
+}
+
+void * operator new[]( size_t size ) throw( std::bad_alloc )
+{
+	return operator new( size );
+}
+
+void operator delete( void * ptr ) throw()
+{
+	free( ptr );
+}
+
+void operator delete[]( void * ptr ) throw()
+{
+	free( ptr );
+}
+#endif // !ENABLE_MEMTRACKER
+
+namespace
+{
+
+/**
+ *	This function writes a number of bytes to a stream in small pieces.
+ */
+void writeBytes( BinaryOStream & stream, int numBytes )
+{
+	for (int i = 0; i < numBytes / 4; ++i)
+	{
+		stream << int32( i );
+	}
+}
+
+
+/**
+ *	This function checks that a stream holds the bytes written by
+ *	writeBytes().
+ */
+bool checkBytes( MemoryOStream & stream, int numBytes )
+{
+	for (int i = 0; i < numBytes / 4; ++i)
+	{
+		int32 value;
+		stream >> value;
+
+		if (value != i)
+		{
+			return false;
+		}
+	}
+
+	return stream.remainingLength() == 0;
+}
+
+
+/**
+ *	This function models the streams used by DBMgr to write an entity: the
+ *	entity's data, with a temporary stream for each of a few USER_TYPE
+ *	properties.
+ */
+void putEntity( MemoryStreamArena * pArena )
+{
+	const int NUM_PROPERTIES = 40;
+	const int PROPERTY_SIZE = 40;
+	const int USER_TYPE_SIZE = 100;
+
+	MemoryOStream * pData = pArena ?
+		new MemoryOStream( 64, *pArena ) : new MemoryOStream( 64 );
+
+	for (int i = 0; i < NUM_PROPERTIES; ++i)
+	{
+		if (i % 10 == 0)
+		{
+			MemoryOStream * pUserType = pArena ?
+				new MemoryOStream( 64, *pArena ) : new MemoryOStream( 64 );
+
+			writeBytes( *pUserType, USER_TYPE_SIZE );
+			pData->appendString( static_cast< const char * >(
+					pUserType->data() ), pUserType->size() );
+
+			delete pUserType;
+		}
+		else
+		{
+			writeBytes( *pData, PROPERTY_SIZE );
+		}
+	}
+
+	delete pData;
+}
+
+} // anonymous namespace
+
+
+TEST( MemoryStreamArena_basics )
+{
+	MemoryStreamArena arena( 64 * 1024 );
+
+	{
+		MemoryOStream first( 16, arena );
+		MemoryOStream second( 16, arena );
+
+		CHECK( first.usesArena() );
+		CHECK( second.usesArena() );
+		CHECK_EQUAL( 2, arena.numBuffers() );
+
+		// The second stream is at the end of the arena, so grows in place.
+		writeBytes( second, 1000 );
+		CHECK_EQUAL( 2, arena.numBuffers() );
+
+		// The first stream has to move past the second.
+		writeBytes( first, 1000 );
+		CHECK( first.usesArena() );
+
+		CHECK( checkBytes( first, 1000 ) );
+		CHECK( checkBytes( second, 1000 ) );
+
+		// A stream is reset at the end of each tick, so should not be
+		// alive when the arena is reset.
+		arena.reset();
+		CHECK_EQUAL( 1U, arena.numBlockedResets() );
+	}
+
+	CHECK_EQUAL( 0, arena.numBuffers() );
+	CHECK_EQUAL( 0, arena.bytesInUse() );
+	CHECK( arena.peakBytesInUse() >= 2000 );
+	CHECK_EQUAL( 0U, arena.numOverflows() );
+
+	arena.reset();
+	CHECK_EQUAL( 1U, arena.numBlockedResets() );
+}
+
+
+TEST( MemoryStreamArena_overflow )
+{
+	MemoryStreamArena arena( 256 );
+
+	{
+		MemoryOStream stream( 64, arena );
+		CHECK( stream.usesArena() );
+
+		// This outgrows the arena, so the stream falls back to the heap.
+		writeBytes( stream, 1000 );
+
+		CHECK( !stream.usesArena() );
+		CHECK( checkBytes( stream, 1000 ) );
+		CHECK_EQUAL( 1U, arena.numOverflows() );
+		CHECK_EQUAL( 0, arena.bytesInUse() );
+
+		// A stream that does not fit at all starts on the heap.
+		MemoryOStream large( 1024, arena );
+		CHECK( !large.usesArena() );
+		CHECK_EQUAL( 2U, arena.numOverflows() );
+	}
+
+	CHECK_EQUAL( 0, arena.numBuffers() );
+}
+
+
+TEST( MemoryStreamArena_instance )
+{
+	MemoryStreamArena & arena = MemoryStreamArena::instance();
+
+	CHECK( &arena == &MemoryStreamArena::instance() );
+
+	{
+		MemoryOStream stream( 64, MemoryStreamArena::instance() );
+		CHECK( stream.usesArena() );
+	}
+
+	MemoryStreamArena::resetCurrentThread();
+	CHECK_EQUAL( 0, arena.bytesInUse() );
+}
+
+
+/**
+ *	This test reports the heap allocations and time of a tick of entity writes
+ *	with and without an arena.
+ */
+TEST( MemoryStreamArena_putEntityBenchmark )
+{
+	const int NUM_TICKS = 100;
+	const int PUTS_PER_TICK = 100;
+
+	MemoryStreamArena arena( MemoryStreamArena::DEFAULT_SIZE );
+
+	double times[2];
+	int numNews[2] = { 0, 0 };
+
+	for (int useArena = 0; useArena < 2; ++useArena)
+	{
+		MemoryStreamArena * pArena = useArena ? &arena : NULL;
+
+#ifndef ENABLE_MEMTRACKER
+		const int startNews = s_numNews;
+#endif
+		const uint64 startTime = timestamp();
+
+		for (int tick = 0; tick < NUM_TICKS; ++tick)
+		{
+			for (int i = 0; i < PUTS_PER_TICK; ++i)
+			{
+				putEntity( pArena );
+			}
+
+			arena.reset();
+		}
+
+		times[ useArena ] = double( timestamp() - startTime ) * 1000000.0 /
+			stampsPerSecondD() / NUM_TICKS;
+#ifndef ENABLE_MEMTRACKER
+		numNews[ useArena ] = (s_numNews - startNews) / NUM_TICKS;
+#endif
+	}
+
+	printf( "MemoryStreamArena_putEntityBenchmark: %d puts per tick: "
+			"heap %d allocations, %.1fus; arena %d allocations, %.1fus\n",
+		PUTS_PER_TICK, numNews[0], times[0], numNews[1], times[1] );
+
+	CHECK_EQUAL( 0U, arena.numOverflows() );
+	CHECK_EQUAL( 0U, arena.numBlockedResets() );
+
+#ifndef ENABLE_MEMTRACKER
+	// Only the MemoryOStream objects themselves are still allocated.
+	CHECK( numNews[1] * 3 < numNews[0] );
+#endif
+}
+
+// test_memory_stream_arena.cpp
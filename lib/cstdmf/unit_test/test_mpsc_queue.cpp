@@ -0,0 +1,341 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include <list>
+
+#include "cstdmf/concurrency.hpp"
+#include "cstdmf/mpsc_queue.hpp"
+#include "cstdmf/safe_fifo.hpp"
+#include "cstdmf/spsc_queue.hpp"
+#include "cstdmf/timestamp.hpp"
+
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <sched.h>
+#endif
+
+namespace
+{
+
+const uint32 NUM_VALUES = 100000;
+const uint32 MAX_PRODUCERS = 4;
+
+/**
+ *	This function gives up the rest of the current thread's time slice.
+ */
+void yieldThread()
+{
+#ifdef _WIN32
+	Sleep( 0 );
+#else
+	sched_yield();
+#endif
+}
+
+
+/**
+ *	This class gives the queues under test a common interface. Values are
+ *	tagged with the producer in the top bits so that the consumer can check
+ *	the order of each producer's values.
+ */
+class TestQueue
+{
+public:
+	virtual ~TestQueue() {}
+
+	virtual const char * name() const = 0;
+	virtual bool push( uint32 value ) = 0;
+	virtual bool pop( uint32 & value ) = 0;
+};
+
+
+template <class QUEUE>
+class BoundedTestQueue : public TestQueue
+{
+public:
+	BoundedTestQueue( const char * name, uint32 capacity ) :
+		name_( name ),
+		queue_( capacity )
+	{}
+
+	const char * name() const			{ return name_; }
+	bool push( uint32 value )			{ return queue_.push( value ); }
+	bool pop( uint32 & value )			{ return queue_.pop( value ); }
+
+private:
+	const char * name_;
+	QUEUE queue_;
+};
+
+
+template <class QUEUE>
+class UnboundedTestQueue : public TestQueue
+{
+public:
+	UnboundedTestQueue( const char * name, uint32 segmentSize ) :
+		name_( name ),
+		queue_( segmentSize )
+	{}
+
+	const char * name() const			{ return name_; }
+	bool push( uint32 value )			{ queue_.push( value ); return true; }
+	bool pop( uint32 & value )			{ return queue_.pop( value ); }
+
+private:
+	const char * name_;
+	QUEUE queue_;
+};
+
+
+class SafeFifoTestQueue : public TestQueue
+{
+public:
+	const char * name() const			{ return "SafeFifo"; }
+	bool push( uint32 value )			{ fifo_.push( value ); return true; }
+
+	bool pop( uint32 & value )
+	{
+		if (fifo_.count() == 0)
+		{
+			return false;
+		}
+
+		value = fifo_.pop();
+		return true;
+	}
+
+private:
+	SafeFifo< uint32 > fifo_;
+};
+
+
+/**
+ *	This structure is passed to each producer thread.
+ */
+struct ProducerData
+{
+	TestQueue * pQueue;
+	uint32 producer;
+	uint32 numValues;
+};
+
+
+void producer( void * arg )
+{
+	ProducerData * pData = (ProducerData *)arg;
+	const uint32 tag = pData->producer << 24;
+
+	for (uint32 i = 0; i < pData->numValues; ++i)
+	{
+		while (!pData->pQueue->push( tag | i ))
+		{
+			yieldThread();
+		}
+	}
+}
+
+
+/**
+ *	This function passes NUM_VALUES values through a queue from the given
+ *	number of producer threads and checks that each producer's values arrive
+ *	in order.
+ *
+ *	@return The number of values passed per second.
+ */
+double runProducers( TestQueue & queue, uint32 numProducers, bool & rIsInOrder )
+{
+	ProducerData data[ MAX_PRODUCERS ];
+	SimpleThread * pThreads[ MAX_PRODUCERS ];
+	uint32 expected[ MAX_PRODUCERS ];
+
+	const uint64 startTime = timestamp();
+
+	for (uint32 i = 0; i < numProducers; ++i)
+	{
+		data[i].pQueue = &queue;
+		data[i].producer = i;
+		data[i].numValues = NUM_VALUES / numProducers;
+		expected[i] = 0;
+		pThreads[i] = new SimpleThread( producer, &data[i] );
+	}
+
+	const uint32 numValues = numProducers * (NUM_VALUES / numProducers);
+	rIsInOrder = true;
+
+	for (uint32 numReceived = 0; numReceived < numValues; )
+	{
+		uint32 value;
+
+		if (queue.pop( value ))
+		{
+			const uint32 producer = value >> 24;
+
+			rIsInOrder = rIsInOrder && (producer < numProducers) &&
+				((value & 0xffffff) == expected[ producer ]);
+
+			if (producer < numProducers)
+			{
+				++expected[ producer ];
+			}
+
+			++numReceived;
+		}
+		else
+		{
+			yieldThread();
+		}
+	}
+
+	const double duration =
+		double( timestamp() - startTime ) / stampsPerSecondD();
+
+	for (uint32 i = 0; i < numProducers; ++i)
+	{
+		delete pThreads[i];
+	}
+
+	uint32 value;
+	rIsInOrder = rIsInOrder && !queue.pop( value );
+
+	return numValues / duration;
+}
+
+} // anonymous namespace
+
+
+TEST( MPSCQueue_capacity )
+{
+	MPSCQueue< int > queue( 5 );
+
+	CHECK_EQUAL( 8U, queue.capacity() );
+	CHECK( queue.empty() );
+
+	for (int i = 0; i < 8; ++i)
+	{
+		CHECK( queue.push( i ) );
+	}
+
+	CHECK( !queue.push( 8 ) );
+	CHECK_EQUAL( 8U, queue.size() );
+
+	int value = -1;
+
+	// Wrap around the ring a few times.
+	for (int i = 0; i < 20; ++i)
+	{
+		CHECK( queue.pop( value ) );
+		CHECK_EQUAL( i, value );
+		CHECK( queue.push( i + 8 ) );
+	}
+
+	for (int i = 20; i < 28; ++i)
+	{
+		CHECK( queue.pop( value ) );
+		CHECK_EQUAL( i, value );
+	}
+
+	CHECK( !queue.pop( value ) );
+	CHECK( queue.empty() );
+}
+
+
+TEST( UnboundedMPSCQueue_segments )
+{
+	UnboundedMPSCQueue< int > queue( 4 );
+
+	int value = -1;
+	CHECK( !queue.pop( value ) );
+
+	for (int i = 0; i < 50; ++i)
+	{
+		queue.push( i );
+	}
+
+	for (int i = 0; i < 50; ++i)
+	{
+		CHECK( queue.pop( value ) );
+		CHECK_EQUAL( i, value );
+	}
+
+	CHECK( !queue.pop( value ) );
+}
+
+
+/**
+ *	This test passes values from several threads through small queues, so that
+ *	they are frequently full or change segment, and checks that each thread's
+ *	values arrive in order.
+ */
+TEST( MPSCQueue_threads )
+{
+	BoundedTestQueue< MPSCQueue< uint32 > > bounded( "MPSCQueue", 64 );
+	UnboundedTestQueue< UnboundedMPSCQueue< uint32 > > unbounded(
+		"UnboundedMPSCQueue", 16 );
+
+	bool isInOrder = false;
+
+	runProducers( bounded, MAX_PRODUCERS, isInOrder );
+	CHECK( isInOrder );
+
+	runProducers( unbounded, MAX_PRODUCERS, isInOrder );
+	CHECK( isInOrder );
+}
+
+
+/**
+ *	This test compares the throughput of the queues with the mutex based
+ *	SafeFifo.
+ */
+TEST( MPSCQueue_benchmark )
+{
+	SafeFifoTestQueue safeFifo;
+	BoundedTestQueue< SPSCQueue< uint32 > > spsc( "SPSCQueue", 1024 );
+	UnboundedTestQueue< UnboundedSPSCQueue< uint32 > > unboundedSPSC(
+		"UnboundedSPSCQueue", 256 );
+	BoundedTestQueue< MPSCQueue< uint32 > > mpsc( "MPSCQueue", 1024 );
+	UnboundedTestQueue< UnboundedMPSCQueue< uint32 > > unboundedMPSC(
+		"UnboundedMPSCQueue", 256 );
+
+	TestQueue * singleProducerQueues[] =
+		{ &safeFifo, &spsc, &unboundedSPSC, &mpsc, &unboundedMPSC };
+	TestQueue * multiProducerQueues[] = { &safeFifo, &mpsc, &unboundedMPSC };
+
+	printf( "MPSCQueue_benchmark: values/s with 1 and %u producers\n",
+		MAX_PRODUCERS );
+
+	for (size_t i = 0; i < ARRAY_SIZE( singleProducerQueues ); ++i)
+	{
+		TestQueue & queue = *singleProducerQueues[i];
+		bool isInOrder = false;
+
+		printf( "\t%-20s %10.0f", queue.name(),
+			runProducers( queue, 1, isInOrder ) );
+		CHECK( isInOrder );
+
+		for (size_t j = 0; j < ARRAY_SIZE( multiProducerQueues ); ++j)
+		{
+			if (multiProducerQueues[j] == &queue)
+			{
+				printf( " %10.0f", runProducers( queue, MAX_PRODUCERS,
+					isInOrder ) );
+				CHECK( isInOrder );
+			}
+		}
+
+		printf( "\n" );
+	}
+}
+
+// test_mpsc_queue.cpp
@@ -0,0 +1,188 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "cstdmf/concurrency.hpp"
+#include "cstdmf/spsc_queue.hpp"
+
+#ifndef _WIN32
+#include <sched.h>
+#endif
+
+namespace
+{
+
+const uint32 NUM_VALUES = 100000;
+
+/**
+ *	This function gives up the rest of the current thread's time slice. It is
+ *	used while waiting on the other thread so that the test does not spin
+ *	for a whole time slice on a single core machine.
+ */
+void yieldThread()
+{
+#ifdef _WIN32
+	Sleep( 0 );
+#else
+	sched_yield();
+#endif
+}
+
+/**
+ *	This structure is shared between the producer and consumer threads.
+ */
+struct SPSCTestData
+{
+	SPSCTestData() : queue( 64 ) {}
+
+	SPSCQueue< uint32 > queue;
+};
+
+
+void producer( void * arg )
+{
+	SPSCTestData * pData = (SPSCTestData *)arg;
+
+	for (uint32 i = 0; i < NUM_VALUES; ++i)
+	{
+		while (!pData->queue.push( i ))
+		{
+			yieldThread();
+		}
+	}
+}
+
+
+/**
+ *	This structure is shared between the producer and consumer threads of the
+ *	unbounded queue test.
+ */
+struct UnboundedSPSCTestData
+{
+	UnboundedSPSCTestData() : queue( 16 ) {}
+
+	UnboundedSPSCQueue< uint32 > queue;
+};
+
+
+void unboundedProducer( void * arg )
+{
+	UnboundedSPSCTestData * pData = (UnboundedSPSCTestData *)arg;
+
+	for (uint32 i = 0; i < NUM_VALUES; ++i)
+	{
+		pData->queue.push( i );
+	}
+}
+
+} // anonymous namespace
+
+
+TEST( SPSCQueue_capacity )
+{
+	SPSCQueue< int > queue( 5 );
+
+	CHECK_EQUAL( 8U, queue.capacity() );
+	CHECK( queue.empty() );
+
+	for (int i = 0; i < 8; ++i)
+	{
+		CHECK( queue.push( i ) );
+	}
+
+	CHECK( !queue.push( 8 ) );
+	CHECK_EQUAL( 8U, queue.size() );
+
+	int value = -1;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		CHECK( queue.pop( value ) );
+		CHECK_EQUAL( i, value );
+	}
+
+	CHECK( !queue.pop( value ) );
+	CHECK( queue.empty() );
+}
+
+
+/**
+ *	This test passes values between two threads through a small queue, so that
+ *	it is frequently full and empty, and checks that they all arrive in order.
+ */
+TEST( SPSCQueue_threads )
+{
+	SPSCTestData data;
+	SimpleThread * pThread = new SimpleThread( producer, &data );
+
+	bool isInOrder = true;
+	uint32 expected = 0;
+
+	while (expected < NUM_VALUES)
+	{
+		uint32 value;
+
+		if (data.queue.pop( value ))
+		{
+			isInOrder = isInOrder && (value == expected);
+			++expected;
+		}
+		else
+		{
+			yieldThread();
+		}
+	}
+
+	delete pThread;
+
+	CHECK( isInOrder );
+	CHECK( data.queue.empty() );
+}
+
+
+/**
+ *	This test passes values between two threads through a queue with small
+ *	segments and checks that they all arrive in order.
+ */
+TEST( UnboundedSPSCQueue_threads )
+{
+	UnboundedSPSCTestData data;
+	SimpleThread * pThread = new SimpleThread( unboundedProducer, &data );
+
+	bool isInOrder = true;
+	uint32 expected = 0;
+
+	while (expected < NUM_VALUES)
+	{
+		uint32 value;
+
+		if (data.queue.pop( value ))
+		{
+			isInOrder = isInOrder && (value == expected);
+			++expected;
+		}
+		else
+		{
+			yieldThread();
+		}
+	}
+
+	delete pThread;
+
+	uint32 value;
+
+	CHECK( isInOrder );
+	CHECK( !data.queue.pop( value ) );
+}
+
+// test_spsc_queue.cpp
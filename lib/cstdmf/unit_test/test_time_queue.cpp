@@ -12,6 +12,10 @@ criminal penalties as provided by law.
 #include "pch.hpp"
 
 #include "cstdmf/time_queue.hpp"
+#include "cstdmf/timestamp.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
 
 class Handler : public TimerHandler
 {
@@ -63,4 +67,205 @@ TEST( BadPurge )
 	timeQueue.process( 2 );
 }
 
+
+namespace
+{
+
+/**
+ *	This handler records the times at which it is called.
+ */
+class RecordingHandler : public TimerHandler
+{
+public:
+	RecordingHandler( uint32 & now ) : now_( now ) {}
+
+	std::vector< uint32 > times_;
+	std::vector< void * > users_;
+
+protected:
+	virtual void handleTimeout( TimerHandle handle, void * pUser )
+	{
+		times_.push_back( now_ );
+		users_.push_back( pUser );
+	}
+
+private:
+	uint32 & now_;
+};
+
+
+/**
+ *	This handler clears the handle of each timer that goes off. It is used for
+ *	benchmarking.
+ */
+class ClearingHandler : public TimerHandler
+{
+public:
+	ClearingHandler( std::vector< TimerHandle > & handles ) :
+		handles_( handles )
+	{}
+
+protected:
+	virtual void handleTimeout( TimerHandle handle, void * pUser )
+	{
+		handles_[ uintptr_t( pUser ) ].clearWithoutCancel();
+	}
+
+private:
+	std::vector< TimerHandle > & handles_;
+};
+
+} // anonymous namespace
+
+
+TEST( TimingWheel_order )
+{
+	TimeQueue timeQueue( TimeQueue::TIMING_WHEEL );
+	uint32 now = 0;
+	RecordingHandler handler( now );
+
+	// Spread the times across several levels of the wheel.
+	const uint32 times[] = { 70000, 5, 300, 5, 1 << 24, 256, 255, 70001 };
+	const int numTimes = sizeof( times ) / sizeof( times[0] );
+
+	for (int i = 0; i < numTimes; ++i)
+	{
+		timeQueue.add( times[i], 0, &handler, (void *)(uintptr_t)i );
+	}
+
+	CHECK_EQUAL( uint32( numTimes ), timeQueue.size() );
+
+	while (!timeQueue.empty())
+	{
+		now += 1 + timeQueue.nextExp( now ) / 2;
+		timeQueue.process( now );
+	}
+
+	CHECK_EQUAL( size_t( numTimes ), handler.users_.size() );
+
+	for (uint i = 0; i < handler.users_.size(); ++i)
+	{
+		const uint32 time = times[ uintptr_t( handler.users_[i] ) ];
+
+		CHECK( handler.times_[i] >= time );
+
+		if (i > 0)
+		{
+			CHECK( times[ uintptr_t( handler.users_[i - 1] ) ] <= time );
+		}
+	}
+
+	// Timers due at the same time are called in the order they were added.
+	CHECK( handler.users_[0] == (void *)1 );
+	CHECK( handler.users_[1] == (void *)3 );
+}
+
+
+TEST( TimingWheel_cancel )
+{
+	std::vector< TimerHandle > handles;
+
+	TimeQueue timeQueue( TimeQueue::TIMING_WHEEL );
+
+	const uint NUM_TIMERS = 50;
+
+	for (uint i = 0; i < NUM_TIMERS; ++i)
+	{
+		handles.push_back( timeQueue.add( i * 100, 0, new Handler, NULL ) );
+	}
+
+	for (uint i = 0; i < NUM_TIMERS; i += 2)
+	{
+		handles[i].cancel();
+	}
+
+	// Cancelled timers are removed immediately.
+	CHECK_EQUAL( NUM_TIMERS / 2, timeQueue.size() );
+	CHECK( timeQueue.legal( handles[1] ) );
+
+	CHECK_EQUAL( int( NUM_TIMERS / 2 ), timeQueue.process( NUM_TIMERS * 100 ) );
+	CHECK( timeQueue.empty() );
+}
+
+
+TEST( TimingWheel_repeating )
+{
+	TimeQueue timeQueue( TimeQueue::TIMING_WHEEL );
+	uint32 now = 0;
+	RecordingHandler handler( now );
+
+	TimerHandle handle = timeQueue.add( 10, 10, &handler, NULL );
+
+	for (now = 0; now <= 1000; ++now)
+	{
+		timeQueue.process( now );
+	}
+
+	CHECK_EQUAL( size_t( 100 ), handler.times_.size() );
+	CHECK_EQUAL( uint32( 1000 ), handler.times_.back() );
+	CHECK_EQUAL( uint32( 1010 ), timeQueue.timerDeliveryTime( handle ) );
+
+	handle.cancel();
+	CHECK( timeQueue.empty() );
+}
+
+
+/**
+ *	This test compares the binary heap and the timing wheel with 100,000
+ *	timers that are repeatedly cancelled and re-added, as channels do with their
+ *	resend and inactivity timers.
+ */
+TEST( TimeQueue_benchmark )
+{
+	const int NUM_TIMERS = 100000;
+	const int NUM_TICKS = 100;
+	const int NUM_RESCHEDULES_PER_TICK = NUM_TIMERS / 10;
+
+	const TimeQueueBase::Implementation implementations[] =
+		{ TimeQueueBase::BINARY_HEAP, TimeQueueBase::TIMING_WHEEL };
+	const char * names[] = { "binary heap", "timing wheel" };
+
+	int numFired[2];
+
+	for (int i = 0; i < 2; ++i)
+	{
+		uint64 startTime = timestamp();
+
+		std::vector< TimerHandle > handles( NUM_TIMERS );
+		ClearingHandler handler( handles );
+		TimeQueue timeQueue( implementations[i] );
+
+		srand( 1 );
+
+		for (int j = 0; j < NUM_TIMERS; ++j)
+		{
+			handles[j] = timeQueue.add( 1 + rand() % (NUM_TICKS * 2), 0,
+					&handler, (void *)uintptr_t( j ) );
+		}
+
+		numFired[i] = 0;
+
+		for (uint32 now = 1; now <= NUM_TICKS; ++now)
+		{
+			for (int j = 0; j < NUM_RESCHEDULES_PER_TICK; ++j)
+			{
+				const int index = rand() % NUM_TIMERS;
+
+				handles[ index ].cancel();
+				handles[ index ] = timeQueue.add( now + 1 + rand() % NUM_TICKS,
+						0, &handler, (void *)uintptr_t( index ) );
+			}
+
+			numFired[i] += timeQueue.process( now );
+		}
+
+		timeQueue.clear();
+
+		printf( "TimeQueue_benchmark: %s: %.3fs\n", names[i],
+			double( timestamp() - startTime ) / stampsPerSecondD() );
+	}
+
+	CHECK_EQUAL( numFired[0], numFired[1] );
+}
+
 // test_time_queue.cpp
@@ -0,0 +1,180 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "cstdmf/concurrency.hpp"
+#include "cstdmf/profile.hpp"
+#include "cstdmf/timestamp.hpp"
+#include "cstdmf/trace_buffer.hpp"
+
+#include <sstream>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
+namespace
+{
+
+/**
+ *	This function returns the number of times that a string occurs in another.
+ */
+int countOccurrences( const std::string & str, const std::string & pattern )
+{
+	int count = 0;
+	std::string::size_type pos = str.find( pattern );
+
+	while (pos != std::string::npos)
+	{
+		++count;
+		pos = str.find( pattern, pos + pattern.size() );
+	}
+
+	return count;
+}
+
+
+void traceWorker( void * )
+{
+	TraceBuffer::begin( "TraceWorker" );
+	TraceBuffer::end( "TraceWorker" );
+}
+
+
+/**
+ *	This function stops the compiler from moving memory accesses across it but,
+ *	unlike memory_barrier, does not stop the processor.
+ */
+inline void compilerBarrier()
+{
+#ifdef _WIN32
+	_ReadWriteBarrier();
+#else
+	__asm__ volatile ( "" : : : "memory" );
+#endif
+}
+
+
+/**
+ *	This function returns the average time in nanoseconds of an empty traced
+ *	scope.
+ */
+double timeScope( int numScopes )
+{
+	// Without these, the check of whether tracing is enabled is moved out of
+	// the loop and the disabled case measures an empty loop.
+	const char * volatile pName = "TraceOverhead";
+
+	const uint64 startTime = timestamp();
+
+	for (int i = 0; i < numScopes; ++i)
+	{
+		TraceBuffer::begin( pName );
+		compilerBarrier();
+		TraceBuffer::end( pName );
+		compilerBarrier();
+	}
+
+	return double( timestamp() - startTime ) * 1000000000.0 /
+		stampsPerSecondD() / numScopes;
+}
+
+} // anonymous namespace
+
+
+TEST( TraceBuffer_chromeTrace )
+{
+	TraceBuffer::isEnabled( true );
+
+	TraceBuffer::begin( "TraceOuter" );
+	TraceBuffer::begin( "Trace\"Inner\"" );
+	TraceBuffer::end( "Trace\"Inner\"" );
+	TraceBuffer::end( "TraceOuter" );
+
+	{
+		// The destructor waits for the thread to finish.
+		SimpleThread thread( traceWorker, NULL );
+	}
+
+	TraceBuffer::isEnabled( false );
+
+	// Nothing is recorded while disabled.
+	TraceBuffer::begin( "TraceDisabled" );
+	TraceBuffer::end( "TraceDisabled" );
+
+	std::ostringstream stream;
+	TraceBuffer::writeChromeTrace( stream, 60.0 );
+	const std::string trace = stream.str();
+
+	CHECK_EQUAL( 0U, trace.find( "{\"traceEvents\":[" ) );
+	CHECK_EQUAL( trace.size() - 2, trace.rfind( "}" ) );
+
+	CHECK_EQUAL( 2, countOccurrences( trace, "\"name\":\"TraceOuter\"" ) );
+	CHECK_EQUAL( 2,
+		countOccurrences( trace, "\"name\":\"Trace\\\"Inner\\\"\"" ) );
+	CHECK_EQUAL( 2, countOccurrences( trace, "\"name\":\"TraceWorker\"" ) );
+	CHECK_EQUAL( 0, countOccurrences( trace, "TraceDisabled" ) );
+
+	CHECK_EQUAL( countOccurrences( trace, "\"ph\":\"B\"" ),
+		countOccurrences( trace, "\"ph\":\"E\"" ) );
+
+	// Events older than the period are left out.
+	std::ostringstream emptyStream;
+	TraceBuffer::writeChromeTrace( emptyStream, 0.0 );
+	CHECK_EQUAL( 0, countOccurrences( emptyStream.str(), "TraceOuter" ) );
+}
+
+
+TEST( TraceBuffer_profile )
+{
+	ProfileVal profile( "TraceProfile" );
+
+	TraceBuffer::isEnabled( true );
+	profile.start();
+	profile.stop();
+	TraceBuffer::isEnabled( false );
+
+	std::ostringstream stream;
+	TraceBuffer::writeChromeTrace( stream, 60.0 );
+	const std::string trace = stream.str();
+
+	CHECK_EQUAL( 1, countOccurrences( trace,
+		"\"name\":\"TraceProfile\",\"ph\":\"B\"" ) );
+	CHECK_EQUAL( 1, countOccurrences( trace,
+		"\"name\":\"TraceProfile\",\"ph\":\"E\"" ) );
+}
+
+
+/**
+ *	This test reports the cost of a traced scope with tracing disabled and
+ *	enabled.
+ */
+TEST( TraceBuffer_overhead )
+{
+	const int NUM_SCOPES = 1000000;
+
+	const double disabledTime = timeScope( NUM_SCOPES );
+
+	TraceBuffer::isEnabled( true );
+	const double enabledTime = timeScope( NUM_SCOPES );
+	TraceBuffer::isEnabled( false );
+
+	printf( "TraceBuffer_overhead: %.1fns per scope disabled, "
+			"%.1fns enabled\n",
+		disabledTime, enabledTime );
+
+	CHECK( disabledTime < enabledTime );
+}
+
+// test_trace_buffer.cpp
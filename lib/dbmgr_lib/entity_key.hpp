@@ -12,6 +12,7 @@ criminal penalties as provided by law.
 #ifndef ENTITY_KEY_HPP
 #define ENTITY_KEY_HPP
 
+#include "cstdmf/hash_map.hpp"
 #include "network/basictypes.hpp"
 #include <string>
 
@@ -34,11 +35,26 @@ public:
 				((typeID == other.typeID) && (dbID < other.dbID));
 	}
 
+	bool operator==( const EntityKey & other ) const
+	{
+		return (typeID == other.typeID) && (dbID == other.dbID);
+	}
+
 	EntityTypeID	typeID;
 	DatabaseID 		dbID;
 };
 
 
+/**
+ *	This function returns the hash of an entity key. It is needed for using an
+ *	entity key as a key in a HashMap.
+ */
+inline uint32 hashMapHash( const EntityKey & key )
+{
+	return hashMapHash( key.dbID ) + key.typeID * 2654435761U;
+}
+
+
 /**
  *	This class represents a key to an entity record in the database that can
  *	use either a DatabaseID or the entity's identifier string.
@@ -11,6 +11,8 @@ criminal penalties as provided by law.
 
 #include "buffered_entity_tasks.hpp"
 
+#include "group_committer.hpp"
+
 #include "dbmgr_lib/idatabase.hpp" // For EntityKey
 
 #include "tasks/entity_task.hpp"
@@ -32,16 +34,12 @@ bool isValidDBID( DatabaseID id )
 template < class MAP, class ID >
 bool grabLockT( MAP & tasks, ID id )
 {
-	typedef typename MAP::iterator iterator;
-	std::pair< iterator, iterator > range = tasks.equal_range( id );
-
-	if (range.first != range.second)
+	if (tasks.count( id ) != 0)
 	{
 		return false;
 	}
 
-	tasks.insert( range.second, std::make_pair( id,
-				static_cast< EntityTask * >( NULL ) ) );
+	tasks[ id ];
 
 	return true;
 }
@@ -50,14 +48,12 @@ bool grabLockT( MAP & tasks, ID id )
 template < class MAP, class ID >
 void bufferT( MAP & tasks, ID id, EntityTask * pTask )
 {
-	typedef typename MAP::iterator iterator;
-	std::pair< iterator, iterator > range = tasks.equal_range( id );
+	typename MAP::iterator iter = tasks.find( id );
 
-	MF_ASSERT( range.first != range.second );
-	MF_ASSERT( range.first->second == NULL );
+	MF_ASSERT( iter != tasks.end() );
 
 	// Make sure that it is inserted at the end.
-	tasks.insert( range.second, std::make_pair( id, pTask ) );
+	iter->second.push_back( pTask );
 }
 
 } // anonymous namespace
@@ -73,7 +69,8 @@ void bufferT( MAP & tasks, ID id, EntityTask * pTask )
  *	@param bgTaskManager The manager where the tasks will be run.
  */
 BufferedEntityTasks::BufferedEntityTasks( BgTaskManager & bgTaskManager ) :
-	bgTaskManager_( bgTaskManager )
+	bgTaskManager_( bgTaskManager ),
+	pGroupCommitter_( NULL )
 {
 }
 
@@ -201,23 +198,20 @@ void BufferedEntityTasks::onFinishedNewEntity( EntityTask * pFinishedTask )
 		return;
 	}
 
-	typedef EntityIDMap Map;
-	Map & tasks = priorToDBIDTasks_;
+	EntityIDMap::iterator found = priorToDBIDTasks_.find( entityID );
 
-	std::pair< Map::iterator, Map::iterator > range =
-			tasks.equal_range( entityID );
+	MF_ASSERT( found != priorToDBIDTasks_.end() );
 
-	MF_ASSERT( range.first != range.second );
-	MF_ASSERT( range.first->second == NULL );
-
-	Map::iterator iter = range.first;
-	++iter;
+	BufferedTasks bufferedTasks;
+	bufferedTasks.swap( found->second );
+	priorToDBIDTasks_.erase( found );
 
 	EntityTask * pTaskToPlay = NULL;
 
-	while (iter != range.second)
+	for (BufferedTasks::iterator iter = bufferedTasks.begin();
+			iter != bufferedTasks.end(); ++iter)
 	{
-		EntityTask * pTask = iter->second;
+		EntityTask * pTask = *iter;
 
 		pTask->dbID( entityKey.dbID );
 
@@ -231,12 +225,8 @@ void BufferedEntityTasks::onFinishedNewEntity( EntityTask * pFinishedTask )
 			MF_ASSERT( pTaskToPlay != NULL );
 			this->buffer( pTask );
 		}
-
-		++iter;
 	}
 
-	tasks.erase( range.first, range.second );
-
 	if (pTaskToPlay)
 	{
 		this->doTask( pTaskToPlay );
@@ -252,7 +242,16 @@ void BufferedEntityTasks::doTask( EntityTask * pTask )
 	// So that it can inform us when it is done.
 	pTask->pBufferedEntityTasks( this );
 
-	bgTaskManager_.addBackgroundTask( pTask );
+	// This task holds the lock for its entity, so it can share a transaction
+	// with the tasks of other entities.
+	if (pGroupCommitter_ && pTask->canGroupCommit())
+	{
+		pGroupCommitter_->add( pTask );
+	}
+	else
+	{
+		bgTaskManager_.addBackgroundTask( pTask );
+	}
 }
 
 
@@ -265,33 +264,26 @@ void BufferedEntityTasks::doTask( EntityTask * pTask )
 template < class MAP, class ID >
 bool BufferedEntityTasks::playNextTask( MAP & tasks, ID id )
 {
-	typedef typename MAP::iterator iterator;
-	std::pair< iterator, iterator > range = tasks.equal_range( id );
+	typename MAP::iterator iter = tasks.find( id );
 
-	if ((range.first == range.second) ||
-			(range.first->second != NULL))
+	if (iter == tasks.end())
 	{
 		// Not from this map.
 		return false;
 	}
 
-	// There must be tasks and the first (the one being deleted) must be
-	// NULL.
-	MF_ASSERT( range.first != range.second );
-	MF_ASSERT( range.first->second == NULL );
-
-	iterator nextIter = range.first;
-	++nextIter;
 	EntityTask * pNextTask = NULL;
 
-	if (nextIter != range.second)
+	if (!iter->second.empty())
 	{
-		pNextTask = nextIter->second;
-
-		nextIter->second = NULL;
+		// The next task takes over the lock.
+		pNextTask = iter->second.front();
+		iter->second.erase( iter->second.begin() );
+	}
+	else
+	{
+		tasks.erase( iter );
 	}
-
-	tasks.erase( range.first );
 
 	if (pNextTask)
 	{
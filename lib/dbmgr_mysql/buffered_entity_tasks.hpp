@@ -12,13 +12,15 @@ criminal penalties as provided by law.
 #ifndef BUFFERED_ENTITY_TASKS_HPP
 #define BUFFERED_ENTITY_TASKS_HPP
 
+#include "cstdmf/hash_map.hpp"
+#include "dbmgr_lib/entity_key.hpp"
 #include "network/basictypes.hpp"
 
-#include <map>
+#include <vector>
 
 class BgTaskManager;
-class EntityKey;
 class EntityTask;
+class GroupCommitter;
 
 
 /**
@@ -36,6 +38,11 @@ public:
 
 	void onFinished( EntityTask * pTask );
 
+	void pGroupCommitter( GroupCommitter * pGroupCommitter )
+	{
+		pGroupCommitter_ = pGroupCommitter;
+	}
+
 private:
 	bool grabLock( EntityTask * pTask );
 	void buffer( EntityTask * pTask );
@@ -47,14 +54,19 @@ private:
 	bool playNextTask( MAP & tasks, ID id );
 
 	BgTaskManager & bgTaskManager_;
+	GroupCommitter * pGroupCommitter_;
+
+	// An entity has an entry while one of its tasks is running. The entry
+	// holds the tasks waiting for it to finish, in the order they arrived.
+	typedef std::vector< EntityTask * > BufferedTasks;
 
-	typedef std::multimap< EntityKey, EntityTask * > EntityKeyMap;
-	typedef std::multimap< EntityID, EntityTask * > EntityIDMap;
+	typedef HashMap< EntityKey, BufferedTasks > EntityKeyMap;
+	typedef HashMap< EntityID, BufferedTasks > EntityIDMap;
 
 	EntityKeyMap tasks_;
 	EntityIDMap priorToDBIDTasks_;
 
-	typedef std::map< EntityID, DatabaseID > NewEntityMap;
+	typedef HashMap< EntityID, DatabaseID > NewEntityMap;
 	NewEntityMap newEntityMap_;
 };
 
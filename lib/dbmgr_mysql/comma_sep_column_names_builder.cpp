@@ -103,4 +103,34 @@ bool CommaSepColNamesBuilderWithSuffix::onVisitColumn(
 	return shouldContinue;
 }
 
+
+/**
+ *	Constructor.
+ */
+CommaSepColNamesBuilderWithValues::CommaSepColNamesBuilderWithValues(
+		PropertyMapping & property )
+{
+	property.visitParentColumns( *this );
+}
+
+
+bool CommaSepColNamesBuilderWithValues::onVisitColumn(
+		const ColumnDescription & column )
+{
+	if (!column.shouldIgnore())
+	{
+		if (count_ > 0)
+		{
+			commaSepColumnNames_ << ',';
+		}
+
+		commaSepColumnNames_ << column.columnName() <<
+			"=VALUES(" << column.columnName() << ')';
+
+		++count_;
+	}
+
+	return true;
+}
+
 // comma_sep_column_names_builder.cpp
@@ -71,4 +71,17 @@ private:
 	std::string suffix_;
 };
 
+/**
+ *	This helper class builds a comma separated list that sets each column to
+ *	the value it would have been inserted with, for example
+ *	"a=VALUES(a),b=VALUES(b)". This is used in ON DUPLICATE KEY UPDATE.
+ */
+class CommaSepColNamesBuilderWithValues : public CommaSepColNamesBuilder
+{
+public:
+	CommaSepColNamesBuilderWithValues( PropertyMapping & property );
+
+	bool onVisitColumn( const ColumnDescription & column );
+};
+
 #endif // MYSQL_COMMA_SEP_COLUMN_NAMES_BUILDER_HPP
@@ -28,6 +28,16 @@ DatabaseException::DatabaseException( MYSQL * pConnection ) :
 }
 
 
+/**
+ *	Constructor.
+ */
+DatabaseException::DatabaseException( MYSQL_STMT * pStatement ) :
+			errStr_( mysql_stmt_error( pStatement ) ),
+			errNum_( mysql_stmt_errno( pStatement ) )
+{
+}
+
+
 /**
  *	Destructor.
  */
@@ -22,6 +22,7 @@ class DatabaseException : public std::exception
 {
 public:
 	DatabaseException( MYSQL * pConnection );
+	DatabaseException( MYSQL_STMT * pStatement );
 	~DatabaseException() throw();
 
 	virtual const char * what() const throw() { return errStr_.c_str(); }
@@ -0,0 +1,261 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "group_committer.hpp"
+
+#include "tasks/entity_task.hpp"
+#include "tasks/group_commit_task.hpp"
+
+#include "cstdmf/bgtask_manager.hpp"
+#include "cstdmf/debug.hpp"
+#include "cstdmf/timestamp.hpp"
+#include "cstdmf/watcher.hpp"
+
+#include "network/event_dispatcher.hpp"
+
+#include <algorithm>
+
+DECLARE_DEBUG_COMPONENT( 0 );
+
+
+/**
+ *	Constructor.
+ *
+ *	@param bgTaskManager	The manager where the batches will be run.
+ *	@param dispatcher		The dispatcher used to time the batch window.
+ */
+GroupCommitter::GroupCommitter( BgTaskManager & bgTaskManager,
+		Mercury::EventDispatcher & dispatcher ) :
+	bgTaskManager_( bgTaskManager ),
+	dispatcher_( dispatcher ),
+	pendingTasks_(),
+	timerHandle_(),
+	maxBatchSize_( 1 ),
+	windowMillis_( 5 ),
+	numBatches_( 0 ),
+	numWrites_( 0 ),
+	numSplitBatches_( 0 ),
+	lastBatchSize_( 0 ),
+	numTimedBatches_( 0 ),
+	totalCommitTime_( 0 ),
+	lastCommitTime_( 0 ),
+	maxCommitTime_( 0 )
+{
+}
+
+
+/**
+ *	Destructor.
+ */
+GroupCommitter::~GroupCommitter()
+{
+	timerHandle_.cancel();
+}
+
+
+/**
+ *	This method adds a task to the current batch. The batch is sent to a
+ *	background thread when it is full or when the window has passed since
+ *	its first task was added.
+ */
+void GroupCommitter::add( EntityTask * pTask )
+{
+	if (!this->isEnabled())
+	{
+		bgTaskManager_.addBackgroundTask( pTask );
+		return;
+	}
+
+	pendingTasks_.push_back( pTask );
+
+	if (int( pendingTasks_.size() ) >= maxBatchSize_)
+	{
+		this->flush();
+	}
+	else if (!timerHandle_.isSet())
+	{
+		timerHandle_ = dispatcher_.addOnceOffTimer(
+				int64( windowMillis_ ) * 1000, this );
+	}
+}
+
+
+/**
+ *	This method sends the current batch, if any, to a background thread.
+ */
+void GroupCommitter::flush()
+{
+	timerHandle_.cancel();
+
+	if (pendingTasks_.empty())
+	{
+		return;
+	}
+
+	if (pendingTasks_.size() == 1)
+	{
+		// Not worth the overhead of a batch.
+		bgTaskManager_.addBackgroundTask( pendingTasks_.front().get() );
+		pendingTasks_.clear();
+
+		this->onBatchCommitted( 1, 0, false );
+		return;
+	}
+
+	bgTaskManager_.addBackgroundTask(
+			new GroupCommitTask( *this, pendingTasks_ ) );
+}
+
+
+/**
+ *	This method is called when the batch window has passed.
+ */
+void GroupCommitter::handleTimeout( TimerHandle handle, void * arg )
+{
+	timerHandle_.clearWithoutCancel();
+	this->flush();
+}
+
+
+/**
+ *	This method is called in the main thread when a batch has completed.
+ *
+ *	@param batchSize	The number of tasks in the batch.
+ *	@param commitTime	The time taken to perform the batch, in stamps.
+ *	@param wasSplit		Whether the batch failed and each task was performed
+ *						in its own transaction.
+ */
+void GroupCommitter::onBatchCommitted( int batchSize, uint64 commitTime,
+		bool wasSplit )
+{
+	++numBatches_;
+	numWrites_ += batchSize;
+	lastBatchSize_ = batchSize;
+
+	if (wasSplit)
+	{
+		++numSplitBatches_;
+	}
+
+	// Single writes are not timed here.
+	if (batchSize > 1)
+	{
+		++numTimedBatches_;
+		totalCommitTime_ += commitTime;
+		lastCommitTime_ = commitTime;
+		maxCommitTime_ = std::max( maxCommitTime_, commitTime );
+	}
+}
+
+
+/**
+ *	This method sets the maximum number of writes in a batch. A value of 1 or
+ *	less disables group commit.
+ */
+void GroupCommitter::maxBatchSize( int value )
+{
+	maxBatchSize_ = std::max( value, 1 );
+
+	if (int( pendingTasks_.size() ) >= maxBatchSize_)
+	{
+		this->flush();
+	}
+}
+
+
+/**
+ *	This method sets how long the first write of a batch may wait for others
+ *	to join it.
+ */
+void GroupCommitter::windowMillis( int value )
+{
+	windowMillis_ = std::max( value, 0 );
+}
+
+
+/**
+ *	This method returns the average number of writes per batch.
+ */
+double GroupCommitter::averageBatchSize() const
+{
+	return (numBatches_ > 0) ? double( numWrites_ )/numBatches_ : 0.0;
+}
+
+
+/**
+ *	This method returns the average time in milliseconds taken to perform and
+ *	commit a batch of more than one write.
+ */
+double GroupCommitter::averageCommitLatency() const
+{
+	return (numTimedBatches_ > 0) ?
+		double( totalCommitTime_ ) * 1000.0 / stampsPerSecondD() /
+			numTimedBatches_ :
+		0.0;
+}
+
+
+/**
+ *	This method returns the time in milliseconds taken by the last batch of
+ *	more than one write.
+ */
+double GroupCommitter::lastCommitLatency() const
+{
+	return double( lastCommitTime_ ) * 1000.0 / stampsPerSecondD();
+}
+
+
+/**
+ *	This method returns the longest time in milliseconds taken by a batch of
+ *	more than one write.
+ */
+double GroupCommitter::maxCommitLatency() const
+{
+	return double( maxCommitTime_ ) * 1000.0 / stampsPerSecondD();
+}
+
+
+#if ENABLE_WATCHERS
+/**
+ *	This method adds the watchers that report the batches of writes.
+ */
+void GroupCommitter::addWatchers()
+{
+	MF_WATCH( "groupCommit/maxBatchSize", *this,
+		MF_ACCESSORS( int, GroupCommitter, maxBatchSize ),
+		"The maximum number of entity writes in a transaction. "
+			"A value of 1 disables group commit" );
+	MF_WATCH( "groupCommit/windowMillis", *this,
+		MF_ACCESSORS( int, GroupCommitter, windowMillis ),
+		"How long in milliseconds a write may wait for others to join its "
+			"transaction" );
+
+	MF_WATCH( "groupCommit/numBatches", numBatches_,
+		Watcher::WT_READ_ONLY );
+	MF_WATCH( "groupCommit/numWrites", numWrites_,
+		Watcher::WT_READ_ONLY );
+	MF_WATCH( "groupCommit/numSplitBatches", numSplitBatches_,
+		Watcher::WT_READ_ONLY );
+	MF_WATCH( "groupCommit/lastBatchSize", lastBatchSize_,
+		Watcher::WT_READ_ONLY );
+	MF_WATCH( "groupCommit/averageBatchSize", *this,
+		&GroupCommitter::averageBatchSize );
+
+	MF_WATCH( "groupCommit/commitLatency/average", *this,
+		&GroupCommitter::averageCommitLatency );
+	MF_WATCH( "groupCommit/commitLatency/last", *this,
+		&GroupCommitter::lastCommitLatency );
+	MF_WATCH( "groupCommit/commitLatency/max", *this,
+		&GroupCommitter::maxCommitLatency );
+}
+#endif // ENABLE_WATCHERS
+
+// group_committer.cpp
@@ -0,0 +1,98 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef GROUP_COMMITTER_HPP
+#define GROUP_COMMITTER_HPP
+
+#include "cstdmf/config.hpp"
+#include "cstdmf/smartpointer.hpp"
+#include "cstdmf/stdmf.hpp"
+#include "cstdmf/timer_handler.hpp"
+
+#include <vector>
+
+class BgTaskManager;
+class EntityTask;
+
+namespace Mercury
+{
+class EventDispatcher;
+}
+
+
+/**
+ *	This class collects entity writes that arrive within a short window and
+ *	commits them in a single transaction. This reduces the number of commits,
+ *	and so the number of log flushes done by MySQL, when many entities are
+ *	written at once, such as during auto-archiving or a mass log off.
+ *
+ *	Tasks are added by BufferedEntityTasks once they hold the lock for their
+ *	entity, so a batch never has two tasks for the same entity. Each task
+ *	still completes, and calls its handler, on its own in the main thread.
+ *
+ *	Group commit is off, with a maxBatchSize of 1, unless it is set with
+ *	dbMgr/groupCommit/maxBatchSize.
+ */
+class GroupCommitter : public TimerHandler
+{
+public:
+	GroupCommitter( BgTaskManager & bgTaskManager,
+			Mercury::EventDispatcher & dispatcher );
+	~GroupCommitter();
+
+	void add( EntityTask * pTask );
+	void flush();
+
+	void onBatchCommitted( int batchSize, uint64 commitTime, bool wasSplit );
+
+	bool isEnabled() const			{ return maxBatchSize_ > 1; }
+
+	int maxBatchSize() const		{ return maxBatchSize_; }
+	void maxBatchSize( int value );
+
+	int windowMillis() const		{ return windowMillis_; }
+	void windowMillis( int value );
+
+#if ENABLE_WATCHERS
+	void addWatchers();
+#endif
+
+private:
+	virtual void handleTimeout( TimerHandle handle, void * arg );
+
+	double averageBatchSize() const;
+	double averageCommitLatency() const;
+	double lastCommitLatency() const;
+	double maxCommitLatency() const;
+
+	typedef std::vector< SmartPointer< EntityTask > > Tasks;
+
+	BgTaskManager & bgTaskManager_;
+	Mercury::EventDispatcher & dispatcher_;
+
+	Tasks pendingTasks_;
+	TimerHandle timerHandle_;
+
+	int maxBatchSize_;
+	int windowMillis_;
+
+	uint64 numBatches_;
+	uint64 numWrites_;
+	uint64 numSplitBatches_;
+	int lastBatchSize_;
+
+	uint64 numTimedBatches_;
+	uint64 totalCommitTime_;
+	uint64 lastCommitTime_;
+	uint64 maxCommitTime_;
+};
+
+#endif // GROUP_COMMITTER_HPP
@@ -53,7 +53,7 @@ void ClassMapping::fromStreamToDatabase( StreamToQueryHelper & helper,
 	}
 	else
 	{
-		MemoryOStream stream;
+		MemoryOStream stream( 64, MemoryStreamArena::instance() );
 		this->CompositePropertyMapping::defaultToStream( stream );
 		this->CompositePropertyMapping::fromStreamToDatabase( helper,
 				stream, queryRunner );
@@ -83,7 +83,7 @@ void ClassMapping::fromDatabaseToStream( ResultToStreamHelper & helper,
 	}
 	else
 	{
-		MemoryOStream tempStream;
+		MemoryOStream tempStream( 64, MemoryStreamArena::instance() );
 		this->CompositePropertyMapping::fromDatabaseToStream( helper,
 				results, tempStream );
 	}
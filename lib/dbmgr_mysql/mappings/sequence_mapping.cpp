@@ -27,6 +27,8 @@ namespace
 const int MAX_NUM_ELEMENTS = 100000;
 }
 
+bool SequenceMapping::s_useMultiRowWrites_ = false;
+
 
 /**
  *	Constructor.
@@ -131,6 +133,25 @@ void SequenceMapping::prepareSQL()
 	stmt += " AND id >= ?";
 	deleteExtraQuery_.init( stmt );
 
+	if (!childHasTable_)
+	{
+		// Existing rows are updated by inserting them again with their IDs.
+		// Rows that have not changed are left untouched by the server.
+		CommaSepColNamesBuilderWithValues valuesBuilder( *pChild_ );
+
+		for (int i = 0; i < NUM_BATCH_SIZES; ++i)
+		{
+			const int numRows = 1 << i;
+
+			insertBatchQueries_[i].init( buildInsertBatchStmt( tblName_,
+				childColNames, childNumColumns, numRows ) );
+
+			updateBatchQueries_[i].init( buildUpdateBatchStmt( tblName_,
+				childColNames, valuesBuilder.getResult(), childNumColumns,
+				numRows ) );
+		}
+	}
+
 	pChild_->prepareSQL();
 }
 
@@ -199,39 +220,54 @@ void SequenceMapping::fromStreamToDatabase( StreamToQueryHelper & helper,
 
 		int numUpdates = std::min( numRows, numElems );
 
+		// Elements with their own tables are written one at a time, since
+		// each row's ID is needed for its children.
+		const bool shouldBatch = s_useMultiRowWrites_ && !childHasTable_;
+
 		// Update existing rows
-		for (int i = 0; i < numUpdates; ++i)
+		if (shouldBatch)
+		{
+			this->writeBatches( updateBatchQueries_, connection, parentID,
+					strm, numUpdates, &resultSet );
+		}
+		else
 		{
-			QueryRunner updateQueryRunner( connection, updateQuery_ );
+			for (int i = 0; i < numUpdates; ++i)
+			{
+				QueryRunner updateQueryRunner( connection, updateQuery_ );
 
-			// If we are updating existing rows we must have a parentID
-			MF_ASSERT( parentID != 0 );
+				// If we are updating existing rows we must have a parentID
+				MF_ASSERT( parentID != 0 );
 
-			updateQueryRunner.pushArg( parentID );
+				updateQueryRunner.pushArg( parentID );
 
-			DatabaseID childID;
-			resultSet.getResult( childID );
+				DatabaseID childID;
+				resultSet.getResult( childID );
 
-			StreamToQueryHelper childHelper( connection, childID );
+				StreamToQueryHelper childHelper( connection, childID );
 
-			pChild_->fromStreamToDatabase( childHelper, strm,
-											updateQueryRunner );
-			if (strm.error())
-			{
-				ERROR_MSG( "SequenceMapping::fromStreamToDatabase: "
-							"Failed to stream property '%s'.\n",
-						pChild_->propName().c_str() );
-			}
+				pChild_->fromStreamToDatabase( childHelper, strm,
+												updateQueryRunner );
+				if (strm.error())
+				{
+					ERROR_MSG( "SequenceMapping::fromStreamToDatabase: "
+								"Failed to stream property '%s'.\n",
+							pChild_->propName().c_str() );
+				}
 
-			MF_ASSERT( !childHelper.hasBufferedQueries() );
+				MF_ASSERT( !childHelper.hasBufferedQueries() );
 
-			updateQueryRunner.pushArg( childID );
+				updateQueryRunner.pushArg( childID );
 
-			updateQueryRunner.execute( NULL );
+				updateQueryRunner.execute( NULL );
+			}
 		}
 
+		// A failed batch stops part way through the stream.
+		const bool hasBatchFailed = shouldBatch && strm.error();
+
 		// Delete any extra rows (i.e. array has shrunk).
-		if (numRows > numElems)
+		if ((numRows > numElems) && !hasBatchFailed)
 		{
 			DatabaseID nextID;
 			resultSet.getResult( nextID );
@@ -248,14 +284,19 @@ void SequenceMapping::fromStreamToDatabase( StreamToQueryHelper & helper,
 			}
 		}
 		// Insert any extra rows (i.e. array has grown)
-		else if ((numElems > numRows) && !strm.error())
+		else if ((numElems > numRows) && !hasBatchFailed)
 		{
 			int numToAdd = numElems - numRows;
 
 			// If we already have the parentID, the child table can be written
 			// now, otherwise this query is buffered until the parentID is
 			// known.
-			if (parentID != 0)
+			if ((parentID != 0) && shouldBatch)
+			{
+				this->writeBatches( insertBatchQueries_, connection, parentID,
+						strm, numToAdd, NULL );
+			}
+			else if (parentID != 0)
 			{
 				for (int i = 0; i < numToAdd; ++i)
 				{
@@ -299,6 +340,139 @@ void SequenceMapping::fromStreamToDatabase( StreamToQueryHelper & helper,
 }
 
 
+/**
+ *	This method writes elements from the stream with multi-row queries. Each
+ *	batch is the largest power of two that fits, so that only a few distinct
+ *	statements are used.
+ *
+ *	@param queries		The queries to use, indexed by log2 of their rows.
+ *	@param connection	The connection to write with.
+ *	@param parentID		The ID of the parent record.
+ *	@param strm			The stream containing the elements.
+ *	@param numElems		The number of elements to write.
+ *	@param pChildIDs	If not NULL, the IDs of the existing rows to update. The
+ *						ID is then the first column of each row.
+ */
+void SequenceMapping::writeBatches( const Query * queries,
+		MySql & connection, DatabaseID parentID, BinaryIStream & strm,
+		int numElems, ResultSet * pChildIDs ) const
+{
+	int numWritten = 0;
+
+	while ((numWritten < numElems) && !strm.error())
+	{
+		const int batchIndex =
+			SequenceMapping::batchSizeIndex( numElems - numWritten );
+		const int batchSize = 1 << batchIndex;
+
+		QueryRunner queryRunner( connection, queries[ batchIndex ] );
+
+		for (int i = 0; i < batchSize; ++i)
+		{
+			DatabaseID childID = 0;
+
+			if (pChildIDs != NULL)
+			{
+				pChildIDs->getResult( childID );
+				queryRunner.pushArg( childID );
+			}
+
+			StreamToQueryHelper childHelper( connection, childID );
+
+			pChild_->fromStreamToDatabase( childHelper, strm, queryRunner );
+
+			MF_ASSERT( !childHelper.hasBufferedQueries() );
+
+			queryRunner.pushArg( parentID );
+		}
+
+		if (strm.error())
+		{
+			ERROR_MSG( "SequenceMapping::writeBatches: "
+						"Failed to stream property '%s'. "
+						"Parent record id=%"FMT_DBID".\n",
+					pChild_->propName().c_str(), parentID );
+			return;
+		}
+
+		queryRunner.execute( NULL );
+
+		numWritten += batchSize;
+	}
+}
+
+
+/**
+ *	This method returns the index of the largest multi-row query that can be
+ *	used to write some elements. That query writes 2^index rows.
+ *
+ *	@param numElems	The number of elements left to write. This must be
+ *					positive.
+ */
+int SequenceMapping::batchSizeIndex( int numElems )
+{
+	int batchIndex = NUM_BATCH_SIZES - 1;
+
+	while ((1 << batchIndex) > numElems)
+	{
+		--batchIndex;
+	}
+
+	return batchIndex;
+}
+
+
+/**
+ *	This method returns the statement that inserts numRows new elements of a
+ *	sequence whose child has the given columns.
+ */
+std::string SequenceMapping::buildInsertBatchStmt( const std::string & tblName,
+		const std::string & childColNames, int childNumColumns, int numRows )
+{
+	std::string stmt = "INSERT INTO " + tblName + " (";
+
+	if (childNumColumns)
+	{
+		stmt += childColNames + ",";
+	}
+
+	stmt += "parentID) VALUES " +
+		buildMultiRowQuestionMarks( childNumColumns + 1, numRows );
+
+	return stmt;
+}
+
+
+/**
+ *	This method returns the statement that writes numRows existing elements of
+ *	a sequence whose child has the given columns. Each row is inserted again
+ *	with its ID, which updates the existing row instead.
+ *
+ *	@param childUpdateValues	The child's columns in the form col=VALUES(col).
+ */
+std::string SequenceMapping::buildUpdateBatchStmt( const std::string & tblName,
+		const std::string & childColNames,
+		const std::string & childUpdateValues, int childNumColumns,
+		int numRows )
+{
+	std::string stmt = "INSERT INTO " + tblName + " (id,";
+
+	if (childNumColumns)
+	{
+		stmt += childColNames + ",";
+	}
+
+	stmt += "parentID) VALUES " +
+		buildMultiRowQuestionMarks( childNumColumns + 2, numRows ) +
+		" ON DUPLICATE KEY UPDATE ";
+
+	// An update clause must set at least one column.
+	stmt += childNumColumns ? childUpdateValues : "parentID=VALUES(parentID)";
+
+	return stmt;
+}
+
+
 /*
  *	Override from PropertyMapping.
  */
@@ -19,6 +19,8 @@ criminal penalties as provided by law.
 
 #include <memory>
 
+class ResultSet;
+
 
 /**
  *	This class maps sequences to tables.
@@ -68,7 +70,33 @@ public:
 
 	virtual bool visitSubTablesWith( TableVisitor & visitor );
 
+	static bool useMultiRowWrites()		{ return s_useMultiRowWrites_; }
+	static void useMultiRowWrites( bool value )
+	{
+		s_useMultiRowWrites_ = value;
+	}
+
+	static int batchSizeIndex( int numElems );
+
+	static std::string buildInsertBatchStmt( const std::string & tblName,
+			const std::string & childColNames, int childNumColumns,
+			int numRows );
+	static std::string buildUpdateBatchStmt( const std::string & tblName,
+			const std::string & childColNames,
+			const std::string & childUpdateValues, int childNumColumns,
+			int numRows );
+
+	/// The number of sizes of multi-row queries. The largest writes
+	/// 2^(NUM_BATCH_SIZES - 1) rows.
+	static const int NUM_BATCH_SIZES = 7;
+
 private:
+	void writeBatches( const Query * queries, MySql & connection,
+			DatabaseID parentID, BinaryIStream & strm, int numElems,
+			ResultSet * pChildIDs ) const;
+
+	static bool s_useMultiRowWrites_;
+
 	std::string tblName_;
 	PropertyMappingPtr pChild_;
 	int	size_;
@@ -86,6 +114,12 @@ private:
 
 	Query insertQuery_;
 	Query updateQuery_;
+
+	// Multi-row queries, indexed by log2 of their number of rows. These are
+	// only used when the child does not have its own table and multi-row
+	// writes are enabled.
+	Query insertBatchQueries_[ NUM_BATCH_SIZES ];
+	Query updateBatchQueries_[ NUM_BATCH_SIZES ];
 };
 
 #endif // MYSQL_SEQUENCE_MAPPING_HPP
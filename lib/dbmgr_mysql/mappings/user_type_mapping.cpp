@@ -71,7 +71,7 @@ void UserTypeMapping::fromDatabaseToStream( ResultToStreamHelper & helper,
 			ResultStream & results,
 			BinaryOStream & strm ) const
 {
-	MemoryOStream localStream;
+	MemoryOStream localStream( 64, MemoryStreamArena::instance() );
 	this->CompositePropertyMapping::fromDatabaseToStream( helper, results,
 			localStream );
 
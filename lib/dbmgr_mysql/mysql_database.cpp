@@ -14,6 +14,7 @@ criminal penalties as provided by law.
 #include "buffered_entity_tasks.hpp"
 #include "database_exception.hpp"
 #include "db_config.hpp"
+#include "group_committer.hpp"
 #include "locked_connection.hpp"
 #include "named_lock.hpp"
 #include "mysql_billing_system.hpp"
@@ -26,6 +27,7 @@ criminal penalties as provided by law.
 #include "wrapper.hpp"
 
 #include "mappings/entity_type_mapping.hpp"
+#include "mappings/sequence_mapping.hpp"
 
 #include "tasks/add_secondary_db_entry_task.hpp"
 #include "tasks/del_entity_task.hpp"
@@ -72,12 +74,15 @@ MySqlDatabase::MySqlDatabase(
 	reconnectTimerHandle_(),
 	reconnectCount_( 0 ),
 	pBufferedEntityTasks_( new BufferedEntityTasks( bgTaskManager_ ) ),
+	pGroupCommitter_( new GroupCommitter( bgTaskManager_, dispatcher ) ),
 	interface_( interface ),
 	dispatcher_( dispatcher ),
 	pEntityDefs_( NULL ),
 	entityTypeMappings_(),
 	pConnection_( NULL )
 {
+	pBufferedEntityTasks_->pGroupCommitter( pGroupCommitter_ );
+
 	dispatcher.addFrequentTask( this );
 }
 
@@ -87,12 +92,17 @@ MySqlDatabase::MySqlDatabase(
  */
 MySqlDatabase::~MySqlDatabase()
 {
+	pGroupCommitter_->flush();
+
 	bgTaskManager_.stopAll();
 
 	reconnectTimerHandle_.cancel();
 
 	delete pBufferedEntityTasks_;
 	pBufferedEntityTasks_ = NULL;
+
+	delete pGroupCommitter_;
+	pGroupCommitter_ = NULL;
 }
 
 
@@ -108,6 +118,19 @@ bool MySqlDatabase::startup( const EntityDefs & entityDefs,
 				info.port,
 				info.database.c_str() );
 
+	MySql::usePreparedStatements( BWConfig::get(
+		"dbMgr/usePreparedStatements", MySql::usePreparedStatements() ) );
+
+	INFO_MSG( "\tMySql: usePreparedStatements = %s.\n",
+			MySql::usePreparedStatements() ? "True" : "False" );
+
+	SequenceMapping::useMultiRowWrites( BWConfig::get(
+		"dbMgr/multiRowSequenceWrites",
+		SequenceMapping::useMultiRowWrites() ) );
+
+	INFO_MSG( "\tMySql: multiRowSequenceWrites = %s.\n",
+			SequenceMapping::useMultiRowWrites() ? "True" : "False" );
+
 	try
 	{
 		const DBConfig::ConnectionInfo & connectionInfo = 
@@ -164,6 +187,22 @@ bool MySqlDatabase::startup( const EntityDefs & entityDefs,
 
 		INFO_MSG( "\tMySql: Number of connections = %d.\n", numConnections_ );
 
+		pGroupCommitter_->maxBatchSize( BWConfig::get(
+			"dbMgr/groupCommit/maxBatchSize",
+			pGroupCommitter_->maxBatchSize() ) );
+		pGroupCommitter_->windowMillis( BWConfig::get(
+			"dbMgr/groupCommit/windowMillis",
+			pGroupCommitter_->windowMillis() ) );
+
+		INFO_MSG( "\tMySql: Group commit: maxBatchSize = %d, "
+				"windowMillis = %d.\n",
+			pGroupCommitter_->maxBatchSize(),
+			pGroupCommitter_->windowMillis() );
+
+#if ENABLE_WATCHERS
+		pGroupCommitter_->addWatchers();
+#endif
+
 		this->startBackgroundThreads( connectionInfo );
 
 		entityTypeMappings_.init( entityDefs, connection );
@@ -191,6 +230,9 @@ void MySqlDatabase::startBackgroundThreads(
 
 bool MySqlDatabase::shutDown()
 {
+	// Do not leave writes waiting for a batch window that will not pass.
+	pGroupCommitter_->flush();
+
 	try
 	{
 		delete pConnection_;
@@ -24,6 +24,7 @@ criminal penalties as provided by law.
 
 class BillingSystem;
 class BufferedEntityTasks;
+class GroupCommitter;
 
 class MySql;
 class MySqlLockedConnection;
@@ -134,6 +135,7 @@ private:
 	TimerHandle	reconnectTimerHandle_;
 	size_t reconnectCount_;
 	BufferedEntityTasks * pBufferedEntityTasks_;
+	GroupCommitter * pGroupCommitter_;
 
 	Mercury::NetworkInterface & interface_;
 	Mercury::EventDispatcher & dispatcher_;
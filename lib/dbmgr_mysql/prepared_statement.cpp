@@ -0,0 +1,573 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "prepared_statement.hpp"
+
+#include "database_exception.hpp"
+#include "result_set.hpp"
+#include "wrapper.hpp"
+
+#include "cstdmf/debug.hpp"
+
+#include <mysql/errmsg.h>
+
+DECLARE_DEBUG_COMPONENT( 0 );
+
+namespace
+{
+
+/// The initial size of the buffer of a string result column. It grows to fit
+/// larger values.
+const size_t INITIAL_COLUMN_BUFFER_SIZE = 256;
+
+} // anonymous namespace
+
+
+// -----------------------------------------------------------------------------
+// Section: StatementArgs
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+StatementArgs::StatementArgs() :
+	binds_(),
+	lengths_(),
+	offsets_(),
+	data_()
+{
+}
+
+
+/**
+ *	This method adds a float argument.
+ */
+void StatementArgs::add( float value )
+{
+	this->addBind( MYSQL_TYPE_FLOAT, false, &value, sizeof( value ) );
+}
+
+
+/**
+ *	This method adds a double argument.
+ */
+void StatementArgs::add( double value )
+{
+	this->addBind( MYSQL_TYPE_DOUBLE, false, &value, sizeof( value ) );
+}
+
+
+/**
+ *	This method adds a signed integer argument. All integers are sent as 64-bit
+ *	values and converted by the server.
+ */
+void StatementArgs::addInt( int64 value )
+{
+	this->addBind( MYSQL_TYPE_LONGLONG, false, &value, sizeof( value ) );
+}
+
+
+/**
+ *	This method adds an unsigned integer argument.
+ */
+void StatementArgs::addUint( uint64 value )
+{
+	this->addBind( MYSQL_TYPE_LONGLONG, true, &value, sizeof( value ) );
+}
+
+
+/**
+ *	This method adds a string argument. The string may contain binary data.
+ */
+void StatementArgs::addString( const char * str, int length )
+{
+	this->addBind( MYSQL_TYPE_STRING, false, str, length );
+}
+
+
+/**
+ *	This method adds a NULL argument.
+ */
+void StatementArgs::addNull()
+{
+	this->addBind( MYSQL_TYPE_NULL, false, NULL, 0 );
+}
+
+
+/**
+ *	This method adds an argument, copying its data.
+ */
+void StatementArgs::addBind( enum_field_types type, bool isUnsigned,
+		const void * pData, int length )
+{
+	// Keep each value 8 byte aligned.
+	const size_t offset = (data_.size() + 7) & ~size_t( 7 );
+
+	data_.resize( offset + length );
+
+	if (length > 0)
+	{
+		memcpy( &data_[ offset ], pData, length );
+	}
+
+	MYSQL_BIND bind;
+	memset( &bind, 0, sizeof( bind ) );
+
+	bind.buffer_type = type;
+	bind.buffer_length = length;
+	bind.is_unsigned = isUnsigned;
+
+	binds_.push_back( bind );
+	lengths_.push_back( length );
+	offsets_.push_back( offset );
+}
+
+
+/**
+ *	This method adds an argument to the text of a query, in the same form as
+ *	QueryRunner uses for queries that are not prepared.
+ *
+ *	@param stream	The stream to add the argument to.
+ *	@param conn		The connection, used to escape strings.
+ *	@param index	The index of the argument.
+ */
+void StatementArgs::addToStream( std::ostream & stream, MySql & conn,
+		int index ) const
+{
+	const MYSQL_BIND & bind = binds_[ index ];
+	const unsigned long length = lengths_[ index ];
+	const char * pData = (length > 0) ? &data_[ offsets_[ index ] ] : "";
+
+	switch (bind.buffer_type)
+	{
+	case MYSQL_TYPE_LONGLONG:
+		if (bind.is_unsigned)
+		{
+			uint64 value;
+			memcpy( &value, pData, sizeof( value ) );
+			StringConv::addToStream( stream, value );
+		}
+		else
+		{
+			int64 value;
+			memcpy( &value, pData, sizeof( value ) );
+			StringConv::addToStream( stream, value );
+		}
+		break;
+
+	case MYSQL_TYPE_FLOAT:
+	{
+		float value;
+		memcpy( &value, pData, sizeof( value ) );
+		StringConv::addToStream( stream, value );
+		break;
+	}
+
+	case MYSQL_TYPE_DOUBLE:
+	{
+		double value;
+		memcpy( &value, pData, sizeof( value ) );
+		StringConv::addToStream( stream, value );
+		break;
+	}
+
+	case MYSQL_TYPE_STRING:
+	{
+		std::vector< char > buffer( 1 + 2*length );
+		mysql_real_escape_string( conn.get(), &buffer[0], pData, length );
+		stream << '\'' << &buffer[0] << '\'';
+		break;
+	}
+
+	default:
+		stream << "NULL";
+		break;
+	}
+}
+
+
+/**
+ *	This method returns the bindings of the arguments, to be passed to
+ *	mysql_stmt_bind_param(). They are only valid until the next argument is
+ *	added.
+ */
+MYSQL_BIND * StatementArgs::binds()
+{
+	if (binds_.empty())
+	{
+		return NULL;
+	}
+
+	// The data may have moved as arguments were added, so the buffers are only
+	// pointed at it now.
+	for (size_t i = 0; i < binds_.size(); ++i)
+	{
+		binds_[i].buffer = data_.empty() ? NULL : &data_[ offsets_[i] ];
+		binds_[i].length = &lengths_[i];
+	}
+
+	return &binds_[0];
+}
+
+
+// -----------------------------------------------------------------------------
+// Section: PreparedStatement
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ *
+ *	@param stmt	The statement, with '?' characters for its arguments.
+ */
+PreparedStatement::PreparedStatement( const std::string & stmt ) :
+	stmt_( stmt ),
+	pStmt_( NULL ),
+	columns_(),
+	resultBinds_()
+{
+}
+
+
+/**
+ *	Destructor.
+ */
+PreparedStatement::~PreparedStatement()
+{
+	this->close();
+}
+
+
+/**
+ *	This method prepares this statement on the server.
+ *
+ *	@return	false if the server cannot prepare this kind of statement. It
+ *			should then be sent as text.
+ *
+ *	@note This method will raise a DatabaseException for other errors.
+ */
+bool PreparedStatement::prepare( MySql & conn )
+{
+	this->close();
+
+	pStmt_ = mysql_stmt_init( conn.get() );
+
+	if (pStmt_ == NULL)
+	{
+		this->throwError( conn );
+	}
+
+	if (mysql_stmt_prepare( pStmt_, stmt_.data(), stmt_.size() ) != 0)
+	{
+		if (mysql_stmt_errno( pStmt_ ) == ER_UNSUPPORTED_PS)
+		{
+			this->close();
+			return false;
+		}
+
+		this->throwError( conn );
+	}
+
+	MYSQL_RES * pMetaData = mysql_stmt_result_metadata( pStmt_ );
+
+	if (pMetaData != NULL)
+	{
+		const unsigned int numFields = mysql_num_fields( pMetaData );
+		const MYSQL_FIELD * pFields = mysql_fetch_fields( pMetaData );
+
+		columns_.resize( numFields );
+
+		for (unsigned int i = 0; i < numFields; ++i)
+		{
+			columns_[i].type = pFields[i].type;
+			columns_[i].isUnsigned = (pFields[i].flags & UNSIGNED_FLAG) != 0;
+		}
+
+		mysql_free_result( pMetaData );
+
+		this->bindResults();
+	}
+
+	return true;
+}
+
+
+/**
+ *	This method closes this statement on the server.
+ */
+void PreparedStatement::close()
+{
+	if (pStmt_ != NULL)
+	{
+		mysql_stmt_close( pStmt_ );
+		pStmt_ = NULL;
+	}
+
+	columns_.clear();
+	resultBinds_.clear();
+}
+
+
+/**
+ *	This method returns the number of arguments that this statement takes.
+ */
+int PreparedStatement::numParams() const
+{
+	return pStmt_ ? int( mysql_stmt_param_count( pStmt_ ) ) : 0;
+}
+
+
+/**
+ *	This method executes this statement.
+ *
+ *	@param conn		The connection that this statement was prepared on.
+ *	@param args		The arguments of the statement.
+ *	@param pResults If not NULL, the results from the statement are placed into
+ *		this object.
+ *
+ *	@return	false if the statement could not be prepared again after the
+ *			connection was re-established. The query should then be sent as
+ *			text.
+ *
+ *	@note This method will raise a DatabaseException if the statement fails.
+ */
+bool PreparedStatement::execute( MySql & conn, StatementArgs & args,
+		ResultSet * pResults )
+{
+	// The connection has been re-established since this was last used.
+	if ((pStmt_ == NULL) && !this->prepare( conn ))
+	{
+		return false;
+	}
+
+	bool isOkay = this->executeOnce( args );
+
+	if (!isOkay && (pStmt_ != NULL) && !conn.inTransaction())
+	{
+		const unsigned int errNum = mysql_stmt_errno( pStmt_ );
+
+		if ((errNum == CR_SERVER_LOST) || (errNum == CR_SERVER_GONE_ERROR))
+		{
+			INFO_MSG( "PreparedStatement::execute: "
+					"Connection lost. Attempting to reconnect.\n" );
+
+			if (conn.reconnect())
+			{
+				INFO_MSG( "PreparedStatement::execute: Reconnect succeeded.\n" );
+
+				if (!this->prepare( conn ))
+				{
+					return false;
+				}
+
+				isOkay = this->executeOnce( args );
+			}
+			else
+			{
+				WARNING_MSG( "PreparedStatement::execute: "
+						"Reconnect failed when executing %s.\n", stmt_.c_str() );
+			}
+		}
+	}
+
+	if (!isOkay)
+	{
+		ERROR_MSG( "PreparedStatement::execute: Query failed '%s'\n",
+				stmt_.c_str() );
+		this->throwError( conn );
+	}
+
+	if (!columns_.empty())
+	{
+		if (pResults != NULL)
+		{
+			this->fetchResults( conn, *pResults );
+		}
+
+		// This also discards any rows that were not fetched.
+		mysql_stmt_free_result( pStmt_ );
+	}
+
+	return true;
+}
+
+
+/**
+ *	This method binds the arguments and executes this statement once.
+ *
+ *	@return	true on success.
+ */
+bool PreparedStatement::executeOnce( StatementArgs & args )
+{
+	if (pStmt_ == NULL)
+	{
+		return false;
+	}
+
+	MF_ASSERT( args.size() == this->numParams() );
+
+	if ((args.size() > 0) &&
+			(mysql_stmt_bind_param( pStmt_, args.binds() ) != 0))
+	{
+		return false;
+	}
+
+	return mysql_stmt_execute( pStmt_ ) == 0;
+}
+
+
+/**
+ *	This method binds each result column to a buffer of the matching type.
+ *	Integer and real columns are received in binary. Everything else is
+ *	received as a string.
+ */
+void PreparedStatement::bindResults()
+{
+	MYSQL_BIND emptyBind;
+	memset( &emptyBind, 0, sizeof( emptyBind ) );
+
+	resultBinds_.assign( columns_.size(), emptyBind );
+
+	for (size_t i = 0; i < columns_.size(); ++i)
+	{
+		Column & column = columns_[i];
+		MYSQL_BIND & bind = resultBinds_[i];
+
+		switch (column.type)
+		{
+		case MYSQL_TYPE_TINY:
+		case MYSQL_TYPE_SHORT:
+		case MYSQL_TYPE_INT24:
+		case MYSQL_TYPE_LONG:
+		case MYSQL_TYPE_LONGLONG:
+		case MYSQL_TYPE_YEAR:
+			bind.buffer_type = MYSQL_TYPE_LONGLONG;
+			bind.buffer = &column.intValue;
+			bind.is_unsigned = column.isUnsigned;
+			break;
+
+		case MYSQL_TYPE_FLOAT:
+		case MYSQL_TYPE_DOUBLE:
+			bind.buffer_type = MYSQL_TYPE_DOUBLE;
+			bind.buffer = &column.realValue;
+			break;
+
+		default:
+			if (column.buffer.empty())
+			{
+				column.buffer.resize( INITIAL_COLUMN_BUFFER_SIZE );
+			}
+
+			bind.buffer_type = MYSQL_TYPE_STRING;
+			bind.buffer = &column.buffer[0];
+			bind.buffer_length = column.buffer.size();
+			break;
+		}
+
+		bind.length = &column.length;
+		bind.is_null = &column.isNull;
+		bind.error = &column.error;
+	}
+
+	if (!resultBinds_.empty())
+	{
+		mysql_stmt_bind_result( pStmt_, &resultBinds_[0] );
+	}
+}
+
+
+/**
+ *	This method fetches all of the rows of the last execution into a
+ *	ResultSet.
+ */
+void PreparedStatement::fetchResults( MySql & conn, ResultSet & results )
+{
+	results.beginFields( columns_.size() );
+
+	int status;
+
+	while (((status = mysql_stmt_fetch( pStmt_ )) == 0) ||
+			(status == MYSQL_DATA_TRUNCATED))
+	{
+		bool shouldRebind = false;
+
+		for (size_t i = 0; i < columns_.size(); ++i)
+		{
+			Column & column = columns_[i];
+			MYSQL_BIND & bind = resultBinds_[i];
+
+			if (column.isNull)
+			{
+				results.addField( ResultField() );
+			}
+			else if (bind.buffer_type == MYSQL_TYPE_LONGLONG)
+			{
+				results.addField( column.isUnsigned ?
+					ResultField::fromUint( uint64( column.intValue ) ) :
+					ResultField::fromInt( column.intValue ) );
+			}
+			else if (bind.buffer_type == MYSQL_TYPE_DOUBLE)
+			{
+				results.addField( ResultField::fromReal( column.realValue ) );
+			}
+			else
+			{
+				if (column.length > column.buffer.size())
+				{
+					// The value did not fit. Grow the buffer, which is kept
+					// for later rows, and fetch the whole value into it.
+					column.buffer.resize( column.length );
+					bind.buffer = &column.buffer[0];
+					bind.buffer_length = column.buffer.size();
+
+					mysql_stmt_fetch_column( pStmt_, &bind, i, 0 );
+					shouldRebind = true;
+				}
+
+				results.addField( ResultField::fromString(
+					&column.buffer[0], int( column.length ) ) );
+			}
+		}
+
+		if (shouldRebind)
+		{
+			mysql_stmt_bind_result( pStmt_, &resultBinds_[0] );
+		}
+	}
+
+	results.endFields();
+
+	if (status != MYSQL_NO_DATA)
+	{
+		ERROR_MSG( "PreparedStatement::fetchResults: Fetch failed for '%s'\n",
+				stmt_.c_str() );
+		this->throwError( conn );
+	}
+}
+
+
+/**
+ *	This method throws an exception based on the state of this statement, or
+ *	of the connection if the statement could not be created.
+ */
+void PreparedStatement::throwError( MySql & conn )
+{
+	DatabaseException e = (pStmt_ != NULL) ?
+		DatabaseException( pStmt_ ) : DatabaseException( conn.get() );
+
+	if (e.isLostConnection())
+	{
+		conn.hasLostConnection( true );
+	}
+
+	throw e;
+}
+
+// prepared_statement.cpp
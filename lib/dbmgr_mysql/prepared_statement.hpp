@@ -0,0 +1,148 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef MYSQL_PREPARED_STATEMENT_HPP
+#define MYSQL_PREPARED_STATEMENT_HPP
+
+#include "string_conv.hpp"
+
+#include "cstdmf/stdmf.hpp"
+
+#include <mysql/mysql.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+class MySql;
+class ResultSet;
+
+
+/**
+ *	This class holds the arguments of an execution of a PreparedStatement, in
+ *	binary form. Each argument is copied, so the caller's values do not need
+ *	to outlive the call that adds them.
+ */
+class StatementArgs
+{
+public:
+	StatementArgs();
+
+	void add( int8 value )		{ this->addInt( value ); }
+	void add( uint8 value )		{ this->addUint( value ); }
+	void add( int16 value )		{ this->addInt( value ); }
+	void add( uint16 value )	{ this->addUint( value ); }
+	void add( int32 value )		{ this->addInt( value ); }
+	void add( uint32 value )	{ this->addUint( value ); }
+	void add( int64 value )		{ this->addInt( value ); }
+	void add( uint64 value )	{ this->addUint( value ); }
+	void add( bool value )		{ this->addInt( value ? 1 : 0 ); }
+	void add( float value );
+	void add( double value );
+
+	void add( const std::string & value )
+	{
+		this->addString( value.data(), value.size() );
+	}
+
+	/**
+	 *	Other types are sent as their text form.
+	 */
+	template <class ARG>
+	void add( const ARG & value )
+	{
+		std::ostringstream stream;
+		StringConv::addToStream( stream, value );
+		this->add( stream.str() );
+	}
+
+	void addString( const char * str, int length );
+	void addNull();
+
+	int size() const		{ return int( binds_.size() ); }
+
+	void addToStream( std::ostream & stream, MySql & conn, int index ) const;
+
+	MYSQL_BIND * binds();
+
+private:
+	void addInt( int64 value );
+	void addUint( uint64 value );
+	void addBind( enum_field_types type, bool isUnsigned,
+			const void * pData, int length );
+
+	std::vector< MYSQL_BIND > binds_;
+	std::vector< unsigned long > lengths_;
+	std::vector< size_t > offsets_;
+	std::vector< char > data_;
+};
+
+
+/**
+ *	This class is a server-side prepared statement on a connection. Arguments
+ *	are sent and results are received in the binary protocol, so neither side
+ *	formats or parses values as text.
+ *
+ *	Prepared statements are created and cached by MySql::preparedStatement().
+ *	They are closed when the connection is and are prepared again the next
+ *	time they are executed. If that fails, QueryRunner sends the query as text.
+ */
+class PreparedStatement
+{
+public:
+	PreparedStatement( const std::string & stmt );
+	~PreparedStatement();
+
+	bool prepare( MySql & conn );
+	void close();
+
+	bool execute( MySql & conn, StatementArgs & args, ResultSet * pResults );
+
+	int numParams() const;
+
+	const std::string & stmt() const	{ return stmt_; }
+	bool isPrepared() const				{ return pStmt_ != NULL; }
+
+private:
+	PreparedStatement( const PreparedStatement & );
+	void operator=( const PreparedStatement & );
+
+	/**
+	 *	This structure holds the buffer of a result column.
+	 */
+	struct Column
+	{
+		Column() : intValue( 0 ), realValue( 0.0 ), length( 0 ), isNull( 0 ),
+			error( 0 ), type( MYSQL_TYPE_NULL ), isUnsigned( false ) {}
+
+		int64 intValue;
+		double realValue;
+		std::vector< char > buffer;
+		unsigned long length;
+		my_bool isNull;
+		my_bool error;
+		enum_field_types type;
+		bool isUnsigned;
+	};
+
+	bool executeOnce( StatementArgs & args );
+	void bindResults();
+	void fetchResults( MySql & conn, ResultSet & results );
+	void throwError( MySql & conn );
+
+	std::string stmt_;
+	MYSQL_STMT * pStmt_;
+
+	std::vector< Column > columns_;
+	std::vector< MYSQL_BIND > resultBinds_;
+};
+
+#endif // MYSQL_PREPARED_STATEMENT_HPP
@@ -23,7 +23,10 @@ DECLARE_DEBUG_COMPONENT( 0 );
 /**
  *	Constructor.
  */
-Query::Query( const std::string & stmt, bool shouldPartitionArgs )
+Query::Query( const std::string & stmt, bool shouldPartitionArgs ) :
+	queryParts_(),
+	stmt_(),
+	shouldPrepare_( false )
 {
 	if (!stmt.empty())
 	{
@@ -35,6 +38,9 @@ Query::Query( const std::string & stmt, bool shouldPartitionArgs )
 /**
  *	This method initialises this query from a query string. The query string
  *	should contain '?' characters to indicate the arguments of the query.
+ *
+ *	A query with arguments partitioned is run as a server-side prepared
+ *	statement. Otherwise, it is sent to the server as text, unchanged.
  */
 bool Query::init( const std::string & stmt, bool shouldPartitionArgs )
 {
@@ -43,6 +49,9 @@ bool Query::init( const std::string & stmt, bool shouldPartitionArgs )
 		return false;
 	}
 
+	stmt_ = stmt;
+	shouldPrepare_ = shouldPartitionArgs;
+
 	if (!shouldPartitionArgs)
 	{
 		queryParts_.push_back( stmt );
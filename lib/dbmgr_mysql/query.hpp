@@ -64,6 +64,9 @@ public:
 
 	int numArgs() const	{ return queryParts_.size() - 1; }
 
+	const std::string & stmt() const	{ return stmt_; }
+	bool shouldPrepare() const			{ return shouldPrepare_; }
+
 	std::string getPart( int index ) const
 	{
 		return size_t(index) < queryParts_.size() ? queryParts_[ index ] : "";
@@ -74,6 +77,9 @@ private:
 	void operator=( const Query& );
 
 	std::vector< std::string > queryParts_;
+
+	std::string stmt_;
+	bool shouldPrepare_;
 };
 
 
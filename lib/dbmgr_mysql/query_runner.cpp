@@ -27,11 +27,16 @@ DECLARE_DEBUG_COMPONENT( 0 );
  */
 QueryRunner::QueryRunner( MySql & conn, const Query & query ) :
 	query_( query ),
+	pStatement_( conn.preparedStatement( query ) ),
+	args_(),
 	stream_(),
 	numArgsAdded_( 0 ),
 	conn_( conn )
 {
-	stream_ << query.getPart( 0 );
+	if (pStatement_ == NULL)
+	{
+		stream_ << query.getPart( 0 );
+	}
 }
 
 
@@ -47,6 +52,18 @@ void QueryRunner::execute( ResultSet * pResults ) const
 {
 	MF_ASSERT( numArgsAdded_ == query_.numArgs() );
 
+	if (pStatement_ != NULL)
+	{
+		if (pStatement_->execute( conn_, args_, pResults ))
+		{
+			return;
+		}
+
+		// The statement could not be prepared on the new connection.
+		conn_.execute( this->textFromArgs(), pResults );
+		return;
+	}
+
 	std::string queryStr = stream_.str();
 	// DEBUG_MSG( "QueryRunner::execute: '%s'\n", queryStr.c_str() );
 
@@ -55,10 +72,36 @@ void QueryRunner::execute( ResultSet * pResults ) const
 
 
 /**
- *
+ *	This method returns the text of the query with the arguments that were
+ *	collected for its prepared statement.
+ */
+std::string QueryRunner::textFromArgs() const
+{
+	std::ostringstream stream;
+	stream << query_.getPart( 0 );
+
+	for (int i = 0; i < numArgsAdded_; ++i)
+	{
+		args_.addToStream( stream, conn_, i );
+		stream << query_.getPart( i + 1 );
+	}
+
+	return stream.str();
+}
+
+
+/**
+ *	This method adds a string argument.
  */
 void QueryRunner::pushArg( const char * arg, int length )
 {
+	if (pStatement_ != NULL)
+	{
+		args_.addString( arg, length );
+		++numArgsAdded_;
+		return;
+	}
+
 	if (length < 1024)
 	{
 		char buffer[ 2048 ];
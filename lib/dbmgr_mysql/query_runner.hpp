@@ -12,6 +12,8 @@ criminal penalties as provided by law.
 #ifndef MYSQL_QUERY_RUNNER_HPP
 #define MYSQL_QUERY_RUNNER_HPP
 
+#include "prepared_statement.hpp"
+
 #include <string.h>
 
 #include <sstream>
@@ -22,7 +24,9 @@ class ResultSet;
 
 
 /**
- *
+ *	This class collects the arguments of a query and runs it. If the query can
+ *	be prepared on the connection, the arguments are bound in binary form.
+ *	Otherwise, they are escaped into the text of the query.
  */
 class QueryRunner
 {
@@ -49,7 +53,11 @@ public:
 	MySql & connection() const		{ return conn_; }
 
 private:
+	std::string textFromArgs() const;
+
 	const Query & query_;
+	PreparedStatement * pStatement_;
+	mutable StatementArgs args_;
 	std::ostringstream stream_;
 	int numArgsAdded_;
 	MySql & conn_;
@@ -62,6 +70,13 @@ private:
 template <class ARG>
 void QueryRunner::pushArg( const ARG & arg )
 {
+	if (pStatement_ != NULL)
+	{
+		args_.add( arg );
+		++numArgsAdded_;
+		return;
+	}
+
 	StringConv::addToStream( stream_, arg );
 	stream_ << query_.getPart( ++numArgsAdded_ );
 }
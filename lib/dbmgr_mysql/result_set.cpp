@@ -13,9 +13,47 @@ criminal penalties as provided by law.
 
 #include "cstdmf/debug.hpp"
 
+#include <algorithm>
+#include <stdio.h>
+
 DECLARE_DEBUG_COMPONENT( 0 );
 
 
+// -----------------------------------------------------------------------------
+// Section: ResultField
+// -----------------------------------------------------------------------------
+
+/**
+ *	This method writes a numeric field as a string.
+ *
+ *	@return The length of the string.
+ */
+int ResultField::format( char * buffer, int size ) const
+{
+	int length = 0;
+
+	switch (type_)
+	{
+	case INT_FIELD:
+		length = bw_snprintf( buffer, size, "%"PRI64, value_.int_ );
+		break;
+
+	case UINT_FIELD:
+		length = bw_snprintf( buffer, size, "%"PRIu64, value_.uint_ );
+		break;
+
+	case REAL_FIELD:
+		length = bw_snprintf( buffer, size, "%.17g", value_.real_ );
+		break;
+
+	default:
+		break;
+	}
+
+	return std::max( 0, std::min( length, size - 1 ) );
+}
+
+
 // -----------------------------------------------------------------------------
 // Section: ResultSet
 // -----------------------------------------------------------------------------
@@ -23,7 +61,13 @@ DECLARE_DEBUG_COMPONENT( 0 );
 /**
  *
  */
-ResultSet::ResultSet() : pResultSet_( NULL )
+ResultSet::ResultSet() :
+	pResultSet_( NULL ),
+	fields_(),
+	data_(),
+	numFields_( 0 ),
+	nextField_( 0 ),
+	hasFields_( false )
 {
 }
 
@@ -33,7 +77,7 @@ ResultSet::ResultSet() : pResultSet_( NULL )
  */
 ResultSet::~ResultSet()
 {
-	this->setResults( NULL );
+	this->clear();
 }
 
 
@@ -42,21 +86,150 @@ ResultSet::~ResultSet()
  */
 int ResultSet::numRows() const
 {
-	return pResultSet_ ? mysql_num_rows( pResultSet_ ) : 0;
+	if (pResultSet_ != NULL)
+	{
+		return mysql_num_rows( pResultSet_ );
+	}
+
+	return (numFields_ > 0) ? int( fields_.size() / numFields_ ) : 0;
 }
 
 
 /**
- *
+ *	This method sets the results of a text query. Any previous results are
+ *	discarded.
  */
 void ResultSet::setResults( MYSQL_RES * pResultSet )
+{
+	this->clear();
+
+	pResultSet_ = pResultSet;
+}
+
+
+/**
+ *	This method discards the results.
+ */
+void ResultSet::clear()
 {
 	if (pResultSet_ != NULL)
 	{
 		mysql_free_result( pResultSet_ );
+		pResultSet_ = NULL;
 	}
 
-	pResultSet_ = pResultSet;
+	fields_.clear();
+	data_.clear();
+	numFields_ = 0;
+	nextField_ = 0;
+	hasFields_ = false;
+}
+
+
+/**
+ *	This method starts the results of a prepared statement. The fields of each
+ *	row are then added in order with addField(), followed by a call to
+ *	endFields().
+ */
+void ResultSet::beginFields( int numFields )
+{
+	this->clear();
+
+	numFields_ = numFields;
+	hasFields_ = true;
+}
+
+
+/**
+ *	This method adds the next field of the results of a prepared statement. The
+ *	data of a string field is copied.
+ */
+void ResultSet::addField( const ResultField & field )
+{
+	if (field.type() != ResultField::STRING_FIELD)
+	{
+		fields_.push_back( field );
+		return;
+	}
+
+	// The data may move as more is added, so only the offset is kept until
+	// endFields() is called.
+	ResultField stored( field );
+	stored.str_ = NULL;
+	stored.value_.uint_ = data_.size();
+
+	data_.insert( data_.end(), field.str(), field.str() + field.length() );
+	fields_.push_back( stored );
+}
+
+
+/**
+ *	This method finishes the results of a prepared statement.
+ */
+void ResultSet::endFields()
+{
+	static const char EMPTY_STRING[] = "";
+
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		ResultField & field = fields_[i];
+
+		if (field.type() == ResultField::STRING_FIELD)
+		{
+			field.str_ = data_.empty() ?
+				EMPTY_STRING : &data_[ size_t( field.value_.uint_ ) ];
+		}
+	}
+}
+
+
+/**
+ *	This method fetches the next row of results.
+ *
+ *	@param row			The row to set.
+ *	@param numFields	The number of fields that the row should have, or -1 if
+ *						any number is expected.
+ *
+ *	@return	true if there was a row with the expected number of fields.
+ */
+bool ResultSet::fetchRow( ResultRow & row, int numFields )
+{
+	if ((numFields != -1) && (this->numFields() != numFields))
+	{
+		ERROR_MSG( "ResultSet::fetchRow: Expected %d. Got %d\n",
+			numFields, this->numFields() );
+		return false;
+	}
+
+	if (pResultSet_ != NULL)
+	{
+		row.row_ = mysql_fetch_row( pResultSet_ );
+
+		if (!row.row_)
+		{
+			return false;
+		}
+
+		row.lengths_ = mysql_fetch_lengths( pResultSet_ );
+		row.pFields_ = NULL;
+		row.numFields_ = mysql_num_fields( pResultSet_ );
+
+		return true;
+	}
+
+	if ((numFields_ == 0) || (nextField_ >= fields_.size()))
+	{
+		return false;
+	}
+
+	row.row_ = NULL;
+	row.lengths_ = NULL;
+	row.pFields_ = &fields_[ nextField_ ];
+	row.numFields_ = numFields_;
+
+	nextField_ += numFields_;
+
+	return true;
 }
 
 // result_set.cpp
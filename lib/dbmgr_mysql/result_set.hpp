@@ -20,6 +20,7 @@ criminal penalties as provided by law.
 
 #include <mysql/mysql.h>
 #include <sstream>
+#include <vector>
 
 inline
 bool getValueFromString( const char * str, int len, std::string & value )
@@ -104,26 +105,190 @@ bool getValueFromString( const char * str, int len,
 }
 
 
-#define RESULT_SET_GET_RESULT( ARG_COUNT )									\
-		if (this->numFields() != ARG_COUNT)									\
-		{																	\
-			ERROR_MSG( "ResultSet::getResult: Expected %d. Got %d\n",		\
-				ARG_COUNT, this->numFields() );								\
-			return false;													\
-		}																	\
-																			\
-		MYSQL_ROW row = mysql_fetch_row( pResultSet_ );						\
-																			\
-		if (!row)															\
-		{																	\
-			return false;													\
-		}																	\
-																			\
-		unsigned long * lengths = mysql_fetch_lengths( pResultSet_ );		\
+/**
+ *	This class is a field of a result row of a prepared statement. Integer and
+ *	real columns are kept in their binary form. Other columns, such as strings,
+ *	blobs and timestamps, are kept as strings.
+ */
+class ResultField
+{
+public:
+	enum Type
+	{
+		NULL_FIELD,
+		INT_FIELD,
+		UINT_FIELD,
+		REAL_FIELD,
+		STRING_FIELD
+	};
+
+	ResultField() : type_( NULL_FIELD ), str_( NULL ), length_( 0 )
+	{
+		value_.int_ = 0;
+	}
+
+	static ResultField fromInt( int64 value )
+	{
+		ResultField field( INT_FIELD );
+		field.value_.int_ = value;
+		return field;
+	}
+
+	static ResultField fromUint( uint64 value )
+	{
+		ResultField field( UINT_FIELD );
+		field.value_.uint_ = value;
+		return field;
+	}
+
+	static ResultField fromReal( double value )
+	{
+		ResultField field( REAL_FIELD );
+		field.value_.real_ = value;
+		return field;
+	}
+
+	static ResultField fromString( const char * str, int length )
+	{
+		ResultField field( STRING_FIELD );
+		field.str_ = str;
+		field.length_ = length;
+		return field;
+	}
+
+	Type type() const				{ return type_; }
+	bool isNull() const				{ return type_ == NULL_FIELD; }
+
+	int64 intValue() const			{ return value_.int_; }
+	uint64 uintValue() const		{ return value_.uint_; }
+	double realValue() const		{ return value_.real_; }
+
+	const char * str() const		{ return str_; }
+	int length() const				{ return length_; }
+
+	int format( char * buffer, int size ) const;
+
+private:
+	explicit ResultField( Type type ) : type_( type ), str_( NULL ), length_( 0 )
+	{
+		value_.int_ = 0;
+	}
+
+	Type type_;
+
+	union
+	{
+		int64 int_;
+		uint64 uint_;
+		double real_;
+	} value_;
+
+	const char * str_;
+	int length_;
+
+	friend class ResultSet;
+};
 
 
 /**
- *
+ *	This function converts a result field to a number without going through a
+ *	string, where possible.
+ */
+template <class VALUE_TYPE>
+bool getNumberFromField( const ResultField & field, VALUE_TYPE & value )
+{
+	switch (field.type())
+	{
+	case ResultField::INT_FIELD:
+		value = VALUE_TYPE( field.intValue() );
+		return true;
+
+	case ResultField::UINT_FIELD:
+		value = VALUE_TYPE( field.uintValue() );
+		return true;
+
+	case ResultField::REAL_FIELD:
+		value = VALUE_TYPE( field.realValue() );
+		return true;
+
+	case ResultField::STRING_FIELD:
+		return getValueFromString( field.str(), field.length(), value );
+
+	default:
+		return false;
+	}
+}
+
+
+template <class VALUE_TYPE>
+bool getValueFromField( const ResultField & field, VALUE_TYPE & value )
+{
+	if (field.type() == ResultField::STRING_FIELD)
+	{
+		return getValueFromString( field.str(), field.length(), value );
+	}
+
+	if (field.isNull())
+	{
+		return getValueFromString( NULL, 0, value );
+	}
+
+	char buffer[ 32 ];
+	const int length = field.format( buffer, sizeof( buffer ) );
+
+	return getValueFromString( buffer, length, value );
+}
+
+
+#define RESULT_SET_NUMBER_FROM_FIELD( TYPE )								\
+inline bool getValueFromField( const ResultField & field, TYPE & value )	\
+{																			\
+	return getNumberFromField( field, value );								\
+}
+
+RESULT_SET_NUMBER_FROM_FIELD( int8 )
+RESULT_SET_NUMBER_FROM_FIELD( uint8 )
+RESULT_SET_NUMBER_FROM_FIELD( int16 )
+RESULT_SET_NUMBER_FROM_FIELD( uint16 )
+RESULT_SET_NUMBER_FROM_FIELD( int32 )
+RESULT_SET_NUMBER_FROM_FIELD( uint32 )
+RESULT_SET_NUMBER_FROM_FIELD( int64 )
+RESULT_SET_NUMBER_FROM_FIELD( uint64 )
+RESULT_SET_NUMBER_FROM_FIELD( float )
+RESULT_SET_NUMBER_FROM_FIELD( double )
+
+#undef RESULT_SET_NUMBER_FROM_FIELD
+
+
+template <class VALUE_TYPE>
+bool getValueFromField( const ResultField & field,
+		ValueOrNull< VALUE_TYPE > & value )
+{
+	if (field.isNull())
+	{
+		value.setNull();
+		return true;
+	}
+
+	VALUE_TYPE v;
+
+	if (getValueFromField( field, v ))
+	{
+		value.setValue( v );
+		return true;
+	}
+
+	return false;
+}
+
+
+class ResultRow;
+
+
+/**
+ *	This class holds the results of a query. The results of a text query are
+ *	kept in the MYSQL_RES from the server. The results of a prepared statement
+ *	are fetched into this object as ResultFields.
  */
 class ResultSet
 {
@@ -135,51 +300,43 @@ public:
 
 	void setResults( MYSQL_RES * pResultSet );
 
+	void beginFields( int numFields );
+	void addField( const ResultField & field );
+	void endFields();
+
+	bool fetchRow( ResultRow & row, int numFields = -1 );
+
 	template <class ARG0>
-	bool getResult( ARG0 & arg0 )
-	{
-		RESULT_SET_GET_RESULT( 1 );
-		return getValueFromString( row[0], lengths[0], arg0 );
-	}
+	bool getResult( ARG0 & arg0 );
 
 	template <class ARG0, class ARG1>
-	bool getResult( ARG0 & arg0, ARG1 & arg1 )
-	{
-		RESULT_SET_GET_RESULT( 2 );
-		return getValueFromString( row[0], lengths[0], arg0 ) &&
-			getValueFromString( row[1], lengths[1], arg1 );
-	}
+	bool getResult( ARG0 & arg0, ARG1 & arg1 );
 
 	template <class ARG0, class ARG1, class ARG2>
-	bool getResult( ARG0 & arg0, ARG1 & arg1, ARG2 & arg2 )
-	{
-		RESULT_SET_GET_RESULT( 3 );
-		return getValueFromString( row[0], lengths[0], arg0 ) &&
-			getValueFromString( row[1], lengths[1], arg1 ) &&
-			getValueFromString( row[2], lengths[2], arg2 );
-	}
+	bool getResult( ARG0 & arg0, ARG1 & arg1, ARG2 & arg2 );
+
 	template <class ARG0, class ARG1, class ARG2, class ARG3>
 	bool getResult( ARG0 & arg0, ARG1 & arg1,
-			ARG2 & arg2, ARG3 & arg3 )
-	{
-		RESULT_SET_GET_RESULT( 4 );
-		return getValueFromString( row[0], lengths[0], arg0 ) &&
-			getValueFromString( row[1], lengths[1], arg1 ) &&
-			getValueFromString( row[2], lengths[2], arg2 ) &&
-			getValueFromString( row[3], lengths[3], arg3 );
-	}
+			ARG2 & arg2, ARG3 & arg3 );
 
 	int numFields() const
 	{
-		return pResultSet_ ? mysql_num_fields( pResultSet_ ) : 0;
+		return pResultSet_ ? mysql_num_fields( pResultSet_ ) : numFields_;
 	}
 
-	bool hasResult() const	{ return pResultSet_ != NULL; }
+	bool hasResult() const	{ return (pResultSet_ != NULL) || hasFields_; }
 
 private:
+	void clear();
+
 	MYSQL_RES * pResultSet_;
 
-	friend class ResultRow;
+	// The results of a prepared statement.
+	std::vector< ResultField > fields_;
+	std::vector< char > data_;
+	int numFields_;
+	size_t nextField_;
+	bool hasFields_;
 };
 
 
@@ -192,24 +349,13 @@ public:
 	ResultRow() :
 		row_( NULL ),
 		lengths_( NULL ),
+		pFields_( NULL ),
 		numFields_( 0 )
 	{}
 
 	bool fetchNextFrom( ResultSet & resultSet )
 	{
-		MYSQL_RES * pResultSet = resultSet.pResultSet_;
-
-		row_ = mysql_fetch_row( pResultSet );
-
-		if (!row_)
-		{
-			return false;
-		}
-
-		lengths_ = mysql_fetch_lengths( pResultSet );
-		numFields_ = mysql_num_fields( pResultSet );
-
-		return true;
+		return resultSet.fetchRow( *this );
 	}
 
 	template <class TYPE>
@@ -223,6 +369,11 @@ public:
 			return false;
 		}
 
+		if (pFields_ != NULL)
+		{
+			return getValueFromField( pFields_[ fieldNum ], value );
+		}
+
 		return getValueFromString( row_[ fieldNum ], lengths_[ fieldNum ],
 				value );
 	}
@@ -232,10 +383,60 @@ public:
 private:
 	MYSQL_ROW row_;
 	unsigned long * lengths_;
+	const ResultField * pFields_;
 	int numFields_;
+
+	friend class ResultSet;
 };
 
 
+template <class ARG0>
+bool ResultSet::getResult( ARG0 & arg0 )
+{
+	ResultRow row;
+
+	return this->fetchRow( row, 1 ) &&
+		row.getField( 0, arg0 );
+}
+
+
+template <class ARG0, class ARG1>
+bool ResultSet::getResult( ARG0 & arg0, ARG1 & arg1 )
+{
+	ResultRow row;
+
+	return this->fetchRow( row, 2 ) &&
+		row.getField( 0, arg0 ) &&
+		row.getField( 1, arg1 );
+}
+
+
+template <class ARG0, class ARG1, class ARG2>
+bool ResultSet::getResult( ARG0 & arg0, ARG1 & arg1, ARG2 & arg2 )
+{
+	ResultRow row;
+
+	return this->fetchRow( row, 3 ) &&
+		row.getField( 0, arg0 ) &&
+		row.getField( 1, arg1 ) &&
+		row.getField( 2, arg2 );
+}
+
+
+template <class ARG0, class ARG1, class ARG2, class ARG3>
+bool ResultSet::getResult( ARG0 & arg0, ARG1 & arg1,
+		ARG2 & arg2, ARG3 & arg3 )
+{
+	ResultRow row;
+
+	return this->fetchRow( row, 4 ) &&
+		row.getField( 0, arg0 ) &&
+		row.getField( 1, arg1 ) &&
+		row.getField( 2, arg2 ) &&
+		row.getField( 3, arg3 );
+}
+
+
 /**
  *
  */
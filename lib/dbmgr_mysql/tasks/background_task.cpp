@@ -39,9 +39,20 @@ MySqlBackgroundTask::MySqlBackgroundTask( const char * taskName ) :
 void MySqlBackgroundTask::doBackgroundTask( BgTaskManager & mgr,
 		BackgroundTaskThread * pThread )
 {
-	MySqlThreadData & threadData =
-		*static_cast< MySqlThreadData * >( pThread->pData().get() );
+	this->performWithRetries(
+		*static_cast< MySqlThreadData * >( pThread->pData().get() ) );
 
+	mgr.addMainThreadTask( this );
+}
+
+
+/**
+ *	This method performs the task in its own transaction on the thread's
+ *	connection. The task is retried if the connection is lost or the
+ *	transaction should be retried, such as after a deadlock.
+ */
+void MySqlBackgroundTask::performWithRetries( MySqlThreadData & threadData )
+{
 	bool retry;
 
 	do
@@ -108,8 +119,18 @@ void MySqlBackgroundTask::doBackgroundTask( BgTaskManager & mgr,
 		}
 	}
 	while (retry);
+}
 
-	mgr.addMainThreadTask( this );
+
+/**
+ *	This method performs the task as part of a transaction that has been
+ *	started by the caller. Any DatabaseException is passed on to the caller,
+ *	which is responsible for rolling back and retrying.
+ */
+void MySqlBackgroundTask::performInTransaction( MySql & conn )
+{
+	succeeded_ = true;
+	this->performBackgroundTask( conn );
 }
 
 
@@ -17,6 +17,7 @@ criminal penalties as provided by law.
 class DatabaseException;
 class MySql;
 class MySqlDatabase;
+class MySqlThreadData;
 
 class MySqlBackgroundTask : public BackgroundTask
 {
@@ -29,7 +30,12 @@ public:
 
 	void doMainThreadTask( BgTaskManager & mgr );
 
+	void performWithRetries( MySqlThreadData & threadData );
+	void performInTransaction( MySql & conn );
+	void prepareToRetry()	{ this->onRetry(); }
+
 	void setFailure()		{ succeeded_ = false; }
+	bool succeeded() const	{ return succeeded_; }
 
 	const char * taskName() const	{ return taskName_; }
 
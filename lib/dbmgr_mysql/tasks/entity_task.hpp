@@ -39,6 +39,12 @@ public:
 
 	EntityKey entityKey() const;
 
+	/**
+	 *	This method returns whether this task may be committed in the same
+	 *	transaction as tasks for other entities.
+	 */
+	virtual bool canGroupCommit() const	{ return false; }
+
 	void pBufferedEntityTasks( BufferedEntityTasks * pBufferedEntityTasks )
 	{
 		pBufferedEntityTasks_ = pBufferedEntityTasks;
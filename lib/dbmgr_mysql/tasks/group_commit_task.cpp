@@ -0,0 +1,122 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "group_commit_task.hpp"
+
+#include "entity_task.hpp"
+
+#include "dbmgr_mysql/group_committer.hpp"
+#include "dbmgr_mysql/thread_data.hpp"
+
+#include "cstdmf/debug.hpp"
+#include "cstdmf/timestamp.hpp"
+
+DECLARE_DEBUG_COMPONENT( 0 );
+
+
+/**
+ *	Constructor.
+ *
+ *	@param committer	The object to inform when the batch has completed.
+ *	@param tasks		The tasks to perform. These are taken from the vector,
+ *						leaving it empty.
+ */
+GroupCommitTask::GroupCommitTask( GroupCommitter & committer, Tasks & tasks ) :
+	MySqlBackgroundTask( "GroupCommitTask" ),
+	committer_( committer ),
+	tasks_(),
+	commitTime_( 0 ),
+	wasSplit_( false )
+{
+	tasks_.swap( tasks );
+}
+
+
+/**
+ *	This method is called in a background thread to perform the batch.
+ */
+void GroupCommitTask::doBackgroundTask( BgTaskManager & mgr,
+		BackgroundTaskThread * pThread )
+{
+	MySqlThreadData & threadData =
+		*static_cast< MySqlThreadData * >( pThread->pData().get() );
+
+	uint64 startTime = timestamp();
+
+	this->performWithRetries( threadData );
+
+	if (!succeeded_)
+	{
+		WARNING_MSG( "GroupCommitTask::doBackgroundTask: "
+				"Batch of %"PRIzu" writes failed. "
+				"Performing each in its own transaction.\n",
+			tasks_.size() );
+
+		wasSplit_ = true;
+
+		for (Tasks::iterator iter = tasks_.begin();
+				iter != tasks_.end(); ++iter)
+		{
+			(*iter)->prepareToRetry();
+			(*iter)->performWithRetries( threadData );
+		}
+	}
+
+	commitTime_ = timestamp() - startTime;
+
+	mgr.addMainThreadTask( this );
+}
+
+
+/**
+ *	This method performs all tasks in the batch. It is called within the
+ *	transaction started by MySqlBackgroundTask::performWithRetries().
+ */
+void GroupCommitTask::performBackgroundTask( MySql & conn )
+{
+	for (Tasks::iterator iter = tasks_.begin(); iter != tasks_.end(); ++iter)
+	{
+		(*iter)->performInTransaction( conn );
+	}
+}
+
+
+/**
+ *	This method is called if the batch's transaction was rolled back and
+ *	should be performed again.
+ */
+void GroupCommitTask::onRetry()
+{
+	for (Tasks::iterator iter = tasks_.begin(); iter != tasks_.end(); ++iter)
+	{
+		(*iter)->prepareToRetry();
+	}
+}
+
+
+/**
+ *	This method is called in the main thread to complete each task in the
+ *	batch.
+ */
+void GroupCommitTask::doMainThreadTask( BgTaskManager & mgr )
+{
+	this->MySqlBackgroundTask::doMainThreadTask( mgr );
+
+	committer_.onBatchCommitted( int( tasks_.size() ), commitTime_,
+			wasSplit_ );
+
+	for (Tasks::iterator iter = tasks_.begin(); iter != tasks_.end(); ++iter)
+	{
+		(*iter)->doMainThreadTask( mgr );
+	}
+}
+
+// group_commit_task.cpp
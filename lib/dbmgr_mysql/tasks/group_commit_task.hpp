@@ -0,0 +1,55 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef GROUP_COMMIT_TASK_HPP
+#define GROUP_COMMIT_TASK_HPP
+
+#include "background_task.hpp"
+
+#include "cstdmf/smartpointer.hpp"
+
+#include <vector>
+
+class EntityTask;
+class GroupCommitter;
+
+
+/**
+ *	This class performs a batch of entity tasks in a single transaction. If
+ *	the transaction fails, each task is performed again in its own
+ *	transaction so that one bad write does not fail the others.
+ */
+class GroupCommitTask : public MySqlBackgroundTask
+{
+public:
+	typedef std::vector< SmartPointer< EntityTask > > Tasks;
+
+	GroupCommitTask( GroupCommitter & committer, Tasks & tasks );
+
+	virtual void doBackgroundTask( BgTaskManager & mgr,
+			BackgroundTaskThread * pThread );
+	virtual void doMainThreadTask( BgTaskManager & mgr );
+
+protected:
+	virtual void performBackgroundTask( MySql & conn );
+	virtual void performMainThreadTask( bool succeeded ) {}
+
+	virtual void onRetry();
+
+private:
+	GroupCommitter & committer_;
+	Tasks tasks_;
+
+	uint64 commitTime_;
+	bool wasSplit_;
+};
+
+#endif // GROUP_COMMIT_TASK_HPP
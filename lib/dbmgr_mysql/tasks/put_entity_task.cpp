@@ -14,6 +14,8 @@ criminal penalties as provided by law.
 #include "../buffered_entity_tasks.hpp"
 #include "dbmgr_mysql/mappings/entity_type_mapping.hpp"
 
+#include <algorithm>
+
 
 // -----------------------------------------------------------------------------
 // Section: PutEntityTask
@@ -38,7 +40,11 @@ PutEntityTask::PutEntityTask( const EntityTypeMapping * pEntityTypeMapping,
 	writeEntityData_( false ),
 	writeBaseMailbox_( false ),
 	removeBaseMailbox_( removeBaseMailbox ),
+	insertedNewEntity_( false ),
 	updateAutoLoad_( updateAutoLoad ),
+	// Sized to hold the entity data without growing.
+	stream_( (pStream != NULL) ?
+		std::max( pStream->remainingLength(), 64 ) : 64 ),
 	handler_( handler ),
 	pGameTime_( pGameTime )
 {
@@ -84,6 +90,7 @@ void PutEntityTask::performBackgroundTask( MySql & conn )
 			MF_ASSERT( pGameTime_ == NULL );
 
 			dbID_ = entityTypeMapping_.insertNew( conn, stream_ );
+			insertedNewEntity_ = true;
 			if (dbID_ == 0)
 			{
 				ERROR_MSG( "PutEntityTask::performBackgroundTask: "
@@ -119,6 +126,24 @@ void PutEntityTask::performBackgroundTask( MySql & conn )
 }
 
 
+/**
+ *	This method is called if the transaction writing the entity was rolled
+ *	back and the task should be performed again.
+ */
+void PutEntityTask::onRetry()
+{
+	stream_.rewind();
+	stream_.error( false );
+
+	// A new entity's insert was rolled back with the transaction.
+	if (insertedNewEntity_)
+	{
+		dbID_ = 0;
+		insertedNewEntity_ = false;
+	}
+}
+
+
 /**
  *
  */
@@ -42,10 +42,16 @@ public:
 	virtual void performBackgroundTask( MySql & conn );
 	virtual void performEntityMainThreadTask( bool succeeded );
 
+	virtual bool canGroupCommit() const	{ return true; }
+
+protected:
+	virtual void onRetry();
+
 private:
 	bool							writeEntityData_;
 	bool							writeBaseMailbox_;
 	bool							removeBaseMailbox_;
+	bool							insertedNewEntity_;
 	UpdateAutoLoad 					updateAutoLoad_;
 
 	MemoryOStream					stream_;
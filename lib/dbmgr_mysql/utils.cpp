@@ -32,6 +32,32 @@ std::string buildCommaSeparatedQuestionMarks( int num )
 }
 
 
+/**
+ *	This function builds the VALUES list of a multi-row INSERT, for example
+ *	"(?,?),(?,?)" for two rows of two columns.
+ */
+std::string buildMultiRowQuestionMarks( int numColumns, int numRows )
+{
+	const std::string row = "(" +
+		buildCommaSeparatedQuestionMarks( numColumns ) + ")";
+
+	std::string list;
+	list.reserve( (row.size() + 1) * numRows );
+
+	for (int i = 0; i < numRows; ++i)
+	{
+		if (i > 0)
+		{
+			list += ',';
+		}
+
+		list += row;
+	}
+
+	return list;
+}
+
+
 /**
  * 	Stores the default value of a sequence mapping into the stream.
  */
@@ -16,6 +16,7 @@ criminal penalties as provided by law.
 class BinaryOStream;
 
 std::string buildCommaSeparatedQuestionMarks( int num );
+std::string buildMultiRowQuestionMarks( int numColumns, int numRows );
 
 void defaultSequenceToStream( BinaryOStream & strm, int seqSize,
 		PropertyMappingPtr pChildMapping_ );
@@ -13,6 +13,8 @@ criminal penalties as provided by law.
 
 #include "connection_info.hpp"
 #include "database_exception.hpp"
+#include "prepared_statement.hpp"
+#include "query.hpp"
 #include "result_set.hpp"
 #include "string_conv.hpp"
 
@@ -51,6 +53,12 @@ time_t convertMySqlTimeToEpoch(  const MYSQL_TIME& mysqlTime )
 	return timegm( &ctime );
 }
 
+/**
+ *	The maximum number of statements prepared on each connection. The server
+ *	limits the number across all connections with max_prepared_stmt_count.
+ */
+const size_t MAX_PREPARED_STATEMENTS = 1024;
+
 } // namespace (anonymous)
 
 
@@ -58,6 +66,7 @@ time_t convertMySqlTimeToEpoch(  const MYSQL_TIME& mysqlTime )
 // Section: class MySql
 // -----------------------------------------------------------------------------
 
+bool MySql::s_usePreparedStatements_ = false;
 bool MySql::s_hasInitedCollationLengths_ = false;
 MySql::CollationLengths MySql::s_collationLengths_;
 
@@ -72,7 +81,8 @@ MySql::MySql( const DBConfig::ConnectionInfo & connectInfo ) :
 	sql_( NULL ),
 	inTransaction_( false ),
 	hasLostConnection_( false ),
-	connectInfo_( connectInfo )
+	connectInfo_( connectInfo ),
+	preparedStatements_()
 {
 	this->connect( connectInfo );
 }
@@ -85,6 +95,12 @@ MySql::~MySql()
 {
 	MF_ASSERT( !inTransaction_ );
 	this->close();
+
+	for (PreparedStatements::iterator iter = preparedStatements_.begin();
+			iter != preparedStatements_.end(); ++iter)
+	{
+		delete iter->second;
+	}
 }
 
 
@@ -93,6 +109,16 @@ MySql::~MySql()
  */
 void MySql::close()
 {
+	// Statements are prepared again when they are next executed.
+	for (PreparedStatements::iterator iter = preparedStatements_.begin();
+			iter != preparedStatements_.end(); ++iter)
+	{
+		if (iter->second != NULL)
+		{
+			iter->second->close();
+		}
+	}
+
 	if (sql_)
 	{
 		mysql_close( sql_ );
@@ -444,6 +470,59 @@ int MySql::query( const std::string & statement )
 }
 
 
+/**
+ *	This method returns the prepared statement for a query on this connection,
+ *	preparing it the first time it is used.
+ *
+ *	@return	The statement, or NULL if the query should be sent as text.
+ */
+PreparedStatement * MySql::preparedStatement( const Query & query )
+{
+	if (!s_usePreparedStatements_ || !query.shouldPrepare())
+	{
+		return NULL;
+	}
+
+	PreparedStatements::iterator iter =
+		preparedStatements_.find( query.stmt() );
+
+	if (iter != preparedStatements_.end())
+	{
+		return iter->second;
+	}
+
+	if (preparedStatements_.size() >= MAX_PREPARED_STATEMENTS)
+	{
+		return NULL;
+	}
+
+	PreparedStatement * pStatement = new PreparedStatement( query.stmt() );
+
+	try
+	{
+		// A '?' in a string literal is counted as an argument by Query but
+		// not by the server, so such a statement is left as text.
+		if (!pStatement->prepare( *this ) ||
+				(pStatement->numParams() != query.numArgs()))
+		{
+			delete pStatement;
+			pStatement = NULL;
+		}
+	}
+	catch (DatabaseException & e)
+	{
+		// The error is reported when the query is run as text. It may not
+		// recur, so nothing is cached.
+		delete pStatement;
+		return NULL;
+	}
+
+	preparedStatements_[ query.stmt() ] = pStatement;
+
+	return pStatement;
+}
+
+
 /**
  * 	This function returns the list of table names that matches the specified
  * 	pattern.
@@ -16,6 +16,7 @@ criminal penalties as provided by law.
 
 #include "cstdmf/stdmf.hpp"
 #include "cstdmf/debug.hpp"
+#include "cstdmf/hash_map.hpp"
 
 #include <mysql/mysql.h>
 #include <mysql/mysqld_error.h>
@@ -27,6 +28,8 @@ criminal penalties as provided by law.
 // Forward declarations.
 class BinaryOStream;
 class BinaryIStream;
+class PreparedStatement;
+class Query;
 class ResultSet;
 
 namespace DBConfig
@@ -57,6 +60,8 @@ public:
 	void execute( const std::string & queryStr, ResultSet * pResultSet );
 	int query( const std::string & statement );
 
+	PreparedStatement * preparedStatement( const Query & query );
+
 	void close();
 	bool reconnectTo( const DBConfig::ConnectionInfo & connectInfo );
 	bool reconnect()
@@ -73,6 +78,7 @@ public:
 	const char* getLastError()	{ return mysql_error( sql_ ); }
 	unsigned int getLastErrorNum() { return mysql_errno( sql_ ); }
 
+	bool inTransaction() const			{ return inTransaction_; }
 	void inTransaction( bool value )
 	{
 		MF_ASSERT( inTransaction_ != value );
@@ -84,6 +90,12 @@ public:
 
 	static uint charsetWidth( unsigned int charsetnr );
 
+	static bool usePreparedStatements()	{ return s_usePreparedStatements_; }
+	static void usePreparedStatements( bool value )
+	{
+		s_usePreparedStatements_ = value;
+	}
+
 private:
 	int realQuery( const std::string & query );
 	void throwError( MYSQL * pConnection );
@@ -102,6 +114,12 @@ private:
 
 	DBConfig::ConnectionInfo connectInfo_;
 
+	// The prepared statements of this connection, by statement. A NULL entry
+	// is a statement that the server cannot prepare.
+	typedef HashMap< std::string, PreparedStatement * > PreparedStatements;
+	PreparedStatements preparedStatements_;
+
+	static bool s_usePreparedStatements_;
 	static bool s_hasInitedCollationLengths_;
 	static CollationLengths s_collationLengths_;
 };
@@ -0,0 +1,364 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "aes_gcm_filter.hpp"
+
+#ifdef HAS_AES_GCM_FILTER
+
+#include "packet_receiver.hpp"
+
+#include "cstdmf/profile.hpp"
+
+#include "openssl/rand.h"
+
+DECLARE_DEBUG_COMPONENT2( "Network", 0 )
+
+
+namespace Mercury
+{
+
+/**
+ *	Create a filter using the supplied key.
+ */
+AESGCMFilter::AESGCMFilter( const Key & key ) :
+	key_( key ),
+	isGood_( false ),
+	pEncryptContext_( NULL )
+{
+	this->initKey();
+}
+
+
+/**
+ *	Create a filter with a randomly generated key.
+ */
+AESGCMFilter::AESGCMFilter() :
+	key_( KEY_SIZE, 0 ),
+	isGood_( false ),
+	pEncryptContext_( NULL )
+{
+	char * keyBytes = const_cast< char * >( key_.c_str() );
+	RAND_bytes( (unsigned char*)keyBytes, key_.size() );
+
+	this->initKey();
+}
+
+
+/**
+ *	Destructor.
+ */
+AESGCMFilter::~AESGCMFilter()
+{
+	EVP_CIPHER_CTX_free( pEncryptContext_ );
+
+	for (DecryptContexts::iterator iter = spareDecryptContexts_.begin();
+			iter != spareDecryptContexts_.end(); ++iter)
+	{
+		EVP_CIPHER_CTX_free( *iter );
+	}
+}
+
+
+/**
+ *	This method initialises the cipher contexts from key_ and checks its
+ *	validity.
+ */
+bool AESGCMFilter::initKey()
+{
+	if (int( key_.size() ) != KEY_SIZE)
+	{
+		ERROR_MSG( "AESGCMFilter::initKey: "
+			"Tried to initialise filter with key of invalid length %d\n",
+			int( key_.size() ) );
+
+		return false;
+	}
+
+	RAND_bytes( nonce_, NONCE_SIZE );
+
+	pEncryptContext_ = EVP_CIPHER_CTX_new();
+
+	isGood_ = pEncryptContext_ &&
+		EVP_EncryptInit_ex( pEncryptContext_, EVP_aes_128_gcm(), NULL,
+			(const unsigned char *)key_.data(), NULL );
+
+	if (!isGood_)
+	{
+		ERROR_MSG( "AESGCMFilter::initKey: "
+			"Could not initialise AES-128-GCM cipher context\n" );
+	}
+
+	return isGood_;
+}
+
+
+/**
+ *	This method returns a decryption context initialised with the key. It must
+ *	be returned with releaseDecryptContext().
+ *
+ *	@return The context, or NULL if one could not be created.
+ */
+EVP_CIPHER_CTX * AESGCMFilter::acquireDecryptContext()
+{
+	{
+		SimpleMutexHolder smh( decryptContextsLock_ );
+
+		if (!spareDecryptContexts_.empty())
+		{
+			EVP_CIPHER_CTX * pContext = spareDecryptContexts_.back();
+			spareDecryptContexts_.pop_back();
+			return pContext;
+		}
+	}
+
+	EVP_CIPHER_CTX * pContext = EVP_CIPHER_CTX_new();
+
+	if (pContext &&
+		!EVP_DecryptInit_ex( pContext, EVP_aes_128_gcm(), NULL,
+			(const unsigned char *)key_.data(), NULL ))
+	{
+		EVP_CIPHER_CTX_free( pContext );
+		pContext = NULL;
+	}
+
+	return pContext;
+}
+
+
+/**
+ *	This method returns a context from acquireDecryptContext() to the pool.
+ */
+void AESGCMFilter::releaseDecryptContext( EVP_CIPHER_CTX * pContext )
+{
+	SimpleMutexHolder smh( decryptContextsLock_ );
+	spareDecryptContexts_.push_back( pContext );
+}
+
+
+/**
+ *	This method copies the nonce for the next packet into the given buffer and
+ *	advances it. Nonces must never be reused with the same key.
+ */
+void AESGCMFilter::nextNonce( unsigned char * pNonce )
+{
+	memcpy( pNonce, nonce_, NONCE_SIZE );
+
+	// Increment the last 64 bits as a big-endian counter.
+	for (int i = NONCE_SIZE - 1; i >= NONCE_SIZE - 8; --i)
+	{
+		if (++nonce_[i] != 0)
+		{
+			break;
+		}
+	}
+}
+
+
+/**
+ *	This method returns a new packet holding the encrypted contents of the
+ *	given packet, followed by its nonce and authentication tag. The given
+ *	packet is not modified.
+ *
+ *	@return The encrypted packet, or NULL if this filter is invalid.
+ */
+PacketPtr AESGCMFilter::encryptPacket( Packet * pPacket )
+{
+	if (!isGood_)
+	{
+		return NULL;
+	}
+
+	PacketPtr pEncrypted = new Packet();
+
+	int len = pPacket->totalSize();
+
+	MF_ASSERT( len + NONCE_SIZE + TAG_SIZE <= PACKET_MAX_SIZE );
+
+	unsigned char * pOut = (unsigned char *)pEncrypted->data();
+	unsigned char * pNonce = pOut + len;
+	unsigned char * pTag = pNonce + NONCE_SIZE;
+
+	this->nextNonce( pNonce );
+
+	int outLen = 0;
+	int finalLen = 0;
+
+	if (!EVP_EncryptInit_ex( pEncryptContext_, NULL, NULL, NULL, pNonce ) ||
+		!EVP_EncryptUpdate( pEncryptContext_, pOut, &outLen,
+			(const unsigned char *)pPacket->data(), len ) ||
+		!EVP_EncryptFinal_ex( pEncryptContext_, pOut + outLen, &finalLen ) ||
+		!EVP_CIPHER_CTX_ctrl( pEncryptContext_, EVP_CTRL_GCM_GET_TAG,
+			TAG_SIZE, pTag ))
+	{
+		ERROR_MSG( "AESGCMFilter::encryptPacket: Encryption failed\n" );
+		return NULL;
+	}
+
+	pEncrypted->msgEndOffset( len + NONCE_SIZE + TAG_SIZE );
+
+	return pEncrypted;
+}
+
+
+/**
+ *	This method encrypts the packet and sends it to the provided address.
+ */
+Reason AESGCMFilter::send( NetworkInterface & networkInterface,
+		const Address & addr, Packet * pPacket )
+{
+	PacketPtr pEncrypted;
+
+	{
+		AUTO_SCOPED_PROFILE( "encryptSend" )
+
+		pEncrypted = this->encryptPacket( pPacket );
+	}
+
+	if (!pEncrypted)
+	{
+		WARNING_MSG( "AESGCMFilter::send: "
+			"Dropping packet to %s due to invalid filter\n",
+			addr.c_str() );
+
+		return REASON_GENERAL_NETWORK;
+	}
+
+	return this->PacketFilter::send( networkInterface, addr,
+		pEncrypted.get() );
+}
+
+
+/**
+ *	This method processes an incoming encrypted packet.
+ */
+Reason AESGCMFilter::recv( PacketReceiver & receiver, const Address & addr,
+		Packet * pPacket, ProcessSocketStatsHelper * pStatsHelper )
+{
+	{
+		AUTO_SCOPED_PROFILE( "encryptRecv" )
+
+		Reason reason = this->decryptPacket( addr, pPacket );
+
+		if (reason == REASON_CORRUPTED_PACKET)
+		{
+			receiver.stats().incCorruptedPackets();
+		}
+
+		if (reason != REASON_SUCCESS)
+		{
+			return reason;
+		}
+	}
+
+	return this->PacketFilter::recv( receiver, addr, pPacket, pStatsHelper );
+}
+
+
+/**
+ *	This method decrypts an incoming packet on a receive thread. This is safe
+ *	because the key is not changed after construction and each call uses its
+ *	own decryption context.
+ */
+Reason AESGCMFilter::preprocessRecv( const Address & addr, Packet * pPacket )
+{
+	return this->decryptPacket( addr, pPacket );
+}
+
+
+/**
+ *	This method authenticates and decrypts an incoming packet in place. It
+ *	does not touch any state other than the packet and the context pool.
+ */
+Reason AESGCMFilter::decryptPacket( const Address & addr, Packet * pPacket )
+{
+	if (!isGood_)
+	{
+		WARNING_MSG( "AESGCMFilter::recv: "
+			"Dropping packet from %s due to invalid filter\n",
+			addr.c_str() );
+
+		return REASON_GENERAL_NETWORK;
+	}
+
+	int len = pPacket->totalSize() - NONCE_SIZE - TAG_SIZE;
+
+	if (len <= 0)
+	{
+		WARNING_MSG( "AESGCMFilter::recv: "
+			"Dropping packet from %s that is too short (%d bytes)\n",
+			addr.c_str(), pPacket->totalSize() );
+
+		return REASON_CORRUPTED_PACKET;
+	}
+
+	EVP_CIPHER_CTX * pContext = this->acquireDecryptContext();
+
+	if (!pContext)
+	{
+		ERROR_MSG( "AESGCMFilter::recv: "
+			"Could not initialise AES-128-GCM cipher context\n" );
+
+		return REASON_GENERAL_NETWORK;
+	}
+
+	unsigned char * pData = (unsigned char *)pPacket->data();
+	unsigned char * pNonce = pData + len;
+	unsigned char * pTag = pNonce + NONCE_SIZE;
+
+	int outLen = 0;
+	int finalLen = 0;
+
+	// GCM is a stream mode, so the data can be decrypted in place.
+	bool isAuthentic =
+		EVP_DecryptInit_ex( pContext, NULL, NULL, NULL, pNonce ) &&
+		EVP_DecryptUpdate( pContext, pData, &outLen, pData, len ) &&
+		EVP_CIPHER_CTX_ctrl( pContext, EVP_CTRL_GCM_SET_TAG,
+			TAG_SIZE, pTag ) &&
+		(EVP_DecryptFinal_ex( pContext, pData + outLen, &finalLen ) > 0);
+
+	this->releaseDecryptContext( pContext );
+
+	if (!isAuthentic)
+	{
+		WARNING_MSG( "AESGCMFilter::recv: "
+			"Dropping packet from %s that failed authentication\n",
+			addr.c_str() );
+
+		return REASON_CORRUPTED_PACKET;
+	}
+
+	pPacket->shrink( NONCE_SIZE + TAG_SIZE );
+
+	return REASON_SUCCESS;
+}
+
+
+/**
+ *	This method returns the number of extra bytes that might be required when
+ *	sending through this filter.
+ */
+int AESGCMFilter::maxSpareSize()
+{
+	// This is the same allowance as EncryptionFilter makes for networks that
+	// cannot handle "full-sized" UDP packets.
+	const int MTU_ALLOWANCE = 200;
+
+	return NONCE_SIZE + TAG_SIZE + MTU_ALLOWANCE;
+}
+
+} // namespace Mercury
+
+#endif // HAS_AES_GCM_FILTER
+
+// aes_gcm_filter.cpp
@@ -0,0 +1,114 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#ifndef AES_GCM_FILTER_HPP
+#define AES_GCM_FILTER_HPP
+
+#include "packet.hpp"
+#include "packet_filter.hpp"
+#include "network/basictypes.hpp"
+
+#include "openssl/opensslv.h"
+
+// AES-GCM is only available through the EVP interface from OpenSSL 1.0.1.
+#if OPENSSL_VERSION_NUMBER >= 0x10001000L
+#define HAS_AES_GCM_FILTER
+#endif
+
+#ifdef HAS_AES_GCM_FILTER
+
+#include "cstdmf/concurrency.hpp"
+
+#include "openssl/evp.h"
+
+#include <string>
+#include <vector>
+
+
+namespace Mercury
+{
+
+class ProcessSocketStatsHelper;
+
+/**
+ *	A PacketFilter that uses AES-128 in Galois/Counter Mode from OpenSSL's EVP
+ *	interface. OpenSSL uses the AES-NI and carry-less multiply instructions
+ *	for this where the processor has them, which makes it considerably cheaper
+ *	than EncryptionFilter.
+ *
+ *	Each packet is encrypted with a unique nonce, which is sent after the
+ *	ciphertext and followed by the authentication tag. Packets that have been
+ *	modified fail authentication and are dropped.
+ */
+class AESGCMFilter : public PacketFilter
+{
+public:
+	static const int KEY_SIZE = 128 / NETWORK_BITS_PER_BYTE;
+	static const int NONCE_SIZE = 96 / NETWORK_BITS_PER_BYTE;
+	static const int TAG_SIZE = 128 / NETWORK_BITS_PER_BYTE;
+
+	typedef std::string Key;
+
+	AESGCMFilter( const Key & key );
+	AESGCMFilter();
+	~AESGCMFilter();
+
+	virtual Reason send( NetworkInterface & networkInterface,
+						const Address & addr, Packet * pPacket );
+	virtual Reason recv( PacketReceiver & receiver,
+						const Address & addr, Packet * pPacket,
+						ProcessSocketStatsHelper * pStatsHelper );
+
+	virtual int maxSpareSize();
+
+	virtual bool isThreadSafe() const { return true; }
+	virtual Reason preprocessRecv( const Address & addr, Packet * pPacket );
+
+	PacketPtr encryptPacket( Packet * pPacket );
+
+	const Key & key() const { return key_; }
+	bool isGood() const { return isGood_; }
+
+private:
+	bool initKey();
+	void nextNonce( unsigned char * pNonce );
+
+	EVP_CIPHER_CTX * acquireDecryptContext();
+	void releaseDecryptContext( EVP_CIPHER_CTX * pContext );
+
+	Reason decryptPacket( const Address & addr, Packet * pPacket );
+
+	Key key_;
+	bool isGood_;
+
+	// The nonce for the next packet sent. This starts at a random value and
+	// its last 64 bits are incremented for each packet.
+	unsigned char nonce_[ NONCE_SIZE ];
+
+	// The cipher contexts are initialised with the key once so that each
+	// packet only has to set its nonce. Packets are only sent from the main
+	// thread but may be received on several threads, so decryption contexts
+	// are kept in a pool.
+	EVP_CIPHER_CTX * pEncryptContext_;
+
+	typedef std::vector< EVP_CIPHER_CTX * > DecryptContexts;
+	DecryptContexts spareDecryptContexts_;
+	SimpleMutex decryptContextsLock_;
+};
+
+typedef SmartPointer< AESGCMFilter > AESGCMFilterPtr;
+
+} // namespace Mercury
+
+#endif // HAS_AES_GCM_FILTER
+
+#endif // AES_GCM_FILTER_HPP
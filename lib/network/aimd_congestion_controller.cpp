@@ -0,0 +1,65 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "pch.hpp"
+
+#include "aimd_congestion_controller.hpp"
+
+namespace Mercury
+{
+
+/**
+ *	Constructor.
+ */
+AIMDCongestionController::AIMDCongestionController( uint32 maxWindow ) :
+	CongestionController( maxWindow ),
+	slowStartThreshold_( this->maxWindow() )
+{
+}
+
+
+/*
+ *	Override from CongestionController.
+ */
+void AIMDCongestionController::doOnAck( uint64 now, uint64 roundTripTime )
+{
+	if (window_ < slowStartThreshold_)
+	{
+		this->window( window_ + 1.0 );
+	}
+	else
+	{
+		this->window( window_ + 1.0 / window_ );
+	}
+}
+
+
+/*
+ *	Override from CongestionController.
+ */
+void AIMDCongestionController::doOnLoss( uint64 now )
+{
+	slowStartThreshold_ = std::max( window_ / 2.0, double( MIN_WINDOW ) );
+	this->window( slowStartThreshold_ );
+}
+
+
+/*
+ *	Override from CongestionController.
+ */
+void AIMDCongestionController::doReset()
+{
+	slowStartThreshold_ = this->maxWindow();
+}
+
+} // namespace Mercury
+
+// aimd_congestion_controller.cpp
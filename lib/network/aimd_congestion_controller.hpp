@@ -0,0 +1,43 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef AIMD_CONGESTION_CONTROLLER_HPP
+#define AIMD_CONGESTION_CONTROLLER_HPP
+
+#include "congestion_controller.hpp"
+
+namespace Mercury
+{
+
+/**
+ *	This class is a loss-based congestion controller. Like TCP Reno, the window
+ *	grows by one packet per acknowledgement until the first loss (slow start),
+ *	then by one packet per round trip. Each loss halves the window.
+ */
+class AIMDCongestionController : public CongestionController
+{
+public:
+	AIMDCongestionController( uint32 maxWindow );
+
+	virtual const char * name() const	{ return "aimd"; }
+
+protected:
+	virtual void doOnAck( uint64 now, uint64 roundTripTime );
+	virtual void doOnLoss( uint64 now );
+	virtual void doReset();
+
+private:
+	double slowStartThreshold_;
+};
+
+} // namespace Mercury
+
+#endif // AIMD_CONGESTION_CONTROLLER_HPP
@@ -269,6 +269,7 @@ namespace Mercury
 	inline bool operator==(const Address & a, const Address & b);
 	inline bool operator!=(const Address & a, const Address & b);
 	inline bool operator<(const Address & a, const Address & b);
+	inline uint32 hashMapHash( const Address & address );
 
 	BinaryIStream& operator>>( BinaryIStream &in, Address &a );
 	BinaryOStream& operator<<( BinaryOStream &out, const Address &a );
@@ -64,6 +64,16 @@ inline bool Mercury::operator<(const Mercury::Address & a, const Mercury::Addres
 	return (a.ip < b.ip) || (a.ip == b.ip && (a.port < b.port));
 }
 
+/**
+ * 	This function returns the hash of an address. It is needed for using an
+ * 	address as a key in a HashMap. Like the operators above, it ignores the
+ * 	salt.
+ */
+inline uint32 Mercury::hashMapHash( const Mercury::Address & address )
+{
+	return address.ip * 2654435761U + address.port;
+}
+
 
 /**
  * This is the default constructor for Capabilities.
@@ -23,6 +23,7 @@ criminal penalties as provided by law.
 #include "interface_table.hpp"
 #include "network_interface.hpp"
 #include "nub_exception.hpp"
+#include "packet_chain_stream.hpp"
 #include "process_socket_stats_helper.hpp"
 
 #include "cstdmf/concurrency.hpp"
@@ -858,9 +859,12 @@ Reason Bundle::dispatchMessages( InterfaceTable & interfaceTable,
 			break;
 		}
 
-		// get the data out of it
-		const char * msgData = iter.data();
-		if (msgData == NULL)
+		// make a stream to belay it. This reads directly from the packets,
+		// even if the message spans several of them.
+		PacketChainIStream mis( iter.packet(), iter.dataOffset(),
+			header.length );
+
+		if (mis.error())
 		{
 			ERROR_MSG( "Bundle::dispatchMessages( %s ): "
 				"Discarding rest of bundle since chain too short for data of "
@@ -872,9 +876,6 @@ Reason Bundle::dispatchMessages( InterfaceTable & interfaceTable,
 			break;
 		}
 
-		// make a stream to belay it
-		MemoryIStream mis = MemoryIStream( msgData, header.length );
-
 		if (pStatsHelper)
 		{
 			pStatsHelper->startMessageHandling( header.length );
@@ -898,6 +899,9 @@ Reason Bundle::dispatchMessages( InterfaceTable & interfaceTable,
 		if (pStatsHelper)
 		{
 			pStatsHelper->stopMessageHandling();
+			pStatsHelper->onMessageRead(
+				mis.spansPackets() ? header.length : 0,
+				mis.numBytesCopied() );
 		}
 
 		// next! (note: can only call this after unpack)
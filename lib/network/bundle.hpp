@@ -187,6 +187,9 @@ public:
 		UnpackedMessageHeader & unpack( const InterfaceElement & ie );
 		const char * data();
 
+		Packet * packet() const		{ return cursor_; }
+		int dataOffset() const		{ return dataOffset_; }
+
 		void operator++(int);
 		bool operator==(const iterator & x) const;
 		bool operator!=(const iterator & x) const;
@@ -99,6 +99,7 @@ Channel::Channel( NetworkInterface & networkInterface,
 	creationVersion_( 0 ),
 	lastReceivedTime_( 0 ),
 	pFilter_( pFilter ),
+	pCongestionController_( NULL ),
 	addr_( Address::NONE ),
 	pBundle_( NULL ),
 	windowSize_(	(traits != INTERNAL)    ? EXTERNAL_CHANNEL_SIZE :
@@ -157,6 +158,12 @@ Channel::Channel( NetworkInterface & networkInterface,
 			id_ );
 	}
 
+	if (this->isExternal())
+	{
+		pCongestionController_ = CongestionController::create(
+			networkInterface.congestionControl(), windowSize_ );
+	}
+
 	// Initialise the bundle
 	this->clearBundle();
 
@@ -225,6 +232,21 @@ Channel * Channel::get( NetworkInterface & networkInterface,
 }
 
 
+/**
+ *	This method sets the packet filter used for sending and receiving on this
+ *	channel.
+ */
+void Channel::pFilter( PacketFilterPtr pFilter )
+{
+	pFilter_ = pFilter;
+
+	if (!this->isIndexed() && (addr_ != Address::NONE))
+	{
+		pNetworkInterface_->onChannelFilterChanged( *this );
+	}
+}
+
+
 /**
  *	This method sets the address of this channel. If necessary, it is registered
  *	with the interface.
@@ -361,6 +383,11 @@ void Channel::clearState( bool warnOnDiscard /*=false*/ )
 
 	acksToSend_.clear();
 
+	if (pCongestionController_)
+	{
+		pCongestionController_->reset();
+	}
+
 	// Increment the version, since we're not going to be talking to the same
 	// channel on the other side anymore.
 	if (this->isIndexed())
@@ -896,7 +923,8 @@ bool Channel::addResendTimer( SeqNum seq, Packet * p,
 	MF_ASSERT( (oldestUnackedSeq_ == SEQ_NULL) ||
 			unackedPackets_[ oldestUnackedSeq_ ] );
 
-	if (seqMask( largeOutSeqAt_ - oldestUnackedSeq_ ) >= windowSize_)
+	if (seqMask( largeOutSeqAt_ - oldestUnackedSeq_ ) >=
+			this->sendWindowSize())
 	{
 		// Make sure that we at least send occasionally.
 		UnackedPacket * pPrevUnackedPacket =
@@ -981,6 +1009,33 @@ bool Channel::handleCumulativeAck( SeqNum endSeq )
 }
 
 
+/**
+ *	This method handles a selective ACK footer. Bit i of the bitmap indicates
+ *	that the remote end has received packet endSeq + 1 + i, where endSeq is the
+ *	cumulative ACK that came with it. Acknowledging these raises highestAck_
+ *	so that checkResendTimers() only resends the packets in the gaps.
+ *
+ *  @return False on error, true otherwise.
+ */
+bool Channel::handleSelectiveAcks( SeqNum endSeq, Packet::AckBitmap bitmap )
+{
+	SeqNum seq = seqMask( endSeq + 1 );
+
+	while (bitmap != 0)
+	{
+		if ((bitmap & 1) && !this->handleAck( seq ))
+		{
+			return false;
+		}
+
+		bitmap >>= 1;
+		seq = seqMask( seq + 1 );
+	}
+
+	return true;
+}
+
+
 /**
  *	This method removes a packet from the collection of packets that have been
  *	sent but not acknowledged. It is called when an acknowledgement to a packet
@@ -1015,6 +1070,8 @@ bool Channel::handleAck( SeqNum seq )
 		return true;
 	}
 
+	const uint64 now = timestamp();
+
 	// Update the average RTT for this channel, if this packet hadn't already
 	// been resent.
 	if (!pUnackedPacket->wasResent_)
@@ -1022,7 +1079,15 @@ bool Channel::handleAck( SeqNum seq )
 		const uint64 RTT_AVERAGE_DENOM = 10;
 
 		roundTripTime_ = ((roundTripTime_ * (RTT_AVERAGE_DENOM - 1)) +
-			(timestamp() - pUnackedPacket->lastSentTime_)) / RTT_AVERAGE_DENOM;
+			(now - pUnackedPacket->lastSentTime_)) / RTT_AVERAGE_DENOM;
+	}
+
+	if (pCongestionController_)
+	{
+		pCongestionController_->onAck( now,
+			pUnackedPacket->wasResent_ ?
+				0 : now - pUnackedPacket->lastSentTime_,
+			pUnackedPacket->pPacket_->totalSize() );
 	}
 
 	// If this packet was the critical one, we're no longer in a critical state!
@@ -1060,7 +1125,8 @@ bool Channel::handleAck( SeqNum seq )
 	MF_ASSERT( oldestUnackedSeq_ == SEQ_NULL ||
 			unackedPackets_[ oldestUnackedSeq_ ] );
 
-	while (seqMask(smallOutSeqAt_ - oldestUnackedSeq_) < windowSize_ &&
+	while (seqMask(smallOutSeqAt_ - oldestUnackedSeq_) <
+				this->sendWindowSize() &&
 		   unackedPackets_[ smallOutSeqAt_ ])
 	{
 		this->sendUnacked( *unackedPackets_[ smallOutSeqAt_ ] );
@@ -1131,6 +1197,11 @@ void Channel::checkResendTimers()
 
 			if (shouldResend)
 			{
+				if (pCongestionController_)
+				{
+					pCongestionController_->onLoss( now );
+				}
+
 				this->resend( seq );
 				++numResends;
 			}
@@ -1574,6 +1645,34 @@ void Channel::writeFlags( Packet * p )
 		}
 	}
 
+	// If there are packets buffered after a gap, describe the ones just past
+	// the cumulative ACK with a bitmap instead of individual ACKs.
+	if (p->hasFlags( Packet::FLAG_HAS_CUMULATIVE_ACK ) &&
+		(numBufferedReceives_ > 0) &&
+		(p->freeSpace() >= int( sizeof( Packet::AckBitmap ) )))
+	{
+		p->enableFlags( Packet::FLAG_HAS_SELECTIVE_ACKS );
+		p->reserveFooter( sizeof( Packet::AckBitmap ) );
+
+		const SeqNum endSeq = seqMask( inSeqAt_ + Packet::ACKS_PER_BITMAP );
+		Acks::iterator iter = acksToSend_.begin();
+
+		while (iter != acksToSend_.end())
+		{
+			// Every packet in this range that has been received is still
+			// buffered, so it will be set in the bitmap.
+			if (Channel::seqLessThan( inSeqAt_, *iter ) &&
+				!Channel::seqLessThan( endSeq, *iter ))
+			{
+				acksToSend_.erase( iter++ );
+			}
+			else
+			{
+				++iter;
+			}
+		}
+	}
+
 	// Put on as many acks as we can.
 	if (!acksToSend_.empty() &&
 		p->freeSpace() >= int(sizeof( Packet::AckCount ) + sizeof( SeqNum )))
@@ -1614,6 +1713,11 @@ void Channel::writeFooter( Packet * p )
 		p->packFooter( inSeqAt_ );
 	}
 
+	if (p->hasFlags( Packet::FLAG_HAS_SELECTIVE_ACKS ))
+	{
+		p->packFooter( this->selectiveAckBitmap() );
+	}
+
 	if (p->hasFlags( Packet::FLAG_HAS_ACKS ))
 	{
 		// Note: Technically we should start at inSeqAt_ since sequence numbers
@@ -1631,6 +1735,31 @@ void Channel::writeFooter( Packet * p )
 }
 
 
+/**
+ *	This method returns the selective ACK bitmap for the packets that follow
+ *	inSeqAt_. Bit i is set if packet inSeqAt_ + 1 + i has been buffered.
+ */
+Packet::AckBitmap Channel::selectiveAckBitmap() const
+{
+	MF_ASSERT( bufferedReceives_.size() > uint( Packet::ACKS_PER_BITMAP ) );
+
+	Packet::AckBitmap bitmap = 0;
+
+	for (uint i = 0; i < uint( Packet::ACKS_PER_BITMAP ); ++i)
+	{
+		const SeqNum seq = seqMask( inSeqAt_ + 1 + i );
+		const Packet * pPacket = bufferedReceives_[ seq ].getObject();
+
+		if (pPacket && (pPacket->seq() == seq))
+		{
+			bitmap |= Packet::AckBitmap( 1 ) << i;
+		}
+	}
+
+	return bitmap;
+}
+
+
 /**
  *	This method handles the channel's timer events.
  */
@@ -1702,6 +1831,11 @@ void Channel::configureFrom( const Channel & other )
 	this->shouldAutoSwitchToSrcAddr( other.shouldAutoSwitchToSrcAddr() );
 	this->pushUnsentAcksThreshold( other.pushUnsentAcksThreshold() );
 
+	this->pCongestionController( other.pCongestionController_ ?
+		CongestionController::create(
+			other.pCongestionController_->name(), windowSize_ ) :
+		NULL );
+
 	// We don't support setting this fields post-construction, so for now, just
 	// make sure the channels match.
 	MF_ASSERT( traits_ == other.traits_ );
@@ -1902,6 +2036,8 @@ WatcherPtr Channel::pWatcher()
 
 		pWatcher->addChild( "roundTripTime",
 				makeWatcher( &Channel::roundTripTimeInSeconds ) );
+		pWatcher->addChild( "sendWindowSize",
+				makeWatcher( &Channel::sendWindowSize ) );
 	}
 
 	return pWatcher;
@@ -14,6 +14,7 @@ criminal penalties as provided by law.
 
 // #include "bundle.hpp"
 #include "circular_array.hpp"
+#include "congestion_controller.hpp"
 #include "fragmented_bundle.hpp"
 #include "irregular_channels.hpp"
 #include "keepalive_channels.hpp"
@@ -143,7 +144,14 @@ public:
 	int earliestUnackedPacketAge() const	{ return this->sendWindowUsage(); }
 
 	PacketFilterPtr pFilter() const { return pFilter_; }
-	void pFilter(PacketFilterPtr pFilter) { pFilter_ = pFilter; }
+	void pFilter( PacketFilterPtr pFilter );
+
+	CongestionControllerPtr pCongestionController() const
+		{ return pCongestionController_; }
+	void pCongestionController( CongestionControllerPtr pController )
+		{ pCongestionController_ = pController; }
+
+	uint32 sendWindowSize() const;
 
 	bool isLocalRegular() const			{ return isLocalRegular_; }
 	void isLocalRegular( bool isLocalRegular );
@@ -157,6 +165,7 @@ public:
 	bool addResendTimer( SeqNum seq, Packet * p,
 		const ReliableOrder * roBeg, const ReliableOrder * roEnd );
 	bool handleCumulativeAck( SeqNum seq );
+	bool handleSelectiveAcks( SeqNum endSeq, Packet::AckBitmap bitmap );
 	bool handleAck( SeqNum seq );
 	void checkResendTimers();
 	void resend( SeqNum seq );
@@ -408,6 +417,10 @@ private:
 	uint64		lastReceivedTime_;
 
 	PacketFilterPtr		pFilter_;
+
+	/// Limits the send window according to the state of the link, if set.
+	CongestionControllerPtr pCongestionController_;
+
 	Address				addr_;
 	Bundle *			pBundle_;
 
@@ -465,6 +478,8 @@ private:
 
 	void sendUnacked( UnackedPacket & unacked );
 
+	Packet::AckBitmap selectiveAckBitmap() const;
+
 	/// The next packet that we expect to receive.
 	SeqNum			inSeqAt_;
 
@@ -33,6 +33,19 @@ INLINE int Channel::windowSize() const
 }
 
 
+/**
+ *	This method returns the number of unacknowledged packets that this channel
+ *	may have outstanding. This is the window size unless a congestion
+ *	controller has reduced it.
+ */
+INLINE uint32 Channel::sendWindowSize() const
+{
+	return pCongestionController_ ?
+		std::min( windowSize_, pCongestionController_->window() ) :
+		windowSize_;
+}
+
+
 /**
  * 	This method returns the peer address of the channel.
  * 	The address is const, and may not be modified.
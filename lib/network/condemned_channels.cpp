@@ -153,14 +153,17 @@ bool CondemnedChannels::deleteFinishedChannels()
 		while (iter != indexedChannels_.end())
 		{
 			Channel * pChannel = iter->second;
-			IndexedChannels::iterator oldIter = iter;
-			++iter;
 
 			if (this->shouldDelete( pChannel, now ))
 			{
+				iter = indexedChannels_.erase( iter );
+
 				// delete pChannel;
 				pChannel->destroy();
-				indexedChannels_.erase( oldIter );
+			}
+			else
+			{
+				++iter;
 			}
 		}
 	}
@@ -15,8 +15,9 @@ criminal penalties as provided by law.
 #include "network/interfaces.hpp"
 #include "misc.hpp"
 
+#include "cstdmf/hash_map.hpp"
+
 #include <list>
-#include <map>
 
 namespace Mercury
 {
@@ -48,7 +49,7 @@ private:
 	bool shouldDelete( Channel * pChannel, uint64 now );
 
 	typedef std::list< Channel * > NonIndexedChannels;
-	typedef std::map< ChannelID, Channel * > IndexedChannels;
+	typedef HashMap< ChannelID, Channel * > IndexedChannels;
 
 	NonIndexedChannels	nonIndexedChannels_;
 	IndexedChannels		indexedChannels_;
@@ -0,0 +1,185 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "pch.hpp"
+
+#include "congestion_controller.hpp"
+
+#include "aimd_congestion_controller.hpp"
+#include "delay_congestion_controller.hpp"
+
+#include "cstdmf/debug.hpp"
+#include "cstdmf/timestamp.hpp"
+
+DECLARE_DEBUG_COMPONENT2( "Network", 0 )
+
+namespace Mercury
+{
+
+namespace
+{
+
+/// The weight given to each new round trip time sample.
+const uint64 RTT_AVERAGE_DENOM = 8;
+
+/// The weight given to each new packet size.
+const double PACKET_SIZE_AVERAGE_WEIGHT = 0.1;
+
+}
+
+// -----------------------------------------------------------------------------
+// Section: CongestionController
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ *
+ *	@param maxWindow	The largest window that the controller will allow. This
+ *						is normally the window size of the channel.
+ */
+CongestionController::CongestionController( uint32 maxWindow ) :
+	window_( 0.0 ),
+	maxWindow_( std::max( maxWindow, MIN_WINDOW ) ),
+	roundTripTime_( 0 ),
+	lastLossTime_( 0 ),
+	averagePacketSize_( 0.0 )
+{
+	this->window( INITIAL_WINDOW );
+}
+
+
+/**
+ *	This method is called by the channel when one of its packets has been
+ *	acknowledged.
+ *
+ *	@param now				The current time.
+ *	@param roundTripTime	The time between sending the packet and receiving
+ *							its acknowledgement, or 0 if the packet was resent.
+ *	@param packetSize		The size of the packet.
+ */
+void CongestionController::onAck( uint64 now, uint64 roundTripTime,
+		int packetSize )
+{
+	if (roundTripTime != 0)
+	{
+		roundTripTime_ = (roundTripTime_ == 0) ? roundTripTime :
+			((roundTripTime_ * (RTT_AVERAGE_DENOM - 1)) + roundTripTime) /
+				RTT_AVERAGE_DENOM;
+	}
+
+	averagePacketSize_ = (averagePacketSize_ == 0.0) ? packetSize :
+		averagePacketSize_ +
+			PACKET_SIZE_AVERAGE_WEIGHT * (packetSize - averagePacketSize_);
+
+	this->doOnAck( now, roundTripTime );
+}
+
+
+/**
+ *	This method is called by the channel when it resends a packet that it
+ *	believes has been lost.
+ */
+void CongestionController::onLoss( uint64 now )
+{
+	// Losses within a round trip of the last one are part of the same
+	// congestion event.
+	if ((lastLossTime_ != 0) && (now - lastLossTime_ < roundTripTime_))
+	{
+		return;
+	}
+
+	lastLossTime_ = now;
+	this->doOnLoss( now );
+}
+
+
+/**
+ *	This method returns the controller to its initial state. It is called when
+ *	the channel is reset.
+ */
+void CongestionController::reset()
+{
+	roundTripTime_ = 0;
+	lastLossTime_ = 0;
+	averagePacketSize_ = 0.0;
+	this->window( INITIAL_WINDOW );
+
+	this->doReset();
+}
+
+
+/**
+ *	This method returns an estimate of the bandwidth available to the channel.
+ *	This is one window of packets per round trip.
+ *
+ *	@return The estimated bandwidth in bytes per second, or 0 if no packets
+ *		have been acknowledged yet.
+ */
+double CongestionController::bytesPerSecond() const
+{
+	if (roundTripTime_ == 0)
+	{
+		return 0.0;
+	}
+
+	return window_ * averagePacketSize_ * stampsPerSecondD() / roundTripTime_;
+}
+
+
+/**
+ *	This method sets the window, limited to between MIN_WINDOW and the maximum
+ *	window.
+ */
+void CongestionController::window( double window )
+{
+	window_ = std::min( std::max( window, double( MIN_WINDOW ) ),
+			double( maxWindow_ ) );
+}
+
+
+/**
+ *	This static method creates a congestion controller by name.
+ *
+ *	@param name			"aimd" for AIMDCongestionController or "delay" for
+ *						DelayCongestionController. An empty string means no
+ *						congestion control.
+ *	@param maxWindow	The largest window that the controller will allow.
+ *
+ *	@return A new controller, or NULL if name is empty or unknown.
+ */
+CongestionController * CongestionController::create( const std::string & name,
+		uint32 maxWindow )
+{
+	if (name.empty())
+	{
+		return NULL;
+	}
+
+	if (name == "aimd")
+	{
+		return new AIMDCongestionController( maxWindow );
+	}
+
+	if (name == "delay")
+	{
+		return new DelayCongestionController( maxWindow );
+	}
+
+	ERROR_MSG( "CongestionController::create: "
+			"Unknown congestion control policy '%s'\n",
+		name.c_str() );
+
+	return NULL;
+}
+
+} // namespace Mercury
+
+// congestion_controller.cpp
@@ -0,0 +1,108 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef CONGESTION_CONTROLLER_HPP
+#define CONGESTION_CONTROLLER_HPP
+
+#include "cstdmf/smartpointer.hpp"
+#include "cstdmf/stdmf.hpp"
+
+#include <string>
+
+namespace Mercury
+{
+
+class CongestionController;
+typedef SmartPointer< CongestionController > CongestionControllerPtr;
+
+/**
+ *	This class is the interface for the policies that limit the send window of
+ *	a channel according to the state of the link. The channel reports each
+ *	acknowledged and each lost packet, and never has more packets outstanding
+ *	than window().
+ *
+ *	Times are in timestamp() units.
+ */
+class CongestionController : public SafeReferenceCount
+{
+public:
+	/// The smallest window that a controller will shrink to.
+	static const uint32 MIN_WINDOW = 2;
+
+	/// The window that a controller starts with.
+	static const uint32 INITIAL_WINDOW = 16;
+
+	CongestionController( uint32 maxWindow );
+	virtual ~CongestionController() {}
+
+	void onAck( uint64 now, uint64 roundTripTime, int packetSize );
+	void onLoss( uint64 now );
+	void reset();
+
+	/**
+	 *	This method returns the maximum number of unacknowledged packets that
+	 *	the channel should have outstanding.
+	 */
+	uint32 window() const	{ return uint32( window_ ); }
+
+	uint32 maxWindow() const	{ return maxWindow_; }
+
+	/**
+	 *	This method returns the smoothed round trip time of the acknowledged
+	 *	packets, or 0 if there have not been any.
+	 */
+	uint64 roundTripTime() const	{ return roundTripTime_; }
+
+	double bytesPerSecond() const;
+
+	virtual const char * name() const = 0;
+
+	static CongestionController * create( const std::string & name,
+		uint32 maxWindow );
+
+protected:
+	/**
+	 *	This method is called when a packet is acknowledged.
+	 *
+	 *	@param now				The current time.
+	 *	@param roundTripTime	The round trip time of the packet, or 0 if the
+	 *							packet was resent and so does not give a valid
+	 *							sample.
+	 */
+	virtual void doOnAck( uint64 now, uint64 roundTripTime ) = 0;
+
+	/**
+	 *	This method is called when a packet has been lost. It is only called
+	 *	once per round trip, since a single congestion event usually loses
+	 *	several packets.
+	 */
+	virtual void doOnLoss( uint64 now ) = 0;
+
+	/**
+	 *	This method is called to return the policy to its initial state.
+	 */
+	virtual void doReset() {}
+
+	void window( double window );
+
+	double window_;
+
+private:
+	uint32 maxWindow_;
+
+	uint64 roundTripTime_;
+	uint64 lastLossTime_;
+	double averagePacketSize_;
+};
+
+} // namespace Mercury
+
+#endif // CONGESTION_CONTROLLER_HPP
@@ -0,0 +1,188 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "pch.hpp"
+
+#include "delay_congestion_controller.hpp"
+
+#include "cstdmf/timestamp.hpp"
+
+namespace Mercury
+{
+
+namespace
+{
+
+/// The length of each base delay interval in seconds.
+const double BASE_DELAY_INTERVAL = 60.0;
+
+/// The number of packets that the window changes by per round trip when the
+/// queuing delay is zero.
+const double GAIN = 1.0;
+
+}
+
+const double DelayCongestionController::DEFAULT_TARGET_DELAY = 0.025;
+
+
+/**
+ *	Constructor.
+ *
+ *	@param maxWindow	The largest window that the controller will allow.
+ *	@param targetDelay	The queuing delay to aim for, in seconds.
+ */
+DelayCongestionController::DelayCongestionController( uint32 maxWindow,
+		double targetDelay ) :
+	CongestionController( maxWindow ),
+	targetDelay_( uint64( targetDelay * stampsPerSecondD() ) ),
+	queuingDelay_( 0 )
+{
+	this->doReset();
+}
+
+
+/**
+ *	This method returns the target queuing delay in seconds.
+ */
+double DelayCongestionController::targetDelay() const
+{
+	return targetDelay_ / stampsPerSecondD();
+}
+
+
+/*
+ *	Override from CongestionController.
+ */
+void DelayCongestionController::doOnAck( uint64 now, uint64 roundTripTime )
+{
+	// Resent packets do not give a usable delay.
+	if (roundTripTime == 0)
+	{
+		return;
+	}
+
+	this->addBaseDelay( now, roundTripTime );
+
+	queuingDelay_ = this->currentDelay( roundTripTime ) - this->baseDelay();
+
+	// Grow when the queue is shorter than the target and shrink when it is
+	// longer, in proportion to how far off the target it is.
+	const double offTarget =
+		(double( targetDelay_ ) - double( queuingDelay_ )) / targetDelay_;
+
+	this->window( window_ + GAIN * offTarget / window_ );
+}
+
+
+/*
+ *	Override from CongestionController.
+ */
+void DelayCongestionController::doOnLoss( uint64 now )
+{
+	this->window( window_ / 2.0 );
+}
+
+
+/*
+ *	Override from CongestionController.
+ */
+void DelayCongestionController::doReset()
+{
+	queuingDelay_ = 0;
+
+	for (int i = 0; i < NUM_BASE_DELAYS; ++i)
+	{
+		baseDelays_[ i ] = 0;
+	}
+
+	baseDelayIndex_ = 0;
+	baseDelayIntervalStart_ = 0;
+
+	for (int i = 0; i < NUM_CURRENT_DELAYS; ++i)
+	{
+		currentDelays_[ i ] = 0;
+	}
+
+	currentDelayIndex_ = 0;
+}
+
+
+/**
+ *	This method records a round trip time in the base delay history.
+ */
+void DelayCongestionController::addBaseDelay( uint64 now,
+		uint64 roundTripTime )
+{
+	if (baseDelayIntervalStart_ == 0)
+	{
+		baseDelays_[ baseDelayIndex_ ] = roundTripTime;
+		baseDelayIntervalStart_ = now;
+	}
+	else if (now - baseDelayIntervalStart_ >
+			uint64( BASE_DELAY_INTERVAL * stampsPerSecondD() ))
+	{
+		baseDelayIndex_ = (baseDelayIndex_ + 1) % NUM_BASE_DELAYS;
+		baseDelays_[ baseDelayIndex_ ] = roundTripTime;
+		baseDelayIntervalStart_ = now;
+	}
+	else
+	{
+		uint64 & rBaseDelay = baseDelays_[ baseDelayIndex_ ];
+		rBaseDelay = std::min( rBaseDelay, roundTripTime );
+	}
+}
+
+
+/**
+ *	This method returns the smallest round trip time in the base delay
+ *	history.
+ */
+uint64 DelayCongestionController::baseDelay() const
+{
+	uint64 baseDelay = baseDelays_[ baseDelayIndex_ ];
+
+	for (int i = 0; i < NUM_BASE_DELAYS; ++i)
+	{
+		if (baseDelays_[ i ] != 0)
+		{
+			baseDelay = std::min( baseDelay, baseDelays_[ i ] );
+		}
+	}
+
+	return baseDelay;
+}
+
+
+/**
+ *	This method adds a round trip time to the current delay filter and returns
+ *	the filtered delay.
+ */
+uint64 DelayCongestionController::currentDelay( uint64 roundTripTime )
+{
+	currentDelays_[ currentDelayIndex_ ] = roundTripTime;
+	currentDelayIndex_ = (currentDelayIndex_ + 1) % NUM_CURRENT_DELAYS;
+
+	uint64 currentDelay = roundTripTime;
+
+	for (int i = 0; i < NUM_CURRENT_DELAYS; ++i)
+	{
+		if (currentDelays_[ i ] != 0)
+		{
+			currentDelay = std::min( currentDelay, currentDelays_[ i ] );
+		}
+	}
+
+	return currentDelay;
+}
+
+} // namespace Mercury
+
+// delay_congestion_controller.cpp
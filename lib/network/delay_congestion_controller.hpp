@@ -0,0 +1,79 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef DELAY_CONGESTION_CONTROLLER_HPP
+#define DELAY_CONGESTION_CONTROLLER_HPP
+
+#include "congestion_controller.hpp"
+
+namespace Mercury
+{
+
+/**
+ *	This class is a delay-based congestion controller, similar to LEDBAT. It
+ *	estimates the queuing delay on the link as the round trip time less the
+ *	smallest round trip time seen recently, and grows or shrinks the window to
+ *	keep the queuing delay near a target. This keeps router buffers close to
+ *	empty rather than filling them until packets are dropped.
+ *
+ *	The remote end may delay its acknowledgements until its next send, so the
+ *	target should be larger than the remote's send interval on channels that
+ *	are remotely regular.
+ */
+class DelayCongestionController : public CongestionController
+{
+public:
+	/// The default target queuing delay in seconds.
+	static const double DEFAULT_TARGET_DELAY;
+
+	DelayCongestionController( uint32 maxWindow,
+		double targetDelay = DEFAULT_TARGET_DELAY );
+
+	virtual const char * name() const	{ return "delay"; }
+
+	double targetDelay() const;
+
+	/**
+	 *	This method returns the current estimate of the queuing delay, in
+	 *	timestamp() units.
+	 */
+	uint64 queuingDelay() const	{ return queuingDelay_; }
+
+protected:
+	virtual void doOnAck( uint64 now, uint64 roundTripTime );
+	virtual void doOnLoss( uint64 now );
+	virtual void doReset();
+
+private:
+	void addBaseDelay( uint64 now, uint64 roundTripTime );
+	uint64 baseDelay() const;
+	uint64 currentDelay( uint64 roundTripTime );
+
+	uint64 targetDelay_;
+	uint64 queuingDelay_;
+
+	// The minimum round trip time in each of the last few intervals. Using
+	// several intervals lets the base delay rise again if the route changes.
+	static const int NUM_BASE_DELAYS = 10;
+	uint64 baseDelays_[ NUM_BASE_DELAYS ];
+	int baseDelayIndex_;
+	uint64 baseDelayIntervalStart_;
+
+	// The last few round trip times. Their minimum is used as the current
+	// delay, to filter out packets whose acknowledgements were delayed.
+	static const int NUM_CURRENT_DELAYS = 4;
+	uint64 currentDelays_[ NUM_CURRENT_DELAYS ];
+	int currentDelayIndex_;
+};
+
+} // namespace Mercury
+
+#endif // DELAY_CONGESTION_CONTROLLER_HPP
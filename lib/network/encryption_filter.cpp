@@ -104,65 +104,82 @@ bool EncryptionFilter::initKey()
 
 
 /**
- *  This method encrypts the packet and sends it to the provided address.
+ *  This method returns a new packet holding the encrypted contents of the
+ *  given packet. The original contents of the given packet are not modified.
+ *
+ *  @return The encrypted packet, or NULL if this filter is invalid.
  */
-Reason EncryptionFilter::send( NetworkInterface & networkInterface,
-		const Address & addr, Packet * pPacket )
+PacketPtr EncryptionFilter::encryptPacket( Packet * pPacket )
 {
-	int len = 0;
-	PacketPtr toSend = NULL;
-	uint8 wastage = 0;
-
+	// Bail if this filter is invalid.
+	if (!isGood_)
 	{
-		AUTO_SCOPED_PROFILE( "encryptSend" )
+		return NULL;
+	}
 
-		// Bail if this filter is invalid.
-		if (!isGood_)
-		{
-			WARNING_MSG( "EncryptionFilter::send: "
-				"Dropping packet to %s due to invalid filter\n",
-				addr.c_str() );
+	// Grab a new packet.  Remember we have to leave the packet in its
+	// original state so we can't just modify its data in-place.
+	PacketPtr toSend = new Packet();
 
-			return REASON_GENERAL_NETWORK;
-		}
+	// Work out the number of pad bytes required to make the data size a
+	// multiple of the key size (required for most block ciphers).  The
+	// magic +1 is for the wastage count that we must write to the end of
+	// the packet so the receiver can figure out how big the unencrypted
+	// stream is.
+	int len = pPacket->totalSize();
 
-		// Grab a new packet.  Remember we have to leave the packet in its
-		// original state so we can't just modify its data in-place.
-		toSend = new Packet();
+	// We append some magic to the end of the packet for validation
+	len += sizeof( ENCRYPTION_MAGIC );
+	uint8 wastage = ((BLOCK_SIZE - ((len + 1) % BLOCK_SIZE)) % BLOCK_SIZE) + 1;
+	// Don't consider the magic size as part of the wastage, it will be
+	// removed separately.
 
-		// Work out the number of pad bytes required to make the data size a
-		// multiple of the key size (required for most block ciphers).  The
-		// magic +1 is for the wastage count that we must write to the end of
-		// the packet so the receiver can figure out how big the unencrypted
-		// stream is.
-		len = pPacket->totalSize();
+	len += wastage;
 
-		// We append some magic to the end of the packet for validation
-		len += sizeof( ENCRYPTION_MAGIC );
-		wastage = ((BLOCK_SIZE - ((len + 1) % BLOCK_SIZE)) % BLOCK_SIZE) + 1;
-		// Don't consider the magic size as part of the wastage, it will be
-		// removed separately.
+	MF_ASSERT( len <= PACKET_MAX_SIZE );
 
-		len += wastage;
+	// len is greater than the actual packet's size but we've ensured that
+	// data_ contains enough space to handle the filters extra data (padding
+	// and encryption magic).
+	// Set up the output packet to match.
+	toSend->msgEndOffset( len );
 
-		MF_ASSERT( len <= PACKET_MAX_SIZE );
+	// Write the wastage count into the last byte of the input packet.
+	// Since wastage >= 1, we are not writing over any of the original data.
+	uint32 startWastage = len - 1;
+	uint32 startMagic = startWastage - sizeof( ENCRYPTION_MAGIC );
+
+	pPacket->data()[ startWastage ] = wastage;
+	*(MagicType *)(pPacket->data() + startMagic) = ENCRYPTION_MAGIC;
+
+	this->encrypt( (const unsigned char*)pPacket->data(),
+		(unsigned char*)toSend->data(), len );
+
+	return toSend;
+}
+
+
+/**
+ *  This method encrypts the packet and sends it to the provided address.
+ */
+Reason EncryptionFilter::send( NetworkInterface & networkInterface,
+		const Address & addr, Packet * pPacket )
+{
+	PacketPtr toSend = NULL;
 
-		// len is greater than the actual packet's size but we've ensured that
-		// data_ contains enough space to handle the filters extra data (padding
-		// and encryption magic).
-		// Set up the output packet to match.
-		toSend->msgEndOffset( len );
+	{
+		AUTO_SCOPED_PROFILE( "encryptSend" )
 
-		// Write the wastage count into the last byte of the input packet.
-		// Since wastage >= 1, we are not writing over any of the original data.
-		uint32 startWastage = len - 1;
-		uint32 startMagic = startWastage - sizeof( ENCRYPTION_MAGIC );
+		toSend = this->encryptPacket( pPacket );
+	}
 
-		pPacket->data()[ startWastage ] = wastage;
-		*(MagicType *)(pPacket->data() + startMagic) = ENCRYPTION_MAGIC;
+	if (!toSend)
+	{
+		WARNING_MSG( "EncryptionFilter::send: "
+			"Dropping packet to %s due to invalid filter\n",
+			addr.c_str() );
 
-		this->encrypt( (const unsigned char*)pPacket->data(),
-			(unsigned char*)toSend->data(), len );
+		return REASON_GENERAL_NETWORK;
 	}
 
 	return this->PacketFilter::send( networkInterface, addr, toSend.getObject() );
@@ -178,70 +195,100 @@ Reason EncryptionFilter::recv( PacketReceiver & receiver, const Address & addr,
 	{
 		AUTO_SCOPED_PROFILE( "encryptRecv" )
 
-		// Bail if this filter is invalid.
-		if (!isGood_)
-		{
-			WARNING_MSG( "EncryptionFilter::recv: "
-				"Dropping packet from %s due to invalid filter\n",
-				addr.c_str() );
-
-			return REASON_GENERAL_NETWORK;
-		}
-
-		// Decrypt the data in place.  This is fine for Blowfish, but may not be
-		// safe for other encryption algorithms.
-		int decryptLen = this->decrypt( (const unsigned char*)pPacket->data(),
-			(unsigned char*)pPacket->data(), pPacket->totalSize() );
+		Reason reason = this->decryptPacket( addr, pPacket );
 
-		if (decryptLen == -1)
+		if (reason == REASON_CORRUPTED_PACKET)
 		{
 			receiver.stats().incCorruptedPackets();
-			return REASON_CORRUPTED_PACKET;
 		}
 
-		// Read the wastage amount
-		uint32 startWastage = pPacket->totalSize() - 1;
-
-		if (startWastage < sizeof( ENCRYPTION_MAGIC ))
+		if (reason != REASON_SUCCESS)
 		{
-			MF_ASSERT_DEV( !"Not enough wastage" );
-			receiver.stats().incCorruptedPackets();
-			return REASON_CORRUPTED_PACKET;
+			return reason;
 		}
+	}
+
+	return this->PacketFilter::recv( receiver, addr, pPacket, pStatsHelper );
+}
 
-		uint32 startMagic   = startWastage - sizeof( ENCRYPTION_MAGIC );
-		uint8 wastage = pPacket->data()[ startWastage ];
 
-		MagicType &packetMagic = *(MagicType *)(pPacket->data() + startMagic);
+/**
+ *	This method decrypts an incoming packet on a receive thread. This is safe
+ *	because the key is not changed after construction.
+ */
+Reason EncryptionFilter::preprocessRecv( const Address & addr,
+		Packet * pPacket )
+{
+	return this->decryptPacket( addr, pPacket );
+}
 
-		// Check the ENCRYPTION_MAGIC is as we expect
-		if (packetMagic != ENCRYPTION_MAGIC)
-		{
-			WARNING_MSG( "EncryptionFilter::recv: "
-				"Dropping packet with invalid magic 0x%x (expected 0x%x)\n",
-				packetMagic, ENCRYPTION_MAGIC );
-			receiver.stats().incCorruptedPackets();
-			return REASON_CORRUPTED_PACKET;
-		}
 
+/**
+ *	This method decrypts and validates an incoming packet in place. It does not
+ *	touch any state other than the packet.
+ */
+Reason EncryptionFilter::decryptPacket( const Address & addr,
+		Packet * pPacket )
+{
+	// Bail if this filter is invalid.
+	if (!isGood_)
+	{
+		WARNING_MSG( "EncryptionFilter::recv: "
+			"Dropping packet from %s due to invalid filter\n",
+			addr.c_str() );
 
-		// Sanity check the wastage
-		int footerSize = wastage + sizeof( ENCRYPTION_MAGIC );
-		if (wastage > BLOCK_SIZE || footerSize > pPacket->totalSize())
-		{
-			WARNING_MSG( "EncryptionFilter::recv: "
-				"Dropping packet from %s due to illegal wastage count (%d)\n",
-				addr.c_str(), wastage );
+		return REASON_GENERAL_NETWORK;
+	}
 
-			receiver.stats().incCorruptedPackets();
-			return REASON_CORRUPTED_PACKET;
-		}
+	// Decrypt the data in place.  This is fine for Blowfish, but may not be
+	// safe for other encryption algorithms.
+	int decryptLen = this->decrypt( (const unsigned char*)pPacket->data(),
+		(unsigned char*)pPacket->data(), pPacket->totalSize() );
 
-		// Set the packet length correctly
-		pPacket->shrink( footerSize );
+	if (decryptLen == -1)
+	{
+		return REASON_CORRUPTED_PACKET;
 	}
 
-	return this->PacketFilter::recv( receiver, addr, pPacket, pStatsHelper );
+	// Read the wastage amount
+	uint32 startWastage = pPacket->totalSize() - 1;
+
+	if (startWastage < sizeof( ENCRYPTION_MAGIC ))
+	{
+		MF_ASSERT_DEV( !"Not enough wastage" );
+		return REASON_CORRUPTED_PACKET;
+	}
+
+	uint32 startMagic   = startWastage - sizeof( ENCRYPTION_MAGIC );
+	uint8 wastage = pPacket->data()[ startWastage ];
+
+	MagicType &packetMagic = *(MagicType *)(pPacket->data() + startMagic);
+
+	// Check the ENCRYPTION_MAGIC is as we expect
+	if (packetMagic != ENCRYPTION_MAGIC)
+	{
+		WARNING_MSG( "EncryptionFilter::recv: "
+			"Dropping packet with invalid magic 0x%x (expected 0x%x)\n",
+			packetMagic, ENCRYPTION_MAGIC );
+		return REASON_CORRUPTED_PACKET;
+	}
+
+
+	// Sanity check the wastage
+	int footerSize = wastage + sizeof( ENCRYPTION_MAGIC );
+	if (wastage > BLOCK_SIZE || footerSize > pPacket->totalSize())
+	{
+		WARNING_MSG( "EncryptionFilter::recv: "
+			"Dropping packet from %s due to illegal wastage count (%d)\n",
+			addr.c_str(), wastage );
+
+		return REASON_CORRUPTED_PACKET;
+	}
+
+	// Set the packet length correctly
+	pPacket->shrink( footerSize );
+
+	return REASON_SUCCESS;
 }
 
 
@@ -16,6 +16,7 @@ criminal penalties as provided by law.
 #define USE_OPENSSL
 #endif
 
+#include "packet.hpp"
 #include "packet_filter.hpp"
 #include "cstdmf/smartpointer.hpp"
 #include "cstdmf/memory_stream.hpp"
@@ -60,6 +61,11 @@ public:
 
 	virtual int maxSpareSize();
 
+	virtual bool isThreadSafe() const { return true; }
+	virtual Reason preprocessRecv( const Address & addr, Packet * pPacket );
+
+	PacketPtr encryptPacket( Packet * pPacket );
+
 	const Key & key() const { return key_; }
 	const char * readableKey() const;
 	bool isGood() const { return isGood_; }
@@ -77,6 +83,8 @@ private:
 	int encrypt( const unsigned char * src, unsigned char * dest, int length );
 	int decrypt( const unsigned char * src, unsigned char * dest, int length );
 
+	Reason decryptPacket( const Address & addr, Packet * pPacket );
+
 	bool initKey();
 
 	Key key_;
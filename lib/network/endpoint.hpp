@@ -42,6 +42,24 @@ criminal penalties as provided by law.
 
 #include "cstdmf/memory_stream.hpp"
 
+#if defined( unix ) && defined( MSG_WAITFORONE )
+	/// recvmmsg() is available (Linux 2.6.33 / glibc 2.12 and later).
+	#define ENDPOINT_HAS_RECVMMSG 1
+
+	#if defined( __GLIBC_PREREQ )
+	#if __GLIBC_PREREQ( 2, 14 )
+		/// sendmmsg() is available (Linux 3.0 / glibc 2.14 and later).
+		#define ENDPOINT_HAS_SENDMMSG 1
+	#endif
+	#endif
+#endif
+
+#if defined( unix ) && defined( SO_REUSEPORT )
+	/// Several sockets can be bound to the same port, with the kernel sharing
+	/// incoming datagrams between them (Linux 3.9 and later).
+	#define ENDPOINT_HAS_REUSEPORT 1
+#endif
+
 #ifndef unix
 
 #ifdef PLAYSTATION3
@@ -115,6 +133,9 @@ public:
 	int setnonblocking( bool nonblocking );
 	int setbroadcast( bool broadcast );
 	int setreuseaddr( bool reuseaddr );
+#ifdef ENDPOINT_HAS_REUSEPORT
+	INLINE int setreuseport( bool reuseport );
+#endif
 	int setkeepalive( bool keepalive );
 
 	int bind( u_int16_t networkPort = 0, u_int32_t networkAddr = INADDR_ANY );
@@ -148,6 +169,12 @@ public:
 		u_int16_t * networkPort, u_int32_t * networkAddr );
 	INLINE int recvfrom( void * gramData, int gramSize,
 		struct sockaddr_in & sin );
+#ifdef ENDPOINT_HAS_RECVMMSG
+	INLINE int recvmmsg( struct mmsghdr * pMessages, unsigned int numMessages );
+#endif
+#ifdef ENDPOINT_HAS_SENDMMSG
+	INLINE int sendmmsg( struct mmsghdr * pMessages, unsigned int numMessages );
+#endif
 	//@}
 
 	/// @name Connecting Socket Methods
@@ -147,6 +147,23 @@ INLINE int Endpoint::setreuseaddr( bool reuseaddr )
 	return ::setsockopt( socket_, SOL_SOCKET, SO_REUSEADDR,
 		(char*)&val, sizeof(val) );
 }
+
+#ifdef ENDPOINT_HAS_REUSEPORT
+/**
+ *	This method toggles the reuse port mode of the socket. All sockets bound to
+ *	the same port must have this set, and incoming datagrams are then shared
+ *	between them.
+ *
+ *	@param reuseport	The desired reuse port mode.
+ */
+INLINE int Endpoint::setreuseport( bool reuseport )
+{
+	int val = reuseport ? 1 : 0;
+	return ::setsockopt( socket_, SOL_SOCKET, SO_REUSEPORT,
+		(char*)&val, sizeof(val) );
+}
+#endif // ENDPOINT_HAS_REUSEPORT
+
 INLINE int Endpoint::setkeepalive( bool keepalive )
 {
 #ifdef unix
@@ -414,6 +431,47 @@ INLINE int Endpoint::recvfrom( void * gramData, int gramSize,
 	return ret;
 }
 
+
+#ifdef ENDPOINT_HAS_RECVMMSG
+/**
+ *	This method attempts to receive a number of packets in a single system
+ *	call. It does not block waiting for further packets once at least one
+ *	packet has been received.
+ *
+ *	@param pMessages	An array of message headers describing the buffers to
+ *						receive into. On return, msg_len of each received
+ *						message is set to the number of bytes received.
+ *	@param numMessages	The number of elements in pMessages.
+ *
+ *	@return The number of packets received, or -1 if an error occurred.
+ */
+INLINE int Endpoint::recvmmsg( struct mmsghdr * pMessages,
+	unsigned int numMessages )
+{
+	return ::recvmmsg( socket_, pMessages, numMessages, MSG_DONTWAIT, NULL );
+}
+#endif // ENDPOINT_HAS_RECVMMSG
+
+
+#ifdef ENDPOINT_HAS_SENDMMSG
+/**
+ *	This method sends a number of packets in a single system call.
+ *
+ *	@param pMessages	An array of message headers describing the packets and
+ *						their destination addresses. On return, msg_len of
+ *						each sent message is set to the number of bytes sent.
+ *	@param numMessages	The number of elements in pMessages.
+ *
+ *	@return The number of packets sent, or -1 if the first packet could not be
+ *		sent.
+ */
+INLINE int Endpoint::sendmmsg( struct mmsghdr * pMessages,
+	unsigned int numMessages )
+{
+	return ::sendmmsg( socket_, pMessages, numMessages, 0 );
+}
+#endif // ENDPOINT_HAS_SENDMMSG
+
 /**
  *	This method instructs this endpoint to listen for incoming connections.
  */
@@ -19,6 +19,7 @@ criminal penalties as provided by law.
 #include "frequent_tasks.hpp"
 
 #include "cstdmf/concurrency.hpp"
+#include "cstdmf/memory_stream_arena.hpp"
 #include "cstdmf/timestamp.hpp"
 #include "cstdmf/time_queue.hpp"
 
@@ -46,6 +47,7 @@ EventDispatcher::EventDispatcher() :
 	breakProcessing_( false ),
 	pTimeQueue_( new TimeQueue64 ),
 	pFrequentTasks_( new FrequentTasks ),
+	pFlushTasks_( new FrequentTasks ),
 	pErrorReporter_( NULL ),
 	accSpareTime_( 0 ),
 	oldSpareTime_( 0 ),
@@ -77,6 +79,7 @@ EventDispatcher::~EventDispatcher()
 	delete pPoller_;
 
 	delete pFrequentTasks_;
+	delete pFlushTasks_;
 
 	if (!pTimeQueue_->empty())
 	{
@@ -166,15 +169,20 @@ void EventDispatcher::detachFrom( EventDispatcher & parentDispatcher )
  * 	Unlike timers, these handlers are only called if you use
  * 	processContinuously
  *
- *	@param fd			The file descriptor to register
- *	@param handler		The handler to receive notification messages.
+ *	An edge-triggered handler is only called when new input arrives, so it
+ *	must read until the file descriptor would block. This saves epoll from
+ *	reporting descriptors that the handler has already drained.
+ *
+ *	@param fd				The file descriptor to register
+ *	@param handler			The handler to receive notification messages.
+ *	@param isEdgeTriggered	Whether the handler should be edge-triggered.
  *
  * 	@return true if descriptor could be registered
  */
 bool EventDispatcher::registerFileDescriptor( int fd,
-	InputNotificationHandler * handler )
+	InputNotificationHandler * handler, bool isEdgeTriggered )
 {
-	return pPoller_->registerForRead( fd, handler );
+	return pPoller_->registerForRead( fd, handler, isEdgeTriggered );
 }
 
 
@@ -289,6 +297,26 @@ bool EventDispatcher::cancelFrequentTask( FrequentTask * pTask )
 }
 
 
+/**
+ *	This method adds a task that will be called once per loop, after timers
+ *	have been processed and just before waiting for network activity. It is
+ *	used to flush work that has been deferred during the current iteration.
+ */
+void EventDispatcher::addFlushTask( FrequentTask * pTask )
+{
+	pFlushTasks_->add( pTask );
+}
+
+
+/**
+ *	This method removes a task added with addFlushTask.
+ */
+bool EventDispatcher::cancelFlushTask( FrequentTask * pTask )
+{
+	return pFlushTasks_->cancel( pTask );
+}
+
+
 // -----------------------------------------------------------------------------
 // Section: Loop processing
 // -----------------------------------------------------------------------------
@@ -302,6 +330,15 @@ void EventDispatcher::processFrequentTasks()
 }
 
 
+/**
+ *	This method calls doTask on all registered flush tasks.
+ */
+void EventDispatcher::processFlushTasks()
+{
+	pFlushTasks_->process();
+}
+
+
 /**
  *	This method processes outstanding timers.
  */
@@ -378,6 +415,9 @@ void EventDispatcher::processContinuously()
 	while (!breakProcessing_)
 	{
 		this->processOnce( /* shouldIdle */ true );
+
+		// Streams should not have outlived the events that created them.
+		MemoryStreamArena::resetCurrentThread();
 	}
 }
 
@@ -398,6 +438,8 @@ int EventDispatcher::processOnce( bool shouldIdle )
 
 	this->processStats();
 
+	this->processFlushTasks();
+
 	if (!breakProcessing_)
 	{
 		return this->processNetwork( shouldIdle );
@@ -486,6 +528,11 @@ WatcherPtr EventDispatcher::pWatcher()
 			makeWatcher( &EventDispatcher::totSpareTime_ ) );
 		watchMe->addChild( "numTimerCalls",
 			makeWatcher( &EventDispatcher::numTimerCalls_ ) );
+
+		EventDispatcher * pNull = NULL;
+		watchMe->addChild( "poller",
+			new BaseDereferenceWatcher( EventPoller::pWatcher() ),
+			&pNull->pPoller_ );
 	}
 
 	return watchMe;
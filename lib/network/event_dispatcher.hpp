@@ -62,7 +62,8 @@ public:
 	void attach( EventDispatcher & childDispatcher );
 	void detach( EventDispatcher & childDispatcher );
 
-	bool registerFileDescriptor( int fd, InputNotificationHandler * handler );
+	bool registerFileDescriptor( int fd, InputNotificationHandler * handler,
+		bool isEdgeTriggered = false );
 	bool deregisterFileDescriptor( int fd );
 	bool registerWriteFileDescriptor( int fd, InputNotificationHandler * handler );
 	bool deregisterWriteFileDescriptor( int fd );
@@ -75,6 +76,9 @@ public:
 	void addFrequentTask( FrequentTask * pTask );
 	bool cancelFrequentTask( FrequentTask * pTask );
 
+	void addFlushTask( FrequentTask * pTask );
+	bool cancelFlushTask( FrequentTask * pTask );
+
 	uint64 timerDeliveryTime( TimerHandle handle ) const;
 	uint64 timerIntervalTime( TimerHandle handle ) const;
 	uint64 & timerIntervalTime( TimerHandle handle );
@@ -99,6 +103,7 @@ private:
 		bool recurrent );
 
 	void processFrequentTasks();
+	void processFlushTasks();
 	void processTimers();
 	void processStats();
 	int processNetwork( bool shouldIdle );
@@ -116,6 +121,9 @@ private:
 
 	FrequentTasks * pFrequentTasks_;
 
+	// Tasks that are called just before waiting for network activity.
+	FrequentTasks * pFlushTasks_;
+
 	ErrorReporter * pErrorReporter_;
 
 	// Statistics
@@ -28,6 +28,9 @@ criminal penalties as provided by law.
 #include <string.h>
 #include <errno.h>
 
+#include <set>
+#include <vector>
+
 #if ENABLE_WATCHERS
 namespace
 {
@@ -50,6 +53,10 @@ EventPoller::EventPoller() :
 	fdWriteHandlers_(), 
 	spareTime_( 0 )
 {
+	for (int i = 0; i < NUM_WAKEUP_BUCKETS; ++i)
+	{
+		eventsPerWakeup_[i] = 0;
+	}
 }
 
 
@@ -63,11 +70,19 @@ EventPoller::~EventPoller()
 
 /**
  *	This method registers a file descriptor for reading.
+ *
+ *	@param fd				The file descriptor to register.
+ *	@param handler			The handler to call when the descriptor is readable.
+ *	@param isEdgeTriggered	If true, the handler is only notified when new data
+ *							arrives, rather than while data remains unread. The
+ *							handler must then read until the descriptor would
+ *							block. Pollers that do not support this fall back to
+ *							level-triggered notification.
  */
 bool EventPoller::registerForRead( int fd,
-		InputNotificationHandler * handler )
+		InputNotificationHandler * handler, bool isEdgeTriggered )
 {
-	if (!this->doRegisterForRead( fd ))
+	if (!this->doRegisterForRead( fd, isEdgeTriggered ))
 	{
 		return false;
 	}
@@ -220,6 +235,69 @@ int EventPoller::maxFD( const FDHandlers & handlerMap )
 }
 
 
+/**
+ *	This method records the number of events returned by a single wait for
+ *	events.
+ */
+void EventPoller::onWakeup( int numEvents )
+{
+	int bucket = 0;
+
+	while ((numEvents > 0) && (bucket < NUM_WAKEUP_BUCKETS - 1))
+	{
+		numEvents >>= 1;
+		++bucket;
+	}
+
+	++eventsPerWakeup_[ bucket ];
+}
+
+
+#if ENABLE_WATCHERS
+/**
+ *	This static method returns a watcher that can be used to inspect an
+ *	EventPoller.
+ */
+WatcherPtr EventPoller::pWatcher()
+{
+	static DirectoryWatcherPtr watchMe = NULL;
+
+	if (watchMe == NULL)
+	{
+		watchMe = new DirectoryWatcher();
+
+		EventPoller * pNull = NULL;
+
+		for (int i = 0; i < NUM_WAKEUP_BUCKETS; ++i)
+		{
+			char name[ 32 ];
+
+			if (i < 2)
+			{
+				bw_snprintf( name, sizeof( name ),
+						"eventsPerWakeup/%d", i );
+			}
+			else if (i < NUM_WAKEUP_BUCKETS - 1)
+			{
+				bw_snprintf( name, sizeof( name ),
+						"eventsPerWakeup/%d-%d", 1 << (i - 1), (1 << i) - 1 );
+			}
+			else
+			{
+				bw_snprintf( name, sizeof( name ),
+						"eventsPerWakeup/%d+", 1 << (i - 1) );
+			}
+
+			watchMe->addChild( name,
+					makeWatcher( pNull->eventsPerWakeup_[i] ) );
+		}
+	}
+
+	return watchMe;
+}
+#endif // ENABLE_WATCHERS
+
+
 // -----------------------------------------------------------------------------
 // Section: SelectPoller
 // -----------------------------------------------------------------------------
@@ -233,7 +311,7 @@ public:
 	SelectPoller();
 
 protected:
-	virtual bool doRegisterForRead( int fd );
+	virtual bool doRegisterForRead( int fd, bool isEdgeTriggered );
 	virtual bool doRegisterForWrite( int fd );
 
 	virtual bool doDeregisterForRead( int fd );
@@ -384,6 +462,11 @@ int SelectPoller::processPendingEvents( double maxWait )
 	spareTime_ += ::timestamp() - startTime;
 #endif
 
+	if (countReady >= 0)
+	{
+		this->onWakeup( countReady );
+	}
+
 	if (countReady > 0)
 	{
 		this->handleInputNotifications( countReady, readFDs, writeFDs );
@@ -404,9 +487,11 @@ int SelectPoller::processPendingEvents( double maxWait )
 
 /**
  *	This method implements a virtual method from EventPoller to do the real
- *	work of registering a file descriptor for reading.
+ *	work of registering a file descriptor for reading. select() is always
+ *	level-triggered, which is still correct for handlers that expect
+ *	edge-triggered notification.
  */
-bool SelectPoller::doRegisterForRead( int fd )
+bool SelectPoller::doRegisterForRead( int fd, bool /*isEdgeTriggered*/ )
 {
 #ifndef _WIN32
 	if ((fd < 0) || (FD_SETSIZE <= fd))
@@ -548,14 +633,12 @@ public:
 	int getFileDescriptor() const { return epfd_; }
 
 protected:
-	virtual bool doRegisterForRead( int fd )
-		{ return this->doRegister( fd, true, true ); }
+	virtual bool doRegisterForRead( int fd, bool isEdgeTriggered );
 
 	virtual bool doRegisterForWrite( int fd )
 		{ return this->doRegister( fd, false, true ); }
 
-	virtual bool doDeregisterForRead( int fd )
-		{ return this->doRegister( fd, true, false ); }
+	virtual bool doDeregisterForRead( int fd );
 
 	virtual bool doDeregisterForWrite( int fd )
 		{ return this->doRegister( fd, false, false ); }
@@ -565,8 +648,21 @@ protected:
 	bool doRegister( int fd, bool isRead, bool isRegister );
 
 private:
+	typedef std::vector< struct epoll_event > Events;
+
+	// The largest number of events that a single epoll_wait() call will
+	// return. The event array grows up to this size while wakeups keep
+	// filling it.
+	static const size_t MAX_EVENTS = 4096;
+
 	// epoll file descriptor
 	int epfd_;
+
+	// The buffer passed to epoll_wait().
+	Events events_;
+
+	// The file descriptors that were registered as edge-triggered.
+	std::set< int > edgeTriggeredFDs_;
 };
 
 
@@ -574,7 +670,9 @@ private:
  *	Constructor.
  */
 EPoller::EPoller( int expectedSize ) :
-	epfd_( epoll_create( expectedSize ) )
+	epfd_( epoll_create( expectedSize ) ),
+	events_( expectedSize ),
+	edgeTriggeredFDs_()
 {
 	if (epfd_ == -1)
 	{
@@ -596,9 +694,43 @@ EPoller::~EPoller()
 }
 
 
+/**
+ *	This method implements a virtual method from EventPoller to do the real
+ *	work of registering a file descriptor for reading.
+ */
+bool EPoller::doRegisterForRead( int fd, bool isEdgeTriggered )
+{
+	if (isEdgeTriggered)
+	{
+		edgeTriggeredFDs_.insert( fd );
+	}
+
+	if (!this->doRegister( fd, true, true ))
+	{
+		edgeTriggeredFDs_.erase( fd );
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+ *	This method implements a virtual method from EventPoller to do the real
+ *	work of deregistering a file descriptor for reading.
+ */
+bool EPoller::doDeregisterForRead( int fd )
+{
+	edgeTriggeredFDs_.erase( fd );
+
+	return this->doRegister( fd, true, false );
+}
+
+
 /**
  *	This method does the work registering and deregistering file descriptors
- *	from the epoll descriptor.
+ *	from the epoll descriptor. A descriptor that was registered for reading as
+ *	edge-triggered is also edge-triggered for any write registration.
  */
 bool EPoller::doRegister( int fd, bool isRead, bool isRegister )
 {
@@ -619,11 +751,16 @@ bool EPoller::doRegister( int fd, bool isRead, bool isRegister )
 	}
 	else
 	{
-		// TODO: Could be good to use EPOLLET (leave like select for now).
 		ev.events = isRead ? EPOLLIN : EPOLLOUT;
 		op = isRegister ? EPOLL_CTL_ADD : EPOLL_CTL_DEL;
 	}
 
+	if ((op != EPOLL_CTL_DEL) &&
+			(edgeTriggeredFDs_.find( fd ) != edgeTriggeredFDs_.end()))
+	{
+		ev.events |= EPOLLET;
+	}
+
 	if (epoll_ctl( epfd_, op, fd, &ev ) < 0)
 	{
 		ERROR_MSG( "EPoller::doRegister: Failed to %s %s file descriptor %d "
@@ -645,9 +782,15 @@ bool EPoller::doRegister( int fd, bool isRead, bool isRegister )
  */
 int EPoller::processPendingEvents( double maxWait )
 {
-	const int MAX_EVENTS = 10;
+	// Take the buffer for the duration of this call. A handler may process
+	// events recursively, in which case the nested call uses a new buffer.
+	Events events;
+	events.swap( events_ );
 
-	struct epoll_event events[ MAX_EVENTS ];
+	if (events.empty())
+	{
+		events.resize( 10 );
+	}
 
 	int maxWaitInMilliseconds = int( ceil( maxWait * 1000 ) );
 
@@ -658,7 +801,8 @@ int EPoller::processPendingEvents( double maxWait )
 #endif
 
 	BWConcurrency::startMainThreadIdling();
-	int nfds = epoll_wait( epfd_, events, MAX_EVENTS, maxWaitInMilliseconds );
+	int nfds = epoll_wait( epfd_, &events[0], int( events.size() ),
+			maxWaitInMilliseconds );
 	BWConcurrency::endMainThreadIdling();
 
 #if ENABLE_WATCHERS
@@ -668,6 +812,11 @@ int EPoller::processPendingEvents( double maxWait )
 	spareTime_ += ::timestamp() - startTime;
 #endif
 
+	if (nfds >= 0)
+	{
+		this->onWakeup( nfds );
+	}
+
 	for (int i = 0; i < nfds; ++i)
 	{
 		if (events[i].events & (EPOLLIN|EPOLLERR|EPOLLHUP))
@@ -681,6 +830,15 @@ int EPoller::processPendingEvents( double maxWait )
 		}
 	}
 
+	// A full buffer may have left events behind. Grow it so that the next
+	// wakeup can collect them all at once.
+	if ((size_t( nfds ) == events.size()) && (events.size() < MAX_EVENTS))
+	{
+		events.resize( std::min( events.size() * 2, size_t( MAX_EVENTS ) ) );
+	}
+
+	events_.swap( events );
+
 	return nfds;
 }
 
@@ -13,6 +13,7 @@ criminal penalties as provided by law.
 #define EVENT_POLLER_HPP
 
 #include "cstdmf/stdmf.hpp"
+#include "cstdmf/watcher.hpp"
 #include "network/interfaces.hpp"
 
 #include <map>
@@ -30,7 +31,8 @@ public:
 	EventPoller();
 	virtual ~EventPoller();
 
-	bool registerForRead( int fd, InputNotificationHandler * handler );
+	bool registerForRead( int fd, InputNotificationHandler * handler,
+		bool isEdgeTriggered = false );
 	bool registerForWrite( int fd, InputNotificationHandler * handler );
 
 	bool deregisterForRead( int fd );
@@ -53,8 +55,12 @@ public:
 
 	static EventPoller * create();
 
+#if ENABLE_WATCHERS
+	static WatcherPtr pWatcher();
+#endif
+
 protected:
-	virtual bool doRegisterForRead( int fd ) = 0;
+	virtual bool doRegisterForRead( int fd, bool isEdgeTriggered ) = 0;
 	virtual bool doRegisterForWrite( int fd ) = 0;
 
 	virtual bool doDeregisterForRead( int fd ) = 0;
@@ -67,9 +73,18 @@ protected:
 
 	int maxFD() const;
 
+	void onWakeup( int numEvents );
+
 private:
 	static int maxFD( const FDHandlers & handlerMap );
 
+	// Histogram of the number of ready events returned by each wakeup. Bucket
+	// 0 counts timeouts, bucket 1 single events and bucket n (n > 1) counts
+	// wakeups with between 2^(n-1) and 2^n - 1 events. The last bucket also
+	// counts anything larger.
+	static const int NUM_WAKEUP_BUCKETS = 8;
+	uint32 eventsPerWakeup_[ NUM_WAKEUP_BUCKETS ];
+
 	// Maps from file descriptor to their callbacks
 	FDHandlers fdReadHandlers_;
 	FDHandlers fdWriteHandlers_;
@@ -154,6 +154,17 @@ bool SimpleLoggerMessageForwarder::isSuppressible( const std::string & format )
 // Section: LoggerMessageForwarder
 // -----------------------------------------------------------------------------
 
+namespace
+{
+
+/// The number of messages from other threads that can be waiting to be sent.
+const uint32 QUEUED_MESSAGES_CAPACITY = 1024;
+
+/// How often messages from other threads are sent, in microseconds.
+const int FLUSH_PERIOD = 100000;
+
+}
+
 /**
  *	Constructor.
  */
@@ -168,7 +179,11 @@ LoggerMessageForwarder::LoggerMessageForwarder(
 	dispatcher_( dispatcher ),
 	spamTimerHandle_(),
 	spamFilterThreshold_( spamFilterThreshold ),
-	spamHandler_( "* Suppressed %d in last 1s: %s" )
+	spamHandler_( "* Suppressed %d in last 1s: %s" ),
+	queuedMessages_( QUEUED_MESSAGES_CAPACITY ),
+	numDroppedMessages_( 0 ),
+	flushTimerHandle_(),
+	droppedHandler_( "* Dropped %u messages from other threads\n" )
 {
 	this->init();
 }
@@ -181,6 +196,7 @@ LoggerMessageForwarder::~LoggerMessageForwarder()
 {
 	// Stop spam suppression timer
 	spamTimerHandle_.cancel();
+	flushTimerHandle_.cancel();
 }
 
 
@@ -302,6 +318,9 @@ void LoggerMessageForwarder::init()
 	// Register a timer for doing spam suppression
 	spamTimerHandle_ = dispatcher_.addTimer( 1000000 /* 1s */,
 		this );
+
+	// Register a timer for sending messages logged by other threads
+	flushTimerHandle_ = dispatcher_.addTimer( FLUSH_PERIOD, this );
 }
 
 
@@ -447,29 +466,54 @@ bool LoggerMessageForwarder::handleMessage( int componentPriority,
 	if (loggers_.empty() || !enabled_)
 		return false;
 
+	// The handler cache is not thread-safe, so other threads leave their
+	// messages for the main thread to send.
+	if (!MainThreadTracker::isCurrentThreadMain())
+	{
+		this->queueMessage( componentPriority, messagePriority,
+			format, argPtr );
+		return false;
+	}
+
 	// Find/create the handler object for this format string
 	ForwardingStringHandler * pHandler =
 		this->findForwardingStringHandler( format );
 
+	// If this isn't considered to be spam, parse and send.
+	if (this->addRecentCall( pHandler ))
+	{
+		this->parseAndSend(
+			pHandler, componentPriority, messagePriority, argPtr );
+	}
+
+	return false;
+}
+
+
+/**
+ *	This method counts a message for spam suppression.
+ *
+ *	@return True if the message should be sent, false if it is spam.
+ */
+bool LoggerMessageForwarder::addRecentCall( ForwardingStringHandler * pHandler )
+{
 	// This must be done before the call to isSpamming() for this logic to be
 	// the exact opposite of that in handleTimeout()
 	pHandler->addRecentCall();
 
-	// If this isn't considered to be spam, parse and send.
-	if (!this->isSpamming( pHandler ))
+	if (this->isSpamming( pHandler ))
 	{
-		this->parseAndSend(
-			pHandler, componentPriority, messagePriority, argPtr );
+		return false;
+	}
 
-		// If this is the first time this handler has been used this second, put
-		// it in the used handlers collection.
-		if (pHandler->numRecentCalls() == 1)
-		{
-			recentlyUsedHandlers_.push_back( pHandler );
-		}
+	// If this is the first time this handler has been used this second, put
+	// it in the used handlers collection.
+	if (pHandler->numRecentCalls() == 1)
+	{
+		recentlyUsedHandlers_.push_back( pHandler );
 	}
 
-	return false;
+	return true;
 }
 
 
@@ -479,6 +523,12 @@ bool LoggerMessageForwarder::handleMessage( int componentPriority,
  */
 void LoggerMessageForwarder::handleTimeout( TimerHandle handle, void * arg )
 {
+	if (handle == flushTimerHandle_)
+	{
+		this->sendQueuedMessages();
+		return;
+	}
+
 	// Send a message about each handler that exceeded its quota, and reset all
 	// call counts.
 	for (RecentlyUsedHandlers::iterator iter = recentlyUsedHandlers_.begin();
@@ -500,6 +550,86 @@ void LoggerMessageForwarder::handleTimeout( TimerHandle handle, void * arg )
 }
 
 
+/**
+ *	This method handles a message logged by a thread other than the main
+ *	thread. Its arguments are packed and it is queued to be sent by the main
+ *	thread. The message is dropped if the queue is full so that logging never
+ *	blocks.
+ *
+ *	Critical messages are sent straight away, since the process may not live
+ *	until the next flush. They may arrive before earlier queued messages.
+ */
+void LoggerMessageForwarder::queueMessage( int componentPriority,
+	int messagePriority, const char * format, va_list argPtr )
+{
+	// The shared handler cache cannot be used from this thread, so the format
+	// string is parsed into a handler of its own.
+	ForwardingStringHandler handler( format );
+
+	if (messagePriority == MESSAGE_PRIORITY_CRITICAL)
+	{
+		this->parseAndSend( &handler, componentPriority, messagePriority,
+			argPtr );
+		return;
+	}
+
+	MemoryOStream args;
+	handler.parseArgs( argPtr, args );
+
+	QueuedMessage message;
+	message.componentPriority_ = componentPriority;
+	message.messagePriority_ = messagePriority;
+	message.format_ = format;
+	message.args_.assign( static_cast< char * >( args.data() ), args.size() );
+
+	if (!queuedMessages_.push( message ))
+	{
+		uint32 numDropped;
+
+		do
+		{
+			numDropped = numDroppedMessages_;
+		}
+		while (!atomic_swap( numDroppedMessages_, numDropped, numDropped + 1 ));
+	}
+}
+
+
+/**
+ *	This method sends the messages that have been queued by other threads.
+ */
+void LoggerMessageForwarder::sendQueuedMessages()
+{
+	QueuedMessage message;
+
+	while (queuedMessages_.pop( message ))
+	{
+		ForwardingStringHandler * pHandler =
+			this->findForwardingStringHandler( message.format_.c_str() );
+
+		if (this->addRecentCall( pHandler ))
+		{
+			this->sendParsed( pHandler, message.componentPriority_,
+				message.messagePriority_, message.args_ );
+		}
+	}
+
+	uint32 numDropped;
+
+	do
+	{
+		numDropped = numDroppedMessages_;
+	}
+	while (numDropped && !atomic_swap( numDroppedMessages_, numDropped, 0 ));
+
+	if (numDropped)
+	{
+		this->parseAndSend( &droppedHandler_, 0, MESSAGE_PRIORITY_WARNING,
+			numDropped );
+	}
+}
+
+
 /**
  *  This method returns true if the given format string should be suppressed if
  *  it exceeds the spam suppression threshold.  This is used to set the
@@ -541,21 +671,11 @@ void SimpleLoggerMessageForwarder::parseAndSend( ForwardingStringHandler * pHand
 	int componentPriority, int messagePriority, va_list argPtr )
 {
 	MemoryOStream os;
-	LoggerMessageHeader hdr;
-
-	hdr.componentPriority_ = componentPriority;
-	hdr.messagePriority_ = messagePriority;
-
-	os << (int)MESSAGE_LOGGER_MSG <<
-		hdr.componentPriority_ << hdr.messagePriority_ << pHandler->fmt();
+	this->addHeader( os, pHandler, componentPriority, messagePriority );
 
 	pHandler->parseArgs( argPtr, os );
 
-	for (Loggers::const_iterator iter = loggers_.begin();
-		 iter != loggers_.end(); ++iter)
-	{
-		endpoint_.sendto( os.data(), os.size(), iter->port, iter->ip );
-	}
+	this->sendToLoggers( os );
 }
 
 
@@ -575,6 +695,53 @@ void SimpleLoggerMessageForwarder::parseAndSend( ForwardingStringHandler * pHand
 	va_end( argPtr );
 }
 
+
+/**
+ *  This method sends a log message whose arguments have already been packed by
+ *  ForwardingStringHandler::parseArgs.
+ */
+void SimpleLoggerMessageForwarder::sendParsed(
+	ForwardingStringHandler * pHandler,
+	int componentPriority, int messagePriority, const std::string & args )
+{
+	MemoryOStream os;
+	this->addHeader( os, pHandler, componentPriority, messagePriority );
+
+	os.addBlob( args.data(), args.size() );
+
+	this->sendToLoggers( os );
+}
+
+
+/**
+ *  This method adds the part of a log message that comes before its arguments.
+ */
+void SimpleLoggerMessageForwarder::addHeader( MemoryOStream & os,
+	ForwardingStringHandler * pHandler,
+	int componentPriority, int messagePriority ) const
+{
+	LoggerMessageHeader hdr;
+
+	hdr.componentPriority_ = componentPriority;
+	hdr.messagePriority_ = messagePriority;
+
+	os << (int)MESSAGE_LOGGER_MSG <<
+		hdr.componentPriority_ << hdr.messagePriority_ << pHandler->fmt();
+}
+
+
+/**
+ *  This method sends an assembled log message to all known loggers.
+ */
+void SimpleLoggerMessageForwarder::sendToLoggers( MemoryOStream & os )
+{
+	for (Loggers::const_iterator iter = loggers_.begin();
+		 iter != loggers_.end(); ++iter)
+	{
+		endpoint_.sendto( os.data(), os.size(), iter->port, iter->ip );
+	}
+}
+
 #ifdef MF_SERVER
 
 // -----------------------------------------------------------------------------
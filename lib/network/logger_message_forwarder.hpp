@@ -17,6 +17,8 @@ criminal penalties as provided by law.
 
 #include "cstdmf/singleton.hpp"
 
+#include "cstdmf/mpsc_queue.hpp"
+
 #include "network/channel.hpp"
 #include "network/endpoint.hpp"
 #include "network/forwarding_string_handler.hpp"
@@ -133,6 +135,13 @@ protected:
 	void parseAndSend( ForwardingStringHandler * pHandler,
 		int componentPriority, int messagePriority, ... );
 
+	void sendParsed( ForwardingStringHandler * pHandler,
+		int componentPriority, int messagePriority, const std::string & args );
+
+	void addHeader( MemoryOStream & os, ForwardingStringHandler * pHandler,
+		int componentPriority, int messagePriority ) const;
+	void sendToLoggers( MemoryOStream & os );
+
 	typedef std::vector< Mercury::Address > Loggers;
 	Loggers loggers_;
 
@@ -209,6 +218,12 @@ private:
 
 	void updateSuppressionPatterns();
 
+	bool addRecentCall( ForwardingStringHandler * pHandler );
+
+	void queueMessage( int componentPriority, int messagePriority,
+		const char * format, va_list argPtr );
+	void sendQueuedMessages();
+
 	/// The dispatcher we register a timer with for managing spam suppression.
 	Mercury::EventDispatcher & dispatcher_;
 
@@ -230,6 +245,32 @@ private:
 	/// handleTimeout() was called.
 	typedef std::vector< ForwardingStringHandler* > RecentlyUsedHandlers;
 	RecentlyUsedHandlers recentlyUsedHandlers_;
+
+	/**
+	 *	This structure is a message logged by a thread other than the main
+	 *	thread. Its arguments are packed by that thread and it is sent by the
+	 *	main thread with its format string, as other messages are.
+	 */
+	struct QueuedMessage
+	{
+		uint8 componentPriority_;
+		uint8 messagePriority_;
+		std::string format_;
+		std::string args_;
+	};
+
+	/// Messages from other threads that are waiting to be sent.
+	MPSCQueue< QueuedMessage > queuedMessages_;
+
+	/// The number of messages from other threads that were dropped because
+	/// the queue was full.
+	volatile uint32 numDroppedMessages_;
+
+	/// The timer handle for sending messages from other threads.
+	TimerHandle flushTimerHandle_;
+
+	/// The forwarding string handler that is used to report dropped messages.
+	ForwardingStringHandler droppedHandler_;
 };
 
 
@@ -30,8 +30,10 @@ criminal penalties as provided by law.
 #include "once_off_packet.hpp"
 #include "packet_monitor.hpp"
 #include "packet_receiver.hpp"
+#include "packet_send_queue.hpp"
 #include "request_manager.hpp"
 #include "rescheduled_sender.hpp"
+#include "sharded_packet_receiver.hpp"
 
 
 #ifdef PLAYSTATION3
@@ -67,6 +69,7 @@ NetworkInterface::NetworkInterface( Mercury::EventDispatcher * pMainDispatcher,
 	socket_(),
 	address_( Address::NONE ),
 	pPacketReceiver_( NULL ),
+	pShardedReceiver_( NULL ),
 	recentlyDeadChannels_(),
 	channelMap_(),
 	pIrregularChannels_( new IrregularChannels() ),
@@ -86,14 +89,18 @@ NetworkInterface::NetworkInterface( Mercury::EventDispatcher * pMainDispatcher,
 	pExtensionData_( NULL ),
 	pOnceOffSender_( new OnceOffSender() ),
 	pPacketMonitor_( NULL ),
+	pSendQueue_( NULL ),
 	dropNextSend_( false ),
 	artificialDropPerMillion_( 0 ),
 	artificialLatencyMin_( 0 ),
 	artificialLatencyMax_( 0 ),
 	shouldUseChecksums_( false ),
+	congestionControl_(),
 	sendingStats_()
 {
 	pPacketReceiver_ = new PacketReceiver( socket_, *this );
+	pShardedReceiver_ = new ShardedPacketReceiver( *this, *pPacketReceiver_ );
+	pSendQueue_ = new PacketSendQueue( *this );
 
 	// This registers the file descriptor and so needs to be done after
 	// initialising fdReadSet_ etc.
@@ -123,6 +130,7 @@ void NetworkInterface::attach( EventDispatcher & mainDispatcher )
 
 	pDelayedChannels_->init( this->mainDispatcher() );
 	sendingStats_.init( this->mainDispatcher() );
+	pSendQueue_->init( this->mainDispatcher() );
 }
 
 
@@ -161,12 +169,20 @@ NetworkInterface::~NetworkInterface()
 	// This cancels outstanding requests. Need to make sure no more are added.
 	this->finaliseRequestManager();
 
-	// Delete any channels this owns.
-	ChannelMap::iterator iter = channelMap_.begin();
-	while (iter != channelMap_.end())
+	// Delete any channels this owns. Destroying a channel deregisters it, so
+	// the channels are copied out of the map first.
+	std::vector< Channel * > channels;
+	channels.reserve( channelMap_.size() );
+
+	for (ChannelMap::iterator iter = channelMap_.begin();
+			iter != channelMap_.end(); ++iter)
+	{
+		channels.push_back( iter->second );
+	}
+
+	for (size_t i = 0; i < channels.size(); ++i)
 	{
-		ChannelMap::iterator oldIter = iter++;
-		Channel * pChannel = oldIter->second;
+		Channel * pChannel = channels[i];
 
 		if (pChannel->isOwnedByInterface())
 		{
@@ -202,9 +218,15 @@ NetworkInterface::~NetworkInterface()
 	delete pInterfaceTable_;
 	pInterfaceTable_ = NULL;
 
+	delete pShardedReceiver_;
+	pShardedReceiver_ = NULL;
+
 	delete pPacketReceiver_;
 	pPacketReceiver_ = NULL;
 
+	delete pSendQueue_;
+	pSendQueue_ = NULL;
+
 	delete pDispatcher_;
 	pDispatcher_ = NULL;
 }
@@ -217,6 +239,7 @@ void NetworkInterface::detach()
 {
 	if (pMainDispatcher_ != NULL )
 	{
+		pSendQueue_->fini();
 		sendingStats_.fini();
 		pDelayedChannels_->fini( this->mainDispatcher() );
 
@@ -299,6 +322,8 @@ void NetworkInterface::closeSocket()
 	// first unregister any existing interfaces.
 	if (socket_.good())
 	{
+		pShardedReceiver_->fini();
+
 		this->interfaceTable().deregisterWithMachined( this->address() );
 
 		this->dispatcher().deregisterFileDescriptor( socket_ );
@@ -320,6 +345,9 @@ void NetworkInterface::closeSocket()
 bool NetworkInterface::recreateListeningSocket( uint16 listeningPort,
 	const char * listeningInterface )
 {
+	// The receive threads are restarted on the new socket.
+	int numReceiveShards = pShardedReceiver_->numShards();
+
 	this->closeSocket();
 
 
@@ -341,7 +369,11 @@ bool NetworkInterface::recreateListeningSocket( uint16 listeningPort,
 		return false;
 	}
 
-	this->dispatcher().registerFileDescriptor( socket_, pPacketReceiver_ );
+	// The receiver drains the socket on each notification, so it only needs
+	// to be told when new packets arrive.
+	pPacketReceiver_->isEdgeTriggered( true );
+	this->dispatcher().registerFileDescriptor( socket_, pPacketReceiver_,
+		/* isEdgeTriggered: */ true );
 
 	// ask endpoint to parse the interface specification into a name
 	char ifname[IFNAMSIZ];
@@ -440,6 +472,11 @@ bool NetworkInterface::recreateListeningSocket( uint16 listeningPort,
 
 	this->interfaceTable().registerWithMachined( this->address() );
 
+	if (numReceiveShards > 0)
+	{
+		this->setNumReceiveShards( numReceiveShards );
+	}
+
 	return true;
 }
 
@@ -475,10 +512,25 @@ bool NetworkInterface::registerChannel( Channel & channel )
 
 	channelMap_[ channel.addr() ] = &channel;
 
+	this->onChannelFilterChanged( channel );
+
 	return true;
 }
 
 
+/**
+ *	This method is called when the filter of a channel registered with this
+ *	interface may have changed. The receive threads need to know about it.
+ */
+void NetworkInterface::onChannelFilterChanged( Channel & channel )
+{
+	if (pShardedReceiver_->numShards() > 0)
+	{
+		pShardedReceiver_->setFilter( channel.addr(), channel.pFilter() );
+	}
+}
+
+
 /**
  *	This method deregisters a channel that has been previously registered with
  *	this interface.
@@ -496,9 +548,14 @@ bool NetworkInterface::deregisterChannel( Channel & channel )
 		return false;
 	}
 
+	if (pShardedReceiver_->numShards() > 0)
+	{
+		pShardedReceiver_->setFilter( addr, NULL );
+	}
+
 	if (channel.isExternal() && pMainDispatcher_)
 	{
-		RecentlyDeadChannels::iterator iter = recentlyDeadChannels_.begin();
+		RecentlyDeadChannels::iterator iter = recentlyDeadChannels_.find( addr );
 
 		if (iter != recentlyDeadChannels_.end())
 		{
@@ -1204,6 +1261,13 @@ void NetworkInterface::sendRescheduledPacket( const Address & address,
 Reason NetworkInterface::basicSendWithRetries( const Address & addr,
 		Packet * pPacket )
 {
+	// When batching, the packet is sent when the send queue is next flushed.
+	if (pSendQueue_->shouldQueue())
+	{
+		pSendQueue_->add( addr, pPacket );
+		return REASON_SUCCESS;
+	}
+
 	// try sending a few times
 	int retries = 0;
 	Reason reason;
@@ -1460,6 +1524,82 @@ const PacketReceiverStats & NetworkInterface::receivingStats() const
 }
 
 
+/**
+ *	This method sets the maximum number of packets that will be read from this
+ *	interface's socket with a single system call. A value of 1 reads a single
+ *	packet per call.
+ */
+void NetworkInterface::setMaxReceiveBatchSize( int size )
+{
+	pPacketReceiver_->maxBatchSize( size );
+}
+
+
+/**
+ *	This method sets the number of threads that read packets arriving at this
+ *	interface's port. Each thread has its own socket bound to the port with
+ *	SO_REUSEPORT and passes packets through their channel's filter, if it is
+ *	thread-safe, before handing them to the main thread. A value of 0 reads
+ *	only on the main thread.
+ *
+ *	@return True if the threads were started, otherwise false and only the
+ *			main thread reads the port.
+ */
+bool NetworkInterface::setNumReceiveShards( int numShards )
+{
+	pShardedReceiver_->fini();
+
+	if (numShards <= 0)
+	{
+		return true;
+	}
+
+	if (!pShardedReceiver_->init( this->dispatcher(), socket_, numShards ))
+	{
+		return false;
+	}
+
+	for (ChannelMap::iterator iter = channelMap_.begin();
+			iter != channelMap_.end(); ++iter)
+	{
+		pShardedReceiver_->setFilter( iter->first, iter->second->pFilter() );
+	}
+
+	return true;
+}
+
+
+/**
+ *	This method returns the number of threads reading packets arriving at this
+ *	interface's port, in addition to the main thread.
+ */
+int NetworkInterface::numReceiveShards() const
+{
+	return pShardedReceiver_->numShards();
+}
+
+
+/**
+ *	This method sets whether packets sent by this interface are collected and
+ *	sent together, with as few system calls as possible, once per iteration of
+ *	the main dispatcher.
+ */
+void NetworkInterface::shouldBatchSends( bool value )
+{
+	pSendQueue_->isEnabled( value );
+}
+
+
+/**
+ *	This method returns whether packets sent by this interface are collected
+ *	and sent together once per iteration of the main dispatcher.
+ */
+bool NetworkInterface::shouldBatchSends() const
+{
+	return pSendQueue_->isEnabled();
+}
+
+
 #if ENABLE_WATCHERS
 /**
  *	This method returns a watcher that can inspect a NetworkInterface.
@@ -1501,9 +1641,17 @@ WatcherPtr NetworkInterface::pWatcher()
 			new BaseDereferenceWatcher( PacketReceiver::pWatcher() ),
 			&pNull->pPacketReceiver_ );
 
+		pWatcher->addChild( "receiveShards",
+			new BaseDereferenceWatcher( ShardedPacketReceiver::pWatcher() ),
+			&pNull->pShardedReceiver_ );
+
 		pWatcher->addChild( "sending/stats",
 				SendingStats::pWatcher(), &pNull->sendingStats_ );
 
+		pWatcher->addChild( "sending/shouldBatch",
+			makeWatcher( &NetworkInterface::shouldBatchSends,
+				&NetworkInterface::shouldBatchSends ) );
+
 		pWatcher->addChild( "timing",
 			new BaseDereferenceWatcher( EventDispatcher::pWatcher() ),
 			&pNull->pMainDispatcher_ );
@@ -19,6 +19,7 @@ criminal penalties as provided by law.
 #include "misc.hpp"
 #include "sending_stats.hpp"
 
+#include "cstdmf/hash_map.hpp"
 #include "cstdmf/timer_handler.hpp"
 
 
@@ -37,7 +38,9 @@ class KeepAliveChannels;
 class OnceOffSender;
 class PacketMonitor;
 class PacketReceiverStats;
+class PacketSendQueue;
 class RequestManager;
+class ShardedPacketReceiver;
 
 enum NetworkInterfaceType
 {
@@ -79,6 +82,8 @@ public:
 	bool registerChannel( Channel & channel );
 	bool deregisterChannel( Channel & channel );
 
+	void onChannelFilterChanged( Channel & channel );
+
 	void onAddressDead( const Address & addr );
 
 	bool isDead( const Address & addr ) const;
@@ -142,6 +147,7 @@ public:
 
 	const PacketReceiverStats & receivingStats() const;
 	const SendingStats & sendingStats() const	{ return sendingStats_; }
+	SendingStats & sendingStats()				{ return sendingStats_; }
 
 	ChannelTimeOutHandler * pChannelTimeOutHandler() const
 		{ return pChannelTimeOutHandler_; }
@@ -169,11 +175,26 @@ public:
 	void shouldUseChecksums( bool b )	{ shouldUseChecksums_ = b; } 
 	bool shouldUseChecksums() const		{ return shouldUseChecksums_; }
 
+	void shouldBatchSends( bool value );
+	bool shouldBatchSends() const;
+
 	const char * c_str() const { return socket_.c_str(); }
 
 	void setLatency( float latencyMin, float latencyMax );
 	void setLossRatio( float lossRatio );
 
+	/// The name of the congestion control policy that external channels
+	/// created on this interface use. See CongestionController::create.
+	const std::string & congestionControl() const
+		{ return congestionControl_; }
+	void congestionControl( const std::string & name )
+		{ congestionControl_ = name; }
+
+	void setMaxReceiveBatchSize( int size );
+
+	bool setNumReceiveShards( int numShards );
+	int numReceiveShards() const;
+
 	// This property is so that data can be associated with a interface. Message
 	// handlers get access to the interface that received the message and can 
 	// get access to this data. Bots use this so that they know which
@@ -242,6 +263,9 @@ private:
 
 	PacketReceiver * pPacketReceiver_;
 
+	/// Reads this interface's port with receive threads, when enabled.
+	ShardedPacketReceiver * pShardedReceiver_;
+
 	/// External interfaces remember recently deregistered channels for a little
 	// while and drop incoming packets from those addresses.  This is to avoid
 	/// processing packets from recently disconnected clients, especially ones
@@ -251,10 +275,10 @@ private:
 	///
 	/// The mapping is addresses of recently deregistered channels, mapped to
 	/// the timer ID for when they will time out.
-	typedef std::map< Address, TimerHandle > RecentlyDeadChannels;
+	typedef HashMap< Address, TimerHandle > RecentlyDeadChannels;
 	RecentlyDeadChannels recentlyDeadChannels_;
 
-	typedef std::map< Address, Channel * >	ChannelMap;
+	typedef HashMap< Address, Channel * >	ChannelMap;
 	ChannelMap					channelMap_;
 
 	IrregularChannels * pIrregularChannels_;
@@ -291,6 +315,10 @@ private:
 
 	PacketMonitor *				pPacketMonitor_;
 
+	/// Packets sent during a dispatcher iteration are collected here when
+	/// batched sends are enabled.
+	PacketSendQueue *			pSendQueue_;
+
 	/// State flag used in debugging to indicate that the next outgoing packet
 	/// should be dropped
 	bool	dropNextSend_;
@@ -305,6 +333,8 @@ private:
 
 	bool shouldUseChecksums_;
 
+	std::string congestionControl_;
+
 	SendingStats	sendingStats_;
 };
 
@@ -16,6 +16,7 @@ criminal penalties as provided by law.
 
 #include "cstdmf/binary_stream.hpp"
 #include "cstdmf/concurrency.hpp"
+#include "cstdmf/pool_allocator.hpp"
 
 DECLARE_DEBUG_COMPONENT2( "Network", 0 );
 
@@ -33,6 +34,70 @@ namespace Mercury
 const int Packet::MAX_SIZE = PACKET_MAX_SIZE;
 
 
+namespace
+{
+
+typedef PoolAllocator< SimpleMutex > PacketAllocator;
+
+/**
+ *	This function returns the pool that packets are allocated from. The pool is
+ *	never destroyed so that packets that are released during static
+ *	destruction are still returned to a valid pool.
+ */
+PacketAllocator & packetAllocator()
+{
+	static PacketAllocator * s_pAllocator =
+		new PacketAllocator( sizeof( Packet ), "network/packetPool" );
+
+	return *s_pAllocator;
+}
+
+/// The packets cached for the current thread, if enabled.
+THREADLOCAL( PacketAllocator::ThreadCache ) s_threadCache;
+
+} // anonymous namespace
+
+
+/**
+ *	This method allocates memory for a packet from the packet pool.
+ */
+void * Packet::operator new( size_t size )
+{
+	return packetAllocator().allocate( size, s_threadCache );
+}
+
+
+/**
+ *	This method returns the memory for a packet to the packet pool.
+ */
+void Packet::operator delete( void * pInstance )
+{
+	packetAllocator().deallocate( pInstance, s_threadCache );
+}
+
+
+/**
+ *	This method makes the calling thread keep a small cache of free packets,
+ *	so that it rarely needs to lock the packet pool. It is intended for
+ *	background threads that create many packets. Each thread that calls this
+ *	must call disableThreadCache() before it exits.
+ */
+void Packet::enableThreadCache()
+{
+	packetAllocator().enableCache( s_threadCache );
+}
+
+
+/**
+ *	This method returns the calling thread's cached packets to the packet pool
+ *	and stops caching packets for this thread.
+ */
+void Packet::disableThreadCache()
+{
+	packetAllocator().disableCache( s_threadCache );
+}
+
+
 /**
  *  Constructor.
  */
@@ -79,12 +79,17 @@ public:
 		FLAG_HAS_CHECKSUM			= 0x0100,
 		FLAG_CREATE_CHANNEL			= 0x0200,
 		FLAG_HAS_CUMULATIVE_ACK		= 0x0400,
-		KNOWN_FLAGS					= 0x07FF
+		FLAG_HAS_SELECTIVE_ACKS		= 0x0800,
+		KNOWN_FLAGS					= 0x0FFF
 	};
 
 	/// The type of the ACK counter in the packet footers.
 	typedef uint8 AckCount;
 
+	/// The type of the selective ACK footer. Bit i acknowledges the packet
+	/// i + 1 after the cumulative ACK.
+	typedef uint32 AckBitmap;
+
 	/// The type of offsets relative to the start of the packet data.
 	typedef uint16 Offset;
 
@@ -105,6 +110,10 @@ public:
 	/// The maximum number of ACKs that can fit on a single packet.
 	static const int MAX_ACKS = (1 << (8 * sizeof( AckCount ))) - 1;
 
+	/// The number of packets that can be acknowledged by a selective ACK
+	/// footer.
+	static const int ACKS_PER_BITMAP = 8 * sizeof( AckBitmap );
+
 	/// The amount of space that is reserved for fixed-length footers on a
 	/// packet.  This is done so that the bundle logic can always assume that
 	/// these footers will fit and not have to worry about pre-allocating them.
@@ -275,6 +284,16 @@ public:
 
 	int recvFromEndpoint( Endpoint & ep, Address & addr );
 
+	/**
+	 *	This method returns the number of bytes of data_ that a received
+	 *	datagram may occupy. It is used when receiving into this packet
+	 *	directly, rather than through recvFromEndpoint().
+	 */
+	static int receiveBufferSize()
+	{
+		return MAX_SIZE;
+	}
+
 	// -------------------------------------------------------------------------
 	// Section: Static methods
 	// -------------------------------------------------------------------------
@@ -309,6 +328,16 @@ public:
 
 	void debugDump() const;
 
+	// -------------------------------------------------------------------------
+	// Section: Allocation
+	// -------------------------------------------------------------------------
+
+	static void * operator new( size_t size );
+	static void operator delete( void * pInstance );
+
+	static void enableThreadCache();
+	static void disableThreadCache();
+
 	// -------------------------------------------------------------------------
 	// Section: Fields
 	// -------------------------------------------------------------------------
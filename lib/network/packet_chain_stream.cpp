@@ -0,0 +1,180 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "packet_chain_stream.hpp"
+
+#include "packet.hpp"
+
+DECLARE_DEBUG_COMPONENT2( "Network", 0 )
+
+
+namespace Mercury
+{
+
+/**
+ *	Constructor.
+ *
+ *	@param pPacket	The packet containing the start of the message data.
+ *	@param offset	The offset of the message data in pPacket. This may be the
+ *					end of pPacket's data if the message data starts on the
+ *					next packet.
+ *	@param length	The length of the message data.
+ *
+ *	If the chain does not contain enough data for the message, the stream is
+ *	empty and its error flag is set.
+ */
+PacketChainIStream::PacketChainIStream( Packet * pPacket, int offset,
+		int length ) :
+	BinaryIStream(),
+	pPacket_( pPacket ),
+	pCurr_( pPacket->data() + offset ),
+	pEnd_( pCurr_ ),
+	remainingLength_( length ),
+	spansPackets_( offset + length > pPacket->msgEndOffset() ),
+	numBytesCopied_( 0 ),
+	buffers_()
+{
+	// Check that the chain is long enough for the message.
+	int available = pPacket->msgEndOffset() - offset;
+
+	for (const Packet * p = pPacket->next();
+			(available < length) && (p != NULL);
+			p = p->next())
+	{
+		available += p->bodySize();
+	}
+
+	if (available < length)
+	{
+		DEBUG_MSG( "PacketChainIStream::PacketChainIStream: "
+				"Run out of packets after %d of %d bytes\n",
+			available, length );
+
+		remainingLength_ = 0;
+		error_ = true;
+		return;
+	}
+
+	pEnd_ = pCurr_ + std::min( length, pPacket->msgEndOffset() - offset );
+}
+
+
+/**
+ *	Destructor.
+ */
+PacketChainIStream::~PacketChainIStream()
+{
+	for (uint i = 0; i < buffers_.size(); ++i)
+	{
+		delete [] buffers_[i];
+	}
+}
+
+
+/**
+ *	This method moves on to the next packet in the chain that has data.
+ */
+void PacketChainIStream::nextPacket()
+{
+	while ((pCurr_ == pEnd_) && (remainingLength_ > 0))
+	{
+		pPacket_ = pPacket_->next();
+		MF_ASSERT( pPacket_ != NULL ); // Checked in the constructor.
+
+		pCurr_ = pPacket_->body();
+		pEnd_ = pCurr_ + std::min( remainingLength_, pPacket_->bodySize() );
+	}
+}
+
+
+/**
+ *	This method retrieves the given number of bytes from this stream. If they
+ *	are all on the current packet, a pointer into the packet is returned.
+ *	Otherwise, they are copied into a buffer owned by this stream.
+ */
+const void * PacketChainIStream::retrieve( int nBytes )
+{
+	// As with MemoryIStream, reading past the end is not fatal.
+	if (nBytes > remainingLength_)
+	{
+		this->finish();
+		error_ = true;
+		return nBytes <= int( sizeof( errBuf ) ) ? errBuf : NULL;
+	}
+
+	this->nextPacket();
+
+	if (pCurr_ + nBytes <= pEnd_)
+	{
+		const char * pOldRead = pCurr_;
+		pCurr_ += nBytes;
+		remainingLength_ -= nBytes;
+
+		return pOldRead;
+	}
+
+	// The data straddles packets.
+	char * pBuffer = new char[ nBytes ];
+	buffers_.push_back( pBuffer );
+
+	int numCopied = 0;
+
+	while (numCopied < nBytes)
+	{
+		this->nextPacket();
+
+		int numToCopy = std::min( nBytes - numCopied, int( pEnd_ - pCurr_ ) );
+		memcpy( pBuffer + numCopied, pCurr_, numToCopy );
+
+		pCurr_ += numToCopy;
+		remainingLength_ -= numToCopy;
+		numCopied += numToCopy;
+	}
+
+	numBytesCopied_ += nBytes;
+
+	return pBuffer;
+}
+
+
+/**
+ *	This method returns the next character to be read without removing it from
+ *	the stream.
+ */
+char PacketChainIStream::peek()
+{
+	if (remainingLength_ <= 0)
+	{
+		error_ = true;
+		return -1;
+	}
+
+	this->nextPacket();
+
+	return *pCurr_;
+}
+
+
+/**
+ *	This method skips the rest of the data on this stream.
+ */
+void PacketChainIStream::finish()
+{
+	pCurr_ = pEnd_;
+	remainingLength_ = 0;
+}
+
+} // namespace Mercury
+
+// packet_chain_stream.cpp
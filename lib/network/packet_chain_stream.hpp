@@ -0,0 +1,72 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#ifndef PACKET_CHAIN_STREAM_HPP
+#define PACKET_CHAIN_STREAM_HPP
+
+#include "cstdmf/binary_stream.hpp"
+
+#include <vector>
+
+namespace Mercury
+{
+
+class Packet;
+
+/**
+ *	This class is used to read a message whose data may be spread across a
+ *	chain of packets. Data is read directly from the packets. It is only copied
+ *	when a single call to retrieve() asks for data that straddles a packet
+ *	boundary, and then only the bytes for that call are copied.
+ */
+class PacketChainIStream : public BinaryIStream
+{
+public:
+	PacketChainIStream( Packet * pPacket, int offset, int length );
+	virtual ~PacketChainIStream();
+
+	virtual const void * retrieve( int nBytes );
+	virtual int remainingLength() const		{ return remainingLength_; }
+	virtual char peek();
+	virtual void finish();
+
+	/// This method returns whether the message spans more than one packet.
+	bool spansPackets() const				{ return spansPackets_; }
+
+	/// This method returns the number of bytes that have been copied into
+	/// temporary buffers by retrieve().
+	int numBytesCopied() const				{ return numBytesCopied_; }
+
+private:
+	PacketChainIStream( const PacketChainIStream & );
+	PacketChainIStream & operator=( const PacketChainIStream & );
+
+	void nextPacket();
+
+	Packet * pPacket_;
+
+	const char * pCurr_;
+	const char * pEnd_;
+
+	int remainingLength_;
+	bool spansPackets_;
+	int numBytesCopied_;
+
+	/// Buffers holding data that straddled packets. These are kept until this
+	/// stream is destroyed, since callers may hold on to the pointers returned
+	/// by retrieve().
+	std::vector< char * > buffers_;
+};
+
+} // namespace Mercury
+
+#endif // PACKET_CHAIN_STREAM_HPP
@@ -63,6 +63,23 @@ public:
 	 *	to leave at least that much room.
 	 */
 	virtual int maxSpareSize() { return 0; }
+
+	/**
+	 *	Return whether preprocessRecv() may be called on this filter from a
+	 *	receive thread. Such filters must not change any state after they
+	 *	are constructed.
+	 */
+	virtual bool isThreadSafe() const { return false; }
+
+	/**
+	 *  This method is called instead of recv() when the packet was read by
+	 *	one of the interface's receive threads and this filter is thread-safe.
+	 *	It is called on the receive thread and should transform the packet in
+	 *	place. The packet is then processed on the main thread as if it had
+	 *	been passed to the base class recv().
+	 */
+	virtual Reason preprocessRecv( const Address & addr, Packet * pPacket )
+		{ return REASON_SUCCESS; }
 };
 
 typedef SmartPointer< PacketFilter > PacketFilterPtr;
@@ -38,7 +38,9 @@ PacketReceiver::PacketReceiver( Endpoint & socket,
 	networkInterface_( networkInterface ),
 	pNextPacket_( new Packet() ),
 	stats_(),
-	onceOffReceiver_()
+	onceOffReceiver_(),
+	maxBatchSize_( 1 ),
+	isEdgeTriggered_( false )
 {
 	onceOffReceiver_.init( this->dispatcher() );
 }
@@ -54,10 +56,26 @@ PacketReceiver::~PacketReceiver()
 
 
 /**
- *	This method is called when their is data on the socket.
+ *	This method is called when their is data on the socket. It reads from the
+ *	socket until it would block.
  */
 int PacketReceiver::handleInputNotification( int fd )
 {
+#ifdef ENDPOINT_HAS_RECVMMSG
+	if (maxBatchSize_ > 1)
+	{
+		if (this->processSocketBatch( /*expectingPacket:*/true ))
+		{
+			while (this->processSocketBatch( /*expectingPacket:*/false ))
+			{
+				/* pass */;
+			}
+		}
+
+		return 0;
+	}
+#endif // ENDPOINT_HAS_RECVMMSG
+
 	if (this->processSocket( /*expectingPacket:*/true ))
 	{
 		while (this->processSocket( /*expectingPacket:*/false ))
@@ -108,6 +126,120 @@ bool PacketReceiver::processSocket( bool expectingPacket )
 }
 
 
+/**
+ *	This method reads up to maxBatchSize_ packets from this object's socket
+ *	with a single system call and then processes them in the order that they
+ *	were received.
+ *
+ *	@return True if there may be more data pending on the socket.
+ */
+bool PacketReceiver::processSocketBatch( bool expectingPacket )
+{
+#ifdef ENDPOINT_HAS_RECVMMSG
+	stats_.updateSocketStats( socket_ );
+
+	// Used to collect stats
+	ProcessSocketStatsHelper statsHelper( stats_ );
+
+	const int batchSize = maxBatchSize_;
+
+	for (int i = 0; i < batchSize; ++i)
+	{
+		if (!batchPackets_[i])
+		{
+			batchPackets_[i] = new Packet();
+		}
+
+		batchBuffers_[i].iov_base = batchPackets_[i]->data();
+		batchBuffers_[i].iov_len = Packet::receiveBufferSize();
+
+		msghdr & header = batchHeaders_[i].msg_hdr;
+		header.msg_name = &batchAddresses_[i];
+		header.msg_namelen = sizeof( batchAddresses_[i] );
+		header.msg_iov = &batchBuffers_[i];
+		header.msg_iovlen = 1;
+		header.msg_control = NULL;
+		header.msg_controllen = 0;
+		header.msg_flags = 0;
+		batchHeaders_[i].msg_len = 0;
+	}
+
+	int numPackets = socket_.recvmmsg( batchHeaders_, batchSize );
+
+	if (numPackets <= 0)
+	{
+		statsHelper.socketBatchReadFinished( 0, 0 );
+
+		// recvmmsg() never returns 0, but treat it like an empty recvfrom().
+		return this->checkSocketErrors( numPackets, expectingPacket );
+	}
+
+	int numBytes = 0;
+
+	for (int i = 0; i < numPackets; ++i)
+	{
+		numBytes += batchHeaders_[i].msg_len;
+	}
+
+	statsHelper.socketBatchReadFinished( numPackets, numBytes );
+
+	for (int i = 0; i < numPackets; ++i)
+	{
+		int len = batchHeaders_[i].msg_len;
+
+		if (len == 0)
+		{
+			this->checkSocketErrors( len, expectingPacket );
+			continue;
+		}
+
+		Address srcAddr( batchAddresses_[i].sin_addr.s_addr,
+				batchAddresses_[i].sin_port );
+
+		// The handler may keep a reference to the packet, so the slot gets a
+		// new one for the next read.
+		PacketPtr curPacket = batchPackets_[i];
+		batchPackets_[i] = NULL;
+		curPacket->msgEndOffset( len );
+
+		Reason ret = this->processPacket( srcAddr, curPacket.get(),
+				&statsHelper );
+
+		if ((ret != REASON_SUCCESS) &&
+				networkInterface_.isVerbose())
+		{
+			this->dispatcher().errorReporter().reportException( ret, srcAddr );
+		}
+	}
+
+	// A short read normally means that the socket has been drained. An
+	// edge-triggered socket is not notified again for data that is already
+	// queued, so keep reading until it would block.
+	return (numPackets == batchSize) || isEdgeTriggered_;
+#else
+	return this->processSocket( expectingPacket );
+#endif // ENDPOINT_HAS_RECVMMSG
+}
+
+
+/**
+ *	This method sets the maximum number of packets to read from the socket in
+ *	a single system call. A size of 1 disables batched receives.
+ */
+void PacketReceiver::maxBatchSize( int size )
+{
+#ifdef ENDPOINT_HAS_RECVMMSG
+	maxBatchSize_ = std::max( 1, std::min( size, int( MAX_BATCH_SIZE ) ) );
+#else
+	if (size > 1)
+	{
+		WARNING_MSG( "PacketReceiver::maxBatchSize: "
+				"Batched receives are not supported on this platform\n" );
+	}
+#endif // ENDPOINT_HAS_RECVMMSG
+}
+
+
 /**
  *	This method checks whether an error was received from a call to
  */
@@ -260,6 +392,62 @@ Reason PacketReceiver::processPacket( const Address & addr, Packet * p,
 }
 
 
+/**
+ *	This method processes a packet that was read by one of the interface's
+ *	receive threads.
+ *
+ *	@param addr				The address that the packet is from.
+ *	@param p				The packet.
+ *	@param pFilter			The filter whose preprocessRecv() the receive
+ *							thread passed the packet through, or NULL if the
+ *							packet has not been filtered.
+ *	@param preprocessReason	The result of preprocessRecv().
+ *	@param pStatsHelper		Used to collect statistics.
+ */
+Reason PacketReceiver::processPreprocessedPacket( const Address & addr,
+		Packet * p, PacketFilter * pFilter, Reason preprocessReason,
+		ProcessSocketStatsHelper * pStatsHelper )
+{
+	if (pFilter == NULL)
+	{
+		return this->processPacket( addr, p, pStatsHelper );
+	}
+
+	Channel * pChannel = networkInterface_.findChannel( addr );
+
+	// The channel's filter may have changed since the packet was read. If so,
+	// the packet has been through the wrong filter and can only be dropped.
+	// Reliable data will be resent.
+	if ((pChannel == NULL) ||
+			(pChannel->pFilter().get() != pFilter) ||
+			pChannel->hasRemoteFailed())
+	{
+		if (networkInterface_.isVerbose())
+		{
+			DEBUG_MSG( "PacketReceiver::processPreprocessedPacket( %s ): "
+				"Dropping packet filtered for a previous channel\n",
+				addr.c_str() );
+		}
+
+		return REASON_SUCCESS;
+	}
+
+	pChannel->onPacketReceived( p->totalSize() );
+
+	if (preprocessReason == REASON_CORRUPTED_PACKET)
+	{
+		stats_.incCorruptedPackets();
+	}
+
+	if (preprocessReason != REASON_SUCCESS)
+	{
+		return preprocessReason;
+	}
+
+	return this->processFilteredPacket( addr, p, pStatsHelper );
+}
+
+
 /**
  *  This macro is used by PacketReceiver::processFilteredPacket() and
  *  PacketReceiver::processOrderedPacket() whenever they need to return early
@@ -497,6 +685,31 @@ Reason PacketReceiver::processFilteredPacket( const Address & addr,
 		{
 			RETURN_FOR_CORRUPTED_PACKET();
 		}
+
+		if (p->hasFlags( Packet::FLAG_HAS_SELECTIVE_ACKS ))
+		{
+			Packet::AckBitmap bitmap;
+
+			if (!p->stripFooter( bitmap ))
+			{
+				WARNING_MSG( "PacketReceiver::processFilteredPacket( %s ): "
+						"Not enough data for selective acks.\n",
+					pChannel->c_str() );
+				RETURN_FOR_CORRUPTED_PACKET();
+			}
+
+			if (!pChannel->handleSelectiveAcks( endSeq, bitmap ))
+			{
+				RETURN_FOR_CORRUPTED_PACKET();
+			}
+		}
+	}
+	else if (p->hasFlags( Packet::FLAG_HAS_SELECTIVE_ACKS ))
+	{
+		WARNING_MSG( "PacketReceiver::processFilteredPacket( %s ): "
+				"Selective acks without a cumulative ack.\n",
+			addr.c_str() );
+		RETURN_FOR_CORRUPTED_PACKET();
 	}
 
 	// Strip and handle ACKs
@@ -992,6 +1205,10 @@ WatcherPtr PacketReceiver::pWatcher()
 	pWatcher->addChild( "stats",
 			PacketReceiverStats::pWatcher(), &pNull->stats_ );
 
+	pWatcher->addChild( "maxBatchSize",
+			makeWatcher( &PacketReceiver::maxBatchSize,
+				&PacketReceiver::maxBatchSize ) );
+
 	return pWatcher;
 }
 #endif
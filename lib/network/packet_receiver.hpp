@@ -14,6 +14,7 @@ criminal penalties as provided by law.
 
 #include "interfaces.hpp"
 
+#include "endpoint.hpp"
 #include "fragmented_bundle.hpp"
 #include "once_off_packet.hpp"
 #include "packet.hpp"
@@ -25,6 +26,7 @@ namespace Mercury
 class Channel;
 class EventDispatcher;
 class NetworkInterface;
+class PacketFilter;
 class ProcessSocketStatsHelper;
 
 /**
@@ -34,6 +36,10 @@ class ProcessSocketStatsHelper;
 class PacketReceiver : public InputNotificationHandler
 {
 public:
+	/// The maximum number of packets that can be read by a single batched
+	/// receive.
+	static const int MAX_BATCH_SIZE = 64;
+
 	PacketReceiver( Endpoint & socket, NetworkInterface & networkInterface );
 	~PacketReceiver();
 
@@ -41,9 +47,18 @@ public:
 			ProcessSocketStatsHelper * pStatsHelper );
 	Reason processFilteredPacket( const Address & addr, Packet * p,
 			ProcessSocketStatsHelper * pStatsHelper );
+	Reason processPreprocessedPacket( const Address & addr, Packet * p,
+			PacketFilter * pFilter, Reason preprocessReason,
+			ProcessSocketStatsHelper * pStatsHelper );
 
 	PacketReceiverStats & stats()		{ return stats_; }
 
+	int maxBatchSize() const			{ return maxBatchSize_; }
+	void maxBatchSize( int size );
+
+	bool isEdgeTriggered() const		{ return isEdgeTriggered_; }
+	void isEdgeTriggered( bool value )	{ isEdgeTriggered_ = value; }
+
 #if ENABLE_WATCHERS
 	static WatcherPtr pWatcher();
 #endif // ENABLE_WATCHERS
@@ -51,6 +66,7 @@ public:
 private:
 	virtual int handleInputNotification( int fd );
 	bool processSocket( bool expectingPacket );
+	bool processSocketBatch( bool expectingPacket );
 	bool checkSocketErrors( int len, bool expectingPacket );
 
 	Reason processOrderedPacket( const Address & addr, Packet * p,
@@ -69,6 +85,23 @@ private:
 	PacketPtr pNextPacket_;
 	PacketReceiverStats stats_;
 	OnceOffReceiver onceOffReceiver_;
+
+	// The maximum number of packets read per system call. A value of 1 uses
+	// the single recvfrom() path.
+	int maxBatchSize_;
+
+	// Whether the socket is registered as edge-triggered. If so, the socket
+	// must be read until it would block.
+	bool isEdgeTriggered_;
+
+#ifdef ENDPOINT_HAS_RECVMMSG
+	// The ring of packets that processSocketBatch reads into. Slots are
+	// replaced with new packets as they are dispatched.
+	PacketPtr batchPackets_[ MAX_BATCH_SIZE ];
+	struct mmsghdr batchHeaders_[ MAX_BATCH_SIZE ];
+	struct iovec batchBuffers_[ MAX_BATCH_SIZE ];
+	sockaddr_in batchAddresses_[ MAX_BATCH_SIZE ];
+#endif // ENDPOINT_HAS_RECVMMSG
 };
 
 } // namespace Mercury
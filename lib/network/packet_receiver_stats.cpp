@@ -47,6 +47,8 @@ PacketReceiverStats::PacketReceiverStats() :
 	numOverheadBytesReceived_(     pStats_ ),
 	numCorruptedPacketsReceived_(  pStats_ ),
 	numCorruptedBundlesReceived_(  pStats_ ),
+	numMultiPacketMessageBytes_(   pStats_ ),
+	numMessageBytesCopied_(        pStats_ ),
 	lastGatherTime_( 0 ),
 	lastTxQueueSize_( 0 ),
 	lastRxQueueSize_( 0 ),
@@ -165,6 +167,8 @@ WatcherPtr PacketReceiverStats::pWatcher()
 	StatWatcherCreator::addWatchers( pWatcher, "overheadBytesReceived", pNull->numOverheadBytesReceived_ );
 	StatWatcherCreator::addWatchers( pWatcher, "corruptedPacketsReceived", pNull->numCorruptedPacketsReceived_ );
 	StatWatcherCreator::addWatchers( pWatcher, "corruptedBundlesReceived", pNull->numCorruptedBundlesReceived_ );
+	StatWatcherCreator::addWatchers( pWatcher, "multiPacketMessageBytes", pNull->numMultiPacketMessageBytes_ );
+	StatWatcherCreator::addWatchers( pWatcher, "messageBytesCopied", pNull->numMessageBytesCopied_ );
 
 #ifdef unix
 	pWatcher->addChild( "socket/transmitQueue",
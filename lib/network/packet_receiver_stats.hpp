@@ -36,6 +36,8 @@ public:
 	unsigned int numMessagesReceived() const;
 	unsigned int numBytesReceived() const;
 	unsigned int numOverheadBytesReceived() const;
+	unsigned int numMultiPacketMessageBytes() const;
+	unsigned int numMessageBytesCopied() const;
 
 	double bitsPerSecond() const;
 	double packetsPerSecond() const;
@@ -74,6 +76,8 @@ private:
 	Stat numOverheadBytesReceived_;
 	Stat numCorruptedPacketsReceived_;
 	Stat numCorruptedBundlesReceived_;
+	Stat numMultiPacketMessageBytes_;
+	Stat numMessageBytesCopied_;
 
 	uint64	lastGatherTime_;
 	int		lastTxQueueSize_;
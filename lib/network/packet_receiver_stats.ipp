@@ -81,6 +81,30 @@ INLINE unsigned int PacketReceiverStats::numOverheadBytesReceived() const
 	return numOverheadBytesReceived_.total();
 }
 
+
+/**
+ *	This method returns the total number of bytes received in messages whose
+ *	data spanned more than one packet.
+ *
+ *	@return Number of bytes in multi-packet messages.
+ */
+INLINE unsigned int PacketReceiverStats::numMultiPacketMessageBytes() const
+{
+	return numMultiPacketMessageBytes_.total();
+}
+
+
+/**
+ *	This method returns the total number of message bytes that had to be copied
+ *	out of the packets they were received in before being read by handlers.
+ *
+ *	@return Number of message bytes copied.
+ */
+INLINE unsigned int PacketReceiverStats::numMessageBytesCopied() const
+{
+	return numMessageBytesCopied_.total();
+}
+
 } // namespace Mercury
 
 // packet_receiver_stats.ipp
@@ -0,0 +1,231 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "packet_send_queue.hpp"
+
+#include "endpoint.hpp"
+#include "event_dispatcher.hpp"
+#include "network_interface.hpp"
+
+DECLARE_DEBUG_COMPONENT2( "Network", 0 )
+
+
+namespace Mercury
+{
+
+/**
+ *	Constructor.
+ */
+PacketSendQueue::PacketSendQueue( NetworkInterface & networkInterface ) :
+	packets_(),
+	networkInterface_( networkInterface ),
+	pDispatcher_( NULL ),
+	isEnabled_( false ),
+	isFlushing_( false )
+{
+}
+
+
+/**
+ *	Destructor.
+ */
+PacketSendQueue::~PacketSendQueue()
+{
+	MF_ASSERT( pDispatcher_ == NULL );
+	MF_ASSERT( packets_.empty() );
+}
+
+
+/**
+ *	This method registers this queue to be flushed by the given dispatcher.
+ */
+void PacketSendQueue::init( EventDispatcher & dispatcher )
+{
+	MF_ASSERT( pDispatcher_ == NULL );
+
+	pDispatcher_ = &dispatcher;
+	pDispatcher_->addFlushTask( this );
+}
+
+
+/**
+ *	This method sends any queued packets and deregisters this queue from its
+ *	dispatcher.
+ */
+void PacketSendQueue::fini()
+{
+	this->flush();
+
+	if (pDispatcher_)
+	{
+		pDispatcher_->cancelFlushTask( this );
+		pDispatcher_ = NULL;
+	}
+}
+
+
+/**
+ *	This method sets whether packets should be queued. Any packets already
+ *	queued are sent when queueing is disabled.
+ */
+void PacketSendQueue::isEnabled( bool value )
+{
+#ifdef ENDPOINT_HAS_SENDMMSG
+	isEnabled_ = value;
+
+	if (!isEnabled_)
+	{
+		this->flush();
+	}
+#else
+	if (value)
+	{
+		WARNING_MSG( "PacketSendQueue::isEnabled: "
+				"Batched sends are not supported on this platform\n" );
+	}
+#endif // ENDPOINT_HAS_SENDMMSG
+}
+
+
+/**
+ *	This method adds a packet to be sent when this queue is next flushed.
+ */
+void PacketSendQueue::add( const Address & addr, Packet * pPacket )
+{
+	packets_.push_back( QueuedPacket() );
+
+	QueuedPacket & queuedPacket = packets_.back();
+	queuedPacket.addr_ = addr;
+	queuedPacket.pPacket_ = pPacket;
+}
+
+
+/**
+ *	This method sends all of the queued packets.
+ */
+void PacketSendQueue::flush()
+{
+	if (packets_.empty() || isFlushing_)
+	{
+		return;
+	}
+
+	isFlushing_ = true;
+
+	int numPackets = int( packets_.size() );
+	int i = 0;
+
+	while (i < numPackets)
+	{
+		i += this->sendBatch( i );
+	}
+
+	packets_.clear();
+
+	isFlushing_ = false;
+}
+
+
+/**
+ *	This method is called by the dispatcher just before it waits for network
+ *	activity.
+ */
+void PacketSendQueue::doTask()
+{
+	this->flush();
+}
+
+
+/**
+ *	This method sends as many queued packets as possible, starting at the
+ *	given index, with a single system call.
+ *
+ *	@return The number of packets that were dealt with. This is always at
+ *		least one.
+ */
+int PacketSendQueue::sendBatch( int start )
+{
+#ifdef ENDPOINT_HAS_SENDMMSG
+	const int numPackets =
+		std::min( int( packets_.size() ) - start, int( MAX_BATCH_SIZE ) );
+
+	// There is no point using sendmmsg() for a single packet.
+	if (numPackets > 1)
+	{
+		struct mmsghdr headers[ MAX_BATCH_SIZE ];
+		struct iovec buffers[ MAX_BATCH_SIZE ];
+		sockaddr_in addresses[ MAX_BATCH_SIZE ];
+
+		for (int i = 0; i < numPackets; ++i)
+		{
+			const QueuedPacket & queuedPacket = packets_[ start + i ];
+
+			addresses[i].sin_family = AF_INET;
+			addresses[i].sin_port = queuedPacket.addr_.port;
+			addresses[i].sin_addr.s_addr = queuedPacket.addr_.ip;
+
+			buffers[i].iov_base = queuedPacket.pPacket_->data();
+			buffers[i].iov_len = queuedPacket.pPacket_->totalSize();
+
+			msghdr & header = headers[i].msg_hdr;
+			header.msg_name = &addresses[i];
+			header.msg_namelen = sizeof( addresses[i] );
+			header.msg_iov = &buffers[i];
+			header.msg_iovlen = 1;
+			header.msg_control = NULL;
+			header.msg_controllen = 0;
+			header.msg_flags = 0;
+			headers[i].msg_len = 0;
+		}
+
+		SendingStats & stats = networkInterface_.sendingStats();
+
+#if ENABLE_WATCHERS
+		stats.systemTimer().start();
+#endif // ENABLE_WATCHERS
+
+		int numSent = networkInterface_.socket().sendmmsg( headers,
+				numPackets );
+
+#if ENABLE_WATCHERS
+		stats.systemTimer().stop( std::max( numSent, 0 ) );
+#endif // ENABLE_WATCHERS
+
+		if (numSent > 0)
+		{
+			int numBytes = 0;
+
+			for (int i = 0; i < numSent; ++i)
+			{
+				numBytes += headers[i].msg_len;
+			}
+
+			stats.onBatchSent( numSent, numBytes );
+
+			return numSent;
+		}
+	}
+#endif // ENDPOINT_HAS_SENDMMSG
+
+	// Let the single packet path send this packet and deal with any errors.
+	const QueuedPacket & queuedPacket = packets_[ start ];
+	networkInterface_.basicSendWithRetries( queuedPacket.addr_,
+			queuedPacket.pPacket_.get() );
+
+	return 1;
+}
+
+} // namespace Mercury
+
+// packet_send_queue.cpp
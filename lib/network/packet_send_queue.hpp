@@ -0,0 +1,91 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#ifndef PACKET_SEND_QUEUE_HPP
+#define PACKET_SEND_QUEUE_HPP
+
+#include "basictypes.hpp"
+#include "frequent_tasks.hpp"
+#include "packet.hpp"
+
+#include <vector>
+
+namespace Mercury
+{
+
+class EventDispatcher;
+class NetworkInterface;
+
+/**
+ *	This class collects the packets sent by a NetworkInterface during a single
+ *	iteration of its dispatcher and sends them together, with as few system
+ *	calls as possible, just before the dispatcher waits for network activity.
+ *
+ *	Packets are queued after any PacketFilter has processed them, so filters
+ *	still see every packet individually.
+ */
+class PacketSendQueue : public FrequentTask
+{
+public:
+	/// The maximum number of packets sent by a single system call.
+	static const int MAX_BATCH_SIZE = 64;
+
+	PacketSendQueue( NetworkInterface & networkInterface );
+	~PacketSendQueue();
+
+	void init( EventDispatcher & dispatcher );
+	void fini();
+
+	bool isEnabled() const			{ return isEnabled_; }
+	void isEnabled( bool value );
+
+	/**
+	 *	This method returns whether a packet being sent now should be added to
+	 *	this queue rather than sent immediately.
+	 */
+	bool shouldQueue() const
+	{
+		return isEnabled_ && !isFlushing_ && (pDispatcher_ != NULL);
+	}
+
+	void add( const Address & addr, Packet * pPacket );
+	void flush();
+
+	int size() const				{ return int( packets_.size() ); }
+
+private:
+	virtual void doTask();
+
+	int sendBatch( int start );
+
+	/**
+	 *	This structure stores a packet waiting to be sent.
+	 */
+	struct QueuedPacket
+	{
+		Address addr_;
+		PacketPtr pPacket_;
+	};
+
+	typedef std::vector< QueuedPacket > QueuedPackets;
+	QueuedPackets packets_;
+
+	NetworkInterface & networkInterface_;
+	EventDispatcher * pDispatcher_;
+
+	bool isEnabled_;
+	bool isFlushing_;
+};
+
+} // namespace Mercury
+
+#endif // PACKET_SEND_QUEUE_HPP
@@ -70,6 +70,22 @@ void ProcessSocketStatsHelper::stopMessageHandling()
 }
 
 
+/**
+ *	This method is called after a message's handler has finished reading it.
+ *
+ *	@param multiPacketBytes	The length of the message if its data spanned more
+ *							than one packet, otherwise 0.
+ *	@param bytesCopied		The number of bytes of the message that had to be
+ *							copied out of the packets.
+ */
+void ProcessSocketStatsHelper::onMessageRead( int multiPacketBytes,
+		int bytesCopied )
+{
+	stats_.numMultiPacketMessageBytes_ += multiPacketBytes;
+	stats_.numMessageBytesCopied_ += bytesCopied;
+}
+
+
 /**
  *	This method is called when an attempt to read the socket (successful or not)
  *	has finished.
@@ -95,6 +111,34 @@ void ProcessSocketStatsHelper::socketReadFinished( int length )
 }
 
 
+/**
+ *	This method is called when a batched read of the socket has finished. It
+ *	is the equivalent of socketReadFinished() for a single system call that
+ *	received a number of packets.
+ *
+ *	@param numPackets	The number of packets read.
+ *	@param numBytes		The total size of the packets read.
+ */
+void ProcessSocketStatsHelper::socketBatchReadFinished( int numPackets,
+		int numBytes )
+{
+#if ENABLE_WATCHERS
+	stats_.systemTimer_.stop( std::max( numPackets, 0 ) );
+#endif // ENABLE_WATCHERS
+
+	if (numPackets > 0)
+	{
+		stats_.numPacketsReceived_ += numPackets;
+
+		int totalLength = numBytes + numPackets * UDP_OVERHEAD;
+
+		// Payload subtracted later
+		stats_.numOverheadBytesReceived_ += totalLength;
+		stats_.numBytesReceived_ += totalLength;
+	}
+}
+
+
 /**
  *	This method is called when a bundle has successful been processed.
  */
@@ -29,8 +29,10 @@ public:
 
 	void startMessageHandling( int messageLength );
 	void stopMessageHandling();
+	void onMessageRead( int multiPacketBytes, int bytesCopied );
 
 	void socketReadFinished( int length );
+	void socketBatchReadFinished( int numPackets, int numBytes );
 
 	void onBundleFinished();
 	void onCorruptedBundle();
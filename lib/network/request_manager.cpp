@@ -49,16 +49,23 @@ RequestManager::~RequestManager()
 					"Num pending reply handlers = %"PRIzu"\n",
 				requestMap_.size() );
 
-		RequestMap::iterator iter = requestMap_.begin();
+		// The handlers may modify the map, so the requests are copied out of
+		// it first.
+		std::vector< Request * > requests;
+		requests.reserve( requestMap_.size() );
 
-		while (iter != requestMap_.end())
+		for (RequestMap::iterator iter = requestMap_.begin();
+				iter != requestMap_.end(); ++iter)
 		{
-			Request * pElement = iter->second;
-			++iter;
-			pElement->handleFailure( REASON_SHUTTING_DOWN );
+			requests.push_back( iter->second );
 		}
 
 		requestMap_.clear();
+
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			requests[i]->handleFailure( REASON_SHUTTING_DOWN );
+		}
 	}
 }
 
@@ -68,21 +75,20 @@ RequestManager::~RequestManager()
  */
 void RequestManager::cancelRequestsFor( Channel * pChannel )
 {
-	RequestMap::iterator iter = requestMap_.begin();
+	// Note: failRequest can modify the map, so the matching requests are
+	// found first.
+	std::vector< int > replyIDs;
 
-	while (iter != requestMap_.end())
+	for (RequestMap::iterator iter = requestMap_.begin();
+			iter != requestMap_.end(); ++iter)
 	{
-		Request & request = *iter->second;
-
-		// Note: failRequest can modify the map so iter needs to be moved
-		// early.
-		++iter;
-
-		if (request.matches( pChannel ))
+		if (iter->second->matches( pChannel ))
 		{
-			this->failRequest( request, REASON_CHANNEL_LOST );
+			replyIDs.push_back( iter->first );
 		}
 	}
+
+	this->failRequests( replyIDs, REASON_CHANNEL_LOST );
 }
 
 
@@ -94,19 +100,38 @@ void RequestManager::cancelRequestsFor( Channel * pChannel )
 void RequestManager::cancelRequestsFor( ReplyMessageHandler * pHandler,
 	   	Reason reason )
 {
-	RequestMap::iterator iter = requestMap_.begin();
+	// Note: failRequest can modify the map, so the matching requests are
+	// found first.
+	std::vector< int > replyIDs;
 
-	while (iter != requestMap_.end())
+	for (RequestMap::iterator iter = requestMap_.begin();
+			iter != requestMap_.end(); ++iter)
 	{
-		Request & request = *iter->second;
+		if (iter->second->matches( pHandler ))
+		{
+			replyIDs.push_back( iter->first );
+		}
+	}
+
+	this->failRequests( replyIDs, reason );
+}
+
 
-		// Note: failRequest can modify the map so iter needs to be moved
-		// early.
-		++iter;
+/**
+ *	This method fails the requests with the given reply IDs that are still
+ *	outstanding.
+ */
+void RequestManager::failRequests( const std::vector< int > & replyIDs,
+		Reason reason )
+{
+	for (size_t i = 0; i < replyIDs.size(); ++i)
+	{
+		// An earlier failure may have cancelled this request.
+		RequestMap::iterator iter = requestMap_.find( replyIDs[i] );
 
-		if (request.matches( pHandler ))
+		if (iter != requestMap_.end())
 		{
-			this->failRequest( request, reason );
+			this->failRequest( *iter->second, reason );
 		}
 	}
 }
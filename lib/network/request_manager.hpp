@@ -14,7 +14,8 @@ criminal penalties as provided by law.
 
 #include "interfaces.hpp"
 
-#include <map>
+#include "cstdmf/hash_map.hpp"
+
 #include <vector>
 
 namespace Mercury
@@ -56,6 +57,8 @@ private:
 		return nextReplyID_++;
 	}
 
+	void failRequests( const std::vector< int > & replyIDs, Reason reason );
+
 	virtual void handleMessage( const Address & source,
 		UnpackedMessageHeader & header,
 		BinaryIStream & data );
@@ -64,7 +67,7 @@ private:
 	// Section: Properties
 	// -------------------------------------------------------------------------
 
-	typedef std::map< int, Request * > RequestMap;
+	typedef HashMap< int, Request * > RequestMap;
 	RequestMap requestMap_;
 
 	ReplyID nextReplyID_;
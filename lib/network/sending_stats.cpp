@@ -13,6 +13,7 @@ criminal penalties as provided by law.
 
 #include "sending_stats.hpp"
 
+#include "basictypes.hpp"
 #include "event_dispatcher.hpp"
 
 #include "math/stat_watcher_creator.hpp"
@@ -41,7 +42,8 @@ SendingStats::SendingStats() :
 	numMessagesSent_( pStats_ ),
 	numReliableMessagesSent_( pStats_ ),
 	numFailedPacketSend_( pStats_ ),
-	numFailedBundleSend_( pStats_ )
+	numFailedBundleSend_( pStats_ ),
+	numSendSystemCallsSaved_( pStats_ )
 #if ENABLE_WATCHERS
 	, mercuryTimer_(),
 	systemTimer_()
@@ -100,6 +102,18 @@ double SendingStats::messagesPerSecond() const
 }
 
 
+/**
+ *	This method records that a number of packets were sent by a single system
+ *	call.
+ */
+void SendingStats::onBatchSent( int numPackets, int numBytes )
+{
+	numBytesSent_ += numBytes + numPackets * UDP_OVERHEAD;
+	numPacketsSent_ += numPackets;
+	numSendSystemCallsSaved_ += numPackets - 1;
+}
+
+
 #if ENABLE_WATCHERS
 WatcherPtr SendingStats::pWatcher()
 {
@@ -117,6 +131,7 @@ WatcherPtr SendingStats::pWatcher()
 	StatWatcherCreator::addWatchers( pWatcher, "reliableMessagesSent",  pNull->numReliableMessagesSent_ );
 	StatWatcherCreator::addWatchers( pWatcher, "failedPacketSends",     pNull->numFailedPacketSend_ );
 	StatWatcherCreator::addWatchers( pWatcher, "failedBundleSends",     pNull->numFailedBundleSend_ );
+	StatWatcherCreator::addWatchers( pWatcher, "systemCallsSaved",      pNull->numSendSystemCallsSaved_ );
 
 	pWatcher->addChild( "timingInSeconds/mercury", ProfileVal::pWatcherSeconds(),
 			&pNull->mercuryTimer_ );
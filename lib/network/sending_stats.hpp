@@ -37,6 +37,8 @@ public:
 	double packetsPerSecond() const;
 	double messagesPerSecond() const;
 
+	void onBatchSent( int numPackets, int numBytes );
+
 #if ENABLE_WATCHERS
 	ProfileVal & mercuryTimer()	{ return mercuryTimer_; }
 	ProfileVal & systemTimer()	{ return systemTimer_; }
@@ -67,6 +69,7 @@ private:
 	Stat numReliableMessagesSent_;
 	Stat numFailedPacketSend_;
 	Stat numFailedBundleSend_;
+	Stat numSendSystemCallsSaved_;
 
 #if ENABLE_WATCHERS
 	ProfileVal	mercuryTimer_;
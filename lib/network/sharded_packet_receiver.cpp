@@ -0,0 +1,625 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "sharded_packet_receiver.hpp"
+
+#include "endpoint.hpp"
+#include "error_reporter.hpp"
+#include "event_dispatcher.hpp"
+#include "network_interface.hpp"
+#include "packet.hpp"
+#include "packet_receiver.hpp"
+#include "process_socket_stats_helper.hpp"
+
+#include "cstdmf/spsc_queue.hpp"
+
+#ifdef unix
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+DECLARE_DEBUG_COMPONENT2( "Network", 0 )
+
+
+namespace Mercury
+{
+
+// -----------------------------------------------------------------------------
+// Section: ReceiveShard
+// -----------------------------------------------------------------------------
+
+/**
+ *	This class is a receive thread of a ShardedPacketReceiver, along with its
+ *	socket and the queue of packets that it has read.
+ */
+class ReceiveShard
+{
+public:
+	/**
+	 *	This structure stores a packet read by the receive thread.
+	 */
+	struct ReceivedPacket
+	{
+		ReceivedPacket() :
+			addr_(),
+			pPacket_( NULL ),
+			pFilter_( NULL ),
+			reason_( REASON_SUCCESS ),
+			length_( 0 )
+		{
+		}
+
+		Address addr_;
+
+		// This holds a reference to the packet. It is not a PacketPtr because
+		// Packet's reference count is not thread-safe.
+		Packet * pPacket_;
+
+		// The filter that the packet was passed through, if any.
+		PacketFilterPtr pFilter_;
+		Reason reason_;
+
+		// The length of the packet as it was read from the socket.
+		int length_;
+	};
+
+	ReceiveShard( ShardedPacketReceiver & owner );
+	~ReceiveShard();
+
+	bool bind( u_int16_t networkPort, u_int32_t networkAddr );
+	void start();
+
+	bool pop( ReceivedPacket & received )	{ return queue_.pop( received ); }
+	bool isEmpty() const					{ return queue_.empty(); }
+
+	// Set by the receive thread when it writes to the wakeup pipe. Cleared by
+	// the main thread before it empties the queue.
+	volatile bool isSignalled_;
+
+	volatile uint32 numPacketsReceived_;
+	volatile uint32 numPacketsPreprocessed_;
+	volatile uint32 numPacketsDropped_;
+
+private:
+	static void s_start( void * arg );
+	void run();
+
+	ShardedPacketReceiver & owner_;
+	Endpoint socket_;
+	SPSCQueue< ReceivedPacket > queue_;
+
+	SimpleThread * pThread_;
+};
+
+
+/**
+ *	Constructor.
+ */
+ReceiveShard::ReceiveShard( ShardedPacketReceiver & owner ) :
+	isSignalled_( false ),
+	numPacketsReceived_( 0 ),
+	numPacketsPreprocessed_( 0 ),
+	numPacketsDropped_( 0 ),
+	owner_( owner ),
+	socket_(),
+	queue_( ShardedPacketReceiver::QUEUE_SIZE ),
+	pThread_( NULL )
+{
+}
+
+
+/**
+ *	Destructor. The thread must have been told to stop. This waits for it to
+ *	finish and then releases any packets that were not processed.
+ */
+ReceiveShard::~ReceiveShard()
+{
+	MF_ASSERT( owner_.shouldStop() );
+
+	// This waits for the thread to finish.
+	delete pThread_;
+
+	ReceivedPacket received;
+
+	while (queue_.pop( received ))
+	{
+		received.pPacket_->decRef();
+	}
+
+	socket_.close();
+}
+
+
+/**
+ *	This method creates this shard's socket and binds it to the given address,
+ *	which is shared with the interface's socket.
+ */
+bool ReceiveShard::bind( u_int16_t networkPort, u_int32_t networkAddr )
+{
+#ifdef ENDPOINT_HAS_REUSEPORT
+	socket_.socket( SOCK_DGRAM );
+
+	if (!socket_.good())
+	{
+		ERROR_MSG( "ReceiveShard::bind: Couldn't create a socket\n" );
+		return false;
+	}
+
+	socket_.setreuseport( true );
+
+	if (socket_.bind( networkPort, networkAddr ) != 0)
+	{
+		ERROR_MSG( "ReceiveShard::bind: Couldn't bind the socket to %s (%s)\n",
+			Address( networkAddr, networkPort ).c_str(), strerror( errno ) );
+		socket_.close();
+		socket_.detach();
+		return false;
+	}
+
+	// Time out reads regularly so that the thread notices when it should
+	// stop.
+	struct timeval timeout;
+	timeout.tv_sec = 0;
+	timeout.tv_usec = 100000;
+	setsockopt( socket_, SOL_SOCKET, SO_RCVTIMEO,
+		&timeout, sizeof( timeout ) );
+
+#ifdef MF_SERVER
+	if (!socket_.setBufferSize( SO_RCVBUF,
+			NetworkInterface::RECV_BUFFER_SIZE ))
+	{
+		WARNING_MSG( "ReceiveShard::bind: "
+			"Operating with a receive buffer of only %d bytes (instead of %d)\n",
+			socket_.getBufferSize( SO_RCVBUF ),
+			NetworkInterface::RECV_BUFFER_SIZE );
+	}
+#endif
+
+	return true;
+#else
+	return false;
+#endif // ENDPOINT_HAS_REUSEPORT
+}
+
+
+/**
+ *	This method starts the receive thread.
+ */
+void ReceiveShard::start()
+{
+	MF_ASSERT( pThread_ == NULL );
+
+	pThread_ = new SimpleThread( ReceiveShard::s_start, this );
+}
+
+
+/**
+ *	This static method is the entry-point for the receive thread.
+ */
+void ReceiveShard::s_start( void * arg )
+{
+	ReceiveShard * pShard = (ReceiveShard*)arg;
+	pShard->run();
+}
+
+
+/**
+ *	This method reads packets from this shard's socket until the owner is
+ *	stopped.
+ */
+void ReceiveShard::run()
+{
+	Packet::enableThreadCache();
+
+	Packet * pPacket = new Packet();
+	pPacket->incRef();
+
+	while (!owner_.shouldStop())
+	{
+		ReceivedPacket received;
+		received.length_ = pPacket->recvFromEndpoint( socket_,
+				received.addr_ );
+
+		if (received.length_ <= 0)
+		{
+			// Timed out, or an error that the main socket will also see.
+			continue;
+		}
+
+		++numPacketsReceived_;
+
+		received.pFilter_ = owner_.findFilter( received.addr_ );
+
+		if (received.pFilter_)
+		{
+			received.reason_ =
+				received.pFilter_->preprocessRecv( received.addr_, pPacket );
+			++numPacketsPreprocessed_;
+		}
+
+		received.pPacket_ = pPacket;
+
+		if (queue_.push( received ))
+		{
+			owner_.onPacketQueued( *this );
+		}
+		else
+		{
+			++numPacketsDropped_;
+			pPacket->decRef();
+		}
+
+		pPacket = new Packet();
+		pPacket->incRef();
+	}
+
+	pPacket->decRef();
+
+	Packet::disableThreadCache();
+}
+
+
+// -----------------------------------------------------------------------------
+// Section: ShardedPacketReceiver
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+ShardedPacketReceiver::ShardedPacketReceiver(
+		NetworkInterface & networkInterface,
+		PacketReceiver & packetReceiver ) :
+	networkInterface_( networkInterface ),
+	packetReceiver_( packetReceiver ),
+	pDispatcher_( NULL ),
+	shards_(),
+	shouldStop_( false ),
+	filters_(),
+	filtersLock_()
+{
+	wakeupPipe_[0] = -1;
+	wakeupPipe_[1] = -1;
+}
+
+
+/**
+ *	Destructor.
+ */
+ShardedPacketReceiver::~ShardedPacketReceiver()
+{
+	this->fini();
+}
+
+
+/**
+ *	This method starts the receive threads.
+ *
+ *	@param dispatcher	The dispatcher that wakes the main thread when packets
+ *						have been queued.
+ *	@param mainSocket	The interface's socket. The receive threads' sockets
+ *						are bound to the same address.
+ *	@param numShards	The number of receive threads to start.
+ *
+ *	@return True on success, otherwise false and no threads are running.
+ */
+bool ShardedPacketReceiver::init( EventDispatcher & dispatcher,
+		Endpoint & mainSocket, int numShards )
+{
+	MF_ASSERT( shards_.empty() );
+
+#if defined( ENDPOINT_HAS_REUSEPORT ) && !defined( MF_SINGLE_THREADED )
+	u_int16_t networkPort = 0;
+	u_int32_t networkAddr = 0;
+
+	if ((mainSocket.setreuseport( true ) != 0) ||
+			(mainSocket.getlocaladdress( &networkPort, &networkAddr ) != 0))
+	{
+		ERROR_MSG( "ShardedPacketReceiver::init: "
+				"Couldn't share the interface's port (%s)\n",
+			strerror( errno ) );
+		return false;
+	}
+
+	if (pipe( wakeupPipe_ ) != 0)
+	{
+		ERROR_MSG( "ShardedPacketReceiver::init: "
+				"Couldn't create wakeup pipe (%s)\n",
+			strerror( errno ) );
+		return false;
+	}
+
+	fcntl( wakeupPipe_[0], F_SETFL, O_NONBLOCK );
+	fcntl( wakeupPipe_[1], F_SETFL, O_NONBLOCK );
+
+	pDispatcher_ = &dispatcher;
+	pDispatcher_->registerFileDescriptor( wakeupPipe_[0], this );
+
+	shouldStop_ = false;
+
+	for (int i = 0; i < numShards; ++i)
+	{
+		ReceiveShard * pShard = new ReceiveShard( *this );
+		shards_.push_back( pShard );
+
+		if (!pShard->bind( networkPort, networkAddr ))
+		{
+			this->fini();
+			mainSocket.setreuseport( false );
+			return false;
+		}
+	}
+
+	for (Shards::iterator iter = shards_.begin();
+			iter != shards_.end(); ++iter)
+	{
+		(*iter)->start();
+	}
+
+	INFO_MSG( "ShardedPacketReceiver::init: "
+			"Receiving on %s with %d threads\n",
+		Address( networkAddr, networkPort ).c_str(), numShards );
+
+	return true;
+#else
+	ERROR_MSG( "ShardedPacketReceiver::init: "
+			"Receive threads are not supported on this platform\n" );
+	return false;
+#endif
+}
+
+
+/**
+ *	This method stops the receive threads. Packets that they have queued but
+ *	the main thread has not processed are discarded.
+ */
+void ShardedPacketReceiver::fini()
+{
+	shouldStop_ = true;
+
+	for (Shards::iterator iter = shards_.begin();
+			iter != shards_.end(); ++iter)
+	{
+		delete *iter;
+	}
+
+	shards_.clear();
+
+#ifdef unix
+	if (pDispatcher_ != NULL)
+	{
+		pDispatcher_->deregisterFileDescriptor( wakeupPipe_[0] );
+		pDispatcher_ = NULL;
+	}
+
+	for (int i = 0; i < 2; ++i)
+	{
+		if (wakeupPipe_[i] != -1)
+		{
+			close( wakeupPipe_[i] );
+			wakeupPipe_[i] = -1;
+		}
+	}
+#endif
+}
+
+
+/**
+ *	This method sets the filter that receive threads use for packets from the
+ *	given address. Only thread-safe filters are used. Passing NULL removes the
+ *	address's filter.
+ */
+void ShardedPacketReceiver::setFilter( const Address & addr,
+		PacketFilterPtr pFilter )
+{
+	SimpleMutexHolder smh( filtersLock_ );
+
+	if (pFilter && pFilter->isThreadSafe())
+	{
+		filters_[ addr ] = pFilter;
+	}
+	else
+	{
+		filters_.erase( addr );
+	}
+}
+
+
+/**
+ *	This method returns the thread-safe filter for the given address, if there
+ *	is one. It is called by the receive threads.
+ */
+PacketFilterPtr ShardedPacketReceiver::findFilter( const Address & addr )
+{
+	SimpleMutexHolder smh( filtersLock_ );
+
+	Filters::iterator iter = filters_.find( addr );
+
+	return (iter != filters_.end()) ? iter->second : NULL;
+}
+
+
+/**
+ *	This method is called by a receive thread after it has queued a packet. It
+ *	wakes the main thread, unless it has already been woken for this shard.
+ */
+void ShardedPacketReceiver::onPacketQueued( ReceiveShard & shard )
+{
+	memory_barrier();
+
+	if (!shard.isSignalled_)
+	{
+		shard.isSignalled_ = true;
+
+#ifdef unix
+		char c = 0;
+		// If the pipe is full, the main thread is already due to wake up.
+		if (write( wakeupPipe_[1], &c, 1 ) < 0) {}
+#endif
+	}
+}
+
+
+/**
+ *	This method is called on the main thread when a receive thread has queued
+ *	packets.
+ */
+int ShardedPacketReceiver::handleInputNotification( int fd )
+{
+#ifdef unix
+	char buf[ 64 ];
+
+	while (read( fd, buf, sizeof( buf ) ) > 0)
+	{
+		/* pass */;
+	}
+#endif
+
+	for (Shards::iterator iter = shards_.begin();
+			iter != shards_.end(); ++iter)
+	{
+		(*iter)->isSignalled_ = false;
+	}
+
+	// Any packet queued after this point signals again.
+	memory_barrier();
+
+	for (Shards::iterator iter = shards_.begin();
+			iter != shards_.end(); ++iter)
+	{
+		this->processQueue( **iter );
+	}
+
+	return 0;
+}
+
+
+/**
+ *	This method processes the packets that a receive thread has queued. At most
+ *	a queue's worth is processed so that a busy thread cannot starve the rest
+ *	of the main loop.
+ */
+void ShardedPacketReceiver::processQueue( ReceiveShard & shard )
+{
+	ReceiveShard::ReceivedPacket received;
+
+	for (int i = 0; (i < QUEUE_SIZE) && shard.pop( received ); ++i)
+	{
+		PacketPtr pPacket( received.pPacket_, PacketPtr::STEAL_REFERENCE );
+
+		ProcessSocketStatsHelper statsHelper( packetReceiver_.stats() );
+		statsHelper.socketReadFinished( received.length_ );
+
+		Reason ret = packetReceiver_.processPreprocessedPacket(
+				received.addr_, pPacket.get(), received.pFilter_.get(),
+				received.reason_, &statsHelper );
+
+		if ((ret != REASON_SUCCESS) &&
+				networkInterface_.isVerbose())
+		{
+			networkInterface_.dispatcher().errorReporter().reportException(
+					ret, received.addr_ );
+		}
+	}
+
+	// Anything left over is processed on the next wakeup.
+	if (!shard.isEmpty())
+	{
+		this->onPacketQueued( shard );
+	}
+}
+
+
+/**
+ *	This method returns the number of packets read by the receive threads.
+ */
+uint32 ShardedPacketReceiver::numPacketsReceived() const
+{
+	uint32 total = 0;
+
+	for (Shards::const_iterator iter = shards_.begin();
+			iter != shards_.end(); ++iter)
+	{
+		total += (*iter)->numPacketsReceived_;
+	}
+
+	return total;
+}
+
+
+/**
+ *	This method returns the number of packets that the receive threads passed
+ *	through a filter.
+ */
+uint32 ShardedPacketReceiver::numPacketsPreprocessed() const
+{
+	uint32 total = 0;
+
+	for (Shards::const_iterator iter = shards_.begin();
+			iter != shards_.end(); ++iter)
+	{
+		total += (*iter)->numPacketsPreprocessed_;
+	}
+
+	return total;
+}
+
+
+/**
+ *	This method returns the number of packets that the receive threads dropped
+ *	because the main thread had not kept up.
+ */
+uint32 ShardedPacketReceiver::numPacketsDropped() const
+{
+	uint32 total = 0;
+
+	for (Shards::const_iterator iter = shards_.begin();
+			iter != shards_.end(); ++iter)
+	{
+		total += (*iter)->numPacketsDropped_;
+	}
+
+	return total;
+}
+
+
+#if ENABLE_WATCHERS
+/**
+ *	This static method returns a watcher that can be used to inspect a
+ *	ShardedPacketReceiver.
+ */
+WatcherPtr ShardedPacketReceiver::pWatcher()
+{
+	static DirectoryWatcherPtr watchMe = NULL;
+
+	if (watchMe == NULL)
+	{
+		watchMe = new DirectoryWatcher();
+
+		watchMe->addChild( "numShards",
+			makeWatcher( &ShardedPacketReceiver::numShards ) );
+		watchMe->addChild( "numPacketsReceived",
+			makeWatcher( &ShardedPacketReceiver::numPacketsReceived ) );
+		watchMe->addChild( "numPacketsPreprocessed",
+			makeWatcher( &ShardedPacketReceiver::numPacketsPreprocessed ) );
+		watchMe->addChild( "numPacketsDropped",
+			makeWatcher( &ShardedPacketReceiver::numPacketsDropped ) );
+	}
+
+	return watchMe;
+}
+#endif // ENABLE_WATCHERS
+
+} // namespace Mercury
+
+// sharded_packet_receiver.cpp
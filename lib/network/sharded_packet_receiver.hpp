@@ -0,0 +1,109 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef SHARDED_PACKET_RECEIVER_HPP
+#define SHARDED_PACKET_RECEIVER_HPP
+
+#include "basictypes.hpp"
+#include "interfaces.hpp"
+#include "packet_filter.hpp"
+
+#include "cstdmf/concurrency.hpp"
+#include "cstdmf/watcher.hpp"
+
+#include <map>
+#include <vector>
+
+class Endpoint;
+
+namespace Mercury
+{
+
+class EventDispatcher;
+class NetworkInterface;
+class PacketReceiver;
+class ReceiveShard;
+
+/**
+ *	This class reads the packets arriving at a NetworkInterface's port with a
+ *	number of receive threads. Each thread has its own socket, bound to the
+ *	same port with SO_REUSEPORT, so the kernel shares incoming datagrams
+ *	between them.
+ *
+ *	If the channel that a packet is from has a thread-safe PacketFilter, the
+ *	receive thread passes the packet through PacketFilter::preprocessRecv().
+ *	This takes work such as decryption off the main thread. Packets are then
+ *	handed to the main thread through a lock-free queue per thread and
+ *	processed by the interface's PacketReceiver as normal.
+ *
+ *	The interface's own socket still receives its share of the port's packets
+ *	and is read on the main thread.
+ */
+class ShardedPacketReceiver : public InputNotificationHandler
+{
+public:
+	/// The number of packets that each receive thread can have waiting for
+	/// the main thread. Further packets are dropped.
+	static const int QUEUE_SIZE = 4096;
+
+	ShardedPacketReceiver( NetworkInterface & networkInterface,
+			PacketReceiver & packetReceiver );
+	~ShardedPacketReceiver();
+
+	bool init( EventDispatcher & dispatcher, Endpoint & mainSocket,
+			int numShards );
+	void fini();
+
+	int numShards() const			{ return int( shards_.size() ); }
+
+	void setFilter( const Address & addr, PacketFilterPtr pFilter );
+	PacketFilterPtr findFilter( const Address & addr );
+
+	void onPacketQueued( ReceiveShard & shard );
+
+	bool shouldStop() const			{ return shouldStop_; }
+
+	uint32 numPacketsReceived() const;
+	uint32 numPacketsPreprocessed() const;
+	uint32 numPacketsDropped() const;
+
+#if ENABLE_WATCHERS
+	static WatcherPtr pWatcher();
+#endif
+
+private:
+	virtual int handleInputNotification( int fd );
+
+	void processQueue( ReceiveShard & shard );
+
+	NetworkInterface & networkInterface_;
+	PacketReceiver & packetReceiver_;
+
+	EventDispatcher * pDispatcher_;
+
+	typedef std::vector< ReceiveShard * > Shards;
+	Shards shards_;
+
+	// The receive threads write to this pipe to wake the main thread.
+	int wakeupPipe_[2];
+
+	volatile bool shouldStop_;
+
+	// The thread-safe filters of the interface's channels, by address. This
+	// is written by the main thread and read by the receive threads.
+	typedef std::map< Address, PacketFilterPtr > Filters;
+	Filters filters_;
+	SimpleMutex filtersLock_;
+};
+
+} // namespace Mercury
+
+#endif // SHARDED_PACKET_RECEIVER_HPP
@@ -0,0 +1,135 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "pch.hpp"
+
+#include "third_party/CppUnitLite2/src/CppUnitLite2.h"
+#include "common_interface.hpp"
+
+#include "network/event_dispatcher.hpp"
+#include "network/network_interface.hpp"
+#include "network/packet_receiver_stats.hpp"
+
+namespace
+{
+
+const int NUM_SENDS = 500;
+const int BATCH_SIZE = 16;
+
+class LocalHandler : public CommonHandler, public TimerHandler
+{
+public:
+	LocalHandler( Mercury::EventDispatcher & dispatcher ) :
+		dispatcher_( dispatcher ),
+		numReceived_( 0 ),
+		inOrder_( true ),
+		hasTimedOut_( false )
+	{
+	}
+
+	int numReceived() const		{ return numReceived_; }
+	bool inOrder() const		{ return inOrder_; }
+	bool hasTimedOut() const	{ return hasTimedOut_; }
+
+protected:
+	virtual void on_msg1( const Mercury::Address & srcAddr,
+			const CommonInterface::msg1Args & args )
+	{
+		if (args.seq != uint32( numReceived_ ))
+		{
+			inOrder_ = false;
+		}
+
+		++numReceived_;
+
+		if (args.data != 0)
+		{
+			dispatcher_.breakProcessing();
+		}
+	}
+
+	void handleTimeout( TimerHandle handle, void * arg )
+	{
+		hasTimedOut_ = true;
+		dispatcher_.breakProcessing();
+	}
+
+private:
+	Mercury::EventDispatcher & dispatcher_;
+	int numReceived_;
+	bool inOrder_;
+	bool hasTimedOut_;
+};
+
+} // anonymous namespace
+
+
+/**
+ *	This test sends a burst of packets at an interface that is reading them in
+ *	batches and checks that they are all dispatched, in order.
+ */
+TEST( PacketReceiver_batched_receive )
+{
+	Mercury::EventDispatcher dispatcher;
+
+	Mercury::NetworkInterface fromInterface( &dispatcher,
+		Mercury::NETWORK_INTERFACE_INTERNAL );
+	Mercury::NetworkInterface toInterface( &dispatcher,
+		Mercury::NETWORK_INTERFACE_INTERNAL );
+
+	toInterface.setMaxReceiveBatchSize( BATCH_SIZE );
+
+	LocalHandler handler( dispatcher );
+	toInterface.pExtensionData( &handler );
+
+	CommonInterface::registerWithInterface( fromInterface );
+	CommonInterface::registerWithInterface( toInterface );
+
+	Mercury::Channel * pFromChannel =
+		new Mercury::Channel( fromInterface, toInterface.address(),
+							  Mercury::Channel::INTERNAL );
+	pFromChannel->isLocalRegular( false );
+	pFromChannel->isRemoteRegular( false );
+
+	Mercury::Channel * pToChannel =
+		new Mercury::Channel( toInterface, fromInterface.address(),
+							  Mercury::Channel::INTERNAL );
+	pToChannel->isLocalRegular( false );
+	pToChannel->isRemoteRegular( false );
+
+	// Queue all of the packets before processing so that the receiving socket
+	// has more than a batch worth of data pending.
+	for (int i = 0; i < NUM_SENDS; ++i)
+	{
+		CommonInterface::msg1Args & args =
+			CommonInterface::msg1Args::start( pFromChannel->bundle() );
+		args.seq = i;
+		args.data = (i == NUM_SENDS - 1);
+		pFromChannel->send();
+	}
+
+	TimerHandle timeoutHandle = dispatcher.addTimer( 5 * 1000000, &handler );
+
+	dispatcher.processUntilBreak();
+
+	timeoutHandle.cancel();
+
+	CHECK( !handler.hasTimedOut() );
+	CHECK( handler.inOrder() );
+	CHECK_EQUAL( NUM_SENDS, handler.numReceived() );
+	CHECK( toInterface.receivingStats().numPacketsReceived() >=
+		uint( NUM_SENDS ) );
+
+	pFromChannel->destroy();
+	pToChannel->destroy();
+}
+
+// test_batch_receive.cpp
@@ -0,0 +1,403 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "pch.hpp"
+
+#include "third_party/CppUnitLite2/src/CppUnitLite2.h"
+#include "common_interface.hpp"
+
+#include "network/aimd_congestion_controller.hpp"
+#include "network/channel.hpp"
+#include "network/delay_congestion_controller.hpp"
+#include "network/event_dispatcher.hpp"
+#include "network/network_interface.hpp"
+
+#include "cstdmf/timestamp.hpp"
+
+#include <queue>
+#include <vector>
+
+using namespace Mercury;
+
+namespace
+{
+
+// -----------------------------------------------------------------------------
+// Section: SimulatedLink
+// -----------------------------------------------------------------------------
+
+/**
+ *	This class models a bottleneck link with a fixed rate, a fixed propagation
+ *	delay and a drop-tail queue. A sender keeps one window of packets in
+ *	flight through it and reports each acknowledgement and loss to a
+ *	congestion controller.
+ */
+class SimulatedLink
+{
+public:
+	SimulatedLink( double packetsPerSecond, double propagationDelay,
+			uint queueSize ) :
+		packetTime_( toStamps( 1.0 / packetsPerSecond ) ),
+		propagationDelay_( toStamps( propagationDelay ) ),
+		queueSize_( queueSize ),
+		numDelivered_( 0 ),
+		numLost_( 0 ),
+		totalQueuingDelay_( 0 )
+	{
+	}
+
+	/**
+	 *	This method sends packets through the link for the given duration. If
+	 *	pController is NULL, the sender uses a fixed window of maxWindow.
+	 */
+	void run( CongestionController * pController, uint32 maxWindow,
+			double duration )
+	{
+		// Start away from zero, since controllers treat 0 as unset.
+		uint64 now = toStamps( 1.0 );
+		const uint64 endTime = now + toStamps( duration );
+
+		uint64 linkFreeTime = now;
+		uint32 numInFlight = 0;
+
+		while (now < endTime)
+		{
+			const uint32 window = pController ?
+				std::min( pController->window(), maxWindow ) : maxWindow;
+
+			// Fill the window.
+			while (numInFlight < window)
+			{
+				const uint64 departTime =
+					std::max( now, linkFreeTime ) + packetTime_;
+				const uint64 queueLength = (departTime - now) / packetTime_;
+
+				Event event;
+				event.sendTime_ = now;
+
+				if (queueLength > queueSize_)
+				{
+					// Dropped at the tail of the queue. The sender finds out
+					// about a round trip later.
+					event.time_ = now + 2 * propagationDelay_;
+					event.isLost_ = true;
+				}
+				else
+				{
+					linkFreeTime = departTime;
+					event.time_ = departTime + 2 * propagationDelay_;
+					event.isLost_ = false;
+				}
+
+				events_.push( event );
+				++numInFlight;
+			}
+
+			// Process the next acknowledgement or loss.
+			Event event = events_.top();
+			events_.pop();
+			--numInFlight;
+			now = event.time_;
+
+			if (event.isLost_)
+			{
+				++numLost_;
+
+				if (pController)
+				{
+					pController->onLoss( now );
+				}
+			}
+			else
+			{
+				const uint64 roundTripTime = now - event.sendTime_;
+
+				++numDelivered_;
+				totalQueuingDelay_ +=
+					roundTripTime - 2 * propagationDelay_ - packetTime_;
+
+				if (pController)
+				{
+					pController->onAck( now, roundTripTime, PACKET_SIZE );
+				}
+			}
+		}
+
+		duration_ = duration;
+	}
+
+	double utilisation() const
+	{
+		return numDelivered_ * (packetTime_ / stampsPerSecondD()) / duration_;
+	}
+
+	double averageQueuingDelay() const
+	{
+		return numDelivered_ ?
+			totalQueuingDelay_ / stampsPerSecondD() / numDelivered_ : 0.0;
+	}
+
+	uint numLost() const	{ return numLost_; }
+
+	static const int PACKET_SIZE = 1200;
+
+private:
+	static uint64 toStamps( double seconds )
+	{
+		return uint64( seconds * stampsPerSecondD() );
+	}
+
+	struct Event
+	{
+		uint64 time_;
+		uint64 sendTime_;
+		bool isLost_;
+
+		bool operator<( const Event & other ) const
+		{
+			return time_ > other.time_;
+		}
+	};
+
+	uint64 packetTime_;
+	uint64 propagationDelay_;
+	uint queueSize_;
+
+	std::priority_queue< Event > events_;
+
+	uint numDelivered_;
+	uint numLost_;
+	uint64 totalQueuingDelay_;
+	double duration_;
+};
+
+} // anonymous namespace
+
+
+/**
+ *	This test runs each policy over a simulated 2000 packets per second link
+ *	with a 40ms round trip and room for 100 packets in its queue. A fixed
+ *	256 packet window keeps the queue full and loses packets continually. Both
+ *	policies should keep the link busy, and the delay-based policy should also
+ *	keep the queue short.
+ */
+TEST( CongestionControl_simulatedLink )
+{
+	const uint32 MAX_WINDOW = 256;
+	const double DURATION = 20.0;
+
+	SimulatedLink fixedLink( 2000.0, 0.020, 100 );
+	fixedLink.run( NULL, MAX_WINDOW, DURATION );
+
+	AIMDCongestionController aimd( MAX_WINDOW );
+	SimulatedLink aimdLink( 2000.0, 0.020, 100 );
+	aimdLink.run( &aimd, MAX_WINDOW, DURATION );
+
+	DelayCongestionController delay( MAX_WINDOW );
+	SimulatedLink delayLink( 2000.0, 0.020, 100 );
+	delayLink.run( &delay, MAX_WINDOW, DURATION );
+
+	printf( "CongestionControl_simulatedLink: "
+			"utilisation, average queuing delay, losses\n" );
+	printf( "\tfixed: %5.1f%% %6.1fms %6u\n",
+		fixedLink.utilisation() * 100.0,
+		fixedLink.averageQueuingDelay() * 1000.0,
+		fixedLink.numLost() );
+	printf( "\taimd:  %5.1f%% %6.1fms %6u (%.0f bytes/s)\n",
+		aimdLink.utilisation() * 100.0,
+		aimdLink.averageQueuingDelay() * 1000.0,
+		aimdLink.numLost(), aimd.bytesPerSecond() );
+	printf( "\tdelay: %5.1f%% %6.1fms %6u (%.0f bytes/s)\n",
+		delayLink.utilisation() * 100.0,
+		delayLink.averageQueuingDelay() * 1000.0,
+		delayLink.numLost(), delay.bytesPerSecond() );
+
+	CHECK( aimdLink.utilisation() > 0.7 );
+	CHECK( delayLink.utilisation() > 0.7 );
+
+	CHECK( aimdLink.numLost() < fixedLink.numLost() );
+	CHECK( delayLink.numLost() < aimdLink.numLost() );
+
+	CHECK( delayLink.averageQueuingDelay() <
+		2.0 * DelayCongestionController::DEFAULT_TARGET_DELAY );
+	CHECK( delayLink.averageQueuingDelay() <
+		aimdLink.averageQueuingDelay() );
+
+	CHECK( aimd.bytesPerSecond() > 0.0 );
+	CHECK( delay.bytesPerSecond() > 0.0 );
+}
+
+
+namespace
+{
+
+// -----------------------------------------------------------------------------
+// Section: Lossy channel
+// -----------------------------------------------------------------------------
+
+const uint NUM_MESSAGES = 500;
+const uint MESSAGES_PER_TICK = 2;
+
+/**
+ *	This class streams messages over an external channel and records the range
+ *	of send windows that the channel's congestion controller chose.
+ */
+class CongestedStreamHandler : public CommonHandler, public TimerHandler
+{
+public:
+	CongestedStreamHandler( EventDispatcher & dispatcher,
+			Channel & fromChannel ) :
+		dispatcher_( dispatcher ),
+		fromChannel_( fromChannel ),
+		numSent_( 0 ),
+		numReceived_( 0 ),
+		isInOrder_( true ),
+		minWindow_( fromChannel.windowSize() ),
+		maxWindow_( 0 )
+	{
+	}
+
+	bool isInOrder() const		{ return isInOrder_; }
+	uint numReceived() const	{ return numReceived_; }
+	uint32 minWindow() const	{ return minWindow_; }
+	uint32 maxWindow() const	{ return maxWindow_; }
+
+protected:
+	virtual void on_msg1( const Address & srcAddr,
+			const CommonInterface::msg1Args & args )
+	{
+		if (args.seq != numReceived_)
+		{
+			isInOrder_ = false;
+		}
+
+		++numReceived_;
+	}
+
+	virtual void handleTimeout( TimerHandle handle, void * arg )
+	{
+		for (uint i = 0;
+				(i < MESSAGES_PER_TICK) && (numSent_ < NUM_MESSAGES); ++i)
+		{
+			CommonInterface::msg1Args & args =
+				CommonInterface::msg1Args::start( fromChannel_.bundle() );
+			args.seq = numSent_;
+			args.data = 0;
+			++numSent_;
+		}
+
+		// This also checks the resend timers once everything has been sent.
+		fromChannel_.send();
+
+		const uint32 window = fromChannel_.sendWindowSize();
+		minWindow_ = std::min( minWindow_, window );
+		maxWindow_ = std::max( maxWindow_, window );
+
+		if ((numReceived_ == NUM_MESSAGES) &&
+			!fromChannel_.hasUnackedPackets())
+		{
+			dispatcher_.breakProcessing();
+		}
+	}
+
+private:
+	EventDispatcher & dispatcher_;
+	Channel & fromChannel_;
+
+	uint numSent_;
+	uint numReceived_;
+	bool isInOrder_;
+
+	uint32 minWindow_;
+	uint32 maxWindow_;
+};
+
+} // anonymous namespace
+
+
+/**
+ *	This test streams messages over an external channel for each congestion
+ *	control policy, using the network interface's artificial latency and loss
+ *	to simulate a poor client link.
+ */
+TEST( CongestionControl_lossyChannel )
+{
+	const char * policies[] = { "aimd", "delay" };
+
+	printf( "CongestionControl_lossyChannel: 30ms latency, 2%% loss\n" );
+
+	for (size_t i = 0; i < sizeof( policies ) / sizeof( policies[0] ); ++i)
+	{
+		EventDispatcher dispatcher;
+
+		NetworkInterface fromInterface( &dispatcher,
+			NETWORK_INTERFACE_INTERNAL );
+		NetworkInterface toInterface( &dispatcher,
+			NETWORK_INTERFACE_INTERNAL );
+
+		CommonInterface::registerWithInterface( fromInterface );
+		CommonInterface::registerWithInterface( toInterface );
+
+		fromInterface.congestionControl( policies[i] );
+
+		Channel * pFromChannel = new Channel( fromInterface,
+			toInterface.address(), Channel::EXTERNAL );
+		pFromChannel->isLocalRegular( false );
+		pFromChannel->isRemoteRegular( false );
+
+		Channel * pToChannel = new Channel( toInterface,
+			fromInterface.address(), Channel::EXTERNAL );
+		pToChannel->isLocalRegular( false );
+		pToChannel->isRemoteRegular( false );
+
+		CHECK( pFromChannel->pCongestionController() != NULL );
+		// Only the sending interface has a policy.
+		CHECK( pToChannel->pCongestionController() == NULL );
+
+		CongestedStreamHandler handler( dispatcher, *pFromChannel );
+		toInterface.pExtensionData( &handler );
+
+		fromInterface.setLatency( 0.03f, 0.03f );
+		fromInterface.setLossRatio( 0.02f );
+
+		TimerHandle timerHandle = dispatcher.addTimer( 2000, &handler, NULL );
+
+		const uint64 startTime = timestamp();
+		dispatcher.processUntilBreak();
+		const double duration =
+			(timestamp() - startTime) / stampsPerSecondD();
+
+		timerHandle.cancel();
+
+		CHECK( handler.isInOrder() );
+		CHECK_EQUAL( NUM_MESSAGES, handler.numReceived() );
+
+		CongestionControllerPtr pController =
+			pFromChannel->pCongestionController();
+
+		if (pController)
+		{
+			CHECK( pController->bytesPerSecond() > 0.0 );
+
+			printf( "\t%-5s: %.2fs, %u resends, window %u-%u, "
+					"%.0f bytes/s\n",
+				pController->name(), duration,
+				pFromChannel->numPacketsResent(),
+				handler.minWindow(), handler.maxWindow(),
+				pController->bytesPerSecond() );
+		}
+
+		pFromChannel->destroy();
+		pToChannel->destroy();
+	}
+}
+
+// test_congestion_control.cpp
@@ -0,0 +1,209 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "third_party/CppUnitLite2/src/CppUnitLite2.h"
+
+#include "cstdmf/timestamp.hpp"
+
+#include "network/aes_gcm_filter.hpp"
+#include "network/encryption_filter.hpp"
+#include "network/packet.hpp"
+
+#if defined( USE_OPENSSL ) || defined( HAS_AES_GCM_FILTER )
+
+namespace
+{
+
+// Typical sizes of packets before encryption, up to the largest that fits in
+// PACKET_MAX_SIZE with either filter's overhead.
+const int PACKET_SIZES[] = { 100, 200, 400, 800, 1440 };
+const int NUM_PACKET_SIZES = sizeof( PACKET_SIZES ) / sizeof( PACKET_SIZES[0] );
+
+const int NUM_ITERATIONS = 20000;
+
+const Mercury::Address ADDRESS( 0x0100007f, 0x1234 );
+
+
+/**
+ *	This function returns a new packet of the given size filled with a
+ *	pattern.
+ */
+Mercury::PacketPtr createPacket( int size )
+{
+	Mercury::PacketPtr pPacket = new Mercury::Packet();
+
+	for (int i = 0; i < size; ++i)
+	{
+		pPacket->data()[i] = char( i * 7 );
+	}
+
+	pPacket->msgEndOffset( size );
+
+	return pPacket;
+}
+
+
+/**
+ *	This function returns whether the packet has the size and contents of one
+ *	from createPacket().
+ */
+bool isOriginalPacket( const Mercury::Packet & packet, int size )
+{
+	if (packet.totalSize() != size)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < size; ++i)
+	{
+		if (packet.data()[i] != char( i * 7 ))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ *	This function encrypts and decrypts packets of the given size with the
+ *	given filter and returns the throughput in megabytes per second.
+ *
+ *	@param isOkay	Set to false if any packet did not decrypt correctly.
+ */
+template <class FILTER>
+double timeFilter( FILTER & filter, int size, bool & isOkay )
+{
+	Mercury::PacketPtr pPacket = createPacket( size );
+
+	uint64 startTime = timestamp();
+
+	for (int i = 0; i < NUM_ITERATIONS; ++i)
+	{
+		Mercury::PacketPtr pEncrypted = filter.encryptPacket( pPacket.get() );
+
+		if (!pEncrypted ||
+			(filter.preprocessRecv( ADDRESS, pEncrypted.get() ) !=
+				Mercury::REASON_SUCCESS))
+		{
+			isOkay = false;
+			break;
+		}
+	}
+
+	double seconds = double( timestamp() - startTime ) / stampsPerSecondD();
+
+	Mercury::PacketPtr pEncrypted = filter.encryptPacket( pPacket.get() );
+	isOkay = isOkay && pEncrypted &&
+		(filter.preprocessRecv( ADDRESS, pEncrypted.get() ) ==
+			Mercury::REASON_SUCCESS) &&
+		isOriginalPacket( *pEncrypted, size );
+
+	return double( size ) * NUM_ITERATIONS / seconds / (1024.0 * 1024.0);
+}
+
+} // anonymous namespace
+
+#endif // USE_OPENSSL || HAS_AES_GCM_FILTER
+
+
+#ifdef HAS_AES_GCM_FILTER
+
+/**
+ *	This test checks that packets survive a round trip through AESGCMFilter
+ *	and that modified packets fail authentication.
+ */
+TEST( AESGCMFilter_round_trip )
+{
+	Mercury::AESGCMFilterPtr pSender = new Mercury::AESGCMFilter();
+	Mercury::AESGCMFilterPtr pReceiver =
+		new Mercury::AESGCMFilter( pSender->key() );
+
+	CHECK( pSender->isGood() );
+	CHECK( pReceiver->isGood() );
+
+	const int SIZE = 500;
+	Mercury::PacketPtr pPacket = createPacket( SIZE );
+
+	Mercury::PacketPtr pFirst = pSender->encryptPacket( pPacket.get() );
+	Mercury::PacketPtr pSecond = pSender->encryptPacket( pPacket.get() );
+
+	CHECK( isOriginalPacket( *pPacket, SIZE ) );
+	CHECK_EQUAL( SIZE + Mercury::AESGCMFilter::NONCE_SIZE +
+			Mercury::AESGCMFilter::TAG_SIZE, pFirst->totalSize() );
+
+	// Each packet has its own nonce, so the same data encrypts differently.
+	CHECK( memcmp( pFirst->data(), pSecond->data(), SIZE ) != 0 );
+
+	CHECK_EQUAL( Mercury::REASON_SUCCESS,
+		pReceiver->preprocessRecv( ADDRESS, pFirst.get() ) );
+	CHECK( isOriginalPacket( *pFirst, SIZE ) );
+
+	pSecond->data()[ 10 ] ^= 0x1;
+
+	CHECK_EQUAL( Mercury::REASON_CORRUPTED_PACKET,
+		pReceiver->preprocessRecv( ADDRESS, pSecond.get() ) );
+
+	// A filter with a different key cannot decrypt the packets.
+	Mercury::AESGCMFilterPtr pOther = new Mercury::AESGCMFilter();
+	Mercury::PacketPtr pThird = pSender->encryptPacket( pPacket.get() );
+
+	CHECK_EQUAL( Mercury::REASON_CORRUPTED_PACKET,
+		pOther->preprocessRecv( ADDRESS, pThird.get() ) );
+}
+
+#endif // HAS_AES_GCM_FILTER
+
+
+#if defined( USE_OPENSSL ) || defined( HAS_AES_GCM_FILTER )
+
+/**
+ *	This test compares the throughput of the available encryption filters for
+ *	a range of packet sizes.
+ */
+TEST( EncryptionFilter_benchmark )
+{
+	printf( "EncryptionFilter_benchmark: MB/s to encrypt and decrypt "
+			"%d packets\n", NUM_ITERATIONS );
+
+	for (int i = 0; i < NUM_PACKET_SIZES; ++i)
+	{
+		int size = PACKET_SIZES[i];
+		bool isOkay = true;
+
+		printf( "\t%4d bytes:", size );
+
+#ifdef USE_OPENSSL
+		Mercury::EncryptionFilterPtr pBlowfish =
+			new Mercury::EncryptionFilter();
+		printf( " Blowfish %7.1f",
+			timeFilter( *pBlowfish, size, isOkay ) );
+#endif
+
+#ifdef HAS_AES_GCM_FILTER
+		Mercury::AESGCMFilterPtr pAES = new Mercury::AESGCMFilter();
+		printf( " AES-128-GCM %7.1f",
+			timeFilter( *pAES, size, isOkay ) );
+#endif
+
+		printf( "\n" );
+
+		CHECK( isOkay );
+	}
+}
+
+#endif // USE_OPENSSL || HAS_AES_GCM_FILTER
+
+// test_encryption_filter.cpp
@@ -0,0 +1,210 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "third_party/CppUnitLite2/src/CppUnitLite2.h"
+
+#include "network/event_poller.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+
+/**
+ *	This class reads a single byte from a pipe each time it is notified.
+ */
+class ByteReader : public Mercury::InputNotificationHandler
+{
+public:
+	ByteReader() : numNotifications_( 0 ) {}
+
+	virtual int handleInputNotification( int fd )
+	{
+		char c;
+		if (read( fd, &c, 1 ) == 1)
+		{
+			++numNotifications_;
+		}
+
+		return 0;
+	}
+
+	int numNotifications() const	{ return numNotifications_; }
+
+private:
+	int numNotifications_;
+};
+
+
+/**
+ *	This class creates a non-blocking pipe.
+ */
+class Pipe
+{
+public:
+	Pipe()
+	{
+		fds_[0] = fds_[1] = -1;
+
+		if (pipe( fds_ ) == 0)
+		{
+			fcntl( fds_[0], F_SETFL, O_NONBLOCK );
+			fcntl( fds_[1], F_SETFL, O_NONBLOCK );
+		}
+	}
+
+	~Pipe()
+	{
+		close( fds_[0] );
+		close( fds_[1] );
+	}
+
+	bool good() const		{ return fds_[0] != -1; }
+	int readFD() const		{ return fds_[0]; }
+
+	void write( int numBytes )
+	{
+		for (int i = 0; i < numBytes; ++i)
+		{
+			char c = char( i );
+			::write( fds_[1], &c, 1 );
+		}
+	}
+
+private:
+	int fds_[2];
+};
+
+
+/**
+ *	This method returns the value of a watcher on the given poller as a string.
+ */
+std::string watcherValue( Mercury::EventPoller & poller, const char * path )
+{
+	std::string result;
+#if ENABLE_WATCHERS
+	Watcher::Mode mode;
+	Mercury::EventPoller::pWatcher()->getAsString( &poller, path,
+			result, mode );
+#endif
+	return result;
+}
+
+} // anonymous namespace
+
+
+/**
+ *	This test checks that a level-triggered descriptor is notified while it has
+ *	unread data, and that an edge-triggered descriptor is notified only when
+ *	new data arrives.
+ */
+TEST( EventPoller_edge_triggered )
+{
+	Mercury::EventPoller * pPoller = Mercury::EventPoller::create();
+
+	Pipe levelPipe;
+	Pipe edgePipe;
+	CHECK( levelPipe.good() && edgePipe.good() );
+
+	ByteReader levelReader;
+	ByteReader edgeReader;
+
+	CHECK( pPoller->registerForRead( levelPipe.readFD(), &levelReader ) );
+	CHECK( pPoller->registerForRead( edgePipe.readFD(), &edgeReader,
+				/* isEdgeTriggered: */ true ) );
+
+	levelPipe.write( 2 );
+	edgePipe.write( 2 );
+
+	pPoller->processPendingEvents( 0.0 );
+	pPoller->processPendingEvents( 0.0 );
+
+	CHECK_EQUAL( 2, levelReader.numNotifications() );
+
+	// Only epoll supports edge-triggered notification. Other pollers fall back
+	// to level-triggered.
+	if (pPoller->getFileDescriptor() != -1)
+	{
+		CHECK_EQUAL( 1, edgeReader.numNotifications() );
+
+		edgePipe.write( 1 );
+		pPoller->processPendingEvents( 0.0 );
+		CHECK_EQUAL( 2, edgeReader.numNotifications() );
+	}
+
+	pPoller->deregisterForRead( levelPipe.readFD() );
+	pPoller->deregisterForRead( edgePipe.readFD() );
+
+	delete pPoller;
+}
+
+
+/**
+ *	This test checks that all ready descriptors are eventually notified when
+ *	there are more of them than the poller initially collects per wakeup, and
+ *	that the wakeups are recorded in the events per wakeup histogram.
+ */
+TEST( EventPoller_many_ready )
+{
+	const int NUM_PIPES = 100;
+
+	Mercury::EventPoller * pPoller = Mercury::EventPoller::create();
+
+	Pipe pipes[ NUM_PIPES ];
+	ByteReader readers[ NUM_PIPES ];
+
+	for (int i = 0; i < NUM_PIPES; ++i)
+	{
+		CHECK( pipes[i].good() );
+		CHECK( pPoller->registerForRead( pipes[i].readFD(), &readers[i] ) );
+		pipes[i].write( 1 );
+	}
+
+	int numWakeups = 0;
+	int numEvents = 0;
+
+	while ((numEvents < NUM_PIPES) && (numWakeups < NUM_PIPES))
+	{
+		numEvents += pPoller->processPendingEvents( 0.0 );
+		++numWakeups;
+	}
+
+	CHECK_EQUAL( NUM_PIPES, numEvents );
+
+	for (int i = 0; i < NUM_PIPES; ++i)
+	{
+		CHECK_EQUAL( 1, readers[i].numNotifications() );
+	}
+
+	// Nothing is ready now, so this wakeup times out.
+	CHECK_EQUAL( 0, pPoller->processPendingEvents( 0.0 ) );
+
+#if ENABLE_WATCHERS
+	CHECK_EQUAL( std::string( "1" ),
+			watcherValue( *pPoller, "eventsPerWakeup/0" ) );
+#endif
+
+	for (int i = 0; i < NUM_PIPES; ++i)
+	{
+		pPoller->deregisterForRead( pipes[i].readFD() );
+	}
+
+	delete pPoller;
+}
+
+#endif // _WIN32
+
+// test_event_poller.cpp
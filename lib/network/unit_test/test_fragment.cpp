@@ -17,6 +17,7 @@ criminal penalties as provided by law.
 #include "network/channel_owner.hpp"
 #include "network/interfaces.hpp"
 #include "network/network_interface.hpp"
+#include "network/packet_receiver_stats.hpp"
 #include "network/nub_exception.hpp"
 #include "network/packet_filter.hpp"
 #include "network/unit_test/network_app.hpp"
@@ -732,6 +733,23 @@ TEST( Fragment_children )
 		(serverApp.onceOffMsgCount() == numChildren * NUM_ITERATIONS),
 		"Received more messages than were expected" );
 
+	// Compare the message data that had to be copied before being handled
+	// with what copying every multi-packet message into a contiguous buffer
+	// would have cost.
+	const Mercury::PacketReceiverStats & stats =
+		serverApp.networkInterface().receivingStats();
+
+	const double megabytesReceived =
+		stats.numBytesReceived() / (1024.0 * 1024.0);
+
+	printf( "Fragment_children: bytes copied per MB received: "
+			"%.0f contiguous, %.0f from packet chain\n",
+		stats.numMultiPacketMessageBytes() / megabytesReceived,
+		stats.numMessageBytesCopied() / megabytesReceived );
+
+	ASSERT_WITH_MESSAGE(
+		stats.numMessageBytesCopied() < stats.numMultiPacketMessageBytes(),
+		"Multi-packet messages were copied" );
 }
 
 #define DEFINE_SERVER_HERE
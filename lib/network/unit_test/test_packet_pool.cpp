@@ -0,0 +1,183 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "third_party/CppUnitLite2/src/CppUnitLite2.h"
+
+#include "cstdmf/concurrency.hpp"
+#include "cstdmf/timestamp.hpp"
+
+#include "network/packet.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+const int NUM_THREADS = 4;
+const int NUM_PACKETS = 256;
+const int NUM_ITERATIONS = 2000;
+
+typedef std::vector< Mercury::Packet * > Packets;
+
+
+/**
+ *	This function allocates and frees a set of packets many times, using either
+ *	the packet pool or the general heap.
+ */
+void allocatePackets( bool shouldUsePool )
+{
+	Packets packets( NUM_PACKETS );
+
+	for (int i = 0; i < NUM_ITERATIONS; ++i)
+	{
+		for (int j = 0; j < NUM_PACKETS; ++j)
+		{
+			packets[j] = shouldUsePool ?
+				new Mercury::Packet() : ::new Mercury::Packet();
+		}
+
+		for (int j = 0; j < NUM_PACKETS; ++j)
+		{
+			if (shouldUsePool)
+			{
+				delete packets[j];
+			}
+			else
+			{
+				::delete packets[j];
+			}
+		}
+	}
+}
+
+
+void heapThreadMain( void * arg )
+{
+	allocatePackets( false );
+}
+
+
+void poolThreadMain( void * arg )
+{
+	allocatePackets( true );
+}
+
+
+void cachedPoolThreadMain( void * arg )
+{
+	Mercury::Packet::enableThreadCache();
+	allocatePackets( true );
+	Mercury::Packet::disableThreadCache();
+}
+
+
+/**
+ *	This function runs the given function in a number of threads at once and
+ *	returns the time taken, in seconds.
+ */
+double timeThreads( SimpleThreadFunc func )
+{
+	uint64 startTime = timestamp();
+
+	std::vector< SimpleThread * > threads;
+
+	for (int i = 0; i < NUM_THREADS; ++i)
+	{
+		threads.push_back( new SimpleThread( func, NULL ) );
+	}
+
+	for (uint i = 0; i < threads.size(); ++i)
+	{
+		delete threads[i];
+	}
+
+	return double( timestamp() - startTime ) / stampsPerSecondD();
+}
+
+} // anonymous namespace
+
+
+/**
+ *	This test checks that freed packets are reused.
+ */
+TEST( Packet_pool_reuse )
+{
+	// The address is kept as an integer, since the packet is freed.
+	Mercury::Packet * pPacket = new Mercury::Packet();
+	const uintptr oldAddress = uintptr( pPacket );
+	delete pPacket;
+
+	Mercury::Packet * pNewPacket = new Mercury::Packet();
+	CHECK( uintptr( pNewPacket ) == oldAddress );
+	CHECK_EQUAL( 0, pNewPacket->msgEndOffset() );
+	delete pNewPacket;
+}
+
+
+/**
+ *	This test checks that a thread cache hands out distinct packets and
+ *	returns them all to the pool when it is disabled.
+ */
+TEST( Packet_thread_cache )
+{
+	Mercury::Packet::enableThreadCache();
+
+	Packets packets;
+
+	for (int i = 0; i < NUM_PACKETS; ++i)
+	{
+		packets.push_back( new Mercury::Packet() );
+	}
+
+	std::sort( packets.begin(), packets.end() );
+	CHECK( std::unique( packets.begin(), packets.end() ) == packets.end() );
+
+	for (uint i = 0; i < packets.size(); ++i)
+	{
+		delete packets[i];
+	}
+
+	Mercury::Packet::disableThreadCache();
+
+	// With the cache disabled, freed packets go straight back to the pool.
+	Mercury::Packet * pPacket = new Mercury::Packet();
+	const uintptr oldAddress = uintptr( pPacket );
+	delete pPacket;
+
+	Mercury::Packet * pNewPacket = new Mercury::Packet();
+	CHECK( uintptr( pNewPacket ) == oldAddress );
+	delete pNewPacket;
+}
+
+
+/**
+ *	This test compares the time taken to allocate packets from the general heap,
+ *	from the packet pool and from the packet pool with thread caches.
+ */
+TEST( Packet_pool_benchmark )
+{
+	double heapTime = timeThreads( heapThreadMain );
+	double poolTime = timeThreads( poolThreadMain );
+	double cachedPoolTime = timeThreads( cachedPoolThreadMain );
+
+	printf( "Packet_pool_benchmark: %d threads x %d allocations\n"
+			"\tnew/delete:          %.3fs\n"
+			"\tpool:                %.3fs\n"
+			"\tpool + thread cache: %.3fs\n",
+		NUM_THREADS, NUM_PACKETS * NUM_ITERATIONS,
+		heapTime, poolTime, cachedPoolTime );
+}
+
+// test_packet_pool.cpp
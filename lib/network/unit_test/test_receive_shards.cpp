@@ -0,0 +1,267 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "pch.hpp"
+
+#include "third_party/CppUnitLite2/src/CppUnitLite2.h"
+#include "common_interface.hpp"
+
+#include "network/event_dispatcher.hpp"
+#include "network/network_interface.hpp"
+#include "network/packet_filter.hpp"
+
+#include <map>
+
+namespace
+{
+
+const int NUM_SENDERS = 8;
+const int NUM_SENDS = 100;
+const int NUM_SHARDS = 4;
+
+/**
+ *	This class checks that the messages from each sender arrive in order. The
+ *	kernel chooses a socket for each sender, so different senders may be read
+ *	by different threads.
+ */
+class LocalHandler : public CommonHandler, public TimerHandler
+{
+public:
+	LocalHandler( Mercury::EventDispatcher & dispatcher, int numExpected ) :
+		dispatcher_( dispatcher ),
+		numExpected_( numExpected ),
+		numReceived_( 0 ),
+		inOrder_( true ),
+		hasTimedOut_( false )
+	{
+	}
+
+	int numReceived() const		{ return numReceived_; }
+	bool inOrder() const		{ return inOrder_; }
+	bool hasTimedOut() const	{ return hasTimedOut_; }
+
+protected:
+	virtual void on_msg1( const Mercury::Address & srcAddr,
+			const CommonInterface::msg1Args & args )
+	{
+		uint32 & nextSeq = nextSeqs_[ srcAddr ];
+
+		if (args.seq != nextSeq)
+		{
+			inOrder_ = false;
+		}
+
+		++nextSeq;
+
+		if (++numReceived_ == numExpected_)
+		{
+			dispatcher_.breakProcessing();
+		}
+	}
+
+	void handleTimeout( TimerHandle handle, void * arg )
+	{
+		hasTimedOut_ = true;
+		dispatcher_.breakProcessing();
+	}
+
+private:
+	Mercury::EventDispatcher & dispatcher_;
+	std::map< Mercury::Address, uint32 > nextSeqs_;
+	int numExpected_;
+	int numReceived_;
+	bool inOrder_;
+	bool hasTimedOut_;
+};
+
+
+/**
+ *	This filter XORs every byte of a packet with a constant. It keeps no
+ *	state so received packets can be decoded on a receive thread.
+ */
+class XORFilter : public Mercury::PacketFilter
+{
+public:
+	virtual Mercury::Reason send( Mercury::NetworkInterface & networkInterface,
+			const Mercury::Address & addr, Mercury::Packet * pPacket )
+	{
+		// The original packet may be resent, so encode a copy of it.
+		Mercury::PacketPtr pEncoded = new Mercury::Packet();
+		memcpy( pEncoded->data(), pPacket->data(), pPacket->totalSize() );
+		pEncoded->msgEndOffset( pPacket->totalSize() );
+		this->apply( pEncoded.get() );
+
+		return this->PacketFilter::send( networkInterface, addr,
+			pEncoded.get() );
+	}
+
+	virtual Mercury::Reason recv( Mercury::PacketReceiver & receiver,
+			const Mercury::Address & addr, Mercury::Packet * pPacket,
+			Mercury::ProcessSocketStatsHelper * pStatsHelper )
+	{
+		this->apply( pPacket );
+		return this->PacketFilter::recv( receiver, addr, pPacket,
+			pStatsHelper );
+	}
+
+	virtual bool isThreadSafe() const { return true; }
+
+	virtual Mercury::Reason preprocessRecv( const Mercury::Address & addr,
+			Mercury::Packet * pPacket )
+	{
+		this->apply( pPacket );
+		return Mercury::REASON_SUCCESS;
+	}
+
+private:
+	void apply( Mercury::Packet * pPacket ) const
+	{
+		for (int i = 0; i < pPacket->totalSize(); ++i)
+		{
+			pPacket->data()[i] ^= 0x5a;
+		}
+	}
+};
+
+
+/**
+ *	This method returns the value of a watcher on the given interface as a
+ *	string.
+ */
+std::string watcherValue( Mercury::NetworkInterface & networkInterface,
+		const char * path )
+{
+	std::string result;
+#if ENABLE_WATCHERS
+	Watcher::Mode mode;
+	Mercury::NetworkInterface::pWatcher()->getAsString( &networkInterface,
+			path, result, mode );
+#endif
+	return result;
+}
+
+
+/**
+ *	This function sends bursts of messages from a number of interfaces to one
+ *	that has receive threads and checks that they are all dispatched, in
+ *	order.
+ */
+void runShardedReceive( TestResult & result_, const char * m_name,
+		bool shouldFilter )
+{
+	Mercury::EventDispatcher dispatcher;
+
+	Mercury::NetworkInterface toInterface( &dispatcher,
+		Mercury::NETWORK_INTERFACE_INTERNAL );
+
+	CHECK( toInterface.setNumReceiveShards( NUM_SHARDS ) );
+	CHECK_EQUAL( NUM_SHARDS, toInterface.numReceiveShards() );
+
+	LocalHandler handler( dispatcher, NUM_SENDERS * NUM_SENDS );
+	toInterface.pExtensionData( &handler );
+
+	CommonInterface::registerWithInterface( toInterface );
+
+	Mercury::PacketFilterPtr pFilter =
+		shouldFilter ? new XORFilter() : NULL;
+
+	Mercury::NetworkInterface * fromInterfaces[ NUM_SENDERS ];
+	Mercury::Channel * fromChannels[ NUM_SENDERS ];
+	Mercury::Channel * toChannels[ NUM_SENDERS ];
+
+	for (int i = 0; i < NUM_SENDERS; ++i)
+	{
+		fromInterfaces[i] = new Mercury::NetworkInterface( &dispatcher,
+			Mercury::NETWORK_INTERFACE_INTERNAL );
+		CommonInterface::registerWithInterface( *fromInterfaces[i] );
+
+		fromChannels[i] = new Mercury::Channel( *fromInterfaces[i],
+			toInterface.address(), Mercury::Channel::INTERNAL, 1.f, pFilter );
+		fromChannels[i]->isLocalRegular( false );
+		fromChannels[i]->isRemoteRegular( false );
+
+		toChannels[i] = new Mercury::Channel( toInterface,
+			fromInterfaces[i]->address(), Mercury::Channel::INTERNAL, 1.f,
+			pFilter );
+		toChannels[i]->isLocalRegular( false );
+		toChannels[i]->isRemoteRegular( false );
+	}
+
+	for (int seq = 0; seq < NUM_SENDS; ++seq)
+	{
+		for (int i = 0; i < NUM_SENDERS; ++i)
+		{
+			CommonInterface::msg1Args & args =
+				CommonInterface::msg1Args::start( fromChannels[i]->bundle() );
+			args.seq = seq;
+			args.data = 0;
+			fromChannels[i]->send();
+		}
+	}
+
+	TimerHandle timeoutHandle = dispatcher.addTimer( 5 * 1000000, &handler );
+
+	dispatcher.processUntilBreak();
+
+	timeoutHandle.cancel();
+
+	CHECK( !handler.hasTimedOut() );
+	CHECK( handler.inOrder() );
+	CHECK_EQUAL( NUM_SENDERS * NUM_SENDS, handler.numReceived() );
+
+#if ENABLE_WATCHERS
+	// Unless the kernel chose the main socket for every sender, some of the
+	// packets were read by a receive thread.
+	CHECK( atoi( watcherValue( toInterface,
+			"receiveShards/numPacketsReceived" ).c_str() ) > 0 );
+
+	if (shouldFilter)
+	{
+		CHECK( atoi( watcherValue( toInterface,
+				"receiveShards/numPacketsPreprocessed" ).c_str() ) > 0 );
+	}
+#endif
+
+	for (int i = 0; i < NUM_SENDERS; ++i)
+	{
+		fromChannels[i]->destroy();
+		toChannels[i]->destroy();
+	}
+
+	CHECK( toInterface.setNumReceiveShards( 0 ) );
+	CHECK_EQUAL( 0, toInterface.numReceiveShards() );
+
+	for (int i = 0; i < NUM_SENDERS; ++i)
+	{
+		delete fromInterfaces[i];
+	}
+}
+
+} // anonymous namespace
+
+
+TEST( ReceiveShards_unfiltered )
+{
+	runShardedReceive( result_, m_name, false );
+}
+
+
+/**
+ *	This test checks that packets on a channel with a thread-safe filter are
+ *	decoded by the receive threads.
+ */
+TEST( ReceiveShards_filtered )
+{
+	runShardedReceive( result_, m_name, true );
+}
+
+// test_receive_shards.cpp
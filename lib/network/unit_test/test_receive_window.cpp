@@ -24,9 +24,13 @@ criminal penalties as provided by law.
 #include "network/network_interface.hpp"
 #include "network/packet.hpp"
 #include "network/packet_filter.hpp"
+#include "network/packet_monitor.hpp"
 #include "network/packet_receiver.hpp"
 
+#include "cstdmf/timestamp.hpp"
+
 #include <memory>
+#include <vector>
 
 namespace
 {
@@ -190,4 +194,229 @@ TEST_F( TestReceiveWindowFixture, ReceiveWindow_test )
 	CHECK_EQUAL( TEST_END_SEQ + 1, handler_.numReceived() );
 }
 
+
+namespace
+{
+
+/**
+ *	This class counts the packets and bytes that a network interface puts on
+ *	the wire.
+ */
+class WireCounter : public Mercury::PacketMonitor
+{
+public:
+	WireCounter() :
+		numPackets_( 0 ),
+		numBytes_( 0 ),
+		numSelectiveAckPackets_( 0 )
+	{}
+
+	virtual void packetOut( const Mercury::Address & addr,
+			const Mercury::Packet & packet )
+	{
+		++numPackets_;
+		numBytes_ += packet.totalSize();
+
+		if (packet.hasFlags( Mercury::Packet::FLAG_HAS_SELECTIVE_ACKS ))
+		{
+			++numSelectiveAckPackets_;
+		}
+	}
+
+	virtual void packetIn( const Mercury::Address & addr,
+			const Mercury::Packet & packet )
+	{
+	}
+
+	uint numPackets() const				{ return numPackets_; }
+	uint numBytes() const				{ return numBytes_; }
+	uint numSelectiveAckPackets() const	{ return numSelectiveAckPackets_; }
+
+private:
+	uint numPackets_;
+	uint numBytes_;
+	uint numSelectiveAckPackets_;
+};
+
+
+const uint NUM_MESSAGES = 2000;
+const uint MESSAGES_PER_TICK = 8;
+
+
+/**
+ *	This class streams messages over a lossy channel and records how long each
+ *	one took to be delivered.
+ */
+class LossyStreamHandler : public CommonHandler, public TimerHandler
+{
+public:
+	LossyStreamHandler( Mercury::EventDispatcher & dispatcher,
+			Mercury::Channel & fromChannel ) :
+		dispatcher_( dispatcher ),
+		fromChannel_( fromChannel ),
+		sendTimes_( NUM_MESSAGES ),
+		numSent_( 0 ),
+		numReceived_( 0 ),
+		isInOrder_( true ),
+		totalLatency_( 0 ),
+		maxLatency_( 0 )
+	{
+	}
+
+	bool isInOrder() const		{ return isInOrder_; }
+	uint numReceived() const	{ return numReceived_; }
+
+	double averageLatency() const
+	{
+		return numReceived_ ?
+			totalLatency_ / stampsPerSecondD() / numReceived_ : 0.0;
+	}
+
+	double maxLatency() const
+	{
+		return maxLatency_ / stampsPerSecondD();
+	}
+
+protected:
+	virtual void on_msg1( const Mercury::Address & srcAddr,
+			const CommonInterface::msg1Args & args )
+	{
+		if (args.seq != numReceived_)
+		{
+			isInOrder_ = false;
+		}
+
+		if (args.seq < NUM_MESSAGES)
+		{
+			const uint64 latency = timestamp() - sendTimes_[ args.seq ];
+			totalLatency_ += latency;
+			maxLatency_ = std::max( maxLatency_, latency );
+		}
+
+		++numReceived_;
+	}
+
+	virtual void handleTimeout( TimerHandle handle, void * arg )
+	{
+		for (uint i = 0;
+				(i < MESSAGES_PER_TICK) && (numSent_ < NUM_MESSAGES); ++i)
+		{
+			CommonInterface::msg1Args & args =
+				CommonInterface::msg1Args::start( fromChannel_.bundle() );
+			args.seq = numSent_;
+			args.data = 0;
+			sendTimes_[ numSent_ ] = timestamp();
+			++numSent_;
+			fromChannel_.send();
+		}
+
+		// Keep checking the resend timers once everything has been sent so
+		// that losses at the end of the stream are recovered.
+		if (numSent_ == NUM_MESSAGES)
+		{
+			fromChannel_.send();
+		}
+
+		if ((numReceived_ == NUM_MESSAGES) &&
+			!fromChannel_.hasUnackedPackets())
+		{
+			dispatcher_.breakProcessing();
+		}
+	}
+
+private:
+	Mercury::EventDispatcher & dispatcher_;
+	Mercury::Channel & fromChannel_;
+
+	std::vector< uint64 > sendTimes_;
+	uint numSent_;
+	uint numReceived_;
+	bool isInOrder_;
+
+	uint64 totalLatency_;
+	uint64 maxLatency_;
+};
+
+} // anonymous namespace
+
+
+/**
+ *	This test streams reliable packets over a channel that drops 10% of the
+ *	packets in each direction. Because every ACK packet repeats the selective
+ *	ACKs for the packets buffered past a gap, a lost ACK rarely causes a
+ *	packet that did arrive to be resent. It reports the traffic in each
+ *	direction and how long the messages took to be delivered.
+ */
+TEST( ReceiveWindow_selectiveAcks )
+{
+	Mercury::EventDispatcher dispatcher;
+
+	Mercury::NetworkInterface fromInterface( &dispatcher,
+		Mercury::NETWORK_INTERFACE_INTERNAL );
+	Mercury::NetworkInterface toInterface( &dispatcher,
+		Mercury::NETWORK_INTERFACE_INTERNAL );
+
+	CommonInterface::registerWithInterface( fromInterface );
+	CommonInterface::registerWithInterface( toInterface );
+
+	WireCounter dataCounter;
+	WireCounter ackCounter;
+	fromInterface.setPacketMonitor( &dataCounter );
+	toInterface.setPacketMonitor( &ackCounter );
+
+	const float RESEND_DELAY = 0.1f;
+
+	Mercury::Channel * pFromChannel =
+		new Mercury::Channel( fromInterface, toInterface.address(),
+			Mercury::Channel::INTERNAL, RESEND_DELAY );
+	pFromChannel->isLocalRegular( false );
+	pFromChannel->isRemoteRegular( false );
+
+	Mercury::Channel * pToChannel =
+		new Mercury::Channel( toInterface, fromInterface.address(),
+			Mercury::Channel::INTERNAL, RESEND_DELAY );
+	pToChannel->isLocalRegular( false );
+	pToChannel->isRemoteRegular( false );
+
+	LossyStreamHandler handler( dispatcher, *pFromChannel );
+	toInterface.pExtensionData( &handler );
+
+	fromInterface.setLossRatio( 0.1f );
+	toInterface.setLossRatio( 0.1f );
+
+	TimerHandle timerHandle = dispatcher.addTimer( 2000, &handler, NULL );
+
+	const uint64 startTime = timestamp();
+	dispatcher.processUntilBreak();
+	const double duration = (timestamp() - startTime) / stampsPerSecondD();
+
+	timerHandle.cancel();
+
+	CHECK( handler.isInOrder() );
+	CHECK_EQUAL( NUM_MESSAGES, handler.numReceived() );
+	CHECK( ackCounter.numSelectiveAckPackets() > 0 );
+
+	// Mostly only the lost packets should be resent. Chains of resends for
+	// packets that did arrive would push this well past the loss ratio.
+	CHECK( pFromChannel->numPacketsResent() <
+		NUM_MESSAGES / 4 );
+
+	printf( "ReceiveWindow_selectiveAcks: %u messages in %.2fs, "
+			"%u resends\n"
+		"\tdata: %u packets, %u bytes\n"
+		"\tacks: %u packets, %u bytes, %u with selective acks\n"
+		"\tdelivery latency: average %.1fms, max %.1fms\n",
+		handler.numReceived(), duration, pFromChannel->numPacketsResent(),
+		dataCounter.numPackets(), dataCounter.numBytes(),
+		ackCounter.numPackets(), ackCounter.numBytes(),
+		ackCounter.numSelectiveAckPackets(),
+		handler.averageLatency() * 1000.0, handler.maxLatency() * 1000.0 );
+
+	fromInterface.setPacketMonitor( NULL );
+	toInterface.setPacketMonitor( NULL );
+
+	pFromChannel->destroy();
+	pToChannel->destroy();
+}
+
 // test_receive_window.cpp
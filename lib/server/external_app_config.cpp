@@ -11,6 +11,8 @@ criminal penalties as provided by law.
 
 #include "external_app_config.hpp"
 
+#include "network/congestion_controller.hpp"
+
 // These need to be defined before including server_app_option_macros.hpp
 #define BW_CONFIG_CLASS ExternalAppConfig
 #define BW_CONFIG_PREFIX ""
@@ -24,10 +26,31 @@ BW_OPTION_RO( float, externalLatencyMin, 0.f );
 BW_OPTION_RO( float, externalLatencyMax, 0.f );
 BW_OPTION_RO( float, externalLossRatio, 0.f );
 
+BW_OPTION_RO( int, externalReceiveBatchSize, 1 );
+BW_OPTION_RO( bool, externalShouldBatchSends, false );
+BW_OPTION_RO( int, externalReceiveShards, 0 );
+
 BW_OPTION_RO( std::string, externalInterface, "" );
 
+BW_OPTION_RO( std::string, externalCongestionControl, "" );
+
 bool ExternalAppConfig::postInit()
 {
+	// Check that the congestion control policy exists. This reports an error
+	// if it does not.
+	if (!externalCongestionControl().empty())
+	{
+		Mercury::CongestionControllerPtr pController =
+			Mercury::CongestionController::create(
+				externalCongestionControl(),
+				Mercury::CongestionController::MIN_WINDOW );
+
+		if (!pController)
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -24,8 +24,14 @@ public:
 	static ServerAppOption< float > externalLatencyMax;
 	static ServerAppOption< float > externalLossRatio;
 
+	static ServerAppOption< int > externalReceiveBatchSize;
+	static ServerAppOption< bool > externalShouldBatchSends;
+	static ServerAppOption< int > externalReceiveShards;
+
 	static ServerAppOption< std::string > externalInterface;
 
+	static ServerAppOption< std::string > externalCongestionControl;
+
 protected:
 	static bool postInit();
 };
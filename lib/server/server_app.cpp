@@ -13,6 +13,9 @@ criminal penalties as provided by law.
 
 #include "server_app_config.hpp"
 
+#include "cstdmf/heap_profiler.hpp"
+#include "cstdmf/memory_stream_arena.hpp"
+#include "cstdmf/trace_buffer.hpp"
 #include "cstdmf/watcher.hpp"
 #include "network/network_interface.hpp"
 #include "network/event_dispatcher.hpp"
@@ -56,6 +59,12 @@ ServerApp::ServerApp( Mercury::EventDispatcher & mainDispatcher,
 	MF_WATCH( "gameTimeInTicks", time_, Watcher::WT_READ_ONLY );
 	MF_WATCH( "gameTimeInSeconds", *this, &ServerApp::gameTimeInSeconds );
 
+#if ENABLE_WATCHERS
+	HeapProfiler::addWatchers();
+	MemoryStreamArena::addWatchers();
+	TraceBuffer::addWatchers();
+#endif
+
 	interface_.pExtensionData( this );
 }
 
@@ -119,6 +128,7 @@ bool ServerApp::init( int argc, char * argv[] )
 	// Handle signals
 	this->enableSignalHandler( SIGINT );
 	this->enableSignalHandler( SIGHUP );
+	this->enableSignalHandler( SIGUSR2 );
 
 	return true;
 }
@@ -241,6 +251,11 @@ void ServerApp::onSignalled( int sigNum )
 	case SIGINT:
 	case SIGHUP:
 		this->shutDown();
+		break;
+	case SIGUSR2:
+		TraceBuffer::dump( "trace_" + std::string( this->getAppName() ) +
+				".json", TraceBuffer::dumpPeriod() );
+		break;
 	default:
 		break;
 	}
@@ -541,10 +541,10 @@ void MozillaWebPageManager::mainLoopInternal()
 		}
 		else
 		{
-			if (commandFifo_.count() > 0) 
+			MozillaWebPageCommandPtr command;
+			if (commandFifo_.pop(command)) 
 			{
 				processed = true;
-				MozillaWebPageCommandPtr command = commandFifo_.pop();
 				processCommand(command);
 			}
 
@@ -906,9 +906,9 @@ bool MozillaWebPageManager::s_tick(float dTime)
 */
 void MozillaWebPageManager::internalProcessCallbacks()
 {
-	while (callbackFifo_.count() > 0)
+	MozillaWebPageCommandPtr command;
+	while (callbackFifo_.pop(command))
 	{
-		MozillaWebPageCommandPtr command = callbackFifo_.pop();
 		CommandMozillaWebPageCallbackBase* inCommand = (CommandMozillaWebPageCallbackBase*)command.get();
 		MapIntMozillaWebPageInterface::iterator iter = mapIntMozillaWebPageInterface_.find(inCommand->key_);
 		if (iter == mapIntMozillaWebPageInterface_.end())
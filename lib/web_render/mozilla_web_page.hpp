@@ -19,7 +19,7 @@ criminal penalties as provided by law.
 #include "romp/texture_feeds.hpp"
 #include "web_page.hpp"
 #include "third_party/LLMozlib2/llmozlib2.h"
-#include "cstdmf/safe_fifo.hpp"
+#include "cstdmf/mpsc_queue.hpp"
 #include "mozilla_web_page_command.hpp"
 
 class MozillaWebPageInterface;
@@ -91,9 +91,9 @@ private:
 	//to protect internal data
 	mutable SimpleMutex managerMutex_;
 	//commands fifo
-	SafeFifo<MozillaWebPageCommandPtr > commandFifo_;
+	UnboundedMPSCQueue<MozillaWebPageCommandPtr > commandFifo_;
 	//callbacks fifo
-	SafeFifo<MozillaWebPageCommandPtr > callbackFifo_;
+	UnboundedMPSCQueue<MozillaWebPageCommandPtr > callbackFifo_;
 
 	volatile int runningState_;
 	typedef std::map<int, MozillaWebPagePtr> MapIntMozillaWebPage;
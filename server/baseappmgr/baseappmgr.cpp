@@ -35,6 +35,7 @@ criminal penalties as provided by law.
 
 #include "cstdmf/memory_stream.hpp"
 #include "cstdmf/timestamp.hpp"
+#include "cstdmf/trace_buffer.hpp"
 
 #include "server/shared_data_type.hpp"
 
@@ -618,6 +619,8 @@ void BaseAppMgr::handleTimeout( TimerHandle /*handle*/, void * arg )
 	{
 		case TIMEOUT_GAME_TICK:
 		{
+			TraceBuffer::tick();
+
 			++time_;
 
 			if (time_ % Config::timeSyncPeriodInTicks() == 0)
@@ -139,6 +139,7 @@ Database::Database( Mercury::EventDispatcher & mainDispatcher,
 	shouldSendInitData_( false ),
 	shouldConsolidate_( true ),
 	statusCheckTimerHandle_(),
+	writeBehindCache_( mainDispatcher ),
 	curLoad_( 1.f ),
 	anyCellAppOverloaded_( true ),
 	overloadStartTime_( 0 ),
@@ -355,6 +356,8 @@ bool Database::init( int argc, char * argv[] )
 		return false;
 	}
 
+	writeBehindCache_.init( *pDatabase_ );
+
 	if (!this->initBillingSystem())
 	{
 		ERROR_MSG( "Database::init: Failed to initialise billing system\n" );
@@ -508,6 +511,8 @@ void Database::addWatchers( Watcher & watcher )
 	watcher.addChild( "anyCellAppOverloaded",
 			makeWatcher( &Database::anyCellAppOverloaded_ ), this );
 
+	writeBehindCache_.addWatchers( watcher );
+
 	// Command watcher to shutdown DBMgr
 	watcher.addChild( "command/shutDown",
 			new NoArgFuncCallableWatcher( commandShutDown,
@@ -534,6 +539,9 @@ bool Database::run()
  */
 void Database::finalise()
 {
+	// Write any held entity data before the database layer shuts down.
+	writeBehindCache_.fini();
+
 	if (pDatabase_)
 	{
 		pDatabase_->shutDown();
@@ -938,6 +946,9 @@ void Database::shutDownNicely()
 
 	status_.set( DBStatus::SHUTTING_DOWN, "Shutting down" );
 
+	// Consolidation reads the primary database, so it must be up to date.
+	writeBehindCache_.fini();
+
 	interface_.processUntilChannelsEmpty();
 
 	if (shouldConsolidate_)
@@ -1031,6 +1042,8 @@ void Database::getEntity( const EntityDBKey & entityKey,
 			const char * pPasswordOverride,
 			GetEntityHandler & handler )
 {
+	writeBehindCache_.onGetEntity( entityKey, pStream != NULL );
+
 	pDatabase_->getEntity( entityKey, pStream, shouldGetBaseEntityLocation,
 			pPasswordOverride, handler );
 }
@@ -1055,6 +1068,13 @@ void Database::putEntity( const EntityKey & entityKey,
 		this->remapMailbox( *pBaseMailbox );
 	}
 
+	if (writeBehindCache_.putEntity( entityKey, entityID,
+			pStream, pBaseMailbox, removeBaseMailbox, updateAutoLoad, handler ))
+	{
+		// Written later, possibly together with newer writes.
+		return;
+	}
+
 	pDatabase_->putEntity( entityKey, entityID,
 			pStream, pBaseMailbox, removeBaseMailbox, updateAutoLoad, handler );
 }
@@ -1067,6 +1087,8 @@ void Database::putEntity( const EntityKey & entityKey,
 void Database::delEntity( const EntityDBKey & ekey, EntityID entityID,
 		IDatabase::IDelEntityHandler& handler )
 {
+	writeBehindCache_.flush( ekey );
+
 	pDatabase_->delEntity( ekey, entityID, handler );
 }
 
@@ -1641,6 +1663,10 @@ void Database::executeRawCommand( const Mercury::Address & srcAddr,
 	BinaryIStream & data )
 {
 	std::string command( (char*)data.retrieve( header.length ), header.length );
+
+	// The command may read entity data.
+	writeBehindCache_.flushAll();
+
 	ExecuteRawCommandHandler* pHandler =
 		new ExecuteRawCommandHandler( *this, srcAddr, header.replyID );
 	pHandler->executeRawCommand( command );
@@ -1941,16 +1967,22 @@ bool Database::onCompleteEntityCheckout( const EntityKey& entityID,
 	bool isErased = (inProgCheckouts_.erase( entityID ) > 0);
 	if (isErased && (checkoutCompletionListeners_.size() > 0))
 	{
-		std::pair< CheckoutCompletionListeners::iterator,
-				CheckoutCompletionListeners::iterator > listeners =
-			checkoutCompletionListeners_.equal_range( entityID );
-		for ( CheckoutCompletionListeners::const_iterator iter =
-				listeners.first; iter != listeners.second; ++iter )
+		CheckoutCompletionListeners::iterator found =
+			checkoutCompletionListeners_.find( entityID );
+
+		if (found != checkoutCompletionListeners_.end())
 		{
-			iter->second->onCheckoutCompleted( pBaseRef );
+			// The listeners are taken out of the map before being called, in
+			// case they modify it.
+			std::vector< ICheckoutCompletionListener* > listeners;
+			listeners.swap( found->second );
+			checkoutCompletionListeners_.erase( found );
+
+			for (size_t i = 0; i < listeners.size(); ++i)
+			{
+				listeners[i]->onCheckoutCompleted( pBaseRef );
+			}
 		}
-		checkoutCompletionListeners_.erase( listeners.first,
-				listeners.second );
 	}
 
 	return isErased;
@@ -1969,8 +2001,7 @@ bool Database::registerCheckoutCompletionListener( EntityTypeID typeID,
 	bool isFound = (inProgCheckouts_.find( key ) != inProgCheckouts_.end());
 	if (isFound)
 	{
-		CheckoutCompletionListeners::value_type item( key, &listener );
-		checkoutCompletionListeners_.insert( item );
+		checkoutCompletionListeners_[ key ].push_back( &listener );
 	}
 	return isFound;
 }
@@ -13,11 +13,13 @@ criminal penalties as provided by law.
 #define DATABASE_HPP
 
 #include "db_interface.hpp"
+#include "write_behind_cache.hpp"
 
 #include "dbmgr_lib/db_status.hpp"
 
 #include "connection/log_on_params.hpp"
 
+#include "cstdmf/hash_map.hpp"
 #include "cstdmf/singleton.hpp"
 
 #include "dbmgr_lib/idatabase.hpp"
@@ -352,13 +354,15 @@ private:
 
 	TimerHandle				statusCheckTimerHandle_;
 
+	WriteBehindCache		writeBehindCache_;
+
 	friend class RelogonAttemptHandler;
-	typedef std::map< EntityKey, RelogonAttemptHandler * > PendingAttempts;
+	typedef HashMap< EntityKey, RelogonAttemptHandler * > PendingAttempts;
 	PendingAttempts pendingAttempts_;
 	typedef std::set< EntityKey > EntityKeySet;
 	EntityKeySet	inProgCheckouts_;
 
-	typedef std::multimap< EntityKey, ICheckoutCompletionListener* >
+	typedef HashMap< EntityKey, std::vector< ICheckoutCompletionListener* > >
 			CheckoutCompletionListeners;
 	CheckoutCompletionListeners checkoutCompletionListeners_;
 
@@ -366,7 +370,7 @@ private:
 	bool				anyCellAppOverloaded_;
 	uint64				overloadStartTime_;
 
-	typedef std::map< Mercury::Address, BackupHash >	MailboxRemapInfo;
+	typedef HashMap< Mercury::Address, BackupHash >	MailboxRemapInfo;
 	MailboxRemapInfo	mailboxRemapInfo_;
 	int					mailboxRemapCheckCount_;
 
@@ -32,6 +32,12 @@ BW_OPTION( float, overloadTolerancePeriod, 5.f );
 
 BW_OPTION_RO( std::string, type, "xml" );
 
+BW_OPTION_FULL( float, writeBehindDelay, 0.f,
+		"dbMgr/writeBehind/delay", "config/writeBehind/delay" );
+BW_OPTION_FULL( int, writeBehindMaxDirtyBytes, 64 * 1024 * 1024,
+		"dbMgr/writeBehind/maxDirtyBytes",
+		"config/writeBehind/maxDirtyBytes" );
+
 
 /**
  *
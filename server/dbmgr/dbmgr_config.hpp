@@ -23,6 +23,9 @@ public:
 
 	static ServerAppOption< std::string > type;
 
+	static ServerAppOption< float > writeBehindDelay;
+	static ServerAppOption< int > writeBehindMaxDirtyBytes;
+
 	static uint64 overloadTolerancePeriodInStamps()
 	{
 		return secondsToStamps( overloadTolerancePeriod() );
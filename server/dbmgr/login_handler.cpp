@@ -401,7 +401,7 @@ void LoginHandler::createNewEntity( EntityTypeID entityTypeID,
 		// __kyl__ (13/7/2005) Need additional MemoryOStream because I
 		// haven't figured out how to make a BinaryIStream out of a
 		// Mercury::Bundle.
-		MemoryOStream strm;
+		MemoryOStream strm( 64, MemoryStreamArena::instance() );
 		isDefaultEntityOK = Database::instance().defaultEntityToStrm(
 			ekey_.typeID, pParams_->username(), strm, &pParams_->password() );
 
@@ -521,7 +521,7 @@ void LoginHandler::handleMessage( const Mercury::Address & source,
 void LoginHandler::handleException( const Mercury::NubException & ne,
 	void * arg )
 {
-	MemoryOStream mos;
+	MemoryOStream mos( 64, MemoryStreamArena::instance() );
 	mos << "BaseAppMgr timed out creating entity.";
 	this->handleFailure( &mos,
 			LogOnStatus::LOGIN_REJECTED_BASEAPPMGR_TIMEOUT );
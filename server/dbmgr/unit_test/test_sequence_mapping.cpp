@@ -0,0 +1,108 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "third_party/CppUnitLite2/src/CppUnitLite2.h"
+
+#include "dbmgr_mysql/utils.hpp"
+#include "dbmgr_mysql/mappings/sequence_mapping.hpp"
+
+#include <vector>
+
+namespace
+{
+
+/**
+ *	This function returns the number of rows in each multi-row query used to
+ *	write the given number of sequence elements.
+ */
+std::vector< int > batchSizes( int numElems )
+{
+	std::vector< int > sizes;
+
+	while (numElems > 0)
+	{
+		const int size = 1 << SequenceMapping::batchSizeIndex( numElems );
+		sizes.push_back( size );
+		numElems -= size;
+	}
+
+	return sizes;
+}
+
+} // anonymous namespace
+
+
+TEST( SequenceMapping_batchStatements )
+{
+	CHECK_EQUAL( std::string( "INSERT INTO tbl_seq (sm_a,sm_b,parentID) "
+			"VALUES (?,?,?),(?,?,?)" ),
+		SequenceMapping::buildInsertBatchStmt( "tbl_seq", "sm_a,sm_b", 2,
+			2 ) );
+
+	CHECK_EQUAL( std::string( "INSERT INTO tbl_seq (id,sm_a,sm_b,parentID) "
+			"VALUES (?,?,?,?) ON DUPLICATE KEY UPDATE "
+			"sm_a=VALUES(sm_a),sm_b=VALUES(sm_b)" ),
+		SequenceMapping::buildUpdateBatchStmt( "tbl_seq", "sm_a,sm_b",
+			"sm_a=VALUES(sm_a),sm_b=VALUES(sm_b)", 2, 1 ) );
+}
+
+
+TEST( SequenceMapping_batchStatementsWithoutColumns )
+{
+	// A child without columns of its own must still give valid statements.
+	CHECK_EQUAL( std::string( "INSERT INTO tbl_seq (parentID) "
+			"VALUES (?),(?)" ),
+		SequenceMapping::buildInsertBatchStmt( "tbl_seq", "", 0, 2 ) );
+
+	CHECK_EQUAL( std::string( "INSERT INTO tbl_seq (id,parentID) "
+			"VALUES (?,?) ON DUPLICATE KEY UPDATE parentID=VALUES(parentID)" ),
+		SequenceMapping::buildUpdateBatchStmt( "tbl_seq", "", "", 0, 1 ) );
+}
+
+
+TEST( SequenceMapping_batchSizes )
+{
+	const int MAX_BATCH_SIZE = 1 << (SequenceMapping::NUM_BATCH_SIZES - 1);
+
+	for (int numElems = 1; numElems <= 1000; ++numElems)
+	{
+		const std::vector< int > sizes = batchSizes( numElems );
+
+		int total = 0;
+
+		for (size_t i = 0; i < sizes.size(); ++i)
+		{
+			// Each batch is the largest size that fits.
+			CHECK( sizes[i] <= MAX_BATCH_SIZE );
+			CHECK( (i == 0) || (sizes[i] <= sizes[i - 1]) );
+			total += sizes[i];
+		}
+
+		CHECK_EQUAL( numElems, total );
+	}
+
+	CHECK_EQUAL( 1U, batchSizes( 1 ).size() );
+	CHECK_EQUAL( 1U, batchSizes( MAX_BATCH_SIZE ).size() );
+
+	// 7 batches of 64, then 32, 16 and 4.
+	CHECK_EQUAL( 10U, batchSizes( 500 ).size() );
+}
+
+
+TEST( SequenceMapping_multiRowQuestionMarks )
+{
+	CHECK_EQUAL( std::string( "(?)" ), buildMultiRowQuestionMarks( 1, 1 ) );
+	CHECK_EQUAL( std::string( "(?,?),(?,?),(?,?)" ),
+		buildMultiRowQuestionMarks( 2, 3 ) );
+}
+
+// test_sequence_mapping.cpp
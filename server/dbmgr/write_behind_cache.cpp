@@ -0,0 +1,361 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "write_behind_cache.hpp"
+
+#include "dbmgr_config.hpp"
+
+#include "cstdmf/debug.hpp"
+#include "cstdmf/timestamp.hpp"
+#include "cstdmf/watcher.hpp"
+
+#include "network/event_dispatcher.hpp"
+
+DECLARE_DEBUG_COMPONENT( 0 )
+
+
+namespace
+{
+
+/// How often, in microseconds, held writes are checked for their delay.
+const int64 FLUSH_CHECK_PERIOD = 100000;
+
+
+/**
+ *	This class passes the result of a coalesced write to the handlers of all
+ *	the writes that it replaced.
+ */
+class CoalescedPutEntityHandler : public IDatabase::IPutEntityHandler
+{
+public:
+	CoalescedPutEntityHandler()
+	{
+	}
+
+	std::vector< IDatabase::IPutEntityHandler * > & handlers()
+	{
+		return handlers_;
+	}
+
+	virtual void onPutEntityComplete( bool isOkay, DatabaseID dbID )
+	{
+		for (size_t i = 0; i < handlers_.size(); ++i)
+		{
+			handlers_[i]->onPutEntityComplete( isOkay, dbID );
+		}
+
+		delete this;
+	}
+
+private:
+	std::vector< IDatabase::IPutEntityHandler * > handlers_;
+};
+
+} // anonymous namespace
+
+
+// -----------------------------------------------------------------------------
+// Section: WriteBehindCache
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+WriteBehindCache::WriteBehindCache( Mercury::EventDispatcher & dispatcher ) :
+	dispatcher_( dispatcher ),
+	pDatabase_( NULL ),
+	timerHandle_(),
+	entries_(),
+	dirtyQueue_(),
+	dirtyBytes_( 0 ),
+	numWrites_( 0 ),
+	numCoalescedWrites_( 0 ),
+	numReads_( 0 ),
+	numReadHits_( 0 )
+{
+}
+
+
+/**
+ *	Destructor.
+ */
+WriteBehindCache::~WriteBehindCache()
+{
+	MF_ASSERT_DEV( entries_.empty() );
+
+	timerHandle_.cancel();
+}
+
+
+/**
+ *	This method starts holding writes to the given database.
+ */
+void WriteBehindCache::init( IDatabase & database )
+{
+	pDatabase_ = &database;
+
+	timerHandle_ = dispatcher_.addTimer( FLUSH_CHECK_PERIOD, this );
+
+	INFO_MSG( "\tWrite-behind delay  = %.2fs\n",
+			DBMgrConfig::writeBehindDelay() );
+}
+
+
+/**
+ *	This method writes all held writes to the database and stops holding new
+ *	ones. It is called when shutting down so that no data is lost.
+ */
+void WriteBehindCache::fini()
+{
+	this->flushAll();
+
+	timerHandle_.cancel();
+	pDatabase_ = NULL;
+}
+
+
+/**
+ *	This method returns whether new writes should be held.
+ */
+bool WriteBehindCache::isEnabled() const
+{
+	return (pDatabase_ != NULL) && (DBMgrConfig::writeBehindDelay() > 0.f);
+}
+
+
+/**
+ *	This method holds a write of an entity, if it can be. Otherwise, any held
+ *	write of the entity is passed to the database so that the caller can then
+ *	pass this write on after it.
+ *
+ *	@return	True if the write is being held, false if the caller should pass it
+ *			to the database.
+ */
+bool WriteBehindCache::putEntity( const EntityKey & entityKey,
+		EntityID entityID,
+		BinaryIStream * pStream,
+		const EntityMailBoxRef * pBaseMailbox,
+		bool removeBaseMailbox,
+		UpdateAutoLoad updateAutoLoad,
+		IDatabase::IPutEntityHandler & handler )
+{
+	const bool canHold = this->isEnabled() &&
+		(pStream != NULL) &&
+		(entityKey.dbID != 0) &&
+		(entityKey.dbID != PENDING_DATABASE_ID) &&
+		(pBaseMailbox == NULL) &&
+		!removeBaseMailbox &&
+		(updateAutoLoad == UPDATE_AUTO_LOAD_RETAIN);
+
+	if (!canHold)
+	{
+		this->flush( entityKey );
+		return false;
+	}
+
+	++numWrites_;
+
+	Entry *& rpEntry = entries_[ entityKey ];
+
+	if (rpEntry == NULL)
+	{
+		rpEntry = new Entry;
+		rpEntry->dirtyTime = timestamp();
+
+		dirtyQueue_.push_back( std::make_pair( rpEntry->dirtyTime, entityKey ) );
+	}
+	else
+	{
+		// The newer data replaces the held data.
+		++numCoalescedWrites_;
+
+		dirtyBytes_ -= rpEntry->data.size();
+		rpEntry->data.reset();
+	}
+
+	Entry & entry = *rpEntry;
+
+	entry.data.transfer( *pStream, pStream->remainingLength() );
+	entry.entityID = entityID;
+	entry.handlers.push_back( &handler );
+
+	dirtyBytes_ += entry.data.size();
+
+	// Write the oldest entities if too much data is held.
+	while ((dirtyBytes_ > DBMgrConfig::writeBehindMaxDirtyBytes()) &&
+			!dirtyQueue_.empty())
+	{
+		EntityKey oldestKey = dirtyQueue_.front().second;
+		dirtyQueue_.pop_front();
+
+		this->flush( oldestKey );
+	}
+
+	return true;
+}
+
+
+/**
+ *	This method is called before an entity is read from the database. If the
+ *	entity's data is wanted, any held write is passed to the database first.
+ *	The entity's base mailbox is not changed by held writes, so a read that
+ *	only wants it, such as when checking whether the entity is checked out,
+ *	does not need to wait for them.
+ */
+void WriteBehindCache::onGetEntity( const EntityKey & entityKey,
+		bool shouldGetData )
+{
+	++numReads_;
+
+	if (entityKey.dbID == 0)
+	{
+		// Looked up by name. Only checked out entities have held writes, and
+		// callers do not use the data of an entity that is checked out.
+		return;
+	}
+
+	Entries::iterator iter = entries_.find( entityKey );
+
+	if (iter != entries_.end())
+	{
+		++numReadHits_;
+
+		if (shouldGetData)
+		{
+			this->flushEntry( iter );
+		}
+	}
+}
+
+
+/**
+ *	This method passes any held write of an entity to the database.
+ */
+void WriteBehindCache::flush( const EntityKey & entityKey )
+{
+	Entries::iterator iter = entries_.find( entityKey );
+
+	if (iter != entries_.end())
+	{
+		this->flushEntry( iter );
+	}
+}
+
+
+/**
+ *	This method passes all held writes to the database.
+ */
+void WriteBehindCache::flushAll()
+{
+	while (!dirtyQueue_.empty())
+	{
+		EntityKey entityKey = dirtyQueue_.front().second;
+		dirtyQueue_.pop_front();
+
+		this->flush( entityKey );
+	}
+
+	MF_ASSERT_DEV( entries_.empty() );
+}
+
+
+/**
+ *	This method passes a held write to the database.
+ */
+void WriteBehindCache::flushEntry( Entries::iterator iter )
+{
+	const EntityKey entityKey = iter->first;
+	Entry * pEntry = iter->second;
+	entries_.erase( iter );
+
+	dirtyBytes_ -= pEntry->data.size();
+
+	CoalescedPutEntityHandler * pHandler = new CoalescedPutEntityHandler();
+	pHandler->handlers().swap( pEntry->handlers );
+
+	// The database copies the data before this returns. The handler may be
+	// called before this returns.
+	pDatabase_->putEntity( entityKey, pEntry->entityID, &pEntry->data,
+			/* pBaseMailbox: */ NULL, /* removeBaseMailbox: */ false,
+			UPDATE_AUTO_LOAD_RETAIN, *pHandler );
+
+	delete pEntry;
+}
+
+
+/**
+ *	This method is called periodically to pass the writes that have been held
+ *	for long enough to the database.
+ */
+void WriteBehindCache::handleTimeout( TimerHandle handle, void * arg )
+{
+	const uint64 now = timestamp();
+	const uint64 delay =
+		DBMgrConfig::secondsToStamps( DBMgrConfig::writeBehindDelay() );
+
+	while (!dirtyQueue_.empty() &&
+			(now - dirtyQueue_.front().first >= delay))
+	{
+		const uint64 dirtyTime = dirtyQueue_.front().first;
+		const EntityKey entityKey = dirtyQueue_.front().second;
+		dirtyQueue_.pop_front();
+
+		Entries::iterator iter = entries_.find( entityKey );
+
+		// Skip entities that have already been written.
+		if ((iter != entries_.end()) && (iter->second->dirtyTime == dirtyTime))
+		{
+			this->flushEntry( iter );
+		}
+	}
+}
+
+
+/**
+ *	This method returns the proportion of entity reads that were of an entity
+ *	with a held write.
+ */
+double WriteBehindCache::hitRate() const
+{
+	return (numReads_ > 0) ? double( numReadHits_ )/numReads_ : 0.0;
+}
+
+
+/**
+ *	This method returns the average number of writes received for each write
+ *	passed to the database.
+ */
+double WriteBehindCache::coalesceRatio() const
+{
+	const uint64 numFlushed = numWrites_ - numCoalescedWrites_;
+
+	return (numFlushed > 0) ? double( numWrites_ )/numFlushed : 0.0;
+}
+
+
+/**
+ *	This method adds the watchers associated with this object.
+ */
+void WriteBehindCache::addWatchers( Watcher & watcher )
+{
+	watcher.addChild( "writeBehind/hitRate",
+		makeWatcher( &WriteBehindCache::hitRate ), this );
+	watcher.addChild( "writeBehind/coalesceRatio",
+		makeWatcher( &WriteBehindCache::coalesceRatio ), this );
+	watcher.addChild( "writeBehind/dirtyBytes",
+		makeWatcher( &WriteBehindCache::dirtyBytes_ ), this );
+	watcher.addChild( "writeBehind/numWrites",
+		makeWatcher( &WriteBehindCache::numWrites_ ), this );
+	watcher.addChild( "writeBehind/numCoalescedWrites",
+		makeWatcher( &WriteBehindCache::numCoalescedWrites_ ), this );
+}
+
+// write_behind_cache.cpp
@@ -0,0 +1,117 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef WRITE_BEHIND_CACHE_HPP
+#define WRITE_BEHIND_CACHE_HPP
+
+#include "cstdmf/hash_map.hpp"
+#include "cstdmf/memory_stream.hpp"
+#include "cstdmf/timer_handler.hpp"
+
+#include "dbmgr_lib/idatabase.hpp"
+
+#include <deque>
+#include <vector>
+
+class Watcher;
+
+namespace Mercury
+{
+class EventDispatcher;
+}
+
+
+/**
+ *	This class holds entity writes for a short time before passing them to the
+ *	database, so that repeated writes of the same entity are written only once.
+ *	While a write is held, a newer write for the same entity replaces its data.
+ *
+ *	Only writes of an existing entity's data are held. Writes that change the
+ *	entity's base mailbox or auto-load state are passed straight through, as
+ *	are writes of new entities.
+ *
+ *	A write is not acknowledged until the data it carries has been written to
+ *	the database. The handlers of coalesced writes are all called when the
+ *	write that replaced them completes.
+ *
+ *	Any other operation on an entity with a held write, such as reading it,
+ *	first passes the held write to the database. Since the database performs
+ *	the operations of an entity in order, the operation sees the latest data.
+ */
+class WriteBehindCache : public TimerHandler
+{
+public:
+	WriteBehindCache( Mercury::EventDispatcher & dispatcher );
+	~WriteBehindCache();
+
+	void init( IDatabase & database );
+	void fini();
+
+	bool putEntity( const EntityKey & entityKey, EntityID entityID,
+			BinaryIStream * pStream,
+			const EntityMailBoxRef * pBaseMailbox,
+			bool removeBaseMailbox,
+			UpdateAutoLoad updateAutoLoad,
+			IDatabase::IPutEntityHandler & handler );
+
+	void onGetEntity( const EntityKey & entityKey, bool shouldGetData );
+
+	void flush( const EntityKey & entityKey );
+	void flushAll();
+
+	void addWatchers( Watcher & watcher );
+
+private:
+	virtual void handleTimeout( TimerHandle handle, void * arg );
+
+	/**
+	 *	This structure holds the latest data of an entity that has not yet been
+	 *	written, and the handlers of the writes it replaced.
+	 */
+	struct Entry
+	{
+		MemoryOStream data;
+		EntityID entityID;
+		uint64 dirtyTime;
+		std::vector< IDatabase::IPutEntityHandler * > handlers;
+	};
+
+	typedef HashMap< EntityKey, Entry * > Entries;
+
+	void flushEntry( Entries::iterator iter );
+
+	bool isEnabled() const;
+
+	double hitRate() const;
+	double coalesceRatio() const;
+
+	Mercury::EventDispatcher & dispatcher_;
+	IDatabase * pDatabase_;
+
+	TimerHandle timerHandle_;
+
+	Entries entries_;
+
+	// The entities in the order they became dirty, with the time at which
+	// they did. An entity that has since been written has no entry, or an
+	// entry with a later time.
+	typedef std::deque< std::pair< uint64, EntityKey > > DirtyQueue;
+	DirtyQueue dirtyQueue_;
+
+	int dirtyBytes_;
+
+	uint64 numWrites_;
+	uint64 numCoalescedWrites_;
+	uint64 numReads_;
+	uint64 numReadHits_;
+};
+
+#endif // WRITE_BEHIND_CACHE_HPP
@@ -0,0 +1,152 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#include "login_cache.hpp"
+
+#include "loginapp_config.hpp"
+
+#include "cstdmf/timestamp.hpp"
+
+
+// -----------------------------------------------------------------------------
+// Section: CachedLogin
+// -----------------------------------------------------------------------------
+
+/**
+ *  This method returns true if this login is pending, i.e. we are waiting on
+ *  the DBMgr to tell us whether or not the login is successful.
+ */
+bool CachedLogin::isPending() const
+{
+	return creationTime_ == 0;
+}
+
+
+/**
+ *	This method returns whether or not this cache is too old to use.
+ */
+bool CachedLogin::isTooOld() const
+{
+	const uint64 MAX_LOGIN_DELAY = LoginAppConfig::maxLoginDelayInStamps();
+
+	return !this->isPending() &&
+		(::timestamp() - creationTime_ > MAX_LOGIN_DELAY);
+}
+
+
+/**
+ *  This method sets the reply record into this cached object, and is called
+ *  when the DBMgr replies.
+ */
+void CachedLogin::replyRecord( const LoginReplyRecord & record )
+{
+	replyRecord_ = record;
+	creationTime_ = ::timestamp();
+}
+
+
+// -----------------------------------------------------------------------------
+// Section: LoginCache
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+LoginCache::LoginCache() :
+	cachedLogins_(),
+	expiryQueue_()
+{
+}
+
+
+/**
+ *	This method returns the cached login from the given address, or NULL if
+ *	there is none. The result is only valid until the cache is next changed.
+ */
+CachedLogin * LoginCache::find( const Mercury::Address & addr )
+{
+	CachedLogins::iterator iter = cachedLogins_.find( addr );
+
+	return (iter != cachedLogins_.end()) ? &iter->second : NULL;
+}
+
+
+/**
+ *	This method remembers that a login from the given address is in progress,
+ *	so that further attempts from that address are discarded for some time
+ *	after it completes.
+ */
+void LoginCache::onLoginPending( const Mercury::Address & addr,
+		LogOnParamsPtr pParams )
+{
+	CachedLogin & cache = cachedLogins_[ addr ];
+	cache.reset();
+	cache.pParams( pParams );
+}
+
+
+/**
+ *	This method caches a successful login so that it can be resent if the
+ *	reply is dropped.
+ */
+void LoginCache::onLoginSucceeded( const Mercury::Address & addr,
+		const LoginReplyRecord & replyRecord )
+{
+	CachedLogin & cache = cachedLogins_[ addr ];
+	cache.replyRecord( replyRecord );
+
+	expiryQueue_.push_back( std::make_pair( cache.creationTime(), addr ) );
+
+	// Do not let the cache get too big.
+	this->expireCachedLogins();
+}
+
+
+/**
+ *	This method forgets a login attempt that has failed.
+ */
+void LoginCache::onLoginFailed( const Mercury::Address & addr )
+{
+	cachedLogins_.erase( addr );
+}
+
+
+/**
+ *	This method removes the cached logins that are too old to use.
+ */
+void LoginCache::expireCachedLogins()
+{
+	while (!expiryQueue_.empty())
+	{
+		const uint64 creationTime = expiryQueue_.front().first;
+
+		if (timestamp() - creationTime <=
+				LoginAppConfig::maxLoginDelayInStamps())
+		{
+			break;
+		}
+
+		CachedLogins::iterator iter =
+			cachedLogins_.find( expiryQueue_.front().second );
+
+		// Skip addresses that have since been removed or cached again.
+		if ((iter != cachedLogins_.end()) &&
+				(iter->second.creationTime() == creationTime))
+		{
+			cachedLogins_.erase( iter );
+		}
+
+		expiryQueue_.pop_front();
+	}
+}
+
+// login_cache.cpp
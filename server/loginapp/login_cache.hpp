@@ -0,0 +1,94 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+
+#ifndef LOGIN_CACHE_HPP
+#define LOGIN_CACHE_HPP
+
+#include "connection/log_on_params.hpp"
+#include "connection/login_reply_record.hpp"
+
+#include "cstdmf/hash_map.hpp"
+
+#include "network/basictypes.hpp"
+#include "network/misc.hpp"
+
+#include <deque>
+#include <utility>
+
+
+/**
+ *	This class is used to store a recent, successful login. It is used to
+ *	handle the case where the reply to the client is dropped.
+ */
+class CachedLogin
+{
+public:
+	// We set creationTime_ to 0 to indicate that the login is pending.
+	CachedLogin() : creationTime_( 0 ) {}
+
+	bool isTooOld() const;
+	bool isPending() const;
+
+	void pParams( LogOnParamsPtr pParams ) { pParams_ = pParams; }
+	LogOnParamsPtr pParams() { return pParams_; }
+
+	void replyRecord( const LoginReplyRecord & record );
+	const LoginReplyRecord & replyRecord() const { return replyRecord_; }
+
+	uint64 creationTime() const { return creationTime_; }
+
+	/// This method re-initialises the cache object to indicate that it is
+	/// pending.
+	void reset() { creationTime_ = 0; }
+
+private:
+	uint64 creationTime_;
+	LogOnParamsPtr pParams_;
+	LoginReplyRecord replyRecord_;
+};
+
+
+/**
+ *	This class holds the pending and recent successful logins of a LoginApp,
+ *	by client address. Successful logins are removed in the order they were
+ *	cached once they are too old to use, so the cache does not grow beyond
+ *	the logins of the last maxLoginDelay seconds.
+ */
+class LoginCache
+{
+public:
+	LoginCache();
+
+	CachedLogin * find( const Mercury::Address & addr );
+
+	void onLoginPending( const Mercury::Address & addr,
+			LogOnParamsPtr pParams );
+	void onLoginSucceeded( const Mercury::Address & addr,
+			const LoginReplyRecord & replyRecord );
+	void onLoginFailed( const Mercury::Address & addr );
+
+	int size() const	{ return int( cachedLogins_.size() ); }
+
+private:
+	void expireCachedLogins();
+
+	typedef HashMap< Mercury::Address, CachedLogin > CachedLogins;
+	CachedLogins cachedLogins_;
+
+	// The successful logins in the order they were cached, with the time at
+	// which they were. An address that has since been removed or cached again
+	// has no entry, or an entry with a later time.
+	typedef std::deque< std::pair< uint64, Mercury::Address > > ExpiryQueue;
+	ExpiryQueue expiryQueue_;
+};
+
+#endif // LOGIN_CACHE_HPP
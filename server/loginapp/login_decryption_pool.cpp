@@ -0,0 +1,333 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "login_decryption_pool.hpp"
+
+#include "loginapp.hpp"
+#include "loginapp_config.hpp"
+
+#include "connection/rsa_stream_encoder.hpp"
+
+#include "cstdmf/debug.hpp"
+#include "cstdmf/memory_stream.hpp"
+#include "cstdmf/timestamp.hpp"
+#include "cstdmf/watcher.hpp"
+
+#include "network/event_dispatcher.hpp"
+
+#include <memory>
+#include <string>
+
+DECLARE_DEBUG_COMPONENT( 0 )
+
+
+namespace // anonymous
+{
+
+/**
+ *	This class holds the private key used by a single decryption thread.
+ */
+class DecryptionThreadData : public BackgroundThreadData
+{
+public:
+	DecryptionThreadData( StreamEncoder * pEncoder ) :
+		pEncoder_( pEncoder )
+	{
+	}
+
+	virtual void onStart( BackgroundTaskThread & thread ) {}
+
+	const StreamEncoder * pEncoder() const	{ return pEncoder_.get(); }
+
+private:
+	std::auto_ptr< StreamEncoder > pEncoder_;
+};
+
+
+/**
+ *	This class decrypts the login parameters of a single login request.
+ */
+class DecryptLoginTask : public BackgroundTask
+{
+public:
+	DecryptLoginTask( LoginDecryptionPool & pool,
+			const Mercury::Address & source, Mercury::ReplyID replyID,
+			const void * pData, int dataLength, bool allowUnencrypted ) :
+		pool_( pool ),
+		source_( source ),
+		replyID_( replyID ),
+		data_( static_cast< const char * >( pData ), dataLength ),
+		allowUnencrypted_( allowUnencrypted ),
+		pParams_(),
+		decryptTime_( 0 )
+	{
+	}
+
+	virtual void doBackgroundTask( BgTaskManager & mgr,
+			BackgroundTaskThread * pThread )
+	{
+		const StreamEncoder * pEncoder = static_cast< DecryptionThreadData * >(
+				pThread->pData().get() )->pEncoder();
+
+		uint64 startTime = timestamp();
+
+		pParams_ = LoginDecryptionPool::readParams( data_.data(),
+				int( data_.size() ), pEncoder, allowUnencrypted_ );
+
+		decryptTime_ = timestamp() - startTime;
+
+		mgr.addMainThreadTask( this );
+	}
+
+	virtual void doMainThreadTask( BgTaskManager & mgr )
+	{
+		pool_.onDecrypted( source_, replyID_, pParams_, decryptTime_ );
+	}
+
+protected:
+	virtual void doBackgroundTask( BgTaskManager & mgr ) {}
+
+private:
+	LoginDecryptionPool & pool_;
+
+	Mercury::Address source_;
+	Mercury::ReplyID replyID_;
+
+	// A copy of the request. The received packet is gone by the time this is
+	// decrypted.
+	std::string data_;
+
+	// Read when the request is received, since the option may be changed in
+	// the main thread.
+	bool allowUnencrypted_;
+
+	LogOnParamsPtr pParams_;
+	uint64 decryptTime_;
+};
+
+} // namespace (anonymous)
+
+
+// -----------------------------------------------------------------------------
+// Section: LoginDecryptionPool
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+LoginDecryptionPool::LoginDecryptionPool( LoginApp & loginApp,
+		Mercury::EventDispatcher & dispatcher ) :
+	loginApp_( loginApp ),
+	dispatcher_( dispatcher ),
+	bgTaskManager_(),
+	numThreads_( 0 ),
+	pendingSources_(),
+	numDecrypted_( 0 ),
+	numFailed_( 0 ),
+	totalDecryptTime_( 0 )
+{
+}
+
+
+/**
+ *	Destructor.
+ */
+LoginDecryptionPool::~LoginDecryptionPool()
+{
+	if (numThreads_ > 0)
+	{
+		dispatcher_.cancelFrequentTask( this );
+	}
+
+	// Requests still being decrypted are dropped. Their clients will time out
+	// and try again.
+	bgTaskManager_.stopAll();
+}
+
+
+/**
+ *	This method starts the decryption threads. Each thread reads its own copy
+ *	of the private key.
+ *
+ *	@return	False if a key could not be read.
+ */
+bool LoginDecryptionPool::init( int numThreads,
+		const std::string & privateKeyPath )
+{
+#ifdef USE_OPENSSL
+	for (int i = 0; i < numThreads; ++i)
+	{
+		RSAStreamEncoder * pEncoder =
+			new RSAStreamEncoder( /* keyIsPrivate: */ true );
+
+		if (!pEncoder->initFromKeyPath( privateKeyPath ))
+		{
+			delete pEncoder;
+			bgTaskManager_.stopAll();
+			return false;
+		}
+
+		bgTaskManager_.startThreads( 1, new DecryptionThreadData( pEncoder ) );
+	}
+
+	numThreads_ = numThreads;
+	dispatcher_.addFrequentTask( this );
+
+	INFO_MSG( "LoginDecryptionPool::init: "
+			"Decrypting logins in %d background threads\n", numThreads_ );
+#endif
+
+	return true;
+}
+
+
+/**
+ *	This method returns whether a request from the given address is being
+ *	decrypted.
+ */
+bool LoginDecryptionPool::isDecrypting( const Mercury::Address & source ) const
+{
+	return pendingSources_.count( source ) != 0;
+}
+
+
+/**
+ *	This method returns whether no more requests should be queued. Requests
+ *	beyond this are rejected rather than delaying those already queued.
+ */
+bool LoginDecryptionPool::isFull() const
+{
+	return this->numPending() >= LoginAppConfig::maxPendingDecryptions();
+}
+
+
+/**
+ *	This method queues a login request to be decrypted.
+ *
+ *	@param source		The address the request was received from.
+ *	@param replyID		The ID to reply to the request with.
+ *	@param pData		The encrypted login parameters. These are copied.
+ *	@param dataLength	The length of the data.
+ */
+void LoginDecryptionPool::decrypt( const Mercury::Address & source,
+		Mercury::ReplyID replyID, const void * pData, int dataLength )
+{
+	MF_ASSERT( !this->isDecrypting( source ) );
+
+	pendingSources_[ source ] = replyID;
+
+	bgTaskManager_.addBackgroundTask( new DecryptLoginTask( *this,
+			source, replyID, pData, dataLength,
+			LoginAppConfig::allowUnencryptedLogins() ) );
+}
+
+
+/**
+ *	This method is called in the main thread when a request has been
+ *	decrypted.
+ *
+ *	@param pParams		The login parameters, or NULL if they could not be
+ *						read.
+ *	@param decryptTime	The time spent decrypting, in stamps.
+ */
+void LoginDecryptionPool::onDecrypted( const Mercury::Address & source,
+		Mercury::ReplyID replyID, LogOnParamsPtr pParams, uint64 decryptTime )
+{
+	pendingSources_.erase( source );
+
+	++numDecrypted_;
+	totalDecryptTime_ += decryptTime;
+
+	if (!pParams)
+	{
+		++numFailed_;
+	}
+
+	loginApp_.onLogOnParamsDecrypted( source, replyID, pParams );
+}
+
+
+/**
+ *	This method implements the FrequentTask method. It completes the requests
+ *	that have been decrypted.
+ */
+void LoginDecryptionPool::doTask()
+{
+	bgTaskManager_.tick();
+}
+
+
+/**
+ *	This method reads the login parameters of a request. If they cannot be
+ *	decrypted, they are read as unencrypted if that is allowed.
+ *
+ *	This is called in background threads so it must not use any shared state.
+ *
+ *	@return	The login parameters, or NULL if they could not be read.
+ */
+LogOnParamsPtr LoginDecryptionPool::readParams( const void * pData,
+		int dataLength, const StreamEncoder * pEncoder, bool allowUnencrypted )
+{
+	LogOnParamsPtr pParams = new LogOnParams();
+
+	MemoryIStream attempt( pData, dataLength );
+
+	if (pParams->readFromStream( attempt, pEncoder ))
+	{
+		return pParams;
+	}
+
+	if (pEncoder && allowUnencrypted)
+	{
+		// If we tried using encryption, have another go without it
+		MemoryIStream unencryptedAttempt( pData, dataLength );
+
+		if (pParams->readFromStream( unencryptedAttempt, NULL ))
+		{
+			return pParams;
+		}
+	}
+
+	return NULL;
+}
+
+
+/**
+ *	This method returns the average time in milliseconds taken to decrypt a
+ *	request.
+ */
+double LoginDecryptionPool::averageDecryptTime() const
+{
+	return (numDecrypted_ > 0) ?
+		double( totalDecryptTime_ ) * 1000.0 / stampsPerSecondD() /
+			numDecrypted_ :
+		0.0;
+}
+
+
+/**
+ *	This method adds the watchers associated with this object.
+ */
+void LoginDecryptionPool::addWatchers( Watcher & watcher )
+{
+	watcher.addChild( "decryption/numThreads",
+		makeWatcher( &LoginDecryptionPool::numThreads_ ), this );
+	watcher.addChild( "decryption/numPending",
+		makeWatcher( &LoginDecryptionPool::numPending ), this );
+	watcher.addChild( "decryption/numDecrypted",
+		makeWatcher( &LoginDecryptionPool::numDecrypted_ ), this );
+	watcher.addChild( "decryption/numFailed",
+		makeWatcher( &LoginDecryptionPool::numFailed_ ), this );
+	watcher.addChild( "decryption/averageDecryptTime",
+		makeWatcher( &LoginDecryptionPool::averageDecryptTime ), this );
+}
+
+// login_decryption_pool.cpp
@@ -0,0 +1,96 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef LOGIN_DECRYPTION_POOL_HPP
+#define LOGIN_DECRYPTION_POOL_HPP
+
+#include "connection/log_on_params.hpp"
+
+#include "cstdmf/bgtask_manager.hpp"
+
+#include "network/basictypes.hpp"
+#include "network/frequent_tasks.hpp"
+#include "network/misc.hpp"
+
+#include <map>
+#include <string>
+
+class LoginApp;
+class StreamEncoder;
+class Watcher;
+
+namespace Mercury
+{
+class EventDispatcher;
+}
+
+
+/**
+ *	This class decrypts the login parameters of login requests in background
+ *	threads, so that the main thread can keep receiving while the expensive
+ *	RSA private key decryption is done. Each thread has its own copy of the
+ *	private key.
+ *
+ *	Only one request from each address is decrypted at a time. This keeps the
+ *	replies to an address in the order its requests were received. Callers
+ *	treat further requests from an address that is being decrypted as repeat
+ *	attempts.
+ *
+ *	When a request has been decrypted, LoginApp::onLogOnParamsDecrypted() is
+ *	called in the main thread.
+ */
+class LoginDecryptionPool : public Mercury::FrequentTask
+{
+public:
+	LoginDecryptionPool( LoginApp & loginApp,
+			Mercury::EventDispatcher & dispatcher );
+	~LoginDecryptionPool();
+
+	bool init( int numThreads, const std::string & privateKeyPath );
+
+	bool isDecrypting( const Mercury::Address & source ) const;
+	bool isFull() const;
+
+	void decrypt( const Mercury::Address & source, Mercury::ReplyID replyID,
+			const void * pData, int dataLength );
+
+	void onDecrypted( const Mercury::Address & source,
+			Mercury::ReplyID replyID, LogOnParamsPtr pParams,
+			uint64 decryptTime );
+
+	void addWatchers( Watcher & watcher );
+
+	static LogOnParamsPtr readParams( const void * pData, int dataLength,
+			const StreamEncoder * pEncoder, bool allowUnencrypted );
+
+private:
+	virtual void doTask();
+
+	int numPending() const	{ return int( pendingSources_.size() ); }
+
+	double averageDecryptTime() const;
+
+	LoginApp & loginApp_;
+	Mercury::EventDispatcher & dispatcher_;
+
+	BgTaskManager bgTaskManager_;
+	int numThreads_;
+
+	// The addresses with a request being decrypted, and that request's ID.
+	typedef std::map< Mercury::Address, Mercury::ReplyID > PendingSources;
+	PendingSources pendingSources_;
+
+	uint32 numDecrypted_;
+	uint32 numFailed_;
+	uint64 totalDecryptTime_;
+};
+
+#endif // LOGIN_DECRYPTION_POOL_HPP
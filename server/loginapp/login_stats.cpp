@@ -0,0 +1,59 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "login_stats.hpp"
+
+#include "cstdmf/watcher.hpp"
+
+
+const uint32 LoginStats::UPDATE_PERIOD = 1000000;
+
+// Make the EMA bias equivalent to having the most recent 5 samples represent
+// 86% of the total weight. This is purely arbitrary, and may be adjusted to
+// increase or decrease the sensitivity of the login statistics as reported in
+// the 'averages' watcher directory.
+static const uint WEIGHTING_NUM_SAMPLES = 5;
+
+/**
+ * The EMA bias for the login statistics.
+ */
+const float LoginStats::BIAS = 2.f / (WEIGHTING_NUM_SAMPLES + 1);
+
+/**
+ *	Constructor.
+ */
+LoginStats::LoginStats():
+			fails_( BIAS ),
+			rateLimited_( BIAS ),
+			pending_( BIAS ),
+			successes_( BIAS ),
+			all_( BIAS )
+{}
+
+
+/**
+ *	This method adds watchers for these statistics to the given directory.
+ */
+void LoginStats::addWatchers( Watcher & watcher )
+{
+	watcher.addChild( "rateLimited",
+			makeWatcher( *this, &LoginStats::rateLimited ) );
+	watcher.addChild( "repeatedForAlreadyPending",
+			makeWatcher( *this, &LoginStats::pending ) );
+	watcher.addChild( "failures",
+			makeWatcher( *this, &LoginStats::fails ) );
+	watcher.addChild( "successes",
+			makeWatcher( *this, &LoginStats::successes ) );
+	watcher.addChild( "all",
+			makeWatcher( *this, &LoginStats::all ) );
+}
+
+// login_stats.cpp
@@ -0,0 +1,123 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef LOGIN_STATS_HPP
+#define LOGIN_STATS_HPP
+
+#include "cstdmf/timer_handler.hpp"
+
+#include "math/ema.hpp"
+
+class Watcher;
+
+
+/**
+ *	This class represents login statistics. These statistics are exposed to
+ *	watchers.
+ */
+class LoginStats: public TimerHandler
+{
+public:
+	LoginStats();
+
+	/**
+	 *	Overridden from TimerHandler.
+	 */
+	virtual void handleTimeout( TimerHandle handle, void * arg )
+	{
+		this->update();
+	}
+
+	// Incrementing accessors
+
+	/**
+	 *	Increment the count for rate-limited logins.
+	 */
+	void incRateLimited() 	{ ++all_.value(); ++rateLimited_.value(); }
+
+	/**
+	 *	Increment the count for failed logins.
+	 */
+	void incFails() 		{ ++all_.value(); ++fails_.value(); }
+
+	/**
+	 *	Increment the count for repeated logins (duplicate logins that came
+	 *	in from the client while the original was pending.
+	 */
+	void incPending() 		{ ++all_.value(); ++pending_.value(); }
+
+	/**
+	 *	Increment the count for successful logins.
+	 */
+	void incSuccesses() 	{ ++all_.value(); ++successes_.value(); }
+
+	// Average accessors
+
+	/**
+	 *	Return the failed logins per second average.
+	 */
+	float fails() const 		{ return fails_.average(); }
+
+	/**
+	 *	Return the rate-limited logins per second average.
+	 */
+	float rateLimited() const 	{ return rateLimited_.average(); }
+
+	/**
+	 *	Return the repeated logins (due to already pending login) per
+	 *	second average.
+	 */
+	float pending() const 		{ return pending_.average(); }
+
+	/**
+	 *	Return the successful logins per second average.
+	 */
+	float successes() const 	{ return successes_.average(); }
+
+	/**
+	 *	Return the logins per second average.
+	 */
+	float all() const 			{ return all_.average(); }
+
+	/**
+	 *	This method updates the averages to the accumulated values.
+	 */
+	void update()
+	{
+		fails_.sample();
+		rateLimited_.sample();
+		successes_.sample();
+		pending_.sample();
+		all_.sample();
+	}
+
+	void addWatchers( Watcher & watcher );
+
+	/// Timer period when updating login statistics, in microseconds.
+	static const uint32 UPDATE_PERIOD;
+
+private:
+	/// Failed logins.
+	AccumulatingEMA< uint32 > fails_;
+	/// Rate-limited logins.
+	AccumulatingEMA< uint32 > rateLimited_;
+	/// Repeated logins that matched a pending login.
+	AccumulatingEMA< uint32 > pending_;
+	/// Successful logins.
+	AccumulatingEMA< uint32 > successes_;
+	/// All logins.
+	AccumulatingEMA< uint32 > all_;
+
+	/// The bias for all the exponential averages.
+	static const float BIAS;
+};
+
+#endif // LOGIN_STATS_HPP
@@ -12,6 +12,7 @@ criminal penalties as provided by law.
 #include "loginapp.hpp"
 
 #include "database_reply_handler.hpp"
+#include "login_decryption_pool.hpp"
 #include "login_int_interface.hpp"
 #include "loginapp_config.hpp"
 #include "nat_config.hpp"
@@ -25,6 +26,7 @@ criminal penalties as provided by law.
 #include "connection/login_interface.hpp"
 #include "connection/rsa_stream_encoder.hpp"
 
+#include "network/aes_gcm_filter.hpp"
 #include "network/encryption_filter.hpp"
 #include "network/msgtypes.hpp"	// for angleToInt8
 #include "network/nub_exception.hpp"
@@ -46,9 +48,6 @@ criminal penalties as provided by law.
 
 DECLARE_DEBUG_COMPONENT( 0 )
 
-/// Timer period when updating login statistics
-const uint32 LoginApp::UPDATE_STATS_PERIOD = 1000000;
-
 /// LoginApp Singleton.
 BW_SINGLETON_STORAGE( LoginApp )
 
@@ -89,6 +88,7 @@ LoginApp::LoginApp( Mercury::EventDispatcher & mainDispatcher,
 		Mercury::NetworkInterface & intInterface ) :
 	ServerApp( mainDispatcher, intInterface ),
 	pLogOnParamsEncoder_( NULL ),
+	pDecryptionPool_( NULL ),
 	extInterface_( &mainDispatcher,
 			Mercury::NETWORK_INTERFACE_EXTERNAL,
 			htons( BWConfig::get( "loginApp/externalPorts/port", PORT_LOGIN ) ),
@@ -96,6 +96,7 @@ LoginApp::LoginApp( Mercury::EventDispatcher & mainDispatcher,
 	netMask_(),
 	externalIP_( 0 ),
 	systemOverloaded_( 0 ),
+	loginCache_(),
 	lastRateLimitCheckTime_( 0 ),
 	numAllowedLoginsLeft_( 0 ),
 	loginStats_()
@@ -156,6 +157,8 @@ LoginApp::LoginApp( Mercury::EventDispatcher & mainDispatcher,
  */
 LoginApp::~LoginApp()
 {
+	pDecryptionPool_.reset();
+
 	this->extInterface().prepareForShutdown();
 	statsTimer_.cancel();
 }
@@ -204,6 +207,18 @@ bool LoginApp::init( int argc, char * argv[] )
 
 		return false;
 	}
+
+	if (Config::numDecryptionThreads() > 0)
+	{
+		pDecryptionPool_.reset(
+				new LoginDecryptionPool( *this, mainDispatcher_ ) );
+
+		if (!pDecryptionPool_->init( Config::numDecryptionThreads(),
+				privateKeyPath ))
+		{
+			return false;
+		}
+	}
 #endif
 
 	if (!this->intInterface().isGood())
@@ -311,6 +326,10 @@ bool LoginApp::init( int argc, char * argv[] )
 	extInterface_.setLatency( Config::externalLatencyMin(),
 			Config::externalLatencyMax() );
 	extInterface_.setLossRatio( Config::externalLossRatio() );
+	extInterface_.setMaxReceiveBatchSize( Config::externalReceiveBatchSize() );
+	extInterface_.shouldBatchSends( Config::externalShouldBatchSends() );
+	extInterface_.setNumReceiveShards( Config::externalReceiveShards() );
+	extInterface_.congestionControl( Config::externalCongestionControl() );
 
 	if (extInterface_.hasArtificialLossOrLatency())
 	{
@@ -352,6 +371,12 @@ bool LoginApp::init( int argc, char * argv[] )
 
 	Watcher & root = Watcher::rootWatcher();
 	this->addWatchers( root );
+
+	if (pDecryptionPool_.get())
+	{
+		pDecryptionPool_->addWatchers( root );
+	}
+
 	root.addChild( "nubExternal", Mercury::NetworkInterface::pWatcher(), 
 		&extInterface_ );
 
@@ -365,28 +390,23 @@ bool LoginApp::init( int argc, char * argv[] )
 	//		&this->dbMgr().channel() );
 
 	WatcherPtr pStatsWatcher = new DirectoryWatcher();
-	pStatsWatcher->addChild( "rateLimited",
-			makeWatcher( loginStats_, &LoginStats::rateLimited ) );
-	pStatsWatcher->addChild( "repeatedForAlreadyPending",
-			makeWatcher( loginStats_, &LoginStats::pending ) );
-	pStatsWatcher->addChild( "failures",
-			makeWatcher( loginStats_, &LoginStats::fails ) );
-	pStatsWatcher->addChild( "successes",
-			makeWatcher( loginStats_, &LoginStats::successes ) );
-	pStatsWatcher->addChild( "all",
-			makeWatcher( loginStats_, &LoginStats::all ) );
+	loginStats_.addWatchers( *pStatsWatcher );
 
 	{
 		// watcher doesn't like const-ness
-		static uint32 s_updateStatsPeriod = LoginApp::UPDATE_STATS_PERIOD;
+		static uint32 s_updateStatsPeriod = LoginStats::UPDATE_PERIOD;
 		pStatsWatcher->addChild( "updatePeriod",
 				makeWatcher( s_updateStatsPeriod ) );
 	}
 
+	root.addChild( "numCachedLogins",
+			makeWatcher( loginCache_, &LoginCache::size ) );
+
 	root.addChild( "averages", pStatsWatcher );
 
 	statsTimer_ =
-		mainDispatcher_.addTimer( UPDATE_STATS_PERIOD, &loginStats_, NULL );
+		mainDispatcher_.addTimer( LoginStats::UPDATE_PERIOD, &loginStats_,
+				NULL );
 
 	if (!this->isDBReady())
 	{
@@ -428,6 +448,8 @@ void LoginApp::sendFailure( const Mercury::Address & addr,
 	Mercury::ReplyID replyID, int status, const char * pDescription,
 	LogOnParamsPtr pParams )
 {
+	LoginApp & app = LoginApp::instance();
+
 	if (status == LogOnStatus::LOGIN_REJECTED_RATE_LIMITED)
 	{
 		loginStats_.incRateLimited();
@@ -454,7 +476,6 @@ void LoginApp::sendFailure( const Mercury::Address & addr,
 	bundle << (int8)status;
 	bundle << pDescription;
 
-	LoginApp & app = LoginApp::instance();
 	app.extInterface_.send( addr, bundle );
 
 	if (*pDescription == 0)
@@ -466,7 +487,7 @@ void LoginApp::sendFailure( const Mercury::Address & addr,
 	// Erase the cache mapping for this attempt if appropriate
 	if (pParams)
 	{
-		app.cachedLoginMap_.erase( addr );
+		app.loginCache_.onLoginFailed( addr );
 	}
 }
 
@@ -488,6 +509,20 @@ void LoginApp::login( const Mercury::Address & source,
 		lastRateLimitCheckTime_ = timestamp();
 	}
 
+	if (pDecryptionPool_.get() && pDecryptionPool_->isDecrypting( source ))
+	{
+		// Replies to an address are sent in the order that its attempts were
+		// received, so nothing is sent for this one while an earlier attempt
+		// is still being decrypted.
+		DEBUG_MSG( "LoginApp::login: Ignoring repeat attempt from %s "
+				"while another attempt is being decrypted\n",
+			source.c_str() );
+
+		loginStats_.incPending();
+		data.finish();
+		return;
+	}
+
 	if (!Config::allowLogin())
 	{
 		WARNING_MSG( "LoginApp::login: Dropping login attempt from %s because "
@@ -509,7 +544,8 @@ void LoginApp::login( const Mercury::Address & source,
 		return;
 	}
 
-	bool isReattempt = (cachedLoginMap_.count( source ) != 0);
+	bool isReattempt =
+		(loginCache_.find( source ) != NULL);
  	INFO_MSG( "LoginApp::login: %s from %s\n",
 		isReattempt ? "Re-attempt" : "Attempt", source.c_str() );
 
@@ -601,9 +637,6 @@ void LoginApp::login( const Mercury::Address & source,
 		}
 	}
 
-	// Read off login parameters
-	LogOnParamsPtr pParams = new LogOnParams();
-
 	// Save the message so we can have multiple attempts to read it
 	int dataLength = data.remainingLength();
 	const void * pDataData = data.retrieve( dataLength );
@@ -618,60 +651,94 @@ void LoginApp::login( const Mercury::Address & source,
 		return;
 	}
 
-	StreamEncoder * pEncoder = pLogOnParamsEncoder_.get();
+	if (pDecryptionPool_.get() && pDecryptionPool_->isFull())
+	{
+		NOTICE_MSG( "LoginApp::login: "
+				"Login from %s not allowed due to too many logins being "
+				"decrypted\n",
+			source.c_str() );
+
+		this->sendFailure( source, header.replyID,
+				LogOnStatus::LOGIN_REJECTED_RATE_LIMITED,
+				"Logins temporarily disallowed due to load" );
+		return;
+	}
 
-	do
+	if (Config::rateLimitEnabled())
 	{
-		MemoryIStream attempt = MemoryIStream( pDataData, dataLength );
+		// Decrypting the logon parameters is the hard work, so we count this
+		// as a login with regards to rate-limiting before it is done. Resent
+		// attempts that will be answered from the login cache are not
+		// counted, as they were not before decryption was moved here.
+		CachedLogin * pCache = loginCache_.find( source );
 
-		if (pParams->readFromStream( attempt, pEncoder ))
+		if ((pCache == NULL) || pCache->isTooOld())
 		{
-			// We are successful, move on
-			break;
+			--numAllowedLoginsLeft_;
 		}
+	}
 
-		if (pEncoder && Config::allowUnencryptedLogins())
-		{
-			// If we tried using encryption, have another go without it
-			pEncoder = NULL;
-			continue;
-		}
+	if (pDecryptionPool_.get())
+	{
+		// Continued in onLogOnParamsDecrypted.
+		pDecryptionPool_->decrypt( source, header.replyID,
+				pDataData, dataLength );
+		return;
+	}
 
-		// Nothing left to try, bail out
-		this->sendFailure( source, header.replyID,
+	LogOnParamsPtr pParams = LoginDecryptionPool::readParams(
+			pDataData, dataLength, pLogOnParamsEncoder_.get(),
+			Config::allowUnencryptedLogins() );
+
+	this->onLogOnParamsDecrypted( source, header.replyID, pParams );
+}
+
+
+/**
+ *	This method continues a login attempt once its login parameters have been
+ *	decrypted.
+ *
+ *	@param pParams	The login parameters, or NULL if they could not be read.
+ */
+void LoginApp::onLogOnParamsDecrypted( const Mercury::Address & source,
+		Mercury::ReplyID replyID, LogOnParamsPtr pParams )
+{
+	if (!pParams)
+	{
+		this->sendFailure( source, replyID,
 			LogOnStatus::LOGIN_MALFORMED_REQUEST,
 			"Could not destream login parameters. Possibly caused by "
 			"mis-matching LoginApp keypair." );
 		return;
-		// Does not reach here
 	}
-	while (false);
 
 	// First check whether this is a repeat attempt from a recent
 	// resolved login before attempting to log in.
-	if (this->handleResentCachedAttempt( source, pParams, header.replyID ))
+	if (this->handleResentCachedAttempt( source, pParams, replyID ))
 	{
 		// ignore this one, we've seen it recently
 		return;
 	}
 
-	if (Config::rateLimitEnabled())
+	// The connection to the DBMgr may have been lost while decrypting.
+	if (!this->isDBReady())
 	{
-		// We've done the hard work of decrypting the logon parameters now, so
-		// we count this as a login with regards to rate-limiting.
-		--numAllowedLoginsLeft_;
+		this->sendFailure( source, replyID,
+			LogOnStatus::LOGIN_REJECTED_DB_NOT_READY, "DB not ready" );
+		return;
 	}
 
 	// Check that it has encryption key if we disallow unencrypted logins
 	if (pParams->encryptionKey().empty() && !Config::allowUnencryptedLogins())
 	{
-		this->sendFailure( source, header.replyID,
+		this->sendFailure( source, replyID,
 			LogOnStatus::LogOnStatus::LOGIN_MALFORMED_REQUEST,
 			"No encryption key supplied, and server is not allowing "
 				"unencrypted logins." );
 		return;
 	}
 
+	this->chooseChannelCipher( *pParams );
 
 	INFO_MSG( "Logging in %s{%s} (%s)\n",
 		pParams->username().c_str(),
@@ -680,11 +747,10 @@ void LoginApp::login( const Mercury::Address & source,
 
 	// Remember that this attempt is now in progress and discard further
 	// attempts from that address for some time after it completes.
-	cachedLoginMap_[ source ].reset();
-	cachedLoginMap_[ source ].pParams( pParams );
+	loginCache_.onLoginPending( source, pParams );
 
 	DatabaseReplyHandler * pDBHandler =
-		new DatabaseReplyHandler( *this, source, header.replyID, pParams );
+		new DatabaseReplyHandler( *this, source, replyID, pParams );
 
 	Mercury::Bundle	& dbBundle = this->dbMgr().bundle();
 	dbBundle.startRequest( DBInterface::logOn, pDBHandler );
@@ -695,6 +761,21 @@ void LoginApp::login( const Mercury::Address & source,
 }
 
 
+/**
+ *	This method chooses the cipher that the client's channel to its BaseApp
+ *	will use. The choice is passed on with the login parameters and returned
+ *	to the client with the login reply.
+ *
+ *	This is always Blowfish for now. The BaseApp does not yet install
+ *	AESGCMFilter on proxy channels, so a client told to use AES-GCM would not
+ *	be able to talk to its BaseApp.
+ */
+void LoginApp::chooseChannelCipher( LogOnParams & params ) const
+{
+	params.channelCipher( LogOnParams::CHANNEL_CIPHER_BLOWFISH );
+}
+
+
 /**
  *
  */
@@ -774,29 +855,9 @@ void LoginApp::sendAndCacheSuccess( const Mercury::Address & addr,
 		Mercury::ReplyID replyID, const LoginReplyRecord & replyRecord,
 		LogOnParamsPtr pParams )
 {
-	this->sendSuccess( addr, replyID, replyRecord,
-		pParams->encryptionKey() );
-
-	cachedLoginMap_[ addr ].replyRecord( replyRecord );
-
-	// Do not let the map get too big. Just check every so often to get rid of
-	// old caches.
+	this->sendSuccess( addr, replyID, replyRecord, *pParams );
 
-	if (cachedLoginMap_.size() > 100)
-	{
-		CachedLoginMap::iterator iter = cachedLoginMap_.begin();
-
-		while (iter != cachedLoginMap_.end())
-		{
-			CachedLoginMap::iterator prevIter = iter;
-			++iter;
-
-			if (prevIter->second.isTooOld())
-			{
-				cachedLoginMap_.erase( prevIter );
-			}
-		}
-	}
+	loginCache_.onLoginSucceeded( addr, replyRecord );
 }
 
 
@@ -806,19 +867,25 @@ void LoginApp::sendAndCacheSuccess( const Mercury::Address & addr,
  */
 void LoginApp::sendSuccess( const Mercury::Address & addr,
 	Mercury::ReplyID replyID, const LoginReplyRecord & replyRecord,
-	const std::string & encryptionKey )
+	const LogOnParams & params )
 {
 	Mercury::Bundle b;
 	b.startReply( replyID, Mercury::RELIABLE_NO );
 	b << (int8)LogOnStatus::LOGGED_ON;
 
 #ifdef USE_OPENSSL
-	if (!encryptionKey.empty())
+	if (!params.encryptionKey().empty())
 	{
 		// We have to encrypt the reply record because it contains the session key
-		Mercury::EncryptionFilter filter( encryptionKey );
+		Mercury::EncryptionFilter filter( params.encryptionKey() );
 		MemoryOStream clearText;
 		clearText << replyRecord;
+
+		// The chosen channel cipher follows the reply record. Older clients
+		// ignore it and the padding of replies from older servers reads as
+		// CHANNEL_CIPHER_BLOWFISH.
+		clearText << params.channelCipher();
+
 		filter.encryptStream( clearText, b );
 	}
 	else
@@ -841,11 +908,11 @@ void LoginApp::sendSuccess( const Mercury::Address & addr,
 bool LoginApp::handleResentPendingAttempt( const Mercury::Address & addr,
 		Mercury::ReplyID replyID )
 {
-	CachedLoginMap::iterator iter = cachedLoginMap_.find( addr );
+	CachedLogin * pCache = loginCache_.find( addr );
 
-	if (iter != cachedLoginMap_.end())
+	if (pCache != NULL)
 	{
-		CachedLogin & cache = iter->second;
+		CachedLogin & cache = *pCache;
 
 		if (cache.isPending())
 		{
@@ -870,18 +937,18 @@ bool LoginApp::handleResentPendingAttempt( const Mercury::Address & addr,
 bool LoginApp::handleResentCachedAttempt( const Mercury::Address & addr,
 		LogOnParamsPtr pParams, Mercury::ReplyID replyID )
 {
-	CachedLoginMap::iterator iter = cachedLoginMap_.find( addr );
+	CachedLogin * pCache = loginCache_.find( addr );
 
-	if (iter != cachedLoginMap_.end())
+	if (pCache != NULL)
 	{
-		CachedLogin & cache = iter->second;
+		CachedLogin & cache = *pCache;
 		if (!cache.isTooOld() && *cache.pParams() == *pParams)
 		{
 			DEBUG_MSG( "%s retransmitting successful login to %s\n",
 					   addr.c_str(),
 					   cache.pParams()->username().c_str() );
 			this->sendSuccess( addr, replyID, cache.replyRecord(),
-				cache.pParams()->encryptionKey() );
+				*cache.pParams() );
 
 			return true;
 		}
@@ -927,66 +994,4 @@ void LoginApp::onSignalled( int sigNum )
 }
 
 
-// -----------------------------------------------------------------------------
-// Section: CachedLogin
-// -----------------------------------------------------------------------------
-
-/**
- *  This method returns true if this login is pending, i.e. we are waiting on
- *  the DBMgr to tell us whether or not the login is successful.
- */
-bool LoginApp::CachedLogin::isPending() const
-{
-	return creationTime_ == 0;
-}
-
-
-/**
- *	This method returns whether or not this cache is too old to use.
- */
-bool LoginApp::CachedLogin::isTooOld() const
-{
-	const uint64 MAX_LOGIN_DELAY = LoginAppConfig::maxLoginDelayInStamps();
-
-	return !this->isPending() &&
-		(::timestamp() - creationTime_ > MAX_LOGIN_DELAY);
-}
-
-
-/**
- *  This method sets the reply record into this cached object, and is called
- *  when the DBMgr replies.
- */
-void LoginApp::CachedLogin::replyRecord( const LoginReplyRecord & record )
-{
-	replyRecord_ = record;
-	creationTime_ = ::timestamp();
-}
-
-
-
-// -----------------------------------------------------------------------------
-// Section: LoginStats
-// -----------------------------------------------------------------------------
-
-
-// Make the EMA bias equivalent to having the most recent 5 samples represent
-// 86% of the total weight. This is purely arbitrary, and may be adjusted to
-// increase or decrease the sensitivity of the login statistics as reported in
-// the 'averages' watcher directory.
-static const uint WEIGHTING_NUM_SAMPLES = 5;
-
-/**
- * The EMA bias for the login statistics.
- */
-const float LoginApp::LoginStats::BIAS = 2.f / (WEIGHTING_NUM_SAMPLES + 1);
-
-LoginApp::LoginStats::LoginStats():
-			fails_( BIAS ),
-			rateLimited_( BIAS ),
-			pending_( BIAS ),
-			successes_( BIAS ),
-			all_( BIAS )
-{}
-
 // loginapp.cpp
@@ -28,14 +28,15 @@ criminal penalties as provided by law.
 #include "server/server_app.hpp"
 #include "server/stream_helper.hpp"
 
-#include "math/ema.hpp"
-
 #include "login_int_interface.hpp"
+#include "login_cache.hpp"
+#include "login_stats.hpp"
 
 #include <memory>
 #include <vector>
 
 class LoginAppConfig;
+class LoginDecryptionPool;
 class StreamEncoder;
 
 namespace Mercury
@@ -87,6 +88,9 @@ public:
 			Mercury::ReplyID replyID, const LoginReplyRecord & replyRecord,
 			LogOnParamsPtr pParams );
 
+	void onLogOnParamsDecrypted( const Mercury::Address & source,
+			Mercury::ReplyID replyID, LogOnParamsPtr pParams );
+
 	Mercury::NetworkInterface &	intInterface()		{ return interface_; }
 	Mercury::NetworkInterface &	extInterface()		{ return extInterface_; }
 
@@ -116,35 +120,6 @@ private:
 	virtual bool run();
 	virtual void onSignalled( int sigNum );
 
-	/**
-	 *	This class is used to store a recent, successful login. It is used to
-	 *	handle the case where the reply to the client is dropped.
-	 */
-	class CachedLogin
-	{
-	public:
-		// We set creationTime_ to 0 to indicate that the login is pending.
-		CachedLogin() : creationTime_( 0 ) {}
-
-		bool isTooOld() const;
-		bool isPending() const;
-
-		void pParams( LogOnParamsPtr pParams ) { pParams_ = pParams; }
-		LogOnParamsPtr pParams() { return pParams_; }
-
-		void replyRecord( const LoginReplyRecord & record );
-		const LoginReplyRecord & replyRecord() const { return replyRecord_; }
-
-		/// This method re-initialises the cache object to indicate that it is
-		/// pending.
-		void reset() { creationTime_ = 0; }
-
-	private:
-		uint64 creationTime_;
-		LogOnParamsPtr pParams_;
-		LoginReplyRecord replyRecord_;
-	};
-
 	bool handleResentPendingAttempt( const Mercury::Address & addr,
 		Mercury::ReplyID replyID );
 	bool handleResentCachedAttempt( const Mercury::Address & addr,
@@ -152,9 +127,12 @@ private:
 
 	void sendSuccess( const Mercury::Address & addr,
 		Mercury::ReplyID replyID, const LoginReplyRecord & replyRecord,
-		const std::string & encryptionKey );
+		const LogOnParams & params );
+
+	void chooseChannelCipher( LogOnParams & params ) const;
 
 	std::auto_ptr< StreamEncoder > 	pLogOnParamsEncoder_;
+	std::auto_ptr< LoginDecryptionPool > pDecryptionPool_;
 	Mercury::NetworkInterface		extInterface_;
 
 	NetMask 			netMask_;
@@ -166,8 +144,7 @@ private:
 	uint8				systemOverloaded_;
 	uint64				systemOverloadedTime_;
 
-	typedef std::map< Mercury::Address, CachedLogin > CachedLoginMap;
-	CachedLoginMap 		cachedLoginMap_;
+	LoginCache			loginCache_;
 
 	AnonymousChannelClient dbMgr_;
 
@@ -180,107 +157,6 @@ private:
 
 	static LoginApp * pInstance_;
 
-	static const uint32 UPDATE_STATS_PERIOD;
-
-	/**
-	 *	This class represents login statistics. These statistics are exposed to
-	 *	watchers.
-	 */
-	class LoginStats: public TimerHandler
-	{
-	public:
-		/**
-		 *	Constructor.
-		 */
-		LoginStats();
-
-		/**
-		 *	Overridden from TimerHandler.
-		 */
-		virtual void handleTimeout( TimerHandle handle, void * arg )
-		{
-			this->update();
-		}
-
-		// Incrementing accessors
-
-		/**
-		 *	Increment the count for rate-limited logins.
-		 */
-		void incRateLimited() 	{ ++all_.value(); ++rateLimited_.value(); }
-
-		/**
-		 *	Increment the count for failed logins.
-		 */
-		void incFails() 		{ ++all_.value(); ++fails_.value(); }
-
-		/**
-		 *	Increment the count for repeated logins (duplicate logins that came
-		 *	in from the client while the original was pending.
-		 */
-		void incPending() 		{ ++all_.value(); ++pending_.value(); }
-
-		/**
-		 *	Increment the count for successful logins.
-		 */
-		void incSuccesses() 	{ ++all_.value(); ++successes_.value(); }
-
-		// Average accessors
-
-		/**
-		 *	Return the failed logins per second average.
-		 */
-		float fails() const 		{ return fails_.average(); }
-
-		/**
-		 *	Return the rate-limited logins per second average.
-		 */
-		float rateLimited() const 	{ return rateLimited_.average(); }
-
-		/**
-		 *	Return the repeated logins (due to already pending login) per
-		 *	second average.
-		 */
-		float pending() const 		{ return pending_.average(); }
-
-		/**
-		 *	Return the successful logins per second average.
-		 */
-		float successes() const 	{ return successes_.average(); }
-
-		/**
-		 *	Return the logins per second average.
-		 */
-		float all() const 			{ return all_.average(); }
-
-		/**
-		 *	This method updates the averages to the accumulated values.
-		 */
-		void update()
-		{
-			fails_.sample();
-			rateLimited_.sample();
-			successes_.sample();
-			pending_.sample();
-			all_.sample();
-		}
-
-	private:
-		/// Failed logins.
-		AccumulatingEMA< uint32 > fails_;
-		/// Rate-limited logins.
-		AccumulatingEMA< uint32 > rateLimited_;
-		/// Repeated logins that matched a pending login.
-		AccumulatingEMA< uint32 > pending_;
-		/// Successful logins.
-		AccumulatingEMA< uint32 > successes_;
-		/// All logins.
-		AccumulatingEMA< uint32 > all_;
-
-		/// The bias for all the exponential averages.
-		static const float BIAS;
-	};
-
 	LoginStats loginStats_;
 	TimerHandle statsTimer_;
 };
@@ -35,6 +35,9 @@ BW_OPTION( bool, logProbes, true );
 BW_OPTION_RO( bool, registerExternalInterface, false );
 BW_OPTION( bool, allowUnencryptedLogins, false );
 
+BW_OPTION_RO( int, numDecryptionThreads, 0 );
+BW_OPTION( int, maxPendingDecryptions, 1000 );
+
 BW_OPTION( int, loginRateLimit, 0 );
 BW_OPTION( int, rateLimitDuration, 0 );
 
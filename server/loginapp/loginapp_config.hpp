@@ -36,6 +36,9 @@ public:
 	static ServerAppOption< bool > registerExternalInterface;
 	static ServerAppOption< bool > allowUnencryptedLogins;
 
+	static ServerAppOption< int > numDecryptionThreads;
+	static ServerAppOption< int > maxPendingDecryptions;
+
 	static ServerAppOption< int > loginRateLimit;
 	static ServerAppOption< int > rateLimitDuration;
 
@@ -317,6 +317,8 @@ void ClientApp::logOn()
 		BotsConfig::serverName().c_str(),
 		userName_.c_str(),
 		userPasswd_.c_str() );
+
+	app.loginStats().onLogOnBegin();
 }
 
 void ClientApp::logOff()
@@ -869,6 +871,11 @@ bool ClientApp::tick( float dTime )
 			LogOnStatus status =
 				serverConnection_.logOnComplete( pLoginInProgress_, this );
 
+			MainApp::instance().loginStats().onLogOnComplete(
+				pLoginInProgress_->startTime(),
+				pLoginInProgress_->finishTime(),
+				status.succeeded() );
+
 			pLoginInProgress_ = NULL;
 
 			if (!status.succeeded())
@@ -0,0 +1,208 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "login_stats.hpp"
+
+#include "cstdmf/debug.hpp"
+#include "cstdmf/timestamp.hpp"
+#include "cstdmf/watcher.hpp"
+
+#include <algorithm>
+
+DECLARE_DEBUG_COMPONENT2( "Bots", 0 )
+
+
+namespace // anonymous
+{
+
+double stampsToMillis( uint64 stamps )
+{
+	return double( stamps ) * 1000.0 / stampsPerSecondD();
+}
+
+} // namespace (anonymous)
+
+
+/**
+ *	Constructor.
+ */
+LoginStats::LoginStats() :
+	numStarted_( 0 ),
+	numSucceeded_( 0 ),
+	numFailed_( 0 ),
+	numStormLoginsLeft_( 0 ),
+	firstStartTime_( 0 ),
+	lastFinishTime_( 0 ),
+	latencies_()
+{
+}
+
+
+/**
+ *	This method clears the statistics before a login storm. The storm is
+ *	complete once the given number of logins have completed.
+ */
+void LoginStats::startStorm( int numLogins )
+{
+	this->reset();
+
+	numStormLoginsLeft_ = numLogins;
+
+	INFO_MSG( "LoginStats::startStorm: Logging in %d bots\n", numLogins );
+}
+
+
+/**
+ *	This method clears the statistics.
+ */
+void LoginStats::reset()
+{
+	numStarted_ = 0;
+	numSucceeded_ = 0;
+	numFailed_ = 0;
+	numStormLoginsLeft_ = 0;
+	firstStartTime_ = 0;
+	lastFinishTime_ = 0;
+	latencies_.clear();
+}
+
+
+/**
+ *	This method is called when a bot sends its login request.
+ */
+void LoginStats::onLogOnBegin()
+{
+	if (numStarted_ == 0)
+	{
+		firstStartTime_ = timestamp();
+	}
+
+	++numStarted_;
+}
+
+
+/**
+ *	This method is called when a bot's login has completed.
+ *
+ *	@param startTime	The time at which the login request was sent.
+ *	@param finishTime	The time at which the login completed.
+ *	@param succeeded	Whether the bot is now logged in.
+ */
+void LoginStats::onLogOnComplete( uint64 startTime, uint64 finishTime,
+		bool succeeded )
+{
+	lastFinishTime_ = std::max( lastFinishTime_, finishTime );
+
+	if (succeeded)
+	{
+		++numSucceeded_;
+		latencies_.push_back( finishTime - startTime );
+	}
+	else
+	{
+		++numFailed_;
+	}
+
+	if ((numStormLoginsLeft_ > 0) && (--numStormLoginsLeft_ == 0))
+	{
+		INFO_MSG( "LoginStats::onLogOnComplete: Login storm complete. "
+				"%d succeeded, %d failed, %.1f logins/sec. "
+				"Latency (ms): average %.1f, median %.1f, p99 %.1f, "
+				"max %.1f\n",
+			numSucceeded_, numFailed_, this->loginsPerSecond(),
+			this->averageLatency(), this->medianLatency(),
+			this->p99Latency(), this->maxLatency() );
+	}
+}
+
+
+/**
+ *	This method returns the rate of successful logins, from when the first
+ *	login was sent to when the last login completed.
+ */
+double LoginStats::loginsPerSecond() const
+{
+	if ((numSucceeded_ == 0) || (lastFinishTime_ <= firstStartTime_))
+	{
+		return 0.0;
+	}
+
+	return numSucceeded_ * stampsPerSecondD() /
+		double( lastFinishTime_ - firstStartTime_ );
+}
+
+
+/**
+ *	This method returns the average latency of successful logins in
+ *	milliseconds.
+ */
+double LoginStats::averageLatency() const
+{
+	if (latencies_.empty())
+	{
+		return 0.0;
+	}
+
+	uint64 total = 0;
+
+	for (size_t i = 0; i < latencies_.size(); ++i)
+	{
+		total += latencies_[i];
+	}
+
+	return stampsToMillis( total ) / latencies_.size();
+}
+
+
+/**
+ *	This method returns the given percentile of the latencies of successful
+ *	logins in milliseconds.
+ */
+double LoginStats::latencyPercentile( double percentile ) const
+{
+	if (latencies_.empty())
+	{
+		return 0.0;
+	}
+
+	std::vector< uint64 > latencies( latencies_ );
+
+	size_t index = std::min( latencies.size() - 1,
+		size_t( percentile / 100.0 * latencies.size() ) );
+
+	std::nth_element( latencies.begin(), latencies.begin() + index,
+		latencies.end() );
+
+	return stampsToMillis( latencies[ index ] );
+}
+
+
+/**
+ *	This method adds the watchers that report the login statistics.
+ */
+void LoginStats::addWatchers()
+{
+	MF_WATCH( "loginStats/numStarted", numStarted_, Watcher::WT_READ_ONLY );
+	MF_WATCH( "loginStats/numSucceeded", numSucceeded_,
+		Watcher::WT_READ_ONLY );
+	MF_WATCH( "loginStats/numFailed", numFailed_, Watcher::WT_READ_ONLY );
+	MF_WATCH( "loginStats/loginsPerSecond", *this,
+		&LoginStats::loginsPerSecond );
+
+	MF_WATCH( "loginStats/latency/average", *this,
+		&LoginStats::averageLatency );
+	MF_WATCH( "loginStats/latency/median", *this,
+		&LoginStats::medianLatency );
+	MF_WATCH( "loginStats/latency/p99", *this, &LoginStats::p99Latency );
+	MF_WATCH( "loginStats/latency/max", *this, &LoginStats::maxLatency );
+}
+
+// login_stats.cpp
@@ -0,0 +1,68 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef LOGIN_STATS_HPP
+#define LOGIN_STATS_HPP
+
+#include "cstdmf/stdmf.hpp"
+
+#include <vector>
+
+
+/**
+ *	This class measures how quickly bots log in. It is used to benchmark the
+ *	server under a login storm, started by the command/loginStorm watcher,
+ *	where many bots log in at once. A summary is logged when every bot in the
+ *	storm has finished logging in.
+ *
+ *	The latency of a login is the time from sending the login request to the
+ *	LoginApp until the BaseApp accepts the client, or the login fails.
+ */
+class LoginStats
+{
+public:
+	LoginStats();
+
+	void startStorm( int numLogins );
+
+	void onLogOnBegin();
+	void onLogOnComplete( uint64 startTime, uint64 finishTime,
+			bool succeeded );
+
+	double loginsPerSecond() const;
+
+	double averageLatency() const;
+	double medianLatency() const	{ return this->latencyPercentile( 50.0 ); }
+	double p99Latency() const		{ return this->latencyPercentile( 99.0 ); }
+	double maxLatency() const		{ return this->latencyPercentile( 100.0 ); }
+
+	void addWatchers();
+
+private:
+	double latencyPercentile( double percentile ) const;
+
+	void reset();
+
+	int numStarted_;
+	int numSucceeded_;
+	int numFailed_;
+
+	// The number of logins in the current storm that are yet to complete.
+	int numStormLoginsLeft_;
+
+	uint64 firstStartTime_;
+	uint64 lastFinishTime_;
+
+	// The latencies of successful logins, in stamps.
+	std::vector< uint64 > latencies_;
+};
+
+#endif // LOGIN_STATS_HPP
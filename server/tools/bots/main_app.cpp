@@ -228,6 +228,20 @@ void MainApp::addBots( int num )
 	}
 }
 
+/**
+ *	This method adds bots that all log in at once, and reports how quickly
+ *	they log in when they have all finished. The login statistics are also
+ *	available as watchers under loginStats.
+ */
+void MainApp::loginStorm( int num )
+{
+	if (num <= 0)
+		return;
+
+	loginStats_.startStorm( num );
+	this->addBots( num );
+}
+
 void MainApp::addBotsWithName( PyObjectPtr logInfoData )
 {
 	if (!logInfoData || logInfoData == Py_None)
@@ -747,6 +761,8 @@ void MainApp::initWatchers()
 			MF_WRITE_ACCESSOR( int, MainApp, addBots ) );
 	MF_WATCH( "command/delBots", *this,
 			MF_WRITE_ACCESSOR( int, MainApp, delBots ) );
+	MF_WATCH( "command/loginStorm", *this,
+			MF_WRITE_ACCESSOR( int, MainApp, loginStorm ) );
 
 	MF_WATCH( "tag", BotsConfig::tag.getRef() );
 	MF_WATCH( "command/delTaggedEntities", *this,
@@ -771,6 +787,8 @@ void MainApp::initWatchers()
 
 	MF_WATCH( "sendTimeReportThreshold", *this, 
 			MF_ACCESSORS( double, MainApp, sendTimeReportThreshold ) ); 
+
+	loginStats_.addWatchers();
 }
 
 
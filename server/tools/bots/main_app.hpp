@@ -15,6 +15,7 @@ criminal penalties as provided by law.
 #include "Python.h"
 
 #include "bots_config.hpp"
+#include "login_stats.hpp"
 #include "space_data_manager.hpp"
 
 #include "cstdmf/md5.hpp"
@@ -58,6 +59,7 @@ public:
 	void addBots( int num );
 	void addBotsWithName( PyObjectPtr logInfoData );
 	void delBots( int num );
+	void loginStorm( int num );
 
 	void delTaggedEntities( std::string tag );
 
@@ -104,12 +106,16 @@ public:
 	SpaceDataManager & spaceDataManager()
 		{ return spaceDataManager_; }
 
+	LoginStats & loginStats()
+		{ return loginStats_; }
+
 private:
 	void parseCommandLine( int argc, char * argv[] );
 	bool initScript();
 	void initWatchers();
 
 	SpaceDataManager spaceDataManager_;
+	LoginStats loginStats_;
 
 	std::auto_ptr< StreamEncoder > 	pLogOnParamsEncoder_;
 
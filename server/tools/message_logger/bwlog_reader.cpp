@@ -207,6 +207,19 @@ const LogStringInterpolator *BWLogReader::getHandlerForLogEntry(
 }
 
 
+/**
+ * Obtains the handler for the format string at the given offset in the
+ * strings file.
+ *
+ * @returns A pointer to a log handler on success, NULL on error.
+ */
+const LogStringInterpolator *BWLogReader::getHandlerForStringOffset(
+	uint32 stringOffset )
+{
+	return formatStrings_.getHandlerForStringOffset( stringOffset );
+}
+
+
 /**
  * Refreshes the main log files if they are being written to and have been
  * modified since we last looked at them.
@@ -45,6 +45,8 @@ public:
 	uint32 getAddressFromHost( const char *hostname ) const;
 
 	const LogStringInterpolator *getHandlerForLogEntry( const LogEntry &entry );
+	const LogStringInterpolator *getHandlerForStringOffset(
+		uint32 stringOffset );
 
 	bool refreshFileMaps();
 
@@ -115,7 +115,20 @@ LogStringInterpolator* FormatStrings::resolve( const std::string &fmt )
 const LogStringInterpolator* FormatStrings::getHandlerForLogEntry(
 	const LogEntry &entry )
 {
-	OffsetMap::iterator it = offsetMap_.find( entry.stringOffset_ );
+	return this->getHandlerForStringOffset( entry.stringOffset_ );
+}
+
+
+/**
+ * This method returns the string handler for the format string at the given
+ * offset in the strings file.
+ *
+ * @returns A pointer to a LogStringInterpolator on success, NULL on error.
+ */
+const LogStringInterpolator* FormatStrings::getHandlerForStringOffset(
+	uint32 stringOffset )
+{
+	OffsetMap::iterator it = offsetMap_.find( stringOffset );
 
 	if (it == offsetMap_.end())
 	{
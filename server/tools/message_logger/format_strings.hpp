@@ -37,6 +37,8 @@ public:
 	LogStringInterpolator * resolve( const std::string &fmt );
 
 	const LogStringInterpolator * getHandlerForLogEntry( const LogEntry &entry );
+	const LogStringInterpolator * getHandlerForStringOffset(
+		uint32 stringOffset );
 
 	FormatStringList getFormatStrings() const;
 
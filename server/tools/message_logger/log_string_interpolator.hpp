@@ -46,6 +46,7 @@ public:
 	void read( FileStream &fs );
 
 	const std::string &fmt() const { return fmt_; }
+	bool hasArgs() const { return !fmtData_.empty(); }
 
 	bool streamToLog( LogStringWriter &writer, 
 		BinaryIStream &is, uint8 version = MESSAGE_LOGGER_VERSION );
@@ -0,0 +1,265 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "mapped_file.hpp"
+
+#include "cstdmf/debug.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+
+namespace // anonymous
+{
+
+// The amount of a file to ask the kernel to read in ahead of a scan. The
+// kernel's own readahead only helps forward scans, so this is what makes
+// backward scans fast.
+const long READ_AHEAD_SIZE = 1024 * 1024;
+
+} // namespace (anonymous)
+
+
+// -----------------------------------------------------------------------------
+// Section: MappedFile
+// -----------------------------------------------------------------------------
+
+/**
+ * Constructor.
+ */
+MappedFile::MappedFile() :
+	path_(),
+	pData_( NULL ),
+	length_( 0 ),
+	readAheadBegin_( 0 ),
+	readAheadEnd_( 0 ),
+	isGood_( false )
+{ }
+
+
+/**
+ * Destructor.
+ */
+MappedFile::~MappedFile()
+{
+	if (pData_ != NULL)
+	{
+		munmap( pData_, length_ );
+	}
+}
+
+
+/**
+ * Sets the file to map. Nothing is mapped until the file is first read.
+ */
+void MappedFile::init( const char *path )
+{
+	path_ = path;
+	isGood_ = true;
+}
+
+
+/**
+ * Returns a pointer to the given range of the file, or NULL if the range is
+ * past the end of the file or the file couldn't be mapped.
+ */
+const char * MappedFile::data( long offset, long length )
+{
+	if (offset < 0)
+	{
+		return NULL;
+	}
+
+	if ((offset + length > length_) &&
+		(!this->remap() || (offset + length > length_)))
+	{
+		return NULL;
+	}
+
+	return pData_ + offset;
+}
+
+
+/**
+ * Tells the kernel that the file is being scanned from the given offset in
+ * the given direction, so that it reads in the pages ahead of the scan. This
+ * only does anything once the scan leaves the range it was last called for.
+ */
+void MappedFile::willRead( long offset, SearchDirection direction )
+{
+	if ((pData_ == NULL) ||
+		((readAheadBegin_ <= offset) && (offset < readAheadEnd_)))
+	{
+		return;
+	}
+
+	static const long pageSize = sysconf( _SC_PAGESIZE );
+
+	long begin;
+	long end;
+
+	if (direction == QUERY_FORWARDS)
+	{
+		begin = offset;
+		end = std::min( offset + READ_AHEAD_SIZE, length_ );
+	}
+	else
+	{
+		begin = std::max( offset - READ_AHEAD_SIZE, 0L );
+		end = std::min( offset + 1, length_ );
+	}
+
+	// madvise() requires a page aligned address.
+	begin -= begin % pageSize;
+
+	if (begin >= end)
+	{
+		return;
+	}
+
+	madvise( pData_ + begin, end - begin, MADV_WILLNEED );
+
+	readAheadBegin_ = begin;
+	readAheadEnd_ = end;
+}
+
+
+/**
+ * Maps the file again if it has grown since it was last mapped.
+ *
+ * @returns false if the file couldn't be mapped, true otherwise.
+ */
+bool MappedFile::remap()
+{
+	if (!isGood_)
+	{
+		return false;
+	}
+
+	int fd = open( path_.c_str(), O_RDONLY );
+
+	if (fd == -1)
+	{
+		ERROR_MSG( "MappedFile::remap: Couldn't open %s: %s\n",
+			path_.c_str(), strerror( errno ) );
+		return false;
+	}
+
+	struct stat statInfo;
+
+	if (fstat( fd, &statInfo ) == -1)
+	{
+		ERROR_MSG( "MappedFile::remap: Couldn't stat %s: %s\n",
+			path_.c_str(), strerror( errno ) );
+		close( fd );
+		return false;
+	}
+
+	long length = statInfo.st_size;
+
+	if (length <= length_)
+	{
+		close( fd );
+		return true;
+	}
+
+	void *pData = mmap( NULL, length, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+
+	if (pData == MAP_FAILED)
+	{
+		ERROR_MSG( "MappedFile::remap: Couldn't map %s: %s\n",
+			path_.c_str(), strerror( errno ) );
+		isGood_ = false;
+		return false;
+	}
+
+	if (pData_ != NULL)
+	{
+		munmap( pData_, length_ );
+	}
+
+	pData_ = static_cast< char * >( pData );
+	length_ = length;
+
+	readAheadBegin_ = 0;
+	readAheadEnd_ = 0;
+
+	return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// Section: MappedFileIStream
+// -----------------------------------------------------------------------------
+
+/**
+ * Constructor.
+ */
+MappedFileIStream::MappedFileIStream() :
+	pFile_( NULL ),
+	offset_( 0 )
+{ }
+
+
+/**
+ * Positions this stream at the given offset of the given file.
+ */
+void MappedFileIStream::reset( MappedFile *pFile, long offset )
+{
+	pFile_ = pFile;
+	offset_ = offset;
+	error_ = false;
+}
+
+
+const void * MappedFileIStream::retrieve( int nBytes )
+{
+	const char *pData = pFile_->data( offset_, nBytes );
+
+	if (pData == NULL)
+	{
+		error_ = true;
+		return nBytes <= int( sizeof( errBuf ) ) ? errBuf : NULL;
+	}
+
+	offset_ += nBytes;
+
+	return pData;
+}
+
+
+int MappedFileIStream::remainingLength() const
+{
+	return int( std::max( pFile_->length() - offset_, 0L ) );
+}
+
+
+char MappedFileIStream::peek()
+{
+	const char *pData = pFile_->data( offset_, 1 );
+
+	if (pData == NULL)
+	{
+		error_ = true;
+		return -1;
+	}
+
+	return *pData;
+}
+
+// mapped_file.cpp
@@ -0,0 +1,85 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include "constants.hpp"
+
+#include "cstdmf/binary_stream.hpp"
+#include "cstdmf/stdmf.hpp"
+
+#include <string>
+
+
+/**
+ * A read-only memory mapping of a file that may still be growing, such as the
+ * entries and args files of an active segment. The file is mapped when it is
+ * first read, and mapped again whenever a read goes past the end of the
+ * current mapping. No file descriptor is kept open between mappings.
+ *
+ * Pointers returned by data() are only valid until the next call to data().
+ */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	void init( const char *path );
+
+	bool isGood() const { return isGood_; }
+
+	const char * data( long offset, long length );
+	void willRead( long offset, SearchDirection direction );
+
+	long length() const { return length_; }
+
+private:
+	bool remap();
+
+	std::string path_;
+
+	char *pData_;
+	long length_;
+
+	// The part of the mapping that has last been advised as needed soon.
+	long readAheadBegin_;
+	long readAheadEnd_;
+
+	// False once mapping the file has failed, after which it isn't retried.
+	bool isGood_;
+};
+
+
+/**
+ * A BinaryIStream that reads from a MappedFile, starting at a given offset.
+ */
+class MappedFileIStream : public BinaryIStream
+{
+public:
+	MappedFileIStream();
+
+	void reset( MappedFile *pFile, long offset );
+
+	long offset() const { return offset_; }
+
+	// BinaryIStream interface
+	virtual const void * retrieve( int nBytes );
+	virtual int remainingLength() const;
+	virtual char peek();
+
+private:
+	MappedFile *pFile_;
+	long offset_;
+};
+
+#endif // MAPPED_FILE_HPP
@@ -15,6 +15,7 @@ criminal penalties as provided by law.
 
 #include "constants.hpp"
 #include "mlutil.hpp"
+#include "py_multi_query.hpp"
 #include "query_params.hpp"
 #include "py_query.hpp"
 #include "py_user_log.hpp"
@@ -33,6 +34,7 @@ PY_BEGIN_METHODS( PyBWLog )
  	PY_METHOD( getUsers )
 	PY_METHOD( getUserLog )
  	PY_METHOD( fetch )
+	PY_METHOD( fetchMany )
 
 PY_END_METHODS()
 
@@ -367,6 +369,113 @@ PyObject * PyBWLog::py_fetch( PyObject *args, PyObject *kwargs )
 }
 
 
+/**
+ * Query the logs of several users at once. The first argument is a sequence
+ * of UIDs, and the keyword arguments are those of fetch(), along with
+ * 'threads', the number of threads to search the logs in. The results of all
+ * the users are returned in time order.
+ */
+PyObject * PyBWLog::py_fetchMany( PyObject *args, PyObject *kwargs )
+{
+	PyObject *pUIDs = NULL;
+
+	if (!PyArg_ParseTuple( args, "O", &pUIDs ))
+	{
+		return NULL;
+	}
+
+	PyObjectPtr pUIDList( PySequence_Fast( pUIDs,
+			"fetchMany() expects a sequence of UIDs" ),
+		PyObjectPtr::STEAL_REFERENCE );
+
+	if (pUIDList == NULL)
+	{
+		return NULL;
+	}
+
+	if (PySequence_Fast_GET_SIZE( pUIDList.getObject() ) == 0)
+	{
+		PyErr_Format( PyExc_ValueError, "fetchMany() expects at least one UID" );
+		return NULL;
+	}
+
+	// The remaining keyword arguments are passed on to each user's query.
+	PyObjectPtr pQueryKwargs( (kwargs != NULL) ? PyDict_Copy( kwargs ) :
+			PyDict_New(),
+		PyObjectPtr::STEAL_REFERENCE );
+
+	int numThreads = PyMultiQuery::DEFAULT_NUM_THREADS;
+
+	PyObject *pThreads =
+		PyDict_GetItemString( pQueryKwargs.getObject(), "threads" );
+
+	if (pThreads != NULL)
+	{
+		numThreads = PyInt_AsLong( pThreads );
+
+		if (PyErr_Occurred())
+		{
+			return NULL;
+		}
+
+		if (numThreads < 1)
+		{
+			PyErr_Format( PyExc_ValueError,
+				"Invalid number of threads (%d)", numThreads );
+			return NULL;
+		}
+
+		PyDict_DelItemString( pQueryKwargs.getObject(), "threads" );
+	}
+
+	PyMultiQueryPtr pQuery;
+
+	for (Py_ssize_t i = 0;
+			i < PySequence_Fast_GET_SIZE( pUIDList.getObject() ); ++i)
+	{
+		PyObjectPtr pQueryArgs( PyTuple_Pack( 1,
+				PySequence_Fast_GET_ITEM( pUIDList.getObject(), i ) ),
+			PyObjectPtr::STEAL_REFERENCE );
+
+		QueryParamsPtr pParams = this->getQueryParamsFromPyArgs(
+			pQueryArgs.getObject(), pQueryKwargs.getObject() );
+
+		if (pParams == NULL)
+		{
+			// PyErr set in getQueryParamsFromPyArgs via init()
+			return NULL;
+		}
+
+		uint16 uid = pParams->getUID();
+		PyUserLogPtr pUserLog = this->getUserLog( uid );
+
+		if (pUserLog == NULL)
+		{
+			PyErr_Format( PyExc_RuntimeError,
+				"PyBWLog::py_fetchMany: No user log for UID %d\n", uid );
+			return NULL;
+		}
+
+		if (pQuery == NULL)
+		{
+			pQuery = PyMultiQueryPtr(
+				new PyMultiQuery( this, pParams, numThreads ),
+				PyMultiQueryPtr::STEAL_REFERENCE );
+		}
+
+		if (!pQuery->addUser( pParams, pUserLog->getUserLog() ))
+		{
+			// PyErr set in addUser
+			return NULL;
+		}
+	}
+
+	PyObject *ret = pQuery.getObject();
+	Py_INCREF( ret );
+	return ret;
+}
+
+
 
 //=====================================
 // Non-Python API
@@ -44,6 +44,7 @@ public:
 	PY_METHOD_DECLARE( py_getUsers );
 	PY_METHOD_DECLARE( py_getUserLog );
 	PY_KEYWORD_METHOD_DECLARE( py_fetch );
+	PY_KEYWORD_METHOD_DECLARE( py_fetchMany );
 
 	// TODO: deprecated interface. remove the 'root' attribute in 2.0, name
 	//       it something more appropriate.
@@ -0,0 +1,440 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "Python.h"
+
+#include "py_multi_query.hpp"
+
+#include "query_params.hpp"
+#include "query_range.hpp"
+#include "user_segment_reader.hpp"
+
+
+namespace // anonymous
+{
+
+// The number of segments of each user that are searched at once. Searching
+// further ahead of the results being returned would only use more memory.
+const size_t MAX_SEARCHES_AHEAD = 2;
+
+/**
+ *	tp_iter function for PyMultiQuery objects.
+ */
+PyObject *multiQuery_iter( PyObject *pQuery )
+{
+	Py_INCREF( pQuery );
+	return pQuery;
+}
+
+/**
+ *	tp_iternext function for PyMultiQuery objects.
+ */
+PyObject *multiQuery_iternext( PyObject *pIter )
+{
+	PyMultiQuery *pQuery = static_cast< PyMultiQuery * >( pIter );
+	return pQuery->next();
+}
+
+} // namespace (anonymous)
+
+PY_TYPEOBJECT_WITH_ITER( PyMultiQuery, multiQuery_iter, multiQuery_iternext );
+
+PY_BEGIN_METHODS( PyMultiQuery )
+
+	PY_METHOD( get )
+	PY_METHOD( inReverse )
+	PY_METHOD( getProgress )
+
+PY_END_METHODS();
+
+PY_BEGIN_ATTRIBUTES( PyMultiQuery );
+
+PY_END_ATTRIBUTES();
+
+
+
+// -----------------------------------------------------------------------------
+// Section: Python API
+// -----------------------------------------------------------------------------
+
+
+PyObject * PyMultiQuery::pyGetAttribute( const char *attr )
+{
+	PY_GETATTR_STD();
+
+	return PyObjectPlus::pyGetAttribute( attr );
+}
+
+
+/**
+ * Fetch at most the next 'n' search results. Passing 0 as the argument means
+ * fetch all possible results.
+ */
+PyObject * PyMultiQuery::py_get( PyObject *args )
+{
+	int n = 0;
+
+	if (!PyArg_ParseTuple( args, "|i", &n ))
+	{
+		return NULL;
+	}
+
+	PyObject *list = PyList_New( 0 );
+	for (int i=0; n == 0 || i < n; i++)
+	{
+		PyObject *result = this->next();
+
+		if (result == NULL)
+		{
+			PyErr_Clear();
+			return list;
+		}
+		else
+		{
+			PyList_Append( list, result );
+		}
+	}
+
+	return list;
+}
+
+
+/**
+ * Returns true if this query will return results in reverse order
+ */
+PyObject * PyMultiQuery::py_inReverse( PyObject *args )
+{
+	if (direction_ == QUERY_BACKWARDS)
+	{
+		Py_RETURN_TRUE;
+	}
+
+	Py_RETURN_FALSE;
+}
+
+
+/**
+ * Returns a tuple containing the number of entries searched so far as well as
+ * the total number of entries in the range of the query, over all the users.
+ */
+PyObject * PyMultiQuery::py_getProgress( PyObject *args )
+{
+	int numEntriesSearched = numEntriesReleased_;
+
+	for (UserSearches::iterator iter = users_.begin();
+			iter != users_.end(); ++iter)
+	{
+		UserSearch &user = *iter;
+
+		for (size_t i = user.currSearch_; i < user.numSearchesStarted_; ++i)
+		{
+			numEntriesSearched += user.searches_[i]->getNumEntriesSearched();
+		}
+	}
+
+	return Py_BuildValue( "(ii)", numEntriesSearched, totalEntries_ );
+}
+
+
+
+// ------------------------------------------------------------------------------
+// Section: Non-Python API
+// ------------------------------------------------------------------------------
+
+/**
+ * Constructor.
+ *
+ * @param pBWLog 		The log object.
+ * @param pParams		The query parameters of the first user. Those of the
+ *						other users may only differ in their UID.
+ * @param numThreads	The number of threads to search the logs in.
+ */
+PyMultiQuery::PyMultiQuery( PyBWLogPtr pBWLog, QueryParamsPtr pParams,
+		int numThreads ) :
+	PyObjectPlus( &s_type_ ),
+	pBWLog_( pBWLog ),
+	direction_( pParams->getDirection() ),
+	indexFilter_( pParams, pBWLog->getBWLogReader() ),
+	users_(),
+	pContextQuery_( NULL ),
+	totalEntries_( 0 ),
+	numEntriesReleased_( 0 ),
+	progress_(),
+	taskManager_()
+{
+	taskManager_.startThreads( numThreads );
+}
+
+
+/**
+ * Destructor.
+ */
+PyMultiQuery::~PyMultiQuery()
+{
+	for (UserSearches::iterator iter = users_.begin();
+			iter != users_.end(); ++iter)
+	{
+		UserSearch &user = *iter;
+
+		for (size_t i = user.currSearch_; i < user.numSearchesStarted_; ++i)
+		{
+			user.searches_[i]->stop();
+		}
+	}
+
+	// The searches that are still running use progress_, so wait for them.
+	taskManager_.stopAll();
+}
+
+
+/**
+ * This method adds the log of a user to this query, and starts searching it.
+ *
+ * @returns true on success, false with a Python exception set on error.
+ */
+bool PyMultiQuery::addUser( QueryParamsPtr pParams, UserLogReaderPtr pUserLog )
+{
+	if (pParams->getDirection() != direction_)
+	{
+		PyErr_Format( PyExc_ValueError,
+			"The query of UID %d is not in the same direction as the others",
+			pParams->getUID() );
+		return false;
+	}
+
+	// The query of each user is only asked for the entries that its searches
+	// have found, so it has no need of the segment indexes.
+	PyQueryPtr pQuery( new PyQuery( pBWLog_, pParams, pUserLog, false ),
+		PyQueryPtr::STEAL_REFERENCE );
+
+	QueryRangePtr pRange = pQuery->getQueryRange();
+
+	// The user has no entries in the range of the query.
+	if (!pRange->areBoundsGood())
+	{
+		return true;
+	}
+
+	users_.push_back( UserSearch() );
+
+	UserSearch &user = users_.back();
+	user.pQuery_ = pQuery;
+	user.currSearch_ = 0;
+	user.numSearchesStarted_ = 0;
+
+	QueryRange::iterator begin = pRange->iter_curr();
+	QueryRange::iterator end = pRange->iter_end();
+
+	for (int segmentNum = begin.getSegmentNumber();
+			(end.getSegmentNumber() - segmentNum) * direction_ >= 0;
+			segmentNum += direction_)
+	{
+		const UserSegmentReader *pSegment =
+			pUserLog->getUserSegment( segmentNum );
+
+		int firstEntry = (direction_ == QUERY_FORWARDS) ?
+			0 : pSegment->getNumEntries() - 1;
+		int lastEntry = (direction_ == QUERY_FORWARDS) ?
+			pSegment->getNumEntries() - 1 : 0;
+
+		if (segmentNum == begin.getSegmentNumber())
+		{
+			firstEntry = begin.getEntryNumber();
+		}
+
+		if (segmentNum == end.getSegmentNumber())
+		{
+			lastEntry = end.getEntryNumber();
+		}
+
+		if ((lastEntry - firstEntry) * direction_ >= 0)
+		{
+			SegmentSearchPtr pSearch = new SegmentSearch( pParams, pUserLog,
+				segmentNum, firstEntry, lastEntry, progress_ );
+
+			user.searches_.push_back( pSearch );
+			totalEntries_ += pSearch->getTotalEntries();
+		}
+	}
+
+	this->startSearches( user );
+
+	return true;
+}
+
+
+/**
+ * This method is used by the iterator helpers.
+ */
+PyObject * PyMultiQuery::next()
+{
+	// Finish returning the context lines of the last result first.
+	if (pContextQuery_)
+	{
+		PyObject *pResult = pContextQuery_->next();
+
+		if (!pContextQuery_->isFetchingContext())
+		{
+			pContextQuery_ = NULL;
+		}
+
+		return pResult;
+	}
+
+	UserSearch *pUser = NULL;
+	SearchHit hit;
+
+	while (this->findNextHit( pUser, hit ))
+	{
+		SegmentSearch &search = *pUser->searches_[ pUser->currSearch_ ];
+		int segmentNum = search.getSegmentNumber();
+
+		search.popHit( taskManager_ );
+
+		PyObject *pResult =
+			pUser->pQuery_->nextAt( segmentNum, hit.entryNum_ );
+
+		// Skip the hits that turn out not to match.
+		if (pResult == Py_None)
+		{
+			Py_DECREF( pResult );
+			continue;
+		}
+
+		if (pUser->pQuery_->isFetchingContext())
+		{
+			pContextQuery_ = pUser->pQuery_;
+		}
+
+		return pResult;
+	}
+
+	PyErr_SetNone( PyExc_StopIteration );
+	return NULL;
+}
+
+
+/**
+ * This method finds the user whose next hit comes first in the direction of
+ * the query. A hit is only returned once every other user either has a hit of
+ * their own or has been searched past it, so this waits for the searches to
+ * make progress as needed.
+ *
+ * @returns false once every search has finished.
+ */
+bool PyMultiQuery::findNextHit( UserSearch *&pBestUser, SearchHit &bestHit )
+{
+	while (true)
+	{
+		pBestUser = NULL;
+
+		// The least far along of the users that are still being searched.
+		bool isSearching = false;
+		LogTime searchedTime;
+
+		for (UserSearches::iterator iter = users_.begin();
+				iter != users_.end(); ++iter)
+		{
+			UserSearch &user = *iter;
+			SegmentSearch::Status status = SegmentSearch::FINISHED;
+			SearchHit hit;
+			LogTime userSearchedTime;
+
+			while (user.currSearch_ < user.searches_.size())
+			{
+				SegmentSearch &search = *user.searches_[ user.currSearch_ ];
+
+				status = search.peekHit( hit, userSearchedTime );
+
+				if (status != SegmentSearch::FINISHED)
+				{
+					break;
+				}
+
+				numEntriesReleased_ += search.getTotalEntries();
+
+				user.searches_[ user.currSearch_ ] = NULL;
+				++user.currSearch_;
+
+				this->startSearches( user );
+			}
+
+			if (status == SegmentSearch::HAS_HIT)
+			{
+				if ((pBestUser == NULL) ||
+					this->isBefore( hit.time_, bestHit.time_ ))
+				{
+					pBestUser = &user;
+					bestHit = hit;
+				}
+			}
+			else if (status == SegmentSearch::SEARCHING)
+			{
+				if (!isSearching ||
+					this->isBefore( userSearchedTime, searchedTime ))
+				{
+					searchedTime = userSearchedTime;
+				}
+
+				isSearching = true;
+			}
+		}
+
+		if (!isSearching)
+		{
+			return (pBestUser != NULL);
+		}
+
+		// No user still being searched can have a hit before this one.
+		if ((pBestUser != NULL) &&
+			!this->isBefore( searchedTime, bestHit.time_ ))
+		{
+			return true;
+		}
+
+		// Let other Python threads run while waiting.
+		Py_BEGIN_ALLOW_THREADS
+		progress_.pull();
+		Py_END_ALLOW_THREADS
+	}
+}
+
+
+/**
+ * This method starts the searches of the given user's segments that are due
+ * to start.
+ */
+void PyMultiQuery::startSearches( UserSearch &user )
+{
+	UserSegmentIndexFilter *pIndexFilter =
+		indexFilter_.isFiltering() ? &indexFilter_ : NULL;
+
+	while ((user.numSearchesStarted_ < user.searches_.size()) &&
+		(user.numSearchesStarted_ < user.currSearch_ + MAX_SEARCHES_AHEAD))
+	{
+		user.searches_[ user.numSearchesStarted_ ]->start( taskManager_,
+			pIndexFilter );
+
+		++user.numSearchesStarted_;
+	}
+}
+
+
+/**
+ * This method returns true if time a comes before time b in the direction of
+ * the query.
+ */
+bool PyMultiQuery::isBefore( const LogTime &a, const LogTime &b ) const
+{
+	return (direction_ == QUERY_FORWARDS) ? (a < b) : (b < a);
+}
+
+// py_multi_query.cpp
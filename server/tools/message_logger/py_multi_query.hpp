@@ -0,0 +1,112 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef PY_MULTI_QUERY_HPP
+#define PY_MULTI_QUERY_HPP
+
+#include "cstdmf/smartpointer.hpp"
+#include "pyscript/pyobject_plus.hpp"
+
+class PyMultiQuery;
+typedef SmartPointer< PyMultiQuery > PyMultiQueryPtr;
+
+#include "py_bwlog.hpp"
+#include "py_query.hpp"
+#include "query_index_filter.hpp"
+#include "segment_search.hpp"
+
+#include "cstdmf/bgtask_manager.hpp"
+#include "cstdmf/concurrency.hpp"
+
+#include <vector>
+
+/**
+ * Generator-style object for iterating over the results of a query of several
+ * users' logs. The segments of each log are searched in a pool of background
+ * threads, and the results of all the users are returned in time order.
+ *
+ * Each result is returned with its context lines, as a PyQuery of that user's
+ * log would return it. The format strings of the log must not be refreshed
+ * while the query is in progress.
+ */
+class PyMultiQuery : public PyObjectPlus
+{
+	Py_InstanceHeader( PyMultiQuery );
+
+public:
+	static const int DEFAULT_NUM_THREADS = 4;
+
+	PyMultiQuery( PyBWLogPtr pBWLog, QueryParamsPtr pParams, int numThreads );
+
+	/* Python API */
+	PyObject * pyGetAttribute( const char *attr );
+
+	PY_METHOD_DECLARE( py_get );
+	PY_METHOD_DECLARE( py_inReverse );
+	PY_METHOD_DECLARE( py_getProgress );
+
+
+	/* Non-Python API */
+	bool addUser( QueryParamsPtr pParams, UserLogReaderPtr pUserLog );
+
+	PyObject * next();
+
+private:
+	// This object should only be deleted by Py_DECREF
+	~PyMultiQuery();
+
+	/**
+	 * The search of one user's log.
+	 */
+	struct UserSearch
+	{
+		PyQueryPtr pQuery_;
+
+		// The searches of the segments in the range of the query, in the
+		// direction of the query. Searches are started a few at a time, and
+		// released once they are finished.
+		typedef std::vector< SegmentSearchPtr > SegmentSearches;
+		SegmentSearches searches_;
+
+		size_t currSearch_;
+		size_t numSearchesStarted_;
+	};
+
+	typedef std::vector< UserSearch > UserSearches;
+
+	bool findNextHit( UserSearch *&pUser, SearchHit &hit );
+	void startSearches( UserSearch &user );
+	bool isBefore( const LogTime &a, const LogTime &b ) const;
+
+	PyBWLogPtr pBWLog_;
+
+	SearchDirection direction_;
+
+	QueryIndexFilter indexFilter_;
+
+	UserSearches users_;
+
+	// The query whose context lines are being returned, if any.
+	PyQueryPtr pContextQuery_;
+
+	// The total number of entries in the range of every segment search.
+	int totalEntries_;
+
+	// The number of entries searched by the searches that have been released.
+	int numEntriesReleased_;
+
+	// This is pushed by the searches whenever they make progress.
+	SimpleSemaphore progress_;
+
+	BgTaskManager taskManager_;
+};
+
+#endif // PY_MULTI_QUERY_HPP
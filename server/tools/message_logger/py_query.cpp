@@ -303,13 +303,15 @@ PyObject * PyQuery::py_setTimeout( PyObject *args )
  * @param pBWLog 			The log object.
  * @param pParams			The query parameters.
  * @param pUserLogReader	The log reader.
+ * @param useIndex			Whether to skip entries using the segment indexes.
  */
 PyQuery::PyQuery( PyBWLogPtr pBWLog, QueryParamsPtr pParams,
-		UserLogReaderPtr pUserLogReader ) :
+		UserLogReaderPtr pUserLogReader, bool useIndex ) :
 	PyObjectPlus( &s_type_ ),
 	pParams_( pParams ),
 	pRange_( new QueryRange( pParams_, pUserLogReader ),
 				QueryRangePtr::NEW_REFERENCE ),
+	indexFilter_( pParams_, pBWLog->getBWLogReader() ),
 	pBWLog_( pBWLog ),
 	pUserLogReader_( pUserLogReader ),
 	pContextResult_( NULL ),
@@ -320,7 +322,13 @@ PyQuery::PyQuery( PyBWLogPtr pBWLog, QueryParamsPtr pParams,
 	pCallback_( NULL ),
 	timeout_( 0 ),
 	timeoutGranularity_( 0 )
-{ }
+{
+	// Only read the entries whose format string and priority can match
+	if (useIndex && indexFilter_.isFiltering())
+	{
+		pRange_->setIndexFilter( &indexFilter_ );
+	}
+}
 
 
 /**
@@ -369,23 +377,7 @@ PyQueryResult * PyQuery::getResultForEntry( const LogEntry &entry, bool filter )
 	// Filter
 	if (filter)
 	{
-		if (!pParams_->validateAddress( pComponent->getAddress().ip ))
-		{
-			return NULL;
-		}
-
-		if (!pParams_->validatePID( pComponent->msg_.pid_ ))
-		{
-			return NULL;
-		}
-
-		if (pComponent->appid_ &&
-			!pParams_->validateAppID( pComponent->appid_ ))
-		{
-			return NULL;
-		}
-
-		if (!pParams_->validateProcessType( pComponent->typeid_ ))
+		if (!pParams_->validateComponent( *pComponent ))
 		{
 			return NULL;
 		}
@@ -535,6 +527,63 @@ PyObject * PyQuery::next()
 }
 
 
+/**
+ * This method returns the result for the given entry as next() would if it
+ * were the next entry of the query to match, and the following calls to
+ * next() return its context lines. This lets the entries that may match be
+ * found some other way, such as in a background thread.
+ *
+ * @returns The result, Py_None if the entry doesn't match the query, or NULL
+ *			on error.
+ */
+PyObject * PyQuery::nextAt( int segmentNum, int entryNum )
+{
+	LogEntry entry;
+
+	if (!pRange_->seek( segmentNum, entryNum, 0 ) ||
+		!pRange_->getNextEntry( entry ))
+	{
+		PyErr_Format( PyExc_LookupError,
+			"Couldn't fetch entry (%d,%d) of query %s",
+			segmentNum, entryNum, pRange_->asString().c_str() );
+		return NULL;
+	}
+
+	PyQueryResult *pResult = this->getResultForEntry( entry, true );
+
+	// As in next(), entries that can't be read are skipped along with those
+	// that are filtered out.
+	if (pResult == NULL)
+	{
+		PyErr_Clear();
+		Py_RETURN_NONE;
+	}
+
+	int numLinesOfContext = pParams_->getNumLinesOfContext();
+
+	if (numLinesOfContext != 0)
+	{
+		PyObject *pContextLine =
+			this->updateContextLines( pResult, numLinesOfContext );
+
+		if ((pContextLine == NULL) &&
+			PyErr_ExceptionMatches( PyExc_StopIteration ))
+		{
+			PyErr_Clear();
+			pContextResult_ = NULL;
+			Py_RETURN_NONE;
+		}
+
+		return pContextLine;
+	}
+
+	mark_ = pRange_->iter_curr();
+	--mark_;
+
+	return pResult;
+}
+
+
 /**
  * This method is used by next() to update the current Query context.
  */
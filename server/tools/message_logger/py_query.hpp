@@ -21,6 +21,7 @@ typedef SmartPointer< PyQuery > PyQueryPtr;
 #include "log_string_interpolator.hpp"
 #include "py_bwlog.hpp"
 #include "py_query_result.hpp"
+#include "query_index_filter.hpp"
 #include "query_range.hpp"
 #include "user_log_reader.hpp"
 
@@ -36,7 +37,7 @@ class PyQuery : public PyObjectPlus
 public:
 	//PyQuery( BWLog *pLog, QueryParams *pParams, UserLog *pUserLog );
 	PyQuery( PyBWLogPtr pBWLog, QueryParamsPtr pParams,
-		UserLogReaderPtr pUserLog );
+		UserLogReaderPtr pUserLog, bool useIndex = true );
 
 	/* Python API */
 	PyObject * pyGetAttribute( const char *attr );
@@ -53,6 +54,11 @@ public:
 
 	/* Non-Python API */
 	PyObject * next();
+	PyObject * nextAt( int segmentNum, int entryNum );
+
+	bool isFetchingContext() const { return pContextResult_.hasObject(); }
+
+	QueryRangePtr getQueryRange() const { return pRange_; }
 
 private:
 	// This object should only be deleted by Py_DECREF
@@ -72,6 +78,8 @@ protected:
 	QueryParamsPtr pParams_;
 	QueryRangePtr pRange_;
 
+	QueryIndexFilter indexFilter_;
+
 	PyBWLogPtr pBWLog_;
 
 	UserLogReaderPtr pUserLogReader_;
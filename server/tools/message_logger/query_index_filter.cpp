@@ -0,0 +1,90 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "query_index_filter.hpp"
+
+#include "bwlog_reader.hpp"
+#include "log_string_interpolator.hpp"
+
+
+/**
+ *	Constructor.
+ *
+ *	@param pParams		The parameters of the query.
+ *	@param pLogReader	The log that is being queried.
+ */
+QueryIndexFilter::QueryIndexFilter( QueryParamsPtr pParams,
+		BWLogReader *pLogReader ) :
+	pParams_( pParams ),
+	pLogReader_( pLogReader ),
+	candidateStrings_()
+{ }
+
+
+/**
+ *	This method returns true if the query rules out any entries based on their
+ *	format string or priority.
+ */
+bool QueryIndexFilter::isFiltering() const
+{
+	return this->isFilteringStrings() || this->isFilteringPriorities();
+}
+
+
+bool QueryIndexFilter::isFilteringStrings() const
+{
+	return pParams_->isFilteringFormatStrings();
+}
+
+
+bool QueryIndexFilter::isFilteringPriorities() const
+{
+	return pParams_->isFilteringMessagePriorities();
+}
+
+
+/**
+ *	This method returns false if no entry using the format string at the given
+ *	offset can match the query.
+ */
+bool QueryIndexFilter::isCandidateString( uint32 stringOffset )
+{
+	CandidateStrings::iterator iter = candidateStrings_.find( stringOffset );
+
+	if (iter != candidateStrings_.end())
+	{
+		return iter->second;
+	}
+
+	const LogStringInterpolator *pHandler =
+		pLogReader_->getHandlerForStringOffset( stringOffset );
+
+	// Entries with an unknown format string are left for the query to report.
+	bool isCandidate = (pHandler == NULL) ||
+		pParams_->validateFormatString( *pHandler );
+
+	// Unknown format strings may be loaded when the strings file is next
+	// refreshed, so they are not remembered.
+	if (pHandler != NULL)
+	{
+		candidateStrings_[ stringOffset ] = isCandidate;
+	}
+
+	return isCandidate;
+}
+
+
+bool QueryIndexFilter::isCandidatePriority( int priority )
+{
+	return pParams_->validateMessagePriority( priority );
+}
+
+// query_index_filter.cpp
@@ -0,0 +1,50 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef QUERY_INDEX_FILTER_HPP
+#define QUERY_INDEX_FILTER_HPP
+
+#include "query_params.hpp"
+#include "user_segment_index.hpp"
+
+#include <map>
+
+class BWLogReader;
+
+/**
+ * This class decides which format strings and priorities can appear in the
+ * results of a query, so that the query only needs to read the entries that
+ * use them.
+ */
+class QueryIndexFilter : public UserSegmentIndexFilter
+{
+public:
+	QueryIndexFilter( QueryParamsPtr pParams, BWLogReader *pLogReader );
+
+	bool isFiltering() const;
+
+	// UserSegmentIndexFilter interface
+	virtual bool isFilteringStrings() const;
+	virtual bool isFilteringPriorities() const;
+
+	virtual bool isCandidateString( uint32 stringOffset );
+	virtual bool isCandidatePriority( int priority );
+
+private:
+	QueryParamsPtr pParams_;
+	BWLogReader *pLogReader_;
+
+	// Whether each format string seen so far can match the query
+	typedef std::map< uint32, bool > CandidateStrings;
+	CandidateStrings candidateStrings_;
+};
+
+#endif // QUERY_INDEX_FILTER_HPP
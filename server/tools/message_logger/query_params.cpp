@@ -15,6 +15,10 @@ criminal penalties as provided by law.
 #include "bwlog_reader.hpp"
 #include "user_log_reader.hpp"
 #include "log_entry.hpp"
+#include "log_string_interpolator.hpp"
+#include "logging_component.hpp"
+
+#include "cstdmf/memory_stream.hpp"
 
 #include <sys/types.h>
 #include <regex.h>
@@ -486,6 +490,31 @@ bool QueryParams::validateProcessType( int procType ) const
 }
 
 
+/**
+ * Returns false if the entries logged by the given component are ruled out by
+ * the host, pid, appid or process type of the query.
+ */
+bool QueryParams::validateComponent( const LoggingComponent &component ) const
+{
+	if (!this->validateAddress( component.getAddress().ip ))
+	{
+		return false;
+	}
+
+	if (!this->validatePID( component.msg_.pid_ ))
+	{
+		return false;
+	}
+
+	if (component.appid_ && !this->validateAppID( component.appid_ ))
+	{
+		return false;
+	}
+
+	return this->validateProcessType( component.typeid_ );
+}
+
+
 bool QueryParams::validateMessagePriority( int priority ) const
 {
 	if (severities_ == -1)
@@ -511,3 +540,54 @@ bool QueryParams::validateExcludeRegex( const char *searchStr ) const
 
 	return (regexec( pExclude_, searchStr, 0, NULL, 0 ) != 0);
 }
+
+
+/**
+ * Returns true if the include or exclude regexes may rule out every entry of
+ * some format strings.
+ */
+bool QueryParams::isFilteringFormatStrings() const
+{
+	return (pInclude_ != NULL) || (pExclude_ != NULL);
+}
+
+
+bool QueryParams::isFilteringMessagePriorities() const
+{
+	return (severities_ != -1);
+}
+
+
+/**
+ * Returns false if no entry using the given format string can pass the
+ * include and exclude regexes. This is only known when the regexes are
+ * matched against the format string itself, or when the format string has no
+ * arguments, since the text of the other entries depends on their arguments.
+ */
+bool QueryParams::validateFormatString(
+	const LogStringInterpolator &handler ) const
+{
+	std::string matchText = handler.fmt();
+
+	if (this->isPreInterpolate())
+	{
+		if (handler.hasArgs())
+		{
+			return true;
+		}
+
+		MemoryIStream noArgs( matchText.data(), 0 );
+		std::string interpolated;
+
+		if (!const_cast< LogStringInterpolator & >( handler ).streamToString(
+				noArgs, interpolated ))
+		{
+			return true;
+		}
+
+		matchText = interpolated;
+	}
+
+	return this->validateIncludeRegex( matchText.c_str() ) &&
+		this->validateExcludeRegex( matchText.c_str() );
+}
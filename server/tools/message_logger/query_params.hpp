@@ -31,6 +31,8 @@ typedef SmartPointer< QueryParams > QueryParamsPtr;
 
 
 class BWLogReader;
+class LogStringInterpolator;
+class LoggingComponent;
 
 /**
  * This class represents a set of parameters to be used when querying logs.
@@ -68,6 +70,12 @@ public:
 	bool validateMessagePriority( int priority ) const;
 	bool validateIncludeRegex( const char *searchStr ) const;
 	bool validateExcludeRegex( const char *searchStr ) const;
+	bool validateComponent( const LoggingComponent &component ) const;
+
+	// These methods are used to rule out entries using a segment's index
+	bool isFilteringFormatStrings() const;
+	bool isFilteringMessagePriorities() const;
+	bool validateFormatString( const LogStringInterpolator &handler ) const;
 
 
 private:
@@ -27,7 +27,11 @@ QueryRange::QueryRange( QueryParamsPtr pParams, UserLogReaderPtr pUserLog ) :
 	begin_( this ),
 	curr_(  this ),
 	end_(   this ),
-	args_(  this )
+	args_(  this ),
+	pIndexFilter_( NULL ),
+	candidates_(),
+	candidatesSuffix_(),
+	candidatesNumEntries_( 0 )
 {
 	// Find the start point for the query
 	begin_ = curr_ = this->findSentinel( direction_ );
@@ -213,10 +217,32 @@ int QueryRange::getUserLogNumSegments() const
 }
 
 
+/**
+ * Sets the filter used to skip over the entries that can't match the query,
+ * using the index of each segment. Only the entries that the filter accepts
+ * are returned by getNextEntry().
+ */
+void QueryRange::setIndexFilter( UserSegmentIndexFilter *pFilter )
+{
+	pIndexFilter_ = pFilter;
+	candidatesSuffix_.clear();
+	candidatesNumEntries_ = 0;
+}
+
+
 bool QueryRange::getNextEntry( LogEntry &entry )
 {
-	if (!begin_.isGood() || !end_.isGood() ||
-		!curr_.isGood()  || !(curr_ <= end_))
+	if (!begin_.isGood() || !end_.isGood())
+	{
+		return false;
+	}
+
+	if (pIndexFilter_ != NULL)
+	{
+		this->skipToCandidate();
+	}
+
+	if (!curr_.isGood() || !(curr_ <= end_))
 	{
 		return false;
 	}
@@ -239,26 +265,91 @@ bool QueryRange::getNextEntry( LogEntry &entry )
 
 
 /**
- *  Returns a FileStream positioned at the args blob corresponding to the most
- *  recent entry fetched by getNextEntry().
+ * Moves the curr_ iterator to the next entry that the index filter has not
+ * ruled out. If there are none left in the range, curr_ is moved past the end
+ * of the range. Entries that have been written since the segment was indexed
+ * are never skipped.
  */
-BinaryIStream* QueryRange::getArgStream()
+void QueryRange::skipToCandidate()
 {
-	const UserSegmentReader *pSegment = args_.getSegment();
+	while (curr_.isGood() && (curr_.getMetaOffset() == 0) && (curr_ <= end_))
+	{
+		const UserSegmentReader *pSegment = curr_.getSegment();
+		const EntryBitmap &candidates = this->getCandidates( pSegment );
 
-	FileStream *pFileStream =
-		const_cast< UserSegmentReader *>( pSegment )->getArgStream();
+		int entryNum = curr_.getEntryNumber();
+		int nextNum = candidates.findCandidate( entryNum, direction_ );
 
-	if (pFileStream)
-	{
-		pFileStream->seek( args_.getArgsOffset() );
-		if (!pFileStream->good())
+		if (nextNum == entryNum)
 		{
-			pFileStream = NULL;
+			return;
+		}
+
+		bool isCandidate = (nextNum != -1) &&
+			(nextNum < pSegment->getNumEntries());
+
+		if (!isCandidate)
+		{
+			// Step off the last entry of the segment in this direction.
+			nextNum = (direction_ == QUERY_FORWARDS) ?
+				pSegment->getNumEntries() - 1 : 0;
+		}
+
+		iterator next( this, curr_.getSegmentNumber(), nextNum );
+
+		if (end_ < next)
+		{
+			curr_ = end_;
+			this->step_forward();
+			return;
 		}
+
+		curr_ = next;
+
+		if (isCandidate)
+		{
+			return;
+		}
+
+		this->step_forward();
+	}
+}
+
+
+/**
+ * Returns the entries of the given segment that the index filter accepts. The
+ * result is kept until the query moves to another segment, or the segment
+ * grows.
+ */
+const EntryBitmap & QueryRange::getCandidates(
+	const UserSegmentReader *pSegment )
+{
+	if ((candidatesSuffix_ != pSegment->getSuffix()) ||
+		(candidatesNumEntries_ != pSegment->getNumEntries()))
+	{
+		const UserSegmentIndex &index =
+			const_cast< UserSegmentReader * >( pSegment )->updateIndex();
+
+		index.select( *pIndexFilter_, candidates_ );
+
+		candidatesSuffix_ = pSegment->getSuffix();
+		candidatesNumEntries_ = pSegment->getNumEntries();
 	}
 
-	return pFileStream;
+	return candidates_;
+}
+
+
+/**
+ *  Returns a stream positioned at the args blob corresponding to the most
+ *  recent entry fetched by getNextEntry().
+ */
+BinaryIStream* QueryRange::getArgStream()
+{
+	const UserSegmentReader *pSegment = args_.getSegment();
+
+	return const_cast< UserSegmentReader *>( pSegment )->getArgStream(
+		args_.getArgsOffset() );
 }
 
 
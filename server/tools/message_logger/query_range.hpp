@@ -22,8 +22,11 @@ typedef SmartPointer< QueryRange > QueryRangePtr;
 #include "query_params.hpp"
 #include "query_range_iterator.hpp"
 #include "user_log_reader.hpp"
+#include "user_segment_index.hpp"
 #include "log_entry.hpp"
 
+#include <string>
+
 /**
  * An iterator over a specified range of a user's log.
  */
@@ -37,6 +40,8 @@ public:
 
 	const SearchDirection & getDirection() const { return direction_; }
 
+	void setIndexFilter( UserSegmentIndexFilter *pFilter );
+
 	bool getNextEntry( LogEntry &entry );
 
 	BinaryIStream* getArgStream();
@@ -72,6 +77,9 @@ private:
 	int findEntryInSegment( const UserSegmentReader *userSegment,
 			int segmentIndexNum, SearchDirection direction );
 
+	void skipToCandidate();
+	const EntryBitmap & getCandidates( const UserSegmentReader *pSegment );
+
 	UserLogReaderPtr pUserLog_;
 
 	LogTime startTime_;
@@ -86,6 +94,14 @@ private:
 	iterator curr_;
 	iterator end_;
 	iterator args_;
+
+	// If set, this is used to skip the entries that can't match the query
+	UserSegmentIndexFilter *pIndexFilter_;
+
+	// The entries of the current segment that may match the query
+	EntryBitmap candidates_;
+	std::string candidatesSuffix_;
+	int candidatesNumEntries_;
 };
 
 #endif // QUERY_RANGE_HPP
@@ -0,0 +1,355 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "segment_search.hpp"
+
+#include "log_entry.hpp"
+#include "logging_component.hpp"
+#include "user_components.hpp"
+#include "user_segment_reader.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+namespace // anonymous
+{
+
+// The number of hits that a search keeps before pausing. It is resumed once
+// the main thread has taken half of them.
+const size_t MAX_HITS = 4096;
+
+// The number of entries read between each report of a search's progress.
+const int ENTRIES_PER_BATCH = 16384;
+
+
+/**
+ *	This class collects the IDs of the components that a query rules out.
+ */
+class RejectedComponentCollector : public UserComponentVisitor
+{
+public:
+	RejectedComponentCollector( const QueryParams &params,
+			std::set< int > &rejectedIDs ) :
+		params_( params ),
+		rejectedIDs_( rejectedIDs )
+	{ }
+
+	virtual bool onComponent( const LoggingComponent &component )
+	{
+		if (!params_.validateComponent( component ))
+		{
+			rejectedIDs_.insert( component.getAppTypeID() );
+		}
+
+		return true;
+	}
+
+private:
+	const QueryParams &params_;
+	std::set< int > &rejectedIDs_;
+};
+
+} // namespace (anonymous)
+
+
+/**
+ *	Constructor.
+ *
+ *	@param pParams		The parameters of the query.
+ *	@param pUserLog		The log of the user being searched.
+ *	@param segmentNum	The segment of the user's log to search.
+ *	@param firstEntry	The first entry to search, in the direction of the
+ *						query.
+ *	@param lastEntry	The last entry to search.
+ *	@param progress		This is pushed whenever the search has made progress.
+ */
+SegmentSearch::SegmentSearch( QueryParamsPtr pParams, UserLogReaderPtr pUserLog,
+		int segmentNum, int firstEntry, int lastEntry,
+		SimpleSemaphore &progress ) :
+	pParams_( pParams ),
+	pUserLog_( pUserLog ),
+	segmentNum_( segmentNum ),
+	firstEntry_( firstEntry ),
+	lastEntry_( lastEntry ),
+	direction_( pParams->getDirection() ),
+	progress_( progress ),
+	entriesFile_(),
+	candidates_(),
+	rejectedComponents_(),
+	nextEntry_( firstEntry ),
+	mutex_(),
+	hits_(),
+	searchedTime_(),
+	numEntriesSearched_( 0 ),
+	isRunning_( false ),
+	isFinished_( false ),
+	isStopping_( false )
+{
+	// No entry of the segment is before its start, or after its end.
+	const UserSegmentReader *pSegment = pUserLog_->getUserSegment( segmentNum );
+
+	searchedTime_ = (direction_ == QUERY_FORWARDS) ?
+		pSegment->getStartLogTime() : pSegment->getEndLogTime();
+}
+
+
+/**
+ *	This method returns the number of entries in the range being searched.
+ */
+int SegmentSearch::getTotalEntries() const
+{
+	return abs( lastEntry_ - firstEntry_ ) + 1;
+}
+
+
+/**
+ *	This method starts the search in a background thread.
+ *
+ *	@param mgr			The manager of the threads to search in.
+ *	@param pIndexFilter	If not NULL, this is used with the segment's index to
+ *						skip the entries that can't match.
+ */
+void SegmentSearch::start( BgTaskManager &mgr,
+	UserSegmentIndexFilter *pIndexFilter )
+{
+	const UserSegmentReader *pSegment = pUserLog_->getUserSegment( segmentNum_ );
+	char buf[ 1024 ];
+
+	// The index is read here, since FileStreams and the filter can only be
+	// used from the main thread. Entries that have been written since the
+	// segment was last indexed are all searched.
+	if (pIndexFilter != NULL)
+	{
+		bw_snprintf( buf, sizeof( buf ), "%s/index.%s",
+			pSegment->getUserLogPath().c_str(), pSegment->getSuffix().c_str() );
+
+		UserSegmentIndex index;
+
+		// An index covering more entries than the segment has is not for
+		// this segment.
+		if (index.read( buf, pSegment->getStartLogTime() ) &&
+			(index.getNumEntries() <= pSegment->getNumEntries()))
+		{
+			index.select( *pIndexFilter, candidates_ );
+		}
+	}
+
+	bw_snprintf( buf, sizeof( buf ), "%s/entries.%s",
+		pSegment->getUserLogPath().c_str(), pSegment->getSuffix().c_str() );
+
+	entriesFile_.init( buf );
+
+	// The components are looked up here rather than by the background
+	// thread, since the main thread may reload them while the search runs.
+	rejectedComponents_.clear();
+
+	RejectedComponentCollector collector( *pParams_, rejectedComponents_ );
+	pUserLog_->getUserComponents( collector );
+
+	isRunning_ = true;
+	mgr.addBackgroundTask( this );
+}
+
+
+/**
+ *	This method asks the search to stop after its current batch of entries.
+ */
+void SegmentSearch::stop()
+{
+	SimpleMutexHolder smh( mutex_ );
+	isStopping_ = true;
+}
+
+
+/**
+ *	This method returns the next hit of the search, if one has been found.
+ *
+ *	@param hit			Set to the next hit, if the result is HAS_HIT.
+ *	@param searchedTime	Set to the time of the last entry searched, if the
+ *						result is SEARCHING.
+ */
+SegmentSearch::Status SegmentSearch::peekHit( SearchHit &hit,
+	LogTime &searchedTime )
+{
+	SimpleMutexHolder smh( mutex_ );
+
+	if (!hits_.empty())
+	{
+		hit = hits_.front();
+		return HAS_HIT;
+	}
+
+	if (isFinished_)
+	{
+		return FINISHED;
+	}
+
+	searchedTime = searchedTime_;
+	return SEARCHING;
+}
+
+
+/**
+ *	This method removes the hit returned by peekHit(), and resumes the search
+ *	if it was waiting for hits to be taken.
+ */
+void SegmentSearch::popHit( BgTaskManager &mgr )
+{
+	SimpleMutexHolder smh( mutex_ );
+
+	MF_ASSERT( !hits_.empty() );
+	hits_.pop_front();
+
+	if (!isRunning_ && !isFinished_ && !isStopping_ &&
+		(hits_.size() <= MAX_HITS / 2))
+	{
+		isRunning_ = true;
+		mgr.addBackgroundTask( this );
+	}
+}
+
+
+/**
+ *	This method returns the number of entries that have been searched so far.
+ */
+int SegmentSearch::getNumEntriesSearched()
+{
+	SimpleMutexHolder smh( mutex_ );
+	return numEntriesSearched_;
+}
+
+
+/**
+ *	This method searches the segment in a background thread, one batch of
+ *	entries at a time, until it reaches the end of the range or has enough
+ *	hits waiting.
+ */
+void SegmentSearch::doBackgroundTask( BgTaskManager &mgr )
+{
+	bool shouldContinue = true;
+
+	while (shouldContinue)
+	{
+		Hits newHits;
+		LogEntry entry;
+		LogTime lastTime;
+		bool hasReadEntry = false;
+		bool isAtEnd = false;
+
+		for (int numRead = 0; numRead < ENTRIES_PER_BATCH; )
+		{
+			if (!this->isInRange( nextEntry_ ))
+			{
+				isAtEnd = true;
+				break;
+			}
+
+			// Skip to the next entry that the index has not ruled out.
+			int nextNum = candidates_.findCandidate( nextEntry_, direction_ );
+
+			if (nextNum != nextEntry_)
+			{
+				nextEntry_ = nextNum;
+				continue;
+			}
+
+			long offset = long( nextEntry_ ) * sizeof( LogEntry );
+
+			entriesFile_.willRead( offset, direction_ );
+
+			const char *pData = entriesFile_.data( offset, sizeof( LogEntry ) );
+
+			if (pData == NULL)
+			{
+				ERROR_MSG( "SegmentSearch::doBackgroundTask: "
+					"Couldn't read entry %d of segment %d\n",
+					nextEntry_, segmentNum_ );
+				isAtEnd = true;
+				break;
+			}
+
+			memcpy( &entry, pData, sizeof( LogEntry ) );
+
+			if (this->isCandidate( entry ))
+			{
+				SearchHit hit;
+				hit.time_ = entry.time_;
+				hit.entryNum_ = nextEntry_;
+
+				newHits.push_back( hit );
+			}
+
+			lastTime = entry.time_;
+			hasReadEntry = true;
+
+			nextEntry_ += direction_;
+			++numRead;
+		}
+
+		{
+			SimpleMutexHolder smh( mutex_ );
+
+			hits_.insert( hits_.end(), newHits.begin(), newHits.end() );
+
+			if (hasReadEntry)
+			{
+				searchedTime_ = lastTime;
+			}
+
+			numEntriesSearched_ = isAtEnd ? this->getTotalEntries() :
+				abs( nextEntry_ - firstEntry_ );
+
+			isFinished_ = isAtEnd;
+
+			shouldContinue = !isAtEnd && !isStopping_ &&
+				(hits_.size() < MAX_HITS);
+
+			// Once this is cleared, popHit() may add this task again.
+			isRunning_ = shouldContinue;
+		}
+
+		progress_.push();
+	}
+}
+
+
+/**
+ *	This method returns false if the given entry can't match the query.
+ */
+bool SegmentSearch::isCandidate( const LogEntry &entry ) const
+{
+	if (!pParams_->validateMessagePriority( entry.messagePriority_ ))
+	{
+		return false;
+	}
+
+	// Entries from components that were unknown when the search started are
+	// left for the main thread to check.
+	return (rejectedComponents_.find( entry.componentID_ ) ==
+		rejectedComponents_.end());
+}
+
+
+/**
+ *	This method returns whether the given entry is in the range being searched.
+ */
+bool SegmentSearch::isInRange( int entryNum ) const
+{
+	if (direction_ == QUERY_FORWARDS)
+	{
+		return (firstEntry_ <= entryNum) && (entryNum <= lastEntry_);
+	}
+
+	return (lastEntry_ <= entryNum) && (entryNum <= firstEntry_);
+}
+
+// segment_search.cpp
@@ -0,0 +1,124 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef SEGMENT_SEARCH_HPP
+#define SEGMENT_SEARCH_HPP
+
+#include "constants.hpp"
+#include "log_time.hpp"
+#include "mapped_file.hpp"
+#include "query_params.hpp"
+#include "user_log_reader.hpp"
+#include "user_segment_index.hpp"
+
+#include "cstdmf/bgtask_manager.hpp"
+#include "cstdmf/concurrency.hpp"
+
+#include <deque>
+#include <set>
+
+class LogEntry;
+class UserSegmentReader;
+
+class SegmentSearch;
+typedef SmartPointer< SegmentSearch > SegmentSearchPtr;
+
+
+/**
+ * An entry found by a SegmentSearch that may match its query.
+ */
+struct SearchHit
+{
+	LogTime time_;
+	int entryNum_;
+};
+
+
+/**
+ * A search of one segment of a user's log that is run in a background thread.
+ * The entries of the segment are read in the direction of the query, and
+ * those that may match it are kept until the main thread takes them. Once
+ * enough are waiting, the search pauses until the main thread has taken some.
+ *
+ * Only the main thread can interpolate messages, so the search rules out
+ * entries by their priority, component and, using the segment's index, their
+ * format string. The main thread decides whether each of the others matches.
+ * The user's components may be reloaded by the main thread at any time, so
+ * the components that the query rules out are collected when the search
+ * starts.
+ */
+class SegmentSearch : public BackgroundTask
+{
+public:
+	enum Status
+	{
+		HAS_HIT,
+		SEARCHING,
+		FINISHED
+	};
+
+	SegmentSearch( QueryParamsPtr pParams, UserLogReaderPtr pUserLog,
+		int segmentNum, int firstEntry, int lastEntry,
+		SimpleSemaphore &progress );
+
+	int getSegmentNumber() const { return segmentNum_; }
+	int getTotalEntries() const;
+
+	// These methods are called from the main thread
+	void start( BgTaskManager &mgr, UserSegmentIndexFilter *pIndexFilter );
+	void stop();
+
+	Status peekHit( SearchHit &hit, LogTime &searchedTime );
+	void popHit( BgTaskManager &mgr );
+
+	int getNumEntriesSearched();
+
+protected:
+	virtual void doBackgroundTask( BgTaskManager &mgr );
+
+private:
+	bool isCandidate( const LogEntry &entry ) const;
+	bool isInRange( int entryNum ) const;
+
+	QueryParamsPtr pParams_;
+	UserLogReaderPtr pUserLog_;
+
+	int segmentNum_;
+	int firstEntry_;
+	int lastEntry_;
+	SearchDirection direction_;
+
+	SimpleSemaphore &progress_;
+
+	// These are only used by the background thread once the search starts.
+	MappedFile entriesFile_;
+	EntryBitmap candidates_;
+	std::set< int > rejectedComponents_;
+	int nextEntry_;
+
+	// These are shared with the main thread and guarded by mutex_.
+	SimpleMutex mutex_;
+
+	typedef std::deque< SearchHit > Hits;
+	Hits hits_;
+
+	// The time of the last entry read. No later hit can be before this in the
+	// direction of the query.
+	LogTime searchedTime_;
+
+	int numEntriesSearched_;
+
+	bool isRunning_;
+	bool isFinished_;
+	bool isStopping_;
+};
+
+#endif // SEGMENT_SEARCH_HPP
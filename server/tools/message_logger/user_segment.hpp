@@ -49,10 +49,11 @@ public:
 	virtual ~UserSegment();
 
 	const std::string & getSuffix() const { return suffix_; }
+	const std::string & getUserLogPath() const { return userLogPath_; }
 
 	bool isGood() const { return isGood_; }
 
-	bool readEntry( int n, LogEntry &entry );
+	virtual bool readEntry( int n, LogEntry &entry );
 
 	void updateEntryBounds();
 
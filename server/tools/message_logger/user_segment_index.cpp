@@ -0,0 +1,665 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#include "user_segment_index.hpp"
+
+#include "log_entry.hpp"
+
+#include "cstdmf/debug.hpp"
+
+#include "network/file_stream.hpp"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+namespace // anonymous
+{
+
+// The version of the index file format. Index files of any other version are
+// ignored and rebuilt.
+const uint8 INDEX_FORMAT_VERSION = 2;
+
+// Each block of an EntrySet covers 2^16 entries.
+const int BLOCK_SHIFT = 16;
+const int BLOCK_MASK = (1 << BLOCK_SHIFT) - 1;
+const int WORDS_PER_BLOCK = (1 << BLOCK_SHIFT) / 32;
+
+// A block with more offsets than this is stored as a bitmap instead, since
+// the bitmap is then the smaller of the two.
+const uint MAX_OFFSETS_PER_BLOCK = WORDS_PER_BLOCK * 2;
+
+
+/**
+ *	This function returns the FNV-1a hash of the given data. It is stored in
+ *	index files to detect ones that have been truncated or corrupted.
+ */
+uint32 calculateChecksum( const void *pData, int length )
+{
+	const uint8 *pCurr = static_cast< const uint8 * >( pData );
+	const uint8 *pEnd = pCurr + length;
+
+	uint32 hash = 2166136261U;
+
+	while (pCurr != pEnd)
+	{
+		hash ^= *pCurr++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+} // namespace (anonymous)
+
+
+// -----------------------------------------------------------------------------
+// Section: EntryBitmap
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+EntryBitmap::EntryBitmap() :
+	words_(),
+	numEntries_( 0 )
+{ }
+
+
+/**
+ *	This method empties this set and sizes it for the given number of entries.
+ */
+void EntryBitmap::clear( int numEntries )
+{
+	words_.assign( (numEntries + 31) / 32, 0 );
+	numEntries_ = numEntries;
+}
+
+
+/**
+ *	This method removes the entries that are not also in the other set.
+ */
+void EntryBitmap::intersect( const EntryBitmap &other )
+{
+	for (size_t i = 0; i < words_.size(); ++i)
+	{
+		words_[i] &= (i < other.words_.size()) ? other.words_[i] : 0;
+	}
+}
+
+
+/**
+ *	This method returns the first entry in the set at or after n in the given
+ *	direction, or -1 if there is none.
+ */
+int EntryBitmap::findNext( int n, SearchDirection direction ) const
+{
+	if ((n < 0) || (n >= numEntries_))
+	{
+		return -1;
+	}
+
+	int word = n >> 5;
+	int bit = n & 31;
+
+	if (direction == QUERY_FORWARDS)
+	{
+		uint32 bits = words_[ word ] & (0xffffffffU << bit);
+
+		while (bits == 0)
+		{
+			if (++word >= int( words_.size() ))
+			{
+				return -1;
+			}
+
+			bits = words_[ word ];
+		}
+
+		bit = 0;
+		while (!(bits & (1U << bit)))
+		{
+			++bit;
+		}
+	}
+	else
+	{
+		uint32 bits = words_[ word ] &
+			((bit == 31) ? 0xffffffffU : ((1U << (bit + 1)) - 1));
+
+		while (bits == 0)
+		{
+			if (--word < 0)
+			{
+				return -1;
+			}
+
+			bits = words_[ word ];
+		}
+
+		bit = 31;
+		while (!(bits & (1U << bit)))
+		{
+			--bit;
+		}
+	}
+
+	int result = (word << 5) + bit;
+
+	return (result < numEntries_) ? result : -1;
+}
+
+
+/**
+ *	This method returns the first entry at or after n in the given direction
+ *	that the index has not ruled out. Entries beyond the end of this set have
+ *	not been indexed, so they are never ruled out. The result is -1 if there
+ *	is no such entry going backwards.
+ */
+int EntryBitmap::findCandidate( int n, SearchDirection direction ) const
+{
+	if ((n < 0) || (n >= numEntries_))
+	{
+		return n;
+	}
+
+	int nextNum = this->findNext( n, direction );
+
+	if ((nextNum == -1) && (direction == QUERY_FORWARDS))
+	{
+		return numEntries_;
+	}
+
+	return nextNum;
+}
+
+
+// -----------------------------------------------------------------------------
+// Section: EntrySet
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+EntrySet::EntrySet() :
+	blocks_(),
+	size_( 0 )
+{ }
+
+
+/**
+ *	This method adds an entry to this set. Entries must be added in increasing
+ *	order.
+ */
+void EntrySet::add( int n )
+{
+	uint32 key = uint32( n ) >> BLOCK_SHIFT;
+	uint16 offset = uint16( n & BLOCK_MASK );
+
+	if (blocks_.empty() || (blocks_.back().key_ != key))
+	{
+		blocks_.push_back( Block() );
+		blocks_.back().key_ = key;
+	}
+
+	Block &block = blocks_.back();
+
+	if (block.bits_.empty())
+	{
+		block.offsets_.push_back( offset );
+
+		if (block.offsets_.size() > MAX_OFFSETS_PER_BLOCK)
+		{
+			block.bits_.resize( WORDS_PER_BLOCK, 0 );
+
+			for (size_t i = 0; i < block.offsets_.size(); ++i)
+			{
+				uint16 off = block.offsets_[i];
+				block.bits_[ off >> 5 ] |= (1U << (off & 31));
+			}
+
+			std::vector< uint16 >().swap( block.offsets_ );
+		}
+	}
+	else
+	{
+		block.bits_[ offset >> 5 ] |= (1U << (offset & 31));
+	}
+
+	++size_;
+}
+
+
+/**
+ *	This method adds the entries of this set to the given bitmap. Entries
+ *	beyond the size of the bitmap are ignored.
+ */
+void EntrySet::addTo( EntryBitmap &bitmap ) const
+{
+	for (Blocks::const_iterator iter = blocks_.begin();
+			iter != blocks_.end(); ++iter)
+	{
+		const Block &block = *iter;
+		int base = int( block.key_ << BLOCK_SHIFT );
+
+		if (block.bits_.empty())
+		{
+			for (size_t i = 0; i < block.offsets_.size(); ++i)
+			{
+				int n = base + block.offsets_[i];
+
+				if (n < bitmap.size())
+				{
+					bitmap.set( n );
+				}
+			}
+		}
+		else
+		{
+			size_t firstWord = base >> 5;
+
+			for (size_t i = 0; (i < block.bits_.size()) &&
+					(firstWord + i < bitmap.words_.size()); ++i)
+			{
+				bitmap.words_[ firstWord + i ] |= block.bits_[i];
+			}
+		}
+	}
+}
+
+
+/**
+ *	This method writes this set to the given stream.
+ */
+void EntrySet::write( BinaryOStream &stream ) const
+{
+	stream << int32( size_ ) << uint32( blocks_.size() );
+
+	for (Blocks::const_iterator iter = blocks_.begin();
+			iter != blocks_.end(); ++iter)
+	{
+		const Block &block = *iter;
+		bool isBitmap = !block.bits_.empty();
+
+		stream << block.key_ << isBitmap;
+
+		if (isBitmap)
+		{
+			stream.addBlob( &block.bits_[0],
+				block.bits_.size() * sizeof( uint32 ) );
+		}
+		else
+		{
+			stream << uint32( block.offsets_.size() );
+			stream.addBlob( &block.offsets_[0],
+				block.offsets_.size() * sizeof( uint16 ) );
+		}
+	}
+}
+
+
+/**
+ *	This method reads this set from the given stream.
+ *
+ *	@returns true on success, false if the stream is corrupt.
+ */
+bool EntrySet::read( BinaryIStream &stream )
+{
+	int32 size;
+	uint32 numBlocks;
+
+	stream >> size >> numBlocks;
+
+	// Entry numbers are ints, so there can be no more blocks than this.
+	const uint32 MAX_BLOCKS = (uint32( INT_MAX ) >> BLOCK_SHIFT) + 1;
+
+	if (stream.error() || (numBlocks > MAX_BLOCKS))
+	{
+		return false;
+	}
+
+	blocks_.clear();
+	blocks_.resize( numBlocks );
+
+	for (Blocks::iterator iter = blocks_.begin(); iter != blocks_.end(); ++iter)
+	{
+		Block &block = *iter;
+		bool isBitmap;
+
+		stream >> block.key_ >> isBitmap;
+
+		if (isBitmap)
+		{
+			int length = WORDS_PER_BLOCK * sizeof( uint32 );
+			const void *pData = stream.retrieve( length );
+
+			if (stream.error())
+			{
+				return false;
+			}
+
+			block.bits_.resize( WORDS_PER_BLOCK );
+			memcpy( &block.bits_[0], pData, length );
+		}
+		else
+		{
+			uint32 numOffsets;
+			stream >> numOffsets;
+
+			if (stream.error() || (numOffsets == 0) ||
+					(numOffsets > MAX_OFFSETS_PER_BLOCK))
+			{
+				return false;
+			}
+
+			int length = numOffsets * sizeof( uint16 );
+			const void *pData = stream.retrieve( length );
+
+			if (stream.error())
+			{
+				return false;
+			}
+
+			block.offsets_.resize( numOffsets );
+			memcpy( &block.offsets_[0], pData, length );
+		}
+	}
+
+	size_ = size;
+
+	return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// Section: UserSegmentIndex
+// -----------------------------------------------------------------------------
+
+/**
+ *	Constructor.
+ */
+UserSegmentIndex::UserSegmentIndex() :
+	stringEntries_(),
+	priorityEntries_(),
+	numEntries_( 0 )
+{ }
+
+
+/**
+ *	This method removes all entries from this index.
+ */
+void UserSegmentIndex::clear()
+{
+	stringEntries_.clear();
+	priorityEntries_.clear();
+	numEntries_ = 0;
+}
+
+
+/**
+ *	This method adds the next entry of the segment to this index.
+ */
+void UserSegmentIndex::addEntry( const LogEntry &entry )
+{
+	stringEntries_[ entry.stringOffset_ ].add( numEntries_ );
+	priorityEntries_[ entry.messagePriority_ ].add( numEntries_ );
+
+	++numEntries_;
+}
+
+
+/**
+ *	This method finds the entries whose format string and priority are both
+ *	accepted by the given filter. The result covers the entries in this index,
+ *	so any entries written to the segment since it was last updated are not
+ *	included.
+ */
+void UserSegmentIndex::select( UserSegmentIndexFilter &filter,
+	EntryBitmap &result ) const
+{
+	result.clear( numEntries_ );
+
+	if (filter.isFilteringStrings())
+	{
+		for (StringEntries::const_iterator iter = stringEntries_.begin();
+				iter != stringEntries_.end(); ++iter)
+		{
+			if (filter.isCandidateString( iter->first ))
+			{
+				iter->second.addTo( result );
+			}
+		}
+	}
+
+	if (filter.isFilteringPriorities())
+	{
+		EntryBitmap priorities;
+		priorities.clear( numEntries_ );
+
+		for (PriorityEntries::const_iterator iter = priorityEntries_.begin();
+				iter != priorityEntries_.end(); ++iter)
+		{
+			if (filter.isCandidatePriority( iter->first ))
+			{
+				iter->second.addTo( priorities );
+			}
+		}
+
+		if (filter.isFilteringStrings())
+		{
+			result.intersect( priorities );
+		}
+		else
+		{
+			result = priorities;
+		}
+	}
+	else if (!filter.isFilteringStrings())
+	{
+		// Nothing is being filtered, so every entry is a candidate.
+		for (PriorityEntries::const_iterator iter = priorityEntries_.begin();
+				iter != priorityEntries_.end(); ++iter)
+		{
+			iter->second.addTo( result );
+		}
+	}
+}
+
+
+/**
+ *	This method reads this index from the given file.
+ *
+ *	@param path			The path of the index file.
+ *	@param startTime	The time of the first entry of the segment. An index
+ *						file for a different segment is ignored.
+ *
+ *	@returns true on success, false if the file does not exist or is not a
+ *			 valid index of the segment.
+ */
+bool UserSegmentIndex::read( const char *path, const LogTime &startTime )
+{
+	this->clear();
+
+	FileStream fs( path, "r" );
+
+	if (!fs.good())
+	{
+		return false;
+	}
+
+	uint8 version;
+	LogTime fileStartTime;
+	uint32 checksum;
+
+	fs >> version;
+
+	if (fs.error() || (version != INDEX_FORMAT_VERSION))
+	{
+		return false;
+	}
+
+	fs >> fileStartTime >> checksum;
+
+	if (fs.error() ||
+		(fileStartTime.secs_ != startTime.secs_) ||
+		(fileStartTime.msecs_ != startTime.msecs_))
+	{
+		return false;
+	}
+
+	// The rest of the file is the body of the index, which must match the
+	// checksum before any of it is used.
+	long bodyLength = fs.length() - fs.tell();
+	const void *pBody = NULL;
+
+	if (!fs.error() && (bodyLength > 0) && (bodyLength <= INT_MAX))
+	{
+		pBody = fs.retrieve( int( bodyLength ) );
+	}
+
+	if ((pBody == NULL) || fs.error() ||
+		(calculateChecksum( pBody, int( bodyLength ) ) != checksum))
+	{
+		WARNING_MSG( "UserSegmentIndex::read: "
+			"Ignoring index file %s with a bad checksum\n", path );
+		return false;
+	}
+
+	MemoryIStream body( pBody, int( bodyLength ) );
+
+	int32 numEntries;
+	uint32 numStrings;
+
+	body >> numEntries >> numStrings;
+
+	bool isOkay = !body.error();
+
+	for (uint32 i = 0; isOkay && (i < numStrings); ++i)
+	{
+		uint32 stringOffset;
+		body >> stringOffset;
+
+		isOkay = !body.error() && stringEntries_[ stringOffset ].read( body );
+	}
+
+	uint32 numPriorities = 0;
+
+	if (isOkay)
+	{
+		body >> numPriorities;
+		isOkay = !body.error();
+	}
+
+	for (uint32 i = 0; isOkay && (i < numPriorities); ++i)
+	{
+		int32 priority;
+		body >> priority;
+
+		isOkay = !body.error() && priorityEntries_[ priority ].read( body );
+	}
+
+	if (!isOkay || (body.remainingLength() != 0))
+	{
+		WARNING_MSG( "UserSegmentIndex::read: "
+			"Ignoring corrupt index file %s\n", path );
+		body.finish();
+		this->clear();
+		return false;
+	}
+
+	numEntries_ = numEntries;
+
+	return true;
+}
+
+
+/**
+ *	This method writes this index to the given file. The index is written to a
+ *	uniquely named temporary file first and then renamed into place, so that
+ *	readers never see a partial index and concurrent writers of the same index
+ *	do not write over each other's files.
+ *
+ *	@returns true on success, false on error.
+ */
+bool UserSegmentIndex::write( const char *path,
+	const LogTime &startTime ) const
+{
+	MemoryOStream body;
+
+	body << int32( numEntries_ ) << uint32( stringEntries_.size() );
+
+	for (StringEntries::const_iterator iter = stringEntries_.begin();
+			iter != stringEntries_.end(); ++iter)
+	{
+		body << iter->first;
+		iter->second.write( body );
+	}
+
+	body << uint32( priorityEntries_.size() );
+
+	for (PriorityEntries::const_iterator iter = priorityEntries_.begin();
+			iter != priorityEntries_.end(); ++iter)
+	{
+		body << int32( iter->first );
+		iter->second.write( body );
+	}
+
+	char tempPath[ 1024 ];
+	bw_snprintf( tempPath, sizeof( tempPath ), "%s.XXXXXX", path );
+
+	int fd = mkstemp( tempPath );
+
+	if (fd == -1)
+	{
+		return false;
+	}
+
+	// mkstemp() creates the file readable only by its owner. Index files are
+	// read by other users of the log, like the rest of its files.
+	fchmod( fd, 0644 );
+	close( fd );
+
+	{
+		FileStream fs( tempPath, "w" );
+
+		if (!fs.good())
+		{
+			unlink( tempPath );
+			return false;
+		}
+
+		const int bodyLength = body.size();
+
+		fs << INDEX_FORMAT_VERSION << startTime
+			<< calculateChecksum( body.data(), bodyLength );
+		fs.addBlob( body.data(), bodyLength );
+
+		if (!fs.commit())
+		{
+			unlink( tempPath );
+			return false;
+		}
+	}
+
+	if (rename( tempPath, path ) != 0)
+	{
+		unlink( tempPath );
+		return false;
+	}
+
+	return true;
+}
+
+// user_segment_index.cpp
@@ -0,0 +1,139 @@
+/******************************************************************************
+BigWorld Technology 
+Copyright BigWorld Pty, Ltd.
+All Rights Reserved. Commercial in confidence.
+
+WARNING: This computer program is protected by copyright law and international
+treaties. Unauthorized use, reproduction or distribution of this program, or
+any portion of this program, may result in the imposition of civil and
+criminal penalties as provided by law.
+******************************************************************************/
+
+#ifndef USER_SEGMENT_INDEX_HPP
+#define USER_SEGMENT_INDEX_HPP
+
+#include "constants.hpp"
+#include "log_time.hpp"
+
+#include "cstdmf/stdmf.hpp"
+
+#include <map>
+#include <vector>
+
+class BinaryIStream;
+class BinaryOStream;
+class LogEntry;
+
+
+/**
+ * A set of entry numbers within a segment, stored as one bit per entry. This
+ * is used to hold the entries that a query needs to look at.
+ */
+class EntryBitmap
+{
+public:
+	EntryBitmap();
+
+	void clear( int numEntries );
+
+	int size() const { return numEntries_; }
+
+	void set( int n ) { words_[ n >> 5 ] |= (1U << (n & 31)); }
+	bool test( int n ) const { return (words_[ n >> 5 ] & (1U << (n & 31))); }
+
+	void intersect( const EntryBitmap &other );
+
+	int findNext( int n, SearchDirection direction ) const;
+	int findCandidate( int n, SearchDirection direction ) const;
+
+private:
+	friend class EntrySet;
+
+	std::vector< uint32 > words_;
+	int numEntries_;
+};
+
+
+/**
+ * A compact set of entry numbers within a segment. Entries are grouped into
+ * blocks of 65536. Sparse blocks are stored as a list of offsets and dense
+ * blocks as a bitmap, so that neither rare nor common format strings take up
+ * much space.
+ */
+class EntrySet
+{
+public:
+	EntrySet();
+
+	void add( int n );
+	void addTo( EntryBitmap &bitmap ) const;
+
+	int size() const { return size_; }
+
+	void write( BinaryOStream &stream ) const;
+	bool read( BinaryIStream &stream );
+
+private:
+	struct Block
+	{
+		uint32 key_;
+		std::vector< uint16 > offsets_;
+		std::vector< uint32 > bits_;
+	};
+
+	typedef std::vector< Block > Blocks;
+	Blocks blocks_;
+
+	int size_;
+};
+
+
+/**
+ * Decides which format strings and priorities a query is interested in. The
+ * index uses this to rule out entries without reading them.
+ */
+class UserSegmentIndexFilter
+{
+public:
+	virtual ~UserSegmentIndexFilter() {}
+
+	virtual bool isFilteringStrings() const = 0;
+	virtual bool isFilteringPriorities() const = 0;
+
+	virtual bool isCandidateString( uint32 stringOffset ) = 0;
+	virtual bool isCandidatePriority( int priority ) = 0;
+};
+
+
+/**
+ * An index of the entries in a segment by format string and by message
+ * priority. It is kept in an 'index' file alongside the entries and args
+ * files of the segment.
+ */
+class UserSegmentIndex
+{
+public:
+	UserSegmentIndex();
+
+	void clear();
+
+	int getNumEntries() const { return numEntries_; }
+
+	void addEntry( const LogEntry &entry );
+
+	void select( UserSegmentIndexFilter &filter, EntryBitmap &result ) const;
+
+	bool read( const char *path, const LogTime &startTime );
+	bool write( const char *path, const LogTime &startTime ) const;
+
+private:
+	typedef std::map< uint32, EntrySet > StringEntries;
+	StringEntries stringEntries_;
+
+	typedef std::map< int, EntrySet > PriorityEntries;
+	PriorityEntries priorityEntries_;
+
+	int numEntries_;
+};
+
+#endif // USER_SEGMENT_INDEX_HPP
@@ -16,11 +16,37 @@ criminal penalties as provided by law.
 #include "py_query_result.hpp"
 
 #include <dirent.h>
+#include <string.h>
+
+
+namespace // anonymous
+{
+
+// The index file is only rewritten once this many entries have been added
+// to the index since it was last read or written, so that queries against an
+// active segment do not rewrite it every time they resume.
+const int MIN_NEW_ENTRIES_TO_WRITE_INDEX = 65536;
+
+// Entries read within this many entries of the previous one, in the same
+// direction, are treated as part of a scan and read ahead of. Queries that
+// use a segment's index skip entries, so this is more than one.
+const int MAX_SCAN_GAP = 256;
+
+} // namespace (anonymous)
 
 
 UserSegmentReader::UserSegmentReader( const std::string userLogPath,
 	const char *suffix ) :
-	UserSegment( userLogPath, suffix )
+	UserSegment( userLogPath, suffix ),
+	entriesFile_(),
+	argsFile_(),
+	argsStream_(),
+	lastEntryNum_( -1 ),
+	scanDirection_( 0 ),
+	index_(),
+	hasReadIndexFile_( false ),
+	canWriteIndexFile_( true ),
+	numEntriesInIndexFile_( 0 )
 { }
 
 
@@ -45,6 +71,8 @@ bool UserSegmentReader::init()
 		return false;
 	}
 
+	entriesFile_.init( buf );
+
 	// Generate args filename
 	bw_snprintf( buf, sizeof( buf ), "%s/args.%s",
 		userLogPath_.c_str(), suffix_.c_str() );
@@ -58,12 +86,93 @@ bool UserSegmentReader::init()
 		return false;
 	}
 
+	argsFile_.init( buf );
+
 	this->updateEntryBounds();
 
 	return true;
 }
 
 
+/**
+ * Retrieves a specific LogEntry from the entries file mapping. Entries that
+ * are read in order, in either direction, are read ahead of.
+ */
+bool UserSegmentReader::readEntry( int n, LogEntry &entry )
+{
+	if (!entriesFile_.isGood())
+	{
+		return UserSegment::readEntry( n, entry );
+	}
+
+	int gap = n - lastEntryNum_;
+
+	if ((lastEntryNum_ != -1) && (0 < gap) && (gap <= MAX_SCAN_GAP))
+	{
+		scanDirection_ = QUERY_FORWARDS;
+	}
+	else if ((lastEntryNum_ != -1) && (0 < -gap) && (-gap <= MAX_SCAN_GAP))
+	{
+		scanDirection_ = QUERY_BACKWARDS;
+	}
+	else
+	{
+		scanDirection_ = 0;
+	}
+
+	lastEntryNum_ = n;
+
+	long offset = long( n ) * sizeof( LogEntry );
+
+	if (scanDirection_ != 0)
+	{
+		entriesFile_.willRead( offset, SearchDirection( scanDirection_ ) );
+	}
+
+	const char *pData = entriesFile_.data( offset, sizeof( LogEntry ) );
+
+	if (pData == NULL)
+	{
+		// Fall back to the FileStream if the file can no longer be mapped.
+		if (!entriesFile_.isGood())
+		{
+			return UserSegment::readEntry( n, entry );
+		}
+
+		ERROR_MSG( "UserSegmentReader::readEntry: "
+			"Entry %d is beyond the end of entries.%s\n",
+			n, suffix_.c_str() );
+		return false;
+	}
+
+	memcpy( &entry, pData, sizeof( LogEntry ) );
+
+	return true;
+}
+
+
+/**
+ * Reads the time of the given entry, which is the first field of a LogEntry.
+ */
+bool UserSegmentReader::readEntryTime( int n, LogTime &time )
+{
+	long offset = long( n ) * sizeof( LogEntry );
+	const char *pData = entriesFile_.isGood() ?
+		entriesFile_.data( offset, sizeof( LogTime ) ) : NULL;
+
+	if (pData != NULL)
+	{
+		memcpy( &time, pData, sizeof( LogTime ) );
+		return true;
+	}
+
+	pEntries_->seek( offset );
+	*pEntries_ >> time;
+
+	return !pEntries_->error();
+}
+
+
 int UserSegmentReader::filter( const struct dirent *ent )
 {
 	return !strncmp( "entries.", ent->d_name, 8 );
@@ -109,8 +218,7 @@ int UserSegmentReader::findEntryNumber( LogTime &time,
 	while (1)
 	{
 		mid = direction == 1 ? (left+right)/2 : (left+right+1)/2;
-		pEntries_->seek( mid * sizeof( LogEntry ) );
-		*pEntries_ >> midtime;
+		this->readEntryTime( mid, midtime );
 
 		if (left >= right)
 		{
@@ -175,15 +283,41 @@ const LogTime & UserSegmentReader::getEndLogTime() const
 bool UserSegmentReader::interpolateMessage( const LogEntry &entry,
 	const LogStringInterpolator *pHandler, std::string &result )
 {
-	pArgs_->seek( entry.argsOffset_ );
+	BinaryIStream *pArgs = this->getArgStream( entry.argsOffset_ );
+
+	if (pArgs == NULL)
+	{
+		return false;
+	}
+
 	return const_cast< LogStringInterpolator * >( pHandler )->streamToString(
-															*pArgs_, result );
+															*pArgs, result );
 }
 
 
-FileStream * UserSegmentReader::getArgStream()
+/**
+ * Returns a stream positioned at the given offset in the args file, or NULL
+ * on error. The stream is shared by all users of this segment, so it is only
+ * valid until the next call to this method.
+ */
+BinaryIStream * UserSegmentReader::getArgStream( int argsOffset )
 {
-	return pArgs_;
+	if (argsFile_.isGood())
+	{
+		// The args of the entries are in the same order as the entries.
+		if (scanDirection_ != 0)
+		{
+			argsFile_.willRead( argsOffset,
+				SearchDirection( scanDirection_ ) );
+		}
+
+		argsStream_.reset( &argsFile_, argsOffset );
+		return &argsStream_;
+	}
+
+	pArgs_->seek( argsOffset );
+
+	return pArgs_->good() ? pArgs_ : NULL;
 }
 
 
@@ -198,4 +332,73 @@ int UserSegmentReader::getArgsLength() const
 	return pArgs_->length();
 }
 
+
+/**
+ * Brings the index of this segment up to date with the entries file and
+ * returns it. The index is read from this segment's index file the first time
+ * this is called, and only the entries added since then are read from the
+ * entries file. The index file is written back if enough entries have been
+ * added to it.
+ */
+const UserSegmentIndex & UserSegmentReader::updateIndex()
+{
+	char buf[ 1024 ];
+	bw_snprintf( buf, sizeof( buf ), "%s/index.%s",
+		userLogPath_.c_str(), suffix_.c_str() );
+
+	if (!hasReadIndexFile_)
+	{
+		hasReadIndexFile_ = true;
+
+		// An index covering more entries than the segment has is not for
+		// this segment.
+		if (!index_.read( buf, start_ ) ||
+			(index_.getNumEntries() > numEntries_))
+		{
+			index_.clear();
+		}
+
+		numEntriesInIndexFile_ = index_.getNumEntries();
+	}
+
+	if (index_.getNumEntries() >= numEntries_)
+	{
+		return index_;
+	}
+
+	LogEntry entry;
+
+	while (index_.getNumEntries() < numEntries_)
+	{
+		if (!this->readEntry( index_.getNumEntries(), entry ))
+		{
+			ERROR_MSG( "UserSegmentReader::updateIndex: "
+				"Failed to read entry %d of segment %s\n",
+				index_.getNumEntries(), suffix_.c_str() );
+			return index_;
+		}
+
+		index_.addEntry( entry );
+	}
+
+	if (canWriteIndexFile_ &&
+		(index_.getNumEntries() - numEntriesInIndexFile_ >=
+			MIN_NEW_ENTRIES_TO_WRITE_INDEX))
+	{
+		if (index_.write( buf, start_ ))
+		{
+			numEntriesInIndexFile_ = index_.getNumEntries();
+		}
+		else
+		{
+			WARNING_MSG( "UserSegmentReader::updateIndex: "
+				"Couldn't write index file %s. The index will be rebuilt "
+				"by each reader of this segment.\n", buf );
+			canWriteIndexFile_ = false;
+		}
+	}
+
+	return index_;
+}
+
 // user_segment_reader.cpp
@@ -12,7 +12,9 @@ criminal penalties as provided by law.
 #ifndef USER_SEGMENT_READER_HPP
 #define USER_SEGMENT_READER_HPP
 
+#include "mapped_file.hpp"
 #include "user_segment.hpp"
+#include "user_segment_index.hpp"
 
 #include <string>
 #include <vector>
@@ -27,6 +29,8 @@ public:
 
 	bool init();
 
+	virtual bool readEntry( int n, LogEntry &entry );
+
 	static int filter( const struct dirent *ent );
 
 	bool isDirty() const;
@@ -42,11 +46,34 @@ public:
 	bool interpolateMessage( const LogEntry &entry,
 			const LogStringInterpolator *pHandler, std::string &result );
 
-	// Candidate for cleanup. QueryRange currently requires this.
-	FileStream * getArgStream();
+	BinaryIStream * getArgStream( int argsOffset );
 
 	int getEntriesLength() const;
 	int getArgsLength() const;
+
+	const UserSegmentIndex & updateIndex();
+
+private:
+	bool readEntryTime( int n, LogTime &time );
+
+	// The entries and args files are read through these mappings, unless
+	// they can't be mapped, in which case the FileStreams are used instead.
+	MappedFile entriesFile_;
+	MappedFile argsFile_;
+	MappedFileIStream argsStream_;
+
+	// The last entry read, and the direction in which entries are being
+	// scanned, or 0 if they are not being read in order.
+	int lastEntryNum_;
+	int scanDirection_;
+
+	// An index of the entries of this segment by format string and priority.
+	// It covers the entries up to index_.getNumEntries().
+	UserSegmentIndex index_;
+
+	bool hasReadIndexFile_;
+	bool canWriteIndexFile_;
+	int numEntriesInIndexFile_;
 };
 
 #endif // USER_SEGMENT_READER_HPP